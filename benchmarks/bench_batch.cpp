@@ -0,0 +1,140 @@
+// Mixed-algorithm batch verification benchmark
+//
+// Verifies a stream of signatures interleaving several algorithms and keys
+// (by default ML-DSA, Falcon and SLH-DSA/SPHINCS+, whichever are enabled),
+// in three modes:
+//   naive  - item by item, in stream order, constructing the algorithm's
+//            oqs::Signature handle for every item
+//   cached - item by item, in stream order, with one handle per algorithm
+//   batch  - oqs::batch::Verifier, grouped by algorithm and public key and
+//            run on --threads threads (also with --threads 1, to isolate the
+//            effect of the grouping)
+// and reports the verifications per second of each mode.
+//
+// Usage: bench_batch [--alg ML-DSA-65,Falcon-512,SPHINCS+-SHA2-128f-simple]
+//                    [--keys 8] [--items 2000] [--rounds 3] [--threads N]
+//                    [--mode naive,cached,batch]
+
+#include <algorithm>
+#include <cstddef>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "bench_common.hpp"
+
+// liboqs C++ wrapper
+#include "oqs_cpp.hpp"
+
+#include "batch/batch.hpp"
+
+int main(int argc, char** argv) {
+    bench::Args args{argc, argv};
+    std::vector<std::string> requested = bench::split(
+        args.get("--alg", "ML-DSA-65,Falcon-512,SPHINCS+-SHA2-128f-simple"));
+    std::size_t num_keys =
+        static_cast<std::size_t>(args.get_number("--keys", 8));
+    std::size_t num_items =
+        static_cast<std::size_t>(args.get_number("--items", 2000));
+    std::size_t rounds =
+        static_cast<std::size_t>(args.get_number("--rounds", 3));
+    std::size_t threads = static_cast<std::size_t>(args.get_number(
+        "--threads", std::max(1u, std::thread::hardware_concurrency())));
+    std::vector<std::string> modes =
+        bench::split(args.get("--mode", "naive,cached,batch"));
+
+    std::vector<std::string> enabled = oqs::Sigs::get_enabled_sigs();
+    std::vector<std::string> algs;
+    for (auto&& alg : requested)
+        if (std::find(enabled.begin(), enabled.end(), alg) != enabled.end())
+            algs.emplace_back(alg);
+    if (algs.empty() || num_keys == 0 || rounds == 0)
+        throw std::invalid_argument("No enabled algorithm, key or round");
+
+    // Keys cycle through the algorithms, items through the keys, so that
+    // consecutive items never share an algorithm
+    std::vector<std::unique_ptr<oqs::Signature>> signers;
+    std::vector<oqs::bytes> public_keys;
+    for (std::size_t k = 0; k < num_keys; ++k) {
+        signers.emplace_back(new oqs::Signature{algs[k % algs.size()]});
+        public_keys.emplace_back(signers.back()->generate_keypair());
+    }
+    std::vector<oqs::batch::Item> items;
+    for (std::size_t i = 0; i < num_items; ++i) {
+        std::size_t k = i % num_keys;
+        oqs::bytes message(64, static_cast<oqs::byte>(i));
+        oqs::bytes signature = signers[k]->sign(message);
+        items.push_back(oqs::batch::Item{signers[k]->get_details().name,
+                                         public_keys[k], message, signature,
+                                         {}});
+    }
+
+    std::cout << "liboqs version: " << oqs::oqs_version() << '\n';
+    std::cout << "liboqs-cpp version: " << oqs::oqs_cpp_version() << '\n';
+    std::cout << num_items << " items, " << num_keys << " keys, "
+              << algs.size() << " algorithm(s), " << threads
+              << " thread(s)\n\n";
+    std::cout << std::left << std::setw(10) << "MODE" << std::right
+              << std::setw(10) << "threads" << std::setw(14) << "verify/s"
+              << std::setw(10) << "speedup" << '\n';
+    std::cout << std::fixed << std::setprecision(1);
+
+    double baseline = 0;
+    auto report = [&](const std::string& mode, std::size_t mode_threads,
+                      double seconds) {
+        double rate = static_cast<double>(num_items * rounds) / seconds;
+        if (baseline == 0)
+            baseline = rate;
+        std::cout << std::left << std::setw(10) << mode << std::right
+                  << std::setw(10) << mode_threads << std::setw(14) << rate
+                  << std::setw(9) << rate / baseline << "x" << std::endl;
+    };
+    auto check = [](bool valid) {
+        if (!valid)
+            throw std::runtime_error("Signature verification failed");
+    };
+
+    for (auto&& mode : modes) {
+        if (mode == "naive") {
+            oqs::Timer<> timer;
+            for (std::size_t r = 0; r < rounds; ++r)
+                for (auto&& item : items)
+                    check(oqs::Signature{item.alg_name}.verify(
+                        item.message, item.signature, item.public_key));
+            timer.toc();
+            report(mode, 1, timer.tics());
+        } else if (mode == "cached") {
+            std::map<std::string, std::unique_ptr<oqs::Signature>> handles;
+            for (auto&& alg : algs)
+                handles[alg].reset(new oqs::Signature{alg});
+            oqs::Timer<> timer;
+            for (std::size_t r = 0; r < rounds; ++r)
+                for (auto&& item : items)
+                    check(handles[item.alg_name]->verify(
+                        item.message, item.signature, item.public_key));
+            timer.toc();
+            report(mode, 1, timer.tics());
+        } else if (mode == "batch") {
+            std::vector<std::size_t> counts{1};
+            if (threads > 1)
+                counts.emplace_back(threads);
+            for (auto&& count : counts) {
+                oqs::batch::Verifier verifier{count};
+                verifier.verify(items); // warm-up, fills the handle cache
+                oqs::Timer<> timer;
+                for (std::size_t r = 0; r < rounds; ++r)
+                    for (auto&& status : verifier.verify(items))
+                        check(status == oqs::batch::Status::Valid);
+                timer.toc();
+                report(mode, count, timer.tics());
+            }
+        } else {
+            throw std::invalid_argument("Unknown mode " + mode);
+        }
+    }
+}
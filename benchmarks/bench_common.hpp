@@ -0,0 +1,213 @@
+// Helpers shared by the benchmarks
+
+#ifndef BENCHMARKS_BENCH_COMMON_HPP_
+#define BENCHMARKS_BENCH_COMMON_HPP_
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <sys/resource.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#endif
+
+namespace bench {
+/**
+ * \brief Nearest-rank percentile of an ascending sorted sample
+ * \param sorted Sorted sample
+ * \param p Percentile in [0, 100]
+ * \return Percentile, 0 for an empty sample
+ */
+inline double percentile(const std::vector<double>& sorted, double p) {
+    if (sorted.empty())
+        return 0;
+    std::size_t rank = static_cast<std::size_t>(
+        std::ceil(p / 100 * static_cast<double>(sorted.size())));
+    return sorted[rank == 0 ? 0 : std::min(rank, sorted.size()) - 1];
+}
+
+/**
+ * \brief User + system CPU time consumed by the whole process
+ * \return CPU time in seconds
+ */
+inline double cpu_seconds() {
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    return static_cast<double>(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) +
+           static_cast<double>(usage.ru_utime.tv_usec +
+                               usage.ru_stime.tv_usec) *
+               1e-6;
+}
+
+/**
+ * \brief Splits \a s at every \a sep
+ */
+inline std::vector<std::string> split(const std::string& s, char sep = ',') {
+    std::vector<std::string> result;
+    std::stringstream ss{s};
+    std::string item;
+    while (std::getline(ss, item, sep))
+        if (!item.empty())
+            result.emplace_back(item);
+    return result;
+}
+
+/**
+ * \brief Whether \a name contains one of \a filters, an empty filter list
+ * matches everything
+ */
+inline bool matches(const std::string& name,
+                    const std::vector<std::string>& filters) {
+    if (filters.empty())
+        return true;
+    for (auto&& filter : filters)
+        if (name.find(filter) != std::string::npos)
+            return true;
+    return false;
+}
+
+/**
+ * \brief Minimal command line parser, accepts "--key value" and "--flag"
+ */
+class Args {
+    std::vector<std::string> args_;
+
+  public:
+    Args(int argc, char** argv) : args_(argv + 1, argv + argc) {}
+
+    /**
+     * \brief Whether \a flag was passed
+     */
+    bool has(const std::string& flag) const {
+        return std::find(args_.begin(), args_.end(), flag) != args_.end();
+    }
+
+    /**
+     * \brief Value following \a key, or \a def if absent
+     */
+    std::string get(const std::string& key, const std::string& def) const {
+        auto it = std::find(args_.begin(), args_.end(), key);
+        if (it == args_.end())
+            return def;
+        if (++it == args_.end())
+            throw std::invalid_argument("Missing value for " + key);
+        return *it;
+    }
+
+    /**
+     * \brief Numeric value following \a key, or \a def if absent
+     */
+    double get_number(const std::string& key, double def) const {
+        std::string value = get(key, "");
+        return value.empty() ? def : std::stod(value);
+    }
+};
+
+/**
+ * \brief Hardware events countable by bench::PerfCounter
+ */
+enum class PerfEvent { CacheMisses, CacheReferences, Instructions, Cycles };
+
+/**
+ * \brief Hardware event counter (perf_event_open) covering the calling thread
+ * and every thread it creates while the counter is open
+ *
+ * Threads must be joined before stop() for their counts to be included.
+ * Unavailable (e.g. non-Linux, perf_event_paranoid, containers) counters
+ * report available() == false and count nothing
+ */
+class PerfCounter {
+    int fd_ = -1;
+
+  public:
+    /**
+     * \brief Opens a user-space only counter
+     * \param event Hardware event
+     */
+    explicit PerfCounter(PerfEvent event) {
+#ifdef __linux__
+        perf_event_attr attr{};
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.size = sizeof(attr);
+        switch (event) {
+            case PerfEvent::CacheMisses:
+                attr.config = PERF_COUNT_HW_CACHE_MISSES;
+                break;
+            case PerfEvent::CacheReferences:
+                attr.config = PERF_COUNT_HW_CACHE_REFERENCES;
+                break;
+            case PerfEvent::Instructions:
+                attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+                break;
+            case PerfEvent::Cycles:
+                attr.config = PERF_COUNT_HW_CPU_CYCLES;
+                break;
+        }
+        attr.disabled = 1;
+        attr.inherit = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        fd_ = static_cast<int>(
+            syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+#else
+        (void) event;
+#endif
+    }
+
+    PerfCounter(const PerfCounter&) = delete;
+
+    PerfCounter& operator=(const PerfCounter&) = delete;
+
+    ~PerfCounter() {
+        if (fd_ >= 0)
+            close(fd_);
+    }
+
+    /**
+     * \brief Whether the counter could be opened
+     */
+    bool available() const { return fd_ >= 0; }
+
+    /**
+     * \brief Resets and enables the counter
+     */
+    void start() {
+#ifdef __linux__
+        if (fd_ >= 0) {
+            ioctl(fd_, PERF_EVENT_IOC_RESET, 0);
+            ioctl(fd_, PERF_EVENT_IOC_ENABLE, 0);
+        }
+#endif
+    }
+
+    /**
+     * \brief Disables the counter
+     * \return Number of events since start(), 0 if unavailable
+     */
+    std::uint64_t stop() {
+        std::uint64_t count = 0;
+#ifdef __linux__
+        if (fd_ >= 0) {
+            ioctl(fd_, PERF_EVENT_IOC_DISABLE, 0);
+            if (read(fd_, &count, sizeof(count)) != sizeof(count))
+                count = 0;
+        }
+#endif
+        return count;
+    }
+};
+} // namespace bench
+
+#endif // BENCHMARKS_BENCH_COMMON_HPP_
@@ -0,0 +1,217 @@
+// Loopback handshake throughput benchmark
+//
+// Runs complete oqs::handshake KEM + signature handshakes between N client
+// threads and a server (one thread per connection) over socketpairs, or over
+// loopback TCP with --tcp, for every combination of enabled algorithms.
+// Reports handshakes/sec, client-side latency percentiles and process CPU
+// time per handshake at each concurrency level.
+//
+// Usage: bench_handshake [--kem ML-KEM,...] [--sig ML-DSA,...]
+//                        [--concurrency 1,2,4] [--handshakes 200] [--tcp]
+
+#include <algorithm>
+#include <cerrno>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "bench_common.hpp"
+
+// liboqs C++ wrapper
+#include "handshake/handshake.hpp"
+#include "oqs_cpp.hpp"
+
+static void read_exact(int fd, oqs::bytes& buf) {
+    std::size_t total = 0;
+    while (total < buf.size()) {
+        ssize_t n = ::read(fd, buf.data() + total, buf.size() - total);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            throw std::runtime_error("Connection closed");
+        total += static_cast<std::size_t>(n);
+    }
+}
+
+static void write_all(int fd, const oqs::bytes& buf) {
+    std::size_t total = 0;
+    while (total < buf.size()) {
+        ssize_t n = ::write(fd, buf.data() + total, buf.size() - total);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n < 0)
+            throw std::runtime_error("Can not write to socket");
+        total += static_cast<std::size_t>(n);
+    }
+}
+
+// Connected (client, server) socket pairs, over socketpair() or loopback TCP
+static std::vector<std::pair<int, int>> connect_pairs(std::size_t n,
+                                                      bool tcp) {
+    std::vector<std::pair<int, int>> pairs;
+    if (!tcp) {
+        for (std::size_t i = 0; i < n; ++i) {
+            int sv[2];
+            if (::socketpair(AF_UNIX, SOCK_STREAM, 0, sv) != 0)
+                throw std::runtime_error("socketpair() failed");
+            pairs.emplace_back(sv[0], sv[1]);
+        }
+        return pairs;
+    }
+
+    int listener = ::socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t len = sizeof(addr);
+    if (listener < 0 ||
+        ::bind(listener, reinterpret_cast<sockaddr*>(&addr), len) != 0 ||
+        ::listen(listener, static_cast<int>(n)) != 0 ||
+        ::getsockname(listener, reinterpret_cast<sockaddr*>(&addr), &len) !=
+            0)
+        throw std::runtime_error("Can not listen on loopback");
+    int one = 1;
+    for (std::size_t i = 0; i < n; ++i) {
+        int client = ::socket(AF_INET, SOCK_STREAM, 0);
+        if (client < 0 ||
+            ::connect(client, reinterpret_cast<sockaddr*>(&addr), len) != 0)
+            throw std::runtime_error("Can not connect to loopback");
+        int server = ::accept(listener, nullptr, nullptr);
+        if (server < 0)
+            throw std::runtime_error("accept() failed");
+        ::setsockopt(client, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        ::setsockopt(server, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        pairs.emplace_back(client, server);
+    }
+    ::close(listener);
+    return pairs;
+}
+
+// Serves handshakes on fd until the client disconnects
+static void run_server(int fd, oqs::handshake::Server server) {
+    oqs::bytes client_hello(server.client_hello_length());
+    oqs::bytes client_finished(server.client_finished_length());
+    try {
+        for (;;) {
+            read_exact(fd, client_hello);
+            write_all(fd, server.process_client_hello(client_hello));
+            read_exact(fd, client_finished);
+            server.process_client_finished(client_finished);
+        }
+    } catch (std::exception&) {
+        // client disconnected
+    }
+    ::close(fd);
+}
+
+// Runs num_handshakes handshakes on fd, records the latencies in seconds
+static void run_client(int fd, oqs::handshake::Client client,
+                       std::size_t num_handshakes,
+                       std::vector<double>& latencies) {
+    oqs::bytes server_hello(client.server_hello_length());
+    latencies.reserve(num_handshakes);
+    for (std::size_t i = 0; i < num_handshakes; ++i) {
+        oqs::Timer<> t;
+        write_all(fd, client.client_hello());
+        read_exact(fd, server_hello);
+        write_all(fd, client.process_server_hello(server_hello));
+        t.toc();
+        latencies.emplace_back(t.tics());
+    }
+    ::shutdown(fd, SHUT_RDWR);
+    ::close(fd);
+}
+
+int main(int argc, char** argv) {
+    bench::Args args{argc, argv};
+    std::vector<std::string> kem_filters = bench::split(args.get("--kem", ""));
+    std::vector<std::string> sig_filters = bench::split(args.get("--sig", ""));
+    std::vector<std::size_t> levels;
+    for (auto&& level : bench::split(args.get("--concurrency", "")))
+        levels.emplace_back(std::stoul(level));
+    if (levels.empty()) {
+        levels.emplace_back(1);
+        if (std::thread::hardware_concurrency() > 1)
+            levels.emplace_back(std::thread::hardware_concurrency());
+    }
+    std::size_t num_handshakes =
+        static_cast<std::size_t>(args.get_number("--handshakes", 200));
+    bool tcp = args.has("--tcp");
+
+    std::cout << "liboqs version: " << oqs::oqs_version() << '\n';
+    std::cout << "liboqs-cpp version: " << oqs::oqs_cpp_version() << '\n';
+    std::cout << "Transport: " << (tcp ? "loopback TCP" : "socketpair")
+              << ", " << num_handshakes << " handshakes per client\n\n";
+    std::cout << std::left << std::setw(28) << "KEM" << std::setw(32) << "SIG"
+              << std::right << std::setw(6) << "N" << std::setw(12) << "hs/s"
+              << std::setw(12) << "p50 (ms)" << std::setw(12) << "p99 (ms)"
+              << std::setw(12) << "p999 (ms)" << std::setw(14)
+              << "CPU/hs (ms)" << '\n';
+    std::cout << std::fixed << std::setprecision(3);
+
+    for (auto&& kem_name : oqs::KEMs::get_enabled_KEMs()) {
+        if (!bench::matches(kem_name, kem_filters))
+            continue;
+        for (auto&& sig_name : oqs::Sigs::get_enabled_sigs()) {
+            if (!bench::matches(sig_name, sig_filters))
+                continue;
+            oqs::Signature signer{sig_name};
+            oqs::bytes server_public_key = signer.generate_keypair();
+
+            for (std::size_t n : levels) {
+                auto pairs = connect_pairs(n, tcp);
+                // Construct (and warm up) the endpoints before timing
+                std::vector<oqs::handshake::Client> clients;
+                std::vector<oqs::handshake::Server> servers;
+                for (std::size_t i = 0; i < n; ++i) {
+                    clients.emplace_back(kem_name, sig_name,
+                                         server_public_key);
+                    servers.emplace_back(kem_name, signer);
+                }
+                std::vector<std::vector<double>> latencies(n);
+                std::vector<std::thread> thread_pool;
+
+                double cpu_start = bench::cpu_seconds();
+                oqs::Timer<> wall;
+                for (std::size_t i = 0; i < n; ++i)
+                    thread_pool.emplace_back(run_server, pairs[i].second,
+                                             std::move(servers[i]));
+                for (std::size_t i = 0; i < n; ++i)
+                    thread_pool.emplace_back(run_client, pairs[i].first,
+                                             std::move(clients[i]),
+                                             num_handshakes,
+                                             std::ref(latencies[i]));
+                for (auto&& elem : thread_pool)
+                    elem.join();
+                wall.toc();
+                double cpu = bench::cpu_seconds() - cpu_start;
+
+                std::vector<double> all;
+                for (auto&& elem : latencies)
+                    all.insert(all.end(), elem.begin(), elem.end());
+                std::sort(all.begin(), all.end());
+                double total = static_cast<double>(all.size());
+                std::cout << std::left << std::setw(28) << kem_name
+                          << std::setw(32) << sig_name << std::right
+                          << std::setw(6) << n << std::setw(12)
+                          << std::setprecision(1) << total / wall.tics()
+                          << std::setprecision(3) << std::setw(12)
+                          << 1e3 * bench::percentile(all, 50)
+                          << std::setw(12) << 1e3 * bench::percentile(all, 99)
+                          << std::setw(12)
+                          << 1e3 * bench::percentile(all, 99.9)
+                          << std::setw(14) << 1e3 * cpu / total << std::endl;
+            }
+        }
+    }
+}
@@ -0,0 +1,128 @@
+// Hybrid X25519 + ML-KEM-768 (X-Wing) benchmark
+//
+// Runs --iterations encapsulations + decapsulations in three modes:
+//   manual - oqs::KeyEncapsulation and oqs::x25519 on separate buffers,
+//            concatenated and hashed by hand, as without oqs::hybrid
+//   fused  - oqs::hybrid::XWing writing into one preallocated buffer
+//   pool   - as fused, with the X25519 half on a 1-thread worker pool
+// and reports the operations per second and the time per encaps + decaps.
+//
+// Usage: bench_hybrid [--iterations 2000] [--mode manual,fused,pool]
+
+#include <algorithm>
+#include <cstddef>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "bench_common.hpp"
+
+// liboqs C++ wrapper
+#include "oqs_cpp.hpp"
+
+#include "async/async.hpp"
+#include "hybrid/hybrid.hpp"
+#include "rand/rand.hpp"
+#include "sha3/sha3.hpp"
+#include "x25519/x25519.hpp"
+
+namespace {
+// X-Wing shared secret, combined by hand from the separate halves
+oqs::bytes combine(const oqs::bytes& ss_m, const oqs::bytes& ss_x,
+                   const oqs::bytes& ct_x, const oqs::bytes& pk_x) {
+    oqs::bytes input = ss_m;
+    input.insert(input.end(), ss_x.begin(), ss_x.end());
+    input.insert(input.end(), ct_x.begin(), ct_x.end());
+    input.insert(input.end(), pk_x.begin(), pk_x.end());
+    input.insert(input.end(), oqs::hybrid::xwing_label,
+                 oqs::hybrid::xwing_label + sizeof(oqs::hybrid::xwing_label));
+    return oqs::sha3::sha3_256(input);
+}
+} // namespace
+
+int main(int argc, char** argv) {
+    bench::Args args{argc, argv};
+    std::size_t iterations =
+        static_cast<std::size_t>(args.get_number("--iterations", 2000));
+    std::vector<std::string> modes =
+        bench::split(args.get("--mode", "manual,fused,pool"));
+    if (iterations == 0)
+        throw std::invalid_argument("--iterations must be at least 1");
+
+    std::cout << "liboqs version: " << oqs::oqs_version() << '\n';
+    std::cout << "liboqs-cpp version: " << oqs::oqs_cpp_version() << '\n';
+    std::cout << iterations << " encaps + decaps per mode\n\n";
+    std::cout << std::left << std::setw(10) << "MODE" << std::right
+              << std::setw(12) << "ops/s" << std::setw(12) << "time [us]"
+              << '\n';
+    std::cout << std::fixed << std::setprecision(1);
+
+    oqs::async::WorkerPool pool{1};
+    for (auto&& mode : modes) {
+        oqs::Timer<> timer;
+        if (mode == "manual") {
+            oqs::KeyEncapsulation server{"ML-KEM-768"};
+            oqs::bytes pk_m = server.generate_keypair();
+            oqs::bytes sk_x = oqs::rand::randombytes(oqs::x25519::key_length);
+            oqs::bytes pk_x = oqs::x25519::public_key(sk_x);
+            oqs::KeyEncapsulation client{"ML-KEM-768"};
+            timer.tic();
+            for (std::size_t i = 0; i < iterations; ++i) {
+                // Client
+                auto encaps = client.encap_secret(pk_m);
+                oqs::bytes ek_x =
+                    oqs::rand::randombytes(oqs::x25519::key_length);
+                oqs::bytes ct_x = oqs::x25519::public_key(ek_x);
+                oqs::bytes ss = combine(encaps.second,
+                                        oqs::x25519::x25519(ek_x, pk_x), ct_x,
+                                        pk_x);
+                oqs::bytes ciphertext = encaps.first;
+                ciphertext.insert(ciphertext.end(), ct_x.begin(), ct_x.end());
+                // Server
+                std::size_t ct_m = ciphertext.size() - ct_x.size();
+                oqs::bytes received_ct_m(ciphertext.begin(),
+                                         ciphertext.begin() +
+                                             static_cast<std::ptrdiff_t>(ct_m));
+                oqs::bytes received_ct_x(ciphertext.begin() +
+                                             static_cast<std::ptrdiff_t>(ct_m),
+                                         ciphertext.end());
+                oqs::bytes ss_server =
+                    combine(server.decap_secret(received_ct_m),
+                            oqs::x25519::x25519(sk_x, received_ct_x),
+                            received_ct_x, pk_x);
+                if (ss != ss_server)
+                    throw std::runtime_error("Shared secrets differ");
+            }
+        } else if (mode == "fused" || mode == "pool") {
+            oqs::async::WorkerPool* mode_pool =
+                mode == "pool" ? &pool : nullptr;
+            oqs::hybrid::XWing server{oqs::bytes{}, mode_pool};
+            oqs::bytes public_key = server.generate_keypair();
+            oqs::hybrid::XWing client{oqs::bytes{}, mode_pool};
+            const auto& details = client.get_details();
+            // Ciphertext | client shared secret | server shared secret
+            oqs::bytes buffer(details.length_ciphertext +
+                              2 * details.length_shared_secret);
+            oqs::byte* ss = buffer.data() + details.length_ciphertext;
+            oqs::byte* ss_server = ss + details.length_shared_secret;
+            timer.tic();
+            for (std::size_t i = 0; i < iterations; ++i) {
+                client.encap_secret(public_key.data(), buffer.data(), ss);
+                server.decap_secret(buffer.data(), ss_server);
+                if (!std::equal(ss, ss_server, ss_server))
+                    throw std::runtime_error("Shared secrets differ");
+            }
+        } else {
+            throw std::invalid_argument("Unknown mode " + mode);
+        }
+        timer.toc();
+        std::cout << std::left << std::setw(10) << mode << std::right
+                  << std::setw(12)
+                  << static_cast<double>(iterations) / timer.tics()
+                  << std::setw(12)
+                  << timer.tics() * 1e6 / static_cast<double>(iterations)
+                  << std::endl;
+    }
+}
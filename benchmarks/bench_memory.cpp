@@ -0,0 +1,334 @@
+// Per-operation memory footprint report
+//
+// For every enabled KEM (keypair, encaps, decaps) and signature (keypair,
+// sign, verify), runs the operation once on a dedicated thread whose stack is
+// user-supplied and painted with a known pattern, and reports
+//   stack - peak stack depth used by the operation (painted stack high-water,
+//           relative to an empty operation)
+//   allocs, heap - number of heap allocations and bytes requested
+//   peak heap - peak live heap bytes allocated during the operation
+//   RSS - growth of the process resident set (peak RSS when the kernel allows
+//         resetting it via /proc/self/clear_refs, current RSS otherwise)
+// as a table on stdout and, with --json, as a JSON array for capacity planning.
+//
+// On glibc the C allocator is interposed, so allocations made inside liboqs
+// are included; elsewhere only C++ operator new allocations are counted.
+//
+// Usage: bench_memory [--alg ML-KEM,ML-DSA,...] [--stack-mib 64]
+//                     [--msg-bytes 64] [--json footprint.json]
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include <pthread.h>
+#include <sys/mman.h>
+
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+#include "bench_common.hpp"
+
+// liboqs C++ wrapper
+#include "oqs_cpp.hpp"
+
+/////////////////////////////// ALLOCATION TRACKING ///////////////////////////
+// Only allocations made by the profiled thread while tracking is on are
+// counted, hence the counters need no synchronization
+static thread_local bool tracking = false;
+static std::size_t num_allocs = 0;
+static std::size_t heap_bytes = 0;
+static std::size_t live_bytes = 0;
+static std::size_t peak_live_bytes = 0;
+
+static void on_alloc(void* p, std::size_t size) {
+    if (!tracking || p == nullptr)
+        return;
+    ++num_allocs;
+    heap_bytes += size;
+#ifdef __GLIBC__
+    live_bytes += malloc_usable_size(p);
+#else
+    live_bytes += size;
+#endif
+    if (live_bytes > peak_live_bytes)
+        peak_live_bytes = live_bytes;
+}
+
+#ifdef __GLIBC__
+static void on_free(void* p) {
+    if (!tracking || p == nullptr)
+        return;
+    std::size_t size = malloc_usable_size(p);
+    live_bytes = size > live_bytes ? 0 : live_bytes - size;
+}
+
+// Interpose the C allocator, covers liboqs and operator new
+extern "C" {
+void* __libc_malloc(std::size_t size);
+void* __libc_calloc(std::size_t num, std::size_t size);
+void* __libc_realloc(void* p, std::size_t size);
+void* __libc_memalign(std::size_t alignment, std::size_t size);
+void __libc_free(void* p);
+
+void* malloc(std::size_t size) __THROW {
+    void* p = __libc_malloc(size);
+    on_alloc(p, size);
+    return p;
+}
+
+void* calloc(std::size_t num, std::size_t size) __THROW {
+    void* p = __libc_calloc(num, size);
+    on_alloc(p, num * size);
+    return p;
+}
+
+void* realloc(void* p, std::size_t size) __THROW {
+    on_free(p);
+    void* q = __libc_realloc(p, size);
+    on_alloc(q, size);
+    return q;
+}
+
+void* aligned_alloc(std::size_t alignment, std::size_t size) __THROW {
+    void* p = __libc_memalign(alignment, size);
+    on_alloc(p, size);
+    return p;
+}
+
+int posix_memalign(void** p, std::size_t alignment, std::size_t size) __THROW {
+    *p = __libc_memalign(alignment, size);
+    on_alloc(*p, size);
+    return *p == nullptr ? ENOMEM : 0;
+}
+
+void free(void* p) __THROW {
+    on_free(p);
+    __libc_free(p);
+}
+}
+#else
+// Count C++ allocations only, sizes are not known on deallocation
+void* operator new(std::size_t size) {
+    void* p = std::malloc(size);
+    if (p == nullptr)
+        throw std::bad_alloc{};
+    on_alloc(p, size);
+    return p;
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+#endif
+
+////////////////////////////////// RSS (Linux) ////////////////////////////////
+// Value of a "VmXXX:   123 kB" line of /proc/self/status, 0 if unavailable
+static long proc_status_kib(const std::string& key) {
+    std::ifstream in{"/proc/self/status"};
+    std::string line;
+    while (std::getline(in, line))
+        if (line.compare(0, key.size(), key) == 0)
+            return std::strtol(line.c_str() + key.size() + 1, nullptr, 10);
+    return 0;
+}
+
+// Resets the peak RSS (VmHWM) to the current RSS, Linux >= 4.0
+static bool reset_peak_rss() {
+    std::ofstream out{"/proc/self/clear_refs"};
+    out << "5";
+    out.flush();
+    return static_cast<bool>(out);
+}
+
+//////////////////////////////// PAINTED STACK ////////////////////////////////
+constexpr unsigned char paint = 0xA5;
+
+struct Sample {
+    std::size_t stack = 0;
+    std::size_t allocs = 0;
+    std::size_t heap = 0;
+    std::size_t peak_heap = 0;
+    long rss_kib = 0;
+};
+
+struct Job {
+    const std::function<void()>* op;
+    Sample* sample;
+    std::exception_ptr error;
+};
+
+static void* run_job(void* arg) {
+    Job* job = static_cast<Job*>(arg);
+    num_allocs = heap_bytes = live_bytes = peak_live_bytes = 0;
+    tracking = true;
+    try {
+        (*job->op)();
+    } catch (...) {
+        job->error = std::current_exception();
+    }
+    tracking = false;
+    job->sample->allocs = num_allocs;
+    job->sample->heap = heap_bytes;
+    job->sample->peak_heap = peak_live_bytes;
+    return nullptr;
+}
+
+// Runs op on a thread with a painted stack of stack_size bytes
+static Sample profile(const std::function<void()>& op, std::size_t stack_size) {
+    void* stack = mmap(nullptr, stack_size, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (stack == MAP_FAILED)
+        throw std::runtime_error("Can not allocate the thread stack");
+    std::memset(stack, paint, stack_size);
+
+    Sample sample;
+    Job job{&op, &sample, nullptr};
+    pthread_attr_t attr;
+    pthread_t thread;
+    pthread_attr_init(&attr);
+    pthread_attr_setstack(&attr, stack, stack_size);
+    // RSS is process-wide, read it here to keep the profiled stack minimal
+    bool peak = reset_peak_rss();
+    long rss_before = proc_status_kib("VmRSS:");
+    int rc = pthread_create(&thread, &attr, run_job, &job);
+    pthread_attr_destroy(&attr);
+    if (rc != 0) {
+        munmap(stack, stack_size);
+        throw std::runtime_error("Can not create the profiling thread");
+    }
+    pthread_join(thread, nullptr);
+    sample.rss_kib = proc_status_kib(peak ? "VmHWM:" : "VmRSS:") - rss_before;
+
+    // The stack grows down, the first overwritten byte is the high-water mark
+    const unsigned char* p = static_cast<const unsigned char*>(stack);
+    std::size_t untouched = 0;
+    while (untouched < stack_size && p[untouched] == paint)
+        ++untouched;
+    sample.stack = stack_size - untouched;
+    munmap(stack, stack_size);
+    if (job.error)
+        std::rethrow_exception(job.error);
+    return sample;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+struct Row {
+    std::string alg;
+    std::string type;
+    std::string op;
+    Sample sample;
+};
+
+static std::string json_escape(const std::string& s) {
+    std::string result;
+    for (char c : s) {
+        if (c == '"' || c == '\\')
+            result += '\\';
+        result += c;
+    }
+    return result;
+}
+
+int main(int argc, char** argv) {
+    bench::Args args{argc, argv};
+    std::vector<std::string> filters = bench::split(args.get("--alg", ""));
+    std::size_t stack_size = static_cast<std::size_t>(
+        args.get_number("--stack-mib", 64) * (1 << 20));
+    std::size_t msg_bytes =
+        static_cast<std::size_t>(args.get_number("--msg-bytes", 64));
+    std::string json_path = args.get("--json", "");
+
+    // Stack used by the thread itself (glibc keeps TLS on top of the stack)
+    std::size_t base_stack = profile([] {}, stack_size).stack;
+
+    std::vector<Row> rows;
+    auto record = [&](const std::string& alg, const std::string& type,
+                      const std::string& op, const std::function<void()>& f) {
+        Row row{alg, type, op, profile(f, stack_size)};
+        row.sample.stack =
+            row.sample.stack > base_stack ? row.sample.stack - base_stack : 0;
+        rows.emplace_back(row);
+    };
+
+    for (auto&& kem_name : oqs::KEMs::get_enabled_KEMs()) {
+        if (!bench::matches(kem_name, filters))
+            continue;
+        oqs::KeyEncapsulation kem{kem_name};
+        oqs::bytes public_key, ciphertext, shared_secret;
+        record(kem_name, "kem", "keypair",
+               [&] { public_key = kem.generate_keypair(); });
+        record(kem_name, "kem", "encaps", [&] {
+            std::tie(ciphertext, shared_secret) = kem.encap_secret(public_key);
+        });
+        record(kem_name, "kem", "decaps",
+               [&] { shared_secret = kem.decap_secret(ciphertext); });
+    }
+    for (auto&& sig_name : oqs::Sigs::get_enabled_sigs()) {
+        if (!bench::matches(sig_name, filters))
+            continue;
+        oqs::Signature signer{sig_name};
+        oqs::bytes public_key, signature, message(msg_bytes, 0x5a);
+        record(sig_name, "sig", "keypair",
+               [&] { public_key = signer.generate_keypair(); });
+        record(sig_name, "sig", "sign",
+               [&] { signature = signer.sign(message); });
+        record(sig_name, "sig", "verify", [&] {
+            if (!signer.verify(message, signature, public_key))
+                throw std::runtime_error("Verification failed");
+        });
+    }
+
+    std::cout << "liboqs version: " << oqs::oqs_version() << '\n';
+    std::cout << "liboqs-cpp version: " << oqs::oqs_cpp_version() << '\n';
+#ifdef __GLIBC__
+    std::cout << "Heap: C allocator (liboqs and wrapper)\n\n";
+#else
+    std::cout << "Heap: C++ operator new only\n\n";
+#endif
+    std::cout << std::left << std::setw(32) << "ALG" << std::setw(9) << "OP"
+              << std::right << std::setw(12) << "stack (B)" << std::setw(8)
+              << "allocs" << std::setw(12) << "heap (B)" << std::setw(14)
+              << "peak heap (B)" << std::setw(11) << "RSS (KiB)" << '\n';
+    for (auto&& row : rows)
+        std::cout << std::left << std::setw(32) << row.alg << std::setw(9)
+                  << row.op << std::right << std::setw(12) << row.sample.stack
+                  << std::setw(8) << row.sample.allocs << std::setw(12)
+                  << row.sample.heap << std::setw(14) << row.sample.peak_heap
+                  << std::setw(11) << row.sample.rss_kib << '\n';
+
+    if (!json_path.empty()) {
+        std::ostringstream json;
+        json << "[\n";
+        for (std::size_t i = 0; i < rows.size(); ++i) {
+            const Row& row = rows[i];
+            json << "  {\"alg\": \"" << json_escape(row.alg)
+                 << "\", \"type\": \"" << row.type << "\", \"op\": \""
+                 << row.op << "\", \"stack_bytes\": " << row.sample.stack
+                 << ", \"heap_allocs\": " << row.sample.allocs
+                 << ", \"heap_bytes\": " << row.sample.heap
+                 << ", \"heap_peak_bytes\": " << row.sample.peak_heap
+                 << ", \"rss_delta_kib\": " << row.sample.rss_kib << "}"
+                 << (i + 1 < rows.size() ? ",\n" : "\n");
+        }
+        json << "]\n";
+        std::ofstream out{json_path};
+        if (!(out << json.str()))
+            throw std::runtime_error("Can not write " + json_path);
+        std::cout << "\nJSON written to " << json_path << '\n';
+    }
+}
@@ -0,0 +1,147 @@
+// NUMA scaling benchmark
+//
+// Signs on a oqs::numa::ShardedPool (one pinned worker per CPU) using the
+// first 1, 2, ... NUMA nodes of the host, in two modes:
+//   local  - every node signs with its own replica of the secret key,
+//            constructed on that node (oqs::numa::ShardedPool::replicate())
+//   remote - every node signs with a single Signature object constructed by
+//            the main thread
+// Reports the signing throughput of every node (socket), the total, and the
+// speedup relative to one node in the same mode.
+//
+// Usage: bench_numa [--alg ML-DSA,...] [--seconds 0.5] [--mode local,remote]
+//                   [--threads-per-node N]
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "bench_common.hpp"
+
+// liboqs C++ wrapper
+#include "oqs_cpp.hpp"
+
+#include "numa/numa.hpp"
+
+// Signs in a loop on every worker of the pool, returns the ops/s per node
+static std::vector<double>
+measure(oqs::numa::ShardedPool& pool,
+        const oqs::numa::Replicas<oqs::Signature>& signers, double seconds) {
+    std::size_t num_nodes = pool.topology().num_nodes();
+    std::atomic<bool> stop{false};
+    std::atomic<std::size_t> finished{0};
+    std::vector<std::atomic<std::uint64_t>> counts(num_nodes);
+    for (auto&& count : counts)
+        count = 0;
+
+    // One long-running job per worker, posted round-robin
+    for (std::size_t i = 0; i < pool.size(); ++i)
+        pool.post(oqs::numa::any_node, [&](std::size_t node) {
+            oqs::bytes message(64, 0x5a);
+            oqs::bytes signature;
+            std::uint64_t count = 0;
+            while (!stop.load(std::memory_order_relaxed)) {
+                signers[node].sign(message, signature);
+                ++count;
+            }
+            counts[node] += count;
+            ++finished;
+        });
+    oqs::Timer<> wall;
+    std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+    stop = true;
+    while (finished < pool.size())
+        std::this_thread::yield();
+    wall.toc();
+
+    std::vector<double> result;
+    for (auto&& count : counts)
+        result.emplace_back(static_cast<double>(count) / wall.tics());
+    return result;
+}
+
+// Number of workers of a node
+static std::size_t workers(const oqs::numa::Topology& topology,
+                           std::size_t node, std::size_t threads_per_node) {
+    std::size_t cpus = topology.cpus(node).size();
+    return threads_per_node == 0 ? cpus : std::min(cpus, threads_per_node);
+}
+
+static void scale(const std::string& alg_name, const std::string& mode,
+                  const oqs::numa::Topology& host,
+                  std::size_t threads_per_node, double seconds) {
+    oqs::Signature keygen{alg_name};
+    keygen.generate_keypair();
+    oqs::bytes secret_key = keygen.export_secret_key();
+    double baseline = 0;
+
+    for (std::size_t n = 1; n <= host.num_nodes(); ++n) {
+        oqs::numa::ShardedPool pool{host.first_nodes(n), threads_per_node};
+        std::shared_ptr<oqs::Signature> remote;
+        if (mode == "remote")
+            remote = std::make_shared<oqs::Signature>(alg_name, secret_key);
+        auto signers = pool.replicate<oqs::Signature>([&] {
+            // A remote "replica" shares the main thread's OQS_SIG and key
+            return mode == "remote" ? new oqs::Signature{*remote}
+                                    : new oqs::Signature{alg_name, secret_key};
+        });
+
+        std::vector<double> per_node = measure(pool, signers, seconds);
+        double total = 0;
+        for (auto&& elem : per_node)
+            total += elem;
+        if (n == 1)
+            baseline = total;
+        for (std::size_t node = 0; node < n; ++node)
+            std::cout << std::left << std::setw(32) << alg_name
+                      << std::setw(8) << mode << std::right << std::setw(6)
+                      << n << std::setw(6) << node << std::setw(6)
+                      << workers(pool.topology(), node, threads_per_node)
+                      << std::setprecision(1) << std::setw(14)
+                      << per_node[node] << std::setw(14) << total
+                      << std::setprecision(2) << std::setw(10)
+                      << total / baseline << '\n';
+        std::cout << std::flush;
+    }
+}
+
+int main(int argc, char** argv) {
+    bench::Args args{argc, argv};
+    std::vector<std::string> filters =
+        bench::split(args.get("--alg", "ML-DSA"));
+    std::vector<std::string> modes =
+        bench::split(args.get("--mode", "local,remote"));
+    double seconds = args.get_number("--seconds", 0.5);
+    std::size_t threads_per_node =
+        static_cast<std::size_t>(args.get_number("--threads-per-node", 0));
+    for (auto&& mode : modes)
+        if (mode != "local" && mode != "remote")
+            throw std::invalid_argument("Unknown mode " + mode);
+
+    oqs::numa::Topology host = oqs::numa::Topology::detect();
+    std::cout << "liboqs version: " << oqs::oqs_version() << '\n';
+    std::cout << "liboqs-cpp version: " << oqs::oqs_cpp_version() << '\n';
+    std::cout << "NUMA nodes: " << host.num_nodes() << ", " << seconds
+              << " s per measurement\n\n";
+    std::cout << std::left << std::setw(32) << "ALG" << std::setw(8) << "MODE"
+              << std::right << std::setw(6) << "NODES" << std::setw(6)
+              << "NODE" << std::setw(6) << "T" << std::setw(14)
+              << "sign/s" << std::setw(14) << "total" << std::setw(10)
+              << "speedup" << '\n';
+    std::cout << std::fixed;
+
+    for (auto&& sig_name : oqs::Sigs::get_enabled_sigs()) {
+        if (!bench::matches(sig_name, filters))
+            continue;
+        for (auto&& mode : modes)
+            scale(sig_name, mode, host, threads_per_node, seconds);
+    }
+}
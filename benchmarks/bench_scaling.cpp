@@ -0,0 +1,196 @@
+// Multi-thread scaling benchmark
+//
+// Measures KEM (encaps + decaps) and signature (sign + verify) throughput from
+// 1 thread up to all cores, in three handle modes:
+//   shared - every thread uses the same KeyEncapsulation/Signature object
+//   copy   - every thread uses its own copy, all copies share the underlying
+//            OQS_KEM/OQS_SIG (shared_ptr) and the secret key buffer
+//   own    - every thread constructs its own handle and key pair
+// Reports throughput, speedup and parallel efficiency relative to 1 thread in
+// the same mode, and cache misses per operation where perf_event_open is
+// available.
+//
+// Usage: bench_scaling [--alg ML-KEM,ML-DSA,...] [--threads 1,2,4]
+//                      [--seconds 0.5] [--mode shared,copy,own]
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "bench_common.hpp"
+
+// liboqs C++ wrapper
+#include "oqs_cpp.hpp"
+
+using Op = std::function<void()>;
+
+struct Result {
+    double ops_per_second;
+    double misses_per_op;
+};
+
+// Runs ops[i] in a loop on thread i for the given duration
+static Result measure(std::vector<Op>& ops, double seconds) {
+    std::atomic<bool> go{false};
+    std::atomic<bool> stop{false};
+    std::vector<std::uint64_t> counts(ops.size(), 0);
+    std::vector<std::thread> thread_pool;
+    bench::PerfCounter misses{bench::PerfEvent::CacheMisses};
+
+    misses.start();
+    for (std::size_t i = 0; i < ops.size(); ++i)
+        thread_pool.emplace_back([&, i] {
+            while (!go.load(std::memory_order_acquire))
+                std::this_thread::yield();
+            std::uint64_t count = 0;
+            while (!stop.load(std::memory_order_relaxed)) {
+                ops[i]();
+                ++count;
+            }
+            counts[i] = count;
+        });
+    oqs::Timer<> wall;
+    go.store(true, std::memory_order_release);
+    std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+    stop.store(true);
+    for (auto&& elem : thread_pool)
+        elem.join();
+    wall.toc();
+    std::uint64_t num_misses = misses.stop();
+
+    std::uint64_t total = 0;
+    for (auto&& elem : counts)
+        total += elem;
+    Result result{};
+    result.ops_per_second = static_cast<double>(total) / wall.tics();
+    result.misses_per_op =
+        !misses.available() || total == 0
+            ? -1
+            : static_cast<double>(num_misses) / static_cast<double>(total);
+    return result;
+}
+
+// One KEM encaps + decaps on handle, with per-thread buffers
+static Op kem_op(const oqs::KeyEncapsulation& kem, const oqs::bytes& pk) {
+    auto ct = std::make_shared<oqs::bytes>();
+    auto ss = std::make_shared<oqs::bytes>();
+    auto ss_decap = std::make_shared<oqs::bytes>();
+    return [&kem, &pk, ct, ss, ss_decap] {
+        kem.encap_secret(pk, *ct, *ss);
+        kem.decap_secret(*ct, *ss_decap);
+    };
+}
+
+// One sign + verify on handle, with per-thread buffers
+static Op sig_op(const oqs::Signature& signer, const oqs::bytes& pk) {
+    auto msg = std::make_shared<oqs::bytes>(64, 0x5a);
+    auto sig = std::make_shared<oqs::bytes>();
+    return [&signer, &pk, msg, sig] {
+        signer.sign(*msg, *sig);
+        if (!signer.verify(*msg, *sig, pk))
+            throw std::runtime_error("Signature verification failed");
+    };
+}
+
+// Builds the per-thread operations for a given mode and runs them
+template <class Handle, class MakeOp>
+static void scale(const std::string& alg_name, const std::string& mode,
+                  const std::vector<std::size_t>& levels, double seconds,
+                  MakeOp make_op) {
+    Handle shared{alg_name};
+    oqs::bytes shared_pk = shared.generate_keypair();
+    double baseline = 0;
+
+    for (std::size_t n : levels) {
+        std::vector<Handle> handles;
+        std::vector<oqs::bytes> pks;
+        handles.reserve(n);
+        pks.reserve(n);
+        for (std::size_t i = 0; i < n; ++i) {
+            if (mode == "own") {
+                handles.emplace_back(alg_name);
+                pks.emplace_back(handles.back().generate_keypair());
+            } else if (mode == "copy") {
+                handles.emplace_back(shared);
+                pks.emplace_back(shared_pk);
+            }
+        }
+        std::vector<Op> ops;
+        for (std::size_t i = 0; i < n; ++i)
+            ops.emplace_back(mode == "shared" ? make_op(shared, shared_pk)
+                                              : make_op(handles[i], pks[i]));
+        for (auto&& op : ops) // warm-up
+            op();
+
+        Result result = measure(ops, seconds);
+        if (n == levels.front())
+            baseline = result.ops_per_second / static_cast<double>(n);
+        double speedup = result.ops_per_second / baseline;
+
+        std::cout << std::left << std::setw(32) << alg_name << std::setw(8)
+                  << mode << std::right << std::setw(6) << n
+                  << std::setprecision(1) << std::setw(14)
+                  << result.ops_per_second << std::setprecision(2)
+                  << std::setw(10) << speedup << std::setw(10)
+                  << speedup / static_cast<double>(n);
+        if (result.misses_per_op < 0)
+            std::cout << std::setw(14) << "n/a";
+        else
+            std::cout << std::setprecision(1) << std::setw(14)
+                      << result.misses_per_op;
+        std::cout << std::endl;
+    }
+}
+
+int main(int argc, char** argv) {
+    bench::Args args{argc, argv};
+    std::vector<std::string> filters = bench::split(args.get("--alg", ""));
+    std::vector<std::string> modes =
+        bench::split(args.get("--mode", "shared,copy,own"));
+    double seconds = args.get_number("--seconds", 0.5);
+    std::vector<std::size_t> levels;
+    for (auto&& level : bench::split(args.get("--threads", "")))
+        levels.emplace_back(std::stoul(level));
+    for (auto&& mode : modes)
+        if (mode != "shared" && mode != "copy" && mode != "own")
+            throw std::invalid_argument("Unknown mode " + mode);
+    if (levels.empty()) {
+        std::size_t max_threads = std::thread::hardware_concurrency();
+        for (std::size_t n = 1; n < max_threads; n *= 2)
+            levels.emplace_back(n);
+        levels.emplace_back(max_threads == 0 ? 1 : max_threads);
+    }
+
+    std::cout << "liboqs version: " << oqs::oqs_version() << '\n';
+    std::cout << "liboqs-cpp version: " << oqs::oqs_cpp_version() << '\n';
+    std::cout << "Hardware threads: " << std::thread::hardware_concurrency()
+              << ", " << seconds << " s per measurement\n";
+    std::cout << "KEM op = encaps + decaps, signature op = sign + verify\n\n";
+    std::cout << std::left << std::setw(32) << "ALG" << std::setw(8) << "MODE"
+              << std::right << std::setw(6) << "T" << std::setw(14) << "ops/s"
+              << std::setw(10) << "speedup" << std::setw(10) << "eff"
+              << std::setw(14) << "misses/op" << '\n';
+    std::cout << std::fixed;
+
+    for (auto&& kem_name : oqs::KEMs::get_enabled_KEMs()) {
+        if (!bench::matches(kem_name, filters))
+            continue;
+        for (auto&& mode : modes)
+            scale<oqs::KeyEncapsulation>(kem_name, mode, levels, seconds,
+                                         kem_op);
+    }
+    for (auto&& sig_name : oqs::Sigs::get_enabled_sigs()) {
+        if (!bench::matches(sig_name, filters))
+            continue;
+        for (auto&& mode : modes)
+            scale<oqs::Signature>(sig_name, mode, levels, seconds, sig_op);
+    }
+}
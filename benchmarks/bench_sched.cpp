@@ -0,0 +1,222 @@
+// Verify latency under bulk load benchmark
+//
+// Keeps the worker threads saturated with bulk work (signing with a slow
+// algorithm, e.g. SLH-DSA/SPHINCS+, or key generation) while issuing
+// verifications at a fixed rate, and reports the verify latency percentiles
+// (from submission to completion) in two modes:
+//   fifo  - a plain FIFO oqs::async::WorkerPool, verifies queue behind bulk
+//   sched - oqs::sched::Scheduler, verifies as Interactive with an optional
+//           deadline, bulk work as Bulk
+//
+// Usage: bench_sched [--verify ML-DSA-65] [--bulk SPHINCS+-SHA2-128f-simple]
+//                    [--bulk-op sign|keypair] [--threads N] [--rate 200]
+//                    [--seconds 2] [--deadline-ms 0] [--mode fifo,sched]
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "bench_common.hpp"
+
+// liboqs C++ wrapper
+#include "oqs_cpp.hpp"
+
+#include "async/async.hpp"
+#include "sched/sched.hpp"
+
+using Clock = oqs::sched::Clock;
+// Queues a bulk or verify job, may throw oqs::sched::DeadlineExceeded
+using Submit =
+    std::function<std::future<void>(bool bulk, std::function<void()> job)>;
+
+struct Result {
+    std::vector<double> latencies; // verify latencies, in seconds
+    std::uint64_t rejected;        // verifies rejected or shed
+    double bulk_per_second;        // completed bulk operations
+};
+
+// Saturates the workers with bulk jobs and verifies at the given rate
+static Result run(const Submit& submit, std::size_t threads, double rate,
+                  double seconds, const std::function<void()>& bulk_op,
+                  const std::function<void()>& verify_op) {
+    std::mutex mutex;
+    Result result{{}, 0, 0};
+    std::atomic<std::size_t> in_flight{0};
+    std::atomic<std::uint64_t> bulk_done{0};
+    std::atomic<bool> stop{false};
+
+    std::thread feeder{[&] {
+        while (!stop) {
+            while (in_flight < 2 * threads) {
+                ++in_flight;
+                submit(true, [&] {
+                    bulk_op();
+                    ++bulk_done;
+                    --in_flight;
+                });
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }};
+
+    auto interval = std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(1 / rate));
+    Clock::time_point start = Clock::now();
+    Clock::time_point end =
+        start + std::chrono::duration_cast<Clock::duration>(
+                    std::chrono::duration<double>(seconds));
+    std::vector<std::future<void>> verifies;
+    for (Clock::time_point next = start; next < end; next += interval) {
+        std::this_thread::sleep_until(next);
+        Clock::time_point submitted = Clock::now();
+        try {
+            verifies.emplace_back(submit(false, [&, submitted] {
+                verify_op();
+                std::lock_guard<std::mutex> lock{mutex};
+                result.latencies.emplace_back(
+                    std::chrono::duration<double>(Clock::now() - submitted)
+                        .count());
+            }));
+        } catch (const oqs::sched::DeadlineExceeded&) {
+            ++result.rejected;
+        }
+    }
+    double elapsed =
+        std::chrono::duration<double>(Clock::now() - start).count();
+    result.bulk_per_second = static_cast<double>(bulk_done) / elapsed;
+    stop = true;
+    feeder.join();
+    for (auto&& elem : verifies) {
+        try {
+            elem.get();
+        } catch (const oqs::sched::DeadlineExceeded&) {
+            ++result.rejected; // shed
+        }
+    }
+    while (in_flight > 0)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    return result;
+}
+
+int main(int argc, char** argv) {
+    bench::Args args{argc, argv};
+    std::string verify_alg = args.get("--verify", "ML-DSA-65");
+    std::string bulk_alg = args.get("--bulk", "SPHINCS+-SHA2-128f-simple");
+    std::string bulk_kind = args.get("--bulk-op", "sign");
+    double rate = args.get_number("--rate", 200);
+    double seconds = args.get_number("--seconds", 2);
+    double deadline_ms = args.get_number("--deadline-ms", 0);
+    std::vector<std::string> modes =
+        bench::split(args.get("--mode", "fifo,sched"));
+    std::size_t threads = static_cast<std::size_t>(args.get_number(
+        "--threads", std::max(1u, std::thread::hardware_concurrency())));
+    if (bulk_kind != "sign" && bulk_kind != "keypair")
+        throw std::invalid_argument("Unknown bulk operation " + bulk_kind);
+
+    oqs::Signature verifier{verify_alg};
+    oqs::bytes public_key = verifier.generate_keypair();
+    oqs::bytes message(64, 0x5a);
+    oqs::bytes signature = verifier.sign(message);
+    auto verify_op = [&] {
+        if (!verifier.verify(message, signature, public_key))
+            throw std::runtime_error("Signature verification failed");
+    };
+    oqs::Signature bulk_signer{bulk_alg};
+    bulk_signer.generate_keypair();
+    oqs::sched::Operation bulk_op_id = bulk_kind == "sign"
+                                           ? oqs::sched::Operation::Sign
+                                           : oqs::sched::Operation::Keypair;
+    auto bulk_op = [&] {
+        if (bulk_kind == "sign")
+            bulk_signer.sign(message);
+        else
+            oqs::Signature{bulk_alg}.generate_keypair();
+    };
+
+    std::cout << "liboqs version: " << oqs::oqs_version() << '\n';
+    std::cout << "liboqs-cpp version: " << oqs::oqs_cpp_version() << '\n';
+    std::cout << "Verify " << verify_alg << " at " << rate << "/s, bulk "
+              << bulk_alg << ' ' << bulk_kind << ", " << threads
+              << " thread(s), " << seconds << " s per mode\n\n";
+    std::cout << std::left << std::setw(8) << "MODE" << std::right
+              << std::setw(10) << "verifies" << std::setw(10) << "rejected"
+              << std::setw(12) << "p50 [us]" << std::setw(12) << "p99 [us]"
+              << std::setw(12) << "max [us]" << std::setw(10) << "bulk/s"
+              << '\n';
+    std::cout << std::fixed;
+
+    for (auto&& mode : modes) {
+        Result result{{}, 0, 0};
+        if (mode == "fifo") {
+            oqs::async::WorkerPool pool{threads};
+            result = run(
+                [&pool](bool, std::function<void()> job) {
+                    auto task =
+                        std::make_shared<std::packaged_task<void()>>(job);
+                    pool.post([task] { (*task)(); });
+                    return task->get_future();
+                },
+                threads, rate, seconds, bulk_op, verify_op);
+        } else if (mode == "sched") {
+            // Seeded with one measurement of each operation
+            oqs::sched::CostModel costs;
+            auto seed = [&costs](const std::string& alg,
+                                 oqs::sched::Operation op,
+                                 const std::function<void()>& fn) {
+                oqs::Timer<> timer;
+                fn();
+                timer.toc();
+                costs.set(alg, op, timer.tics());
+            };
+            seed(bulk_alg, bulk_op_id, bulk_op);
+            seed(verify_alg, oqs::sched::Operation::Verify, verify_op);
+            oqs::sched::SchedulerOptions options;
+            options.num_threads = threads;
+            oqs::sched::Scheduler scheduler{costs, options};
+            auto deadline = std::chrono::duration_cast<Clock::duration>(
+                std::chrono::duration<double>(deadline_ms * 1e-3));
+            result = run(
+                [&](bool bulk, std::function<void()> job) {
+                    using oqs::sched::Priority;
+                    Clock::time_point until =
+                        bulk || deadline_ms <= 0
+                            ? Clock::time_point::max()
+                            : Clock::now() + deadline;
+                    return scheduler.submit(
+                        oqs::sched::Request{
+                            bulk ? bulk_alg : verify_alg,
+                            bulk ? bulk_op_id : oqs::sched::Operation::Verify,
+                            bulk ? Priority::Bulk : Priority::Interactive,
+                            until},
+                        job);
+                },
+                threads, rate, seconds, bulk_op, verify_op);
+        } else {
+            throw std::invalid_argument("Unknown mode " + mode);
+        }
+
+        std::sort(result.latencies.begin(), result.latencies.end());
+        std::cout << std::left << std::setw(8) << mode << std::right
+                  << std::setw(10) << result.latencies.size() << std::setw(10)
+                  << result.rejected << std::setprecision(1) << std::setw(12)
+                  << bench::percentile(result.latencies, 50) * 1e6
+                  << std::setw(12)
+                  << bench::percentile(result.latencies, 99) * 1e6
+                  << std::setw(12)
+                  << (result.latencies.empty() ? 0
+                                               : result.latencies.back()) *
+                         1e6
+                  << std::setw(10) << result.bulk_per_second << std::endl;
+    }
+}
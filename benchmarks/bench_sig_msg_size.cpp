@@ -0,0 +1,221 @@
+// Message-size sweep benchmark for sign/verify
+//
+// For every enabled signature scheme, sweeps the message length from 0 B up to
+// --max-bytes (1 GiB by default, x16 steps) and measures sign and verify
+// throughput in four modes:
+//   mem          - sign/verify the whole in-memory message
+//   file         - read the message from a file, then sign/verify it
+//   prehash      - sign/verify the 64-byte SHAKE256 digest of the message
+//   file-prehash - stream the file through SHAKE256, sign/verify the digest
+// and reports, per scheme, the message length from which pre-hashing becomes
+// faster than signing the message directly (the crossover point).
+//
+// Note: liboqs exposes no HashML-DSA/HashSLH-DSA API, hence "prehash" is the
+// wrapper-level SHAKE256 pre-hash, not the FIPS 204/205 pre-hash variants.
+// The file is read through the page cache, i.e., the "file" modes measure
+// warm reads.
+//
+// Usage: bench_sig_msg_size [--sig ML-DSA,SPHINCS,...] [--max-bytes 1073741824]
+//                           [--seconds 0.2] [--dir /tmp]
+
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+#include "bench_common.hpp"
+
+// liboqs C++ wrapper
+#include "oqs_cpp.hpp"
+#include "rand/rand.hpp"
+#include "sha3/sha3.hpp"
+
+static const char* modes[] = {"mem", "file", "prehash", "file-prehash"};
+constexpr std::size_t num_modes = sizeof(modes) / sizeof(modes[0]);
+constexpr std::size_t digest_length = 64;
+constexpr std::size_t read_chunk = 1 << 20;
+
+// Average seconds per call of f, repeated for at least min_seconds
+static double time_per_op(const std::function<void()>& f, double min_seconds) {
+    std::size_t iterations = 0;
+    oqs::Timer<> t;
+    do {
+        f();
+        ++iterations;
+        t.toc();
+    } while (t.tics() < min_seconds);
+    return t.tics() / static_cast<double>(iterations);
+}
+
+// Reads the first len bytes of path into buf
+static void read_file(const std::string& path, std::size_t len,
+                      oqs::bytes& buf) {
+    std::ifstream in{path, std::ios::binary};
+    buf.resize(len);
+    if (!in.read(reinterpret_cast<char*>(buf.data()),
+                 static_cast<std::streamsize>(len)))
+        throw std::runtime_error("Can not read " + path);
+}
+
+// SHAKE256 digest of the first len bytes of path, read in chunks
+static void hash_file(const std::string& path, std::size_t len,
+                      oqs::bytes& chunk, oqs::bytes& digest) {
+    std::ifstream in{path, std::ios::binary};
+    oqs::sha3::SHAKE256 shake;
+    chunk.resize(read_chunk);
+    while (len > 0) {
+        std::size_t n = len < read_chunk ? len : read_chunk;
+        if (!in.read(reinterpret_cast<char*>(chunk.data()),
+                     static_cast<std::streamsize>(n)))
+            throw std::runtime_error("Can not read " + path);
+        shake.absorb(chunk.data(), n);
+        len -= n;
+    }
+    digest.resize(digest_length);
+    shake.finalize().squeeze(digest.data(), digest_length);
+}
+
+static void prehash(const oqs::bytes& message, std::size_t len,
+                    oqs::bytes& digest) {
+    oqs::sha3::SHAKE256 shake;
+    digest.resize(digest_length);
+    shake.absorb(message.data(), len).finalize().squeeze(digest.data(),
+                                                         digest_length);
+}
+
+static std::string format_size(std::size_t len) {
+    if (len >= (1u << 30) && len % (1u << 30) == 0)
+        return std::to_string(len >> 30) + " GiB";
+    if (len >= (1u << 20) && len % (1u << 20) == 0)
+        return std::to_string(len >> 20) + " MiB";
+    if (len >= (1u << 10) && len % (1u << 10) == 0)
+        return std::to_string(len >> 10) + " KiB";
+    return std::to_string(len) + " B";
+}
+
+int main(int argc, char** argv) {
+    bench::Args args{argc, argv};
+    std::vector<std::string> filters = bench::split(args.get("--sig", ""));
+    std::size_t max_bytes = static_cast<std::size_t>(
+        args.get_number("--max-bytes", static_cast<double>(1u << 30)));
+    double seconds = args.get_number("--seconds", 0.2);
+    std::string path = args.get("--dir", "/tmp") + "/bench_sig_XXXXXX";
+
+    std::vector<std::size_t> sizes{0};
+    for (std::size_t len = 64; len <= max_bytes; len *= 16)
+        sizes.emplace_back(len);
+
+    // Random message, also written to a temporary file
+    oqs::bytes message = oqs::rand::randombytes(max_bytes);
+    std::vector<char> file_name(path.begin(), path.end());
+    file_name.emplace_back('\0');
+    int fd = mkstemp(file_name.data());
+    if (fd < 0)
+        throw std::runtime_error("Can not create a file in " + path);
+    path = file_name.data();
+    std::size_t written = 0;
+    while (written < max_bytes) {
+        ssize_t n = write(fd, message.data() + written, max_bytes - written);
+        if (n <= 0)
+            throw std::runtime_error("Can not write " + path);
+        written += static_cast<std::size_t>(n);
+    }
+    close(fd);
+
+    std::cout << "liboqs version: " << oqs::oqs_version() << '\n';
+    std::cout << "liboqs-cpp version: " << oqs::oqs_cpp_version() << '\n';
+    std::cout << "Throughput in MB/s (message bytes per second), latency in "
+                 "microseconds\n\n";
+    std::cout << std::left << std::setw(32) << "SIG" << std::setw(14)
+              << "MODE" << std::right << std::setw(10) << "SIZE"
+              << std::setw(14) << "sign (us)" << std::setw(12) << "sign MB/s"
+              << std::setw(14) << "verify (us)" << std::setw(12)
+              << "verify MB/s" << '\n';
+    std::cout << std::fixed;
+
+    for (auto&& sig_name : oqs::Sigs::get_enabled_sigs()) {
+        if (!bench::matches(sig_name, filters))
+            continue;
+        oqs::Signature signer{sig_name};
+        oqs::bytes public_key = signer.generate_keypair();
+        oqs::bytes msg, digest, chunk, signature;
+        // sign/verify times per size, per mode
+        std::vector<std::vector<double>> sign_time(num_modes),
+            verify_time(num_modes);
+
+        for (std::size_t len : sizes) {
+            oqs::bytes prefix(message.begin(),
+                              message.begin() +
+                                  static_cast<std::ptrdiff_t>(len));
+            for (std::size_t mode = 0; mode < num_modes; ++mode) {
+                std::function<const oqs::bytes&()> input;
+                switch (mode) {
+                    case 0:
+                        input = [&]() -> const oqs::bytes& { return prefix; };
+                        break;
+                    case 1:
+                        input = [&]() -> const oqs::bytes& {
+                            read_file(path, len, msg);
+                            return msg;
+                        };
+                        break;
+                    case 2:
+                        input = [&]() -> const oqs::bytes& {
+                            prehash(message, len, digest);
+                            return digest;
+                        };
+                        break;
+                    default:
+                        input = [&]() -> const oqs::bytes& {
+                            hash_file(path, len, chunk, digest);
+                            return digest;
+                        };
+                        break;
+                }
+                signer.sign(input(), signature);
+                double t_sign = time_per_op(
+                    [&] { signer.sign(input(), signature); }, seconds);
+                double t_verify = time_per_op(
+                    [&] {
+                        if (!signer.verify(input(), signature, public_key))
+                            throw std::runtime_error("Verification failed");
+                    },
+                    seconds);
+                sign_time[mode].emplace_back(t_sign);
+                verify_time[mode].emplace_back(t_verify);
+
+                double mb = static_cast<double>(len) / 1e6;
+                std::cout << std::left << std::setw(32) << sig_name
+                          << std::setw(14) << modes[mode] << std::right
+                          << std::setw(10) << format_size(len)
+                          << std::setprecision(1) << std::setw(14)
+                          << 1e6 * t_sign << std::setw(12) << mb / t_sign
+                          << std::setw(14) << 1e6 * t_verify << std::setw(12)
+                          << mb / t_verify << std::endl;
+            }
+        }
+
+        // Crossover: smallest size from which pre-hashing stays faster
+        auto crossover = [&](const std::vector<std::vector<double>>& times,
+                             std::size_t direct, std::size_t hashed) {
+            std::size_t idx = sizes.size();
+            while (idx > 0 && times[hashed][idx - 1] < times[direct][idx - 1])
+                --idx;
+            return idx == sizes.size() ? std::string{"never"}
+                                       : format_size(sizes[idx]);
+        };
+        std::cout << "  " << sig_name << " pre-hash faster from: sign "
+                  << crossover(sign_time, 0, 2) << ", verify "
+                  << crossover(verify_time, 0, 2) << " (in memory); sign "
+                  << crossover(sign_time, 1, 3) << ", verify "
+                  << crossover(verify_time, 1, 3) << " (file)\n\n";
+    }
+    std::remove(path.c_str());
+}
@@ -0,0 +1,102 @@
+// Tree hash pre-hashing throughput benchmark
+//
+// Hashes an in-memory buffer with
+//   stream  - one sequential SHAKE256 pass (oqs::sha3::SHAKE256)
+//   tree    - oqs::treehash::root() with the 1-lane SHAKE256, one thread
+//   tree-x4 - oqs::treehash::root() with the 4-lane SHAKE256, one thread
+//   tree-mt - oqs::treehash::root() with the 4-lane SHAKE256, --threads
+//             threads
+// and reports the throughput of each mode, then the time to sign and to
+// verify the tree hash root with --alg.
+//
+// Usage: bench_treehash [--mib 256] [--leaf-kib 1024] [--threads N]
+//                       [--alg ML-DSA-65] [--mode stream,tree,tree-x4,tree-mt]
+
+#include <algorithm>
+#include <cstddef>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "bench_common.hpp"
+
+// liboqs C++ wrapper
+#include "oqs_cpp.hpp"
+
+#include "sha3/sha3.hpp"
+#include "treehash/treehash.hpp"
+
+int main(int argc, char** argv) {
+    bench::Args args{argc, argv};
+    std::size_t mib = static_cast<std::size_t>(args.get_number("--mib", 256));
+    std::size_t leaf_kib =
+        static_cast<std::size_t>(args.get_number("--leaf-kib", 1024));
+    std::size_t threads = static_cast<std::size_t>(args.get_number(
+        "--threads", std::max(1u, std::thread::hardware_concurrency())));
+    std::string alg = args.get("--alg", "ML-DSA-65");
+    std::vector<std::string> modes =
+        bench::split(args.get("--mode", "stream,tree,tree-x4,tree-mt"));
+    if (leaf_kib == 0)
+        throw std::invalid_argument("--leaf-kib must be at least 1");
+
+    oqs::bytes data(mib << 20);
+    for (std::size_t i = 0; i < data.size(); ++i)
+        data[i] = static_cast<oqs::byte>(i * 31 + (i >> 12));
+
+    std::cout << "liboqs version: " << oqs::oqs_version() << '\n';
+    std::cout << "liboqs-cpp version: " << oqs::oqs_cpp_version() << '\n';
+    std::cout << mib << " MiB input, " << leaf_kib << " KiB leaves, "
+              << threads << " thread(s)\n\n";
+    std::cout << std::left << std::setw(10) << "MODE" << std::right
+              << std::setw(10) << "threads" << std::setw(12) << "MiB/s"
+              << std::setw(12) << "time [ms]" << '\n';
+    std::cout << std::fixed << std::setprecision(1);
+
+    oqs::treehash::Options options;
+    options.leaf_size = leaf_kib << 10;
+    for (auto&& mode : modes) {
+        std::size_t mode_threads = 1;
+        oqs::Timer<> timer;
+        if (mode == "stream") {
+            oqs::sha3::SHAKE256 xof;
+            xof.absorb(data).finalize().squeeze(oqs::treehash::digest_length);
+        } else if (mode == "tree" || mode == "tree-x4" || mode == "tree-mt") {
+            oqs::treehash::Options mode_options = options;
+            mode_options.use_x4 = mode != "tree";
+            mode_threads = mode == "tree-mt" ? threads : 1;
+            mode_options.num_threads = mode_threads;
+            oqs::treehash::root(data, mode_options);
+        } else {
+            throw std::invalid_argument("Unknown mode " + mode);
+        }
+        timer.toc();
+        std::cout << std::left << std::setw(10) << mode << std::right
+                  << std::setw(10) << mode_threads << std::setw(12)
+                  << static_cast<double>(mib) / timer.tics() << std::setw(12)
+                  << timer.tics() * 1e3 << std::endl;
+    }
+
+    oqs::Signature signer{alg};
+    if (!signer.get_details().sig_with_ctx_support) {
+        std::cout << '\n' << alg << " does not support context strings\n";
+        return 0;
+    }
+    oqs::bytes public_key = signer.generate_keypair();
+    options.num_threads = threads;
+    oqs::Timer<> sign_timer;
+    oqs::bytes signature =
+        oqs::treehash::sign(signer, data.data(), data.size(), options);
+    sign_timer.toc();
+    oqs::Timer<> verify_timer;
+    bool valid = oqs::treehash::verify(signer, data.data(), data.size(),
+                                       signature, public_key, options);
+    verify_timer.toc();
+    if (!valid)
+        throw std::runtime_error("Signature verification failed");
+    std::cout << '\n'
+              << alg << " tree hash sign " << sign_timer.tics() * 1e3
+              << " ms, verify " << verify_timer.tics() * 1e3 << " ms\n";
+}
@@ -0,0 +1,217 @@
+// Wrapper-overhead differential benchmark
+//
+// Runs every KEM (construct, keypair, encaps, decaps) and signature
+// (construct, keypair, sign, verify) operation
+//   raw      - through direct OQS_KEM_*/OQS_SIG_* calls on preallocated buffers
+//   wrapper  - through the value-returning oqs::KeyEncapsulation/oqs::Signature
+//              member functions (and the string-based constructor)
+//   in-place - through the in-place overloads reusing caller buffers
+// and reports the absolute and relative overhead of both wrapper flavours, and
+// the number of C++ heap allocations per call (allocations made inside liboqs
+// are not counted, they are common to all modes). Each mode is measured in
+// --rounds interleaved rounds and the fastest round is kept, to reduce drift.
+//
+// Usage: bench_wrapper_overhead [--alg ML-KEM-512,...] [--seconds 0.1]
+//                               [--rounds 3]
+
+#include <atomic>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "bench_common.hpp"
+
+// liboqs C++ wrapper
+#include "oqs_cpp.hpp"
+
+// Count C++ heap allocations
+static std::atomic<std::size_t> num_allocs{0};
+
+void* operator new(std::size_t size) {
+    num_allocs.fetch_add(1, std::memory_order_relaxed);
+    void* p = std::malloc(size == 0 ? 1 : size);
+    if (p == nullptr)
+        throw std::bad_alloc{};
+    return p;
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+struct Measurement {
+    double seconds = 0;  // per call
+    double allocs = 0;   // per call
+};
+
+// Time and C++ allocations per call of f, repeated for at least min_seconds
+static Measurement measure_once(const std::function<void()>& f,
+                                double min_seconds) {
+    std::size_t iterations = 0;
+    std::size_t allocs_before = num_allocs.load();
+    oqs::Timer<> t;
+    do {
+        f();
+        ++iterations;
+        t.toc();
+    } while (t.tics() < min_seconds);
+    Measurement m;
+    m.seconds = t.tics() / static_cast<double>(iterations);
+    m.allocs = static_cast<double>(num_allocs.load() - allocs_before) /
+               static_cast<double>(iterations);
+    return m;
+}
+
+// Interleaves the modes over rounds, keeps the fastest round of each mode
+static std::vector<Measurement>
+measure(const std::vector<std::function<void()>>& modes, std::size_t rounds,
+        double min_seconds) {
+    std::vector<Measurement> best(modes.size());
+    for (std::size_t r = 0; r < rounds; ++r)
+        for (std::size_t i = 0; i < modes.size(); ++i) {
+            Measurement m = measure_once(modes[i], min_seconds);
+            if (r == 0 || m.seconds < best[i].seconds)
+                best[i] = m;
+        }
+    return best;
+}
+
+static void report(const std::string& alg, const std::string& op,
+                   const std::vector<Measurement>& m) {
+    const double raw = m[0].seconds;
+    std::cout << std::left << std::setw(32) << alg << std::setw(10) << op
+              << std::right << std::setprecision(2) << std::setw(11)
+              << 1e6 * raw;
+    for (std::size_t i = 1; i < m.size(); ++i)
+        std::cout << std::setw(11) << 1e6 * m[i].seconds << std::setw(10)
+                  << 1e6 * (m[i].seconds - raw) << std::setprecision(1)
+                  << std::setw(8) << 100 * (m[i].seconds - raw) / raw << "%"
+                  << std::setw(8) << m[i].allocs << std::setprecision(2);
+    if (m.size() == 2) // no in-place flavour
+        std::cout << std::setw(11) << "-" << std::setw(10) << "-"
+                  << std::setw(9) << "-" << std::setw(8) << "-";
+    std::cout << std::endl;
+}
+
+static void bench_kem(const std::string& name, std::size_t rounds,
+                      double seconds) {
+    using namespace oqs::C;
+    OQS_KEM* kem = OQS_KEM_new(name.c_str());
+    oqs::bytes pk(kem->length_public_key), sk(kem->length_secret_key),
+        ct(kem->length_ciphertext), ss(kem->length_shared_secret);
+    OQS_KEM_keypair(kem, pk.data(), sk.data());
+    OQS_KEM_encaps(kem, ct.data(), ss.data(), pk.data());
+
+    oqs::KeyEncapsulation client{name};
+    oqs::KeyEncapsulation server{name, sk};
+    oqs::bytes public_key, ciphertext, shared_secret;
+    oqs::KeyEncapsulation keygen{name};
+
+    report(name, "construct",
+           measure({[&] { OQS_KEM_free(OQS_KEM_new(name.c_str())); },
+                    [&] { oqs::KeyEncapsulation tmp{name}; }},
+                   rounds, seconds));
+    report(name, "keypair",
+           measure({[&] { OQS_KEM_keypair(kem, pk.data(), sk.data()); },
+                    [&] { public_key = keygen.generate_keypair(); },
+                    [&] { keygen.generate_keypair(public_key); }},
+                   rounds, seconds));
+    report(name, "encaps",
+           measure({[&] {
+                        OQS_KEM_encaps(kem, ct.data(), ss.data(), pk.data());
+                    },
+                    [&] { ciphertext = client.encap_secret(pk).first; },
+                    [&] {
+                        client.encap_secret(pk, ciphertext, shared_secret);
+                    }},
+                   rounds, seconds));
+    report(name, "decaps",
+           measure({[&] {
+                        OQS_KEM_decaps(kem, ss.data(), ct.data(), sk.data());
+                    },
+                    [&] { shared_secret = server.decap_secret(ct); },
+                    [&] { server.decap_secret(ct, shared_secret); }},
+                   rounds, seconds));
+    OQS_KEM_free(kem);
+}
+
+static void bench_sig(const std::string& name, std::size_t rounds,
+                      double seconds) {
+    using namespace oqs::C;
+    OQS_SIG* sig = OQS_SIG_new(name.c_str());
+    oqs::bytes pk(sig->length_public_key), sk(sig->length_secret_key),
+        raw_sig(sig->length_signature), message(64, 0x5a);
+    std::size_t sig_len = 0;
+    OQS_SIG_keypair(sig, pk.data(), sk.data());
+    OQS_SIG_sign(sig, raw_sig.data(), &sig_len, message.data(),
+                 message.size(), sk.data());
+
+    oqs::Signature signer{name, sk};
+    oqs::bytes public_key, signature;
+    oqs::bytes verified(raw_sig.begin(),
+                        raw_sig.begin() + static_cast<std::ptrdiff_t>(sig_len));
+    oqs::Signature keygen{name};
+
+    report(name, "construct",
+           measure({[&] { OQS_SIG_free(OQS_SIG_new(name.c_str())); },
+                    [&] { oqs::Signature tmp{name}; }},
+                   rounds, seconds));
+    report(name, "keypair",
+           measure({[&] { OQS_SIG_keypair(sig, pk.data(), sk.data()); },
+                    [&] { public_key = keygen.generate_keypair(); },
+                    [&] { keygen.generate_keypair(public_key); }},
+                   rounds, seconds));
+    report(name, "sign",
+           measure({[&] {
+                        OQS_SIG_sign(sig, raw_sig.data(), &sig_len,
+                                     message.data(), message.size(),
+                                     sk.data());
+                    },
+                    [&] { signature = signer.sign(message); },
+                    [&] { signer.sign(message, signature); }},
+                   rounds, seconds));
+    // verify has no in-place flavour, it does not produce output
+    report(name, "verify",
+           measure({[&] {
+                        OQS_SIG_verify(sig, message.data(), message.size(),
+                                       verified.data(), verified.size(),
+                                       pk.data());
+                    },
+                    [&] { signer.verify(message, verified, pk); }},
+                   rounds, seconds));
+    OQS_SIG_free(sig);
+}
+
+int main(int argc, char** argv) {
+    bench::Args args{argc, argv};
+    std::vector<std::string> filters = bench::split(args.get("--alg", ""));
+    double seconds = args.get_number("--seconds", 0.1);
+    std::size_t rounds =
+        static_cast<std::size_t>(args.get_number("--rounds", 3));
+    if (rounds == 0)
+        throw std::invalid_argument("At least 1 round is required");
+
+    std::cout << "liboqs version: " << oqs::oqs_version() << '\n';
+    std::cout << "liboqs-cpp version: " << oqs::oqs_cpp_version() << '\n';
+    std::cout << "Times in microseconds per call, overhead relative to raw, "
+                 "C++ allocations per call\n\n";
+    std::cout << std::left << std::setw(32) << "ALG" << std::setw(10) << "OP"
+              << std::right << std::setw(11) << "raw" << std::setw(11)
+              << "wrapper" << std::setw(10) << "+us" << std::setw(9) << "+%"
+              << std::setw(8) << "allocs" << std::setw(11) << "in-place"
+              << std::setw(10) << "+us" << std::setw(9) << "+%"
+              << std::setw(8) << "allocs" << '\n';
+    std::cout << std::fixed;
+
+    for (auto&& kem_name : oqs::KEMs::get_enabled_KEMs())
+        if (bench::matches(kem_name, filters))
+            bench_kem(kem_name, rounds, seconds);
+    for (auto&& sig_name : oqs::Sigs::get_enabled_sigs())
+        if (bench::matches(sig_name, filters))
+            bench_sig(sig_name, rounds, seconds);
+}
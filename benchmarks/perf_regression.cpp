@@ -0,0 +1,284 @@
+// Performance regression gate
+//
+// Runs a short benchmark of every enabled KEM (keypair, encaps, decaps) and
+// signature (keypair, sign, verify), as a number of timed batches per
+// operation, and compares the mean time per operation against a baseline JSON
+// file with Welch's t-test. Fails (exit code 1) when the lower bound of the
+// confidence interval of the slowdown exceeds --threshold, i.e., when an
+// operation is slower by a statistically significant and relevant amount.
+// Operations flagged as slower are re-measured up to --retries times and the
+// fastest measurement is kept, so that transient machine noise does not fail
+// the gate.
+//
+// A missing baseline is recorded and the run passes; --update-baseline
+// overwrites it. The baseline is only meaningful on the machine (and build
+// type) that recorded it.
+//
+// Usage: perf_regression --baseline perf_baseline.json [--alg ML-KEM,...]
+//                        [--batches 10] [--batch-ms 20] [--threshold 0.05]
+//                        [--confidence 0.99] [--retries 2]
+//                        [--update-baseline]
+
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+#include "bench_common.hpp"
+
+// liboqs C++ wrapper
+#include "oqs_cpp.hpp"
+
+struct Stats {
+    std::size_t n = 0;
+    double mean = 0;
+    double stddev = 0;
+};
+
+// Sample mean and standard deviation of the per-batch seconds per operation
+static Stats measure(const std::function<void()>& op, std::size_t batches,
+                     double batch_seconds) {
+    std::vector<double> samples;
+    for (std::size_t b = 0; b <= batches; ++b) {
+        std::size_t iterations = 0;
+        oqs::Timer<> t;
+        do {
+            op();
+            ++iterations;
+            t.toc();
+        } while (t.tics() < batch_seconds);
+        if (b > 0) // the first batch is a warm-up
+            samples.emplace_back(t.tics() / static_cast<double>(iterations));
+    }
+    Stats stats;
+    stats.n = samples.size();
+    for (double x : samples)
+        stats.mean += x;
+    stats.mean /= static_cast<double>(stats.n);
+    for (double x : samples)
+        stats.stddev += (x - stats.mean) * (x - stats.mean);
+    stats.stddev = std::sqrt(stats.stddev / static_cast<double>(stats.n - 1));
+    return stats;
+}
+
+// Two-sided standard normal quantile z, P(|Z| > z) = 1 - confidence
+static double normal_quantile(double confidence) {
+    double lo = 0, hi = 10;
+    for (int i = 0; i < 100; ++i) {
+        double mid = (lo + hi) / 2;
+        if (std::erfc(mid / std::sqrt(2.0)) > 1 - confidence)
+            lo = mid;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+// Student's t quantile, Cornish-Fisher expansion around the normal quantile
+static double t_quantile(double confidence, double df) {
+    double z = normal_quantile(confidence);
+    double z3 = z * z * z, z5 = z3 * z * z;
+    return z + (z3 + z) / (4 * df) +
+           (5 * z5 + 16 * z3 + 3 * z) / (96 * df * df);
+}
+
+// Welch's confidence interval of (now - base) / base.mean
+static std::pair<double, double> relative_ci(const Stats& base,
+                                             const Stats& now,
+                                             double confidence) {
+    double va = base.stddev * base.stddev / static_cast<double>(base.n);
+    double vb = now.stddev * now.stddev / static_cast<double>(now.n);
+    double se = std::sqrt(va + vb);
+    double df = se == 0 ? 1e9
+                        : (va + vb) * (va + vb) /
+                              (va * va / static_cast<double>(base.n - 1) +
+                               vb * vb / static_cast<double>(now.n - 1));
+    double margin = t_quantile(confidence, df) * se;
+    double diff = now.mean - base.mean;
+    return {(diff - margin) / base.mean, (diff + margin) / base.mean};
+}
+
+// Baseline file, one entry per line as written by save_baseline()
+static std::map<std::string, Stats> load_baseline(const std::string& path) {
+    std::map<std::string, Stats> baseline;
+    std::ifstream in{path};
+    std::string line;
+    while (std::getline(in, line)) {
+        std::size_t name = line.find("\"name\": \"");
+        if (name == std::string::npos)
+            continue;
+        name += 9;
+        std::string key = line.substr(name, line.find('"', name) - name);
+        auto number = [&line](const std::string& field) {
+            std::size_t pos = line.find("\"" + field + "\": ");
+            if (pos == std::string::npos)
+                throw std::runtime_error("Malformed baseline entry: " + line);
+            return std::stod(line.substr(pos + field.size() + 4));
+        };
+        Stats stats;
+        stats.n = static_cast<std::size_t>(number("n"));
+        stats.mean = number("mean");
+        stats.stddev = number("stddev");
+        baseline[key] = stats;
+    }
+    return baseline;
+}
+
+static void save_baseline(const std::string& path,
+                          const std::map<std::string, Stats>& results) {
+    std::ostringstream json;
+    json << std::setprecision(9) << "{\n  \"liboqs\": \"" << oqs::oqs_version()
+         << "\",\n  \"liboqs-cpp\": \"" << oqs::oqs_cpp_version()
+         << "\",\n  \"entries\": [\n";
+    std::size_t i = 0;
+    for (auto&& elem : results)
+        json << "    {\"name\": \"" << elem.first
+             << "\", \"n\": " << elem.second.n
+             << ", \"mean\": " << elem.second.mean
+             << ", \"stddev\": " << elem.second.stddev << "}"
+             << (++i < results.size() ? ",\n" : "\n");
+    json << "  ]\n}\n";
+    std::ofstream out{path};
+    if (!(out << json.str()))
+        throw std::runtime_error("Can not write " + path);
+}
+
+int main(int argc, char** argv) {
+    bench::Args args{argc, argv};
+    std::string baseline_path = args.get("--baseline", "perf_baseline.json");
+    std::vector<std::string> filters = bench::split(args.get("--alg", ""));
+    std::size_t batches =
+        static_cast<std::size_t>(args.get_number("--batches", 10));
+    double batch_seconds = args.get_number("--batch-ms", 20) / 1000;
+    double threshold = args.get_number("--threshold", 0.05);
+    double confidence = args.get_number("--confidence", 0.99);
+    std::size_t retries =
+        static_cast<std::size_t>(args.get_number("--retries", 2));
+    bool update = args.has("--update-baseline");
+    if (batches < 2)
+        throw std::invalid_argument("At least 2 batches are required");
+
+#ifdef __linux__
+    // Pin to the current CPU to reduce migration noise
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    int cpu = sched_getcpu();
+    if (cpu >= 0) {
+        CPU_SET(cpu, &cpus);
+        sched_setaffinity(0, sizeof(cpus), &cpus);
+    }
+#endif
+
+    std::map<std::string, Stats> baseline;
+    if (!update)
+        baseline = load_baseline(baseline_path);
+
+    // Benchmark
+    std::map<std::string, Stats> results;
+    auto run = [&](const std::string& name, const std::function<void()>& op) {
+        Stats now = measure(op, batches, batch_seconds);
+        auto it = baseline.find(name);
+        for (std::size_t i = 0; i < retries && it != baseline.end() &&
+                                relative_ci(it->second, now, confidence)
+                                        .first > threshold;
+             ++i) {
+            Stats again = measure(op, batches, batch_seconds);
+            if (again.mean < now.mean)
+                now = again;
+        }
+        results[name] = now;
+    };
+    for (auto&& kem_name : oqs::KEMs::get_enabled_KEMs()) {
+        if (!bench::matches(kem_name, filters))
+            continue;
+        oqs::KeyEncapsulation kem{kem_name};
+        oqs::bytes public_key = kem.generate_keypair();
+        oqs::bytes ciphertext, shared_secret;
+        kem.encap_secret(public_key, ciphertext, shared_secret);
+        oqs::KeyEncapsulation keygen{kem_name};
+        oqs::bytes scratch;
+        run(kem_name + "/keypair", [&] { keygen.generate_keypair(scratch); });
+        run(kem_name + "/encaps", [&] {
+            kem.encap_secret(public_key, ciphertext, shared_secret);
+        });
+        run(kem_name + "/decaps",
+            [&] { kem.decap_secret(ciphertext, shared_secret); });
+    }
+    for (auto&& sig_name : oqs::Sigs::get_enabled_sigs()) {
+        if (!bench::matches(sig_name, filters))
+            continue;
+        oqs::Signature signer{sig_name};
+        oqs::bytes public_key = signer.generate_keypair();
+        oqs::bytes message(64, 0x5a), signature;
+        signer.sign(message, signature);
+        oqs::Signature keygen{sig_name};
+        oqs::bytes scratch;
+        run(sig_name + "/keypair", [&] { keygen.generate_keypair(scratch); });
+        run(sig_name + "/sign", [&] { signer.sign(message, signature); });
+        run(sig_name + "/verify", [&] {
+            if (!signer.verify(message, signature, public_key))
+                throw std::runtime_error("Verification failed");
+        });
+    }
+
+    if (baseline.empty()) {
+        save_baseline(baseline_path, results);
+        std::cout << "Baseline (" << results.size() << " entries) written to "
+                  << baseline_path << '\n';
+        return 0;
+    }
+
+    // Compare
+    std::cout << "Baseline: " << baseline_path << ", " << 100 * confidence
+              << "% confidence, threshold " << 100 * threshold << "%\n\n";
+    std::cout << std::left << std::setw(40) << "OPERATION" << std::right
+              << std::setw(13) << "base (us)" << std::setw(13) << "now (us)"
+              << std::setw(10) << "change" << std::setw(22) << "CI"
+              << "  VERDICT\n";
+    std::cout << std::fixed;
+    std::size_t regressions = 0;
+    for (auto&& elem : results) {
+        const Stats& now = elem.second;
+        std::cout << std::left << std::setw(40) << elem.first << std::right;
+        auto it = baseline.find(elem.first);
+        if (it == baseline.end()) {
+            std::cout << std::setw(13) << "-" << std::setprecision(2)
+                      << std::setw(13) << 1e6 * now.mean << "  NEW\n";
+            continue;
+        }
+        const Stats& base = it->second;
+
+        double lo, hi;
+        std::tie(lo, hi) = relative_ci(base, now, confidence);
+        double diff = now.mean - base.mean;
+        bool regressed = lo > threshold;
+        regressions += regressed;
+
+        std::ostringstream ci;
+        ci << std::fixed << std::setprecision(1) << "[" << 100 * lo << "%, "
+           << 100 * hi << "%]";
+        std::cout << std::setprecision(2) << std::setw(13) << 1e6 * base.mean
+                  << std::setw(13) << 1e6 * now.mean << std::setprecision(1)
+                  << std::setw(9) << 100 * diff / base.mean << "%"
+                  << std::setw(22) << ci.str() << "  "
+                  << (regressed ? "REGRESSION"
+                                : (hi < -threshold ? "faster" : "ok"))
+                  << '\n';
+    }
+
+    std::cout << '\n' << regressions << " significant regression(s)\n";
+    return regressions == 0 ? 0 : 1;
+}
@@ -0,0 +1,36 @@
+# Benchmarks Source file(s) to be compiled, modify as needed
+aux_source_directory(${CMAKE_SOURCE_DIR}/benchmarks BENCHMARK_FILES)
+
+# Build all benchmarks in ${BENCHMARK_FILES}
+find_package(Threads REQUIRED)
+add_custom_target(benchmarks COMMENT "Benchmarks")
+foreach(file ${BENCHMARK_FILES})
+  get_filename_component(TARGET_NAME ${file} NAME_WE)
+  add_executable(${TARGET_NAME} EXCLUDE_FROM_ALL ${file})
+  add_dependencies(benchmarks ${TARGET_NAME})
+  target_link_libraries(${TARGET_NAME} PUBLIC liboqs-cpp oqs Threads::Threads)
+endforeach()
+
+# Performance regression gate, run by CTest as "perf_regression"
+option(LIBOQS_CPP_PERF_REGRESSION "Add the perf_regression CTest test" OFF)
+if(LIBOQS_CPP_PERF_REGRESSION)
+  set(LIBOQS_CPP_PERF_BASELINE
+      "${CMAKE_BINARY_DIR}/perf_baseline.json"
+      CACHE FILEPATH "Baseline JSON of the perf_regression test")
+  set(LIBOQS_CPP_PERF_ALGS
+      ""
+      CACHE STRING "Comma-separated algorithm filters, empty for all")
+  set(PERF_REGRESSION_ARGS --baseline "${LIBOQS_CPP_PERF_BASELINE}" --alg
+                           "${LIBOQS_CPP_PERF_ALGS}")
+  set_target_properties(perf_regression PROPERTIES EXCLUDE_FROM_ALL OFF)
+  add_test(NAME perf_regression COMMAND perf_regression
+                                        ${PERF_REGRESSION_ARGS})
+  set_tests_properties(perf_regression PROPERTIES LABELS perf RUN_SERIAL TRUE
+                                                  TIMEOUT 3600)
+  # Records (or overwrites) the baseline
+  add_custom_target(
+    perf_baseline
+    COMMAND perf_regression ${PERF_REGRESSION_ARGS} --update-baseline
+    DEPENDS perf_regression
+    COMMENT "Updating ${LIBOQS_CPP_PERF_BASELINE}")
+endif()
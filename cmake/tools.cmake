@@ -0,0 +1,11 @@
+# Command-line tools, installed into bin/
+find_package(Threads REQUIRED)
+set(TOOLS oqs-speed)
+if(NOT WIN32)
+  list(APPEND TOOLS oqs-cryptod oqs-filesign)
+endif()
+foreach(TOOL ${TOOLS})
+  add_executable(${TOOL} ${CMAKE_SOURCE_DIR}/tools/${TOOL}/${TOOL}.cpp)
+  target_link_libraries(${TOOL} PUBLIC liboqs-cpp oqs Threads::Threads)
+  install(TARGETS ${TOOL} RUNTIME DESTINATION bin)
+endforeach()
@@ -0,0 +1,107 @@
+/**
+ * \file aes/aes.hpp
+ * \brief Provides support for the AES-256 functions exported by liboqs
+ */
+
+#ifndef AES_AES_HPP_
+#define AES_AES_HPP_
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <stdexcept>
+
+#include "common.hpp"
+
+namespace oqs {
+namespace C {
+// everything in liboqs has C linkage
+extern "C" {
+#include <oqs/aes_ops.h>
+}
+} // namespace C
+
+/**
+ * \namespace aes
+ * \brief Namespace containing AES-related functions
+ */
+namespace aes {
+constexpr std::size_t key_length = 32;   ///< AES-256 key length
+constexpr std::size_t nonce_length = 12; ///< AES-256-CTR nonce length
+constexpr std::size_t block_length = 16; ///< AES block length
+
+/**
+ * \class oqs::aes::AES256_CTR
+ * \brief AES-256 in counter mode, owns the liboqs key schedule
+ *
+ * The 16-byte counter block is the 12-byte nonce followed by a 32-bit
+ * big-endian block counter starting at 0. The key schedule is read-only after
+ * construction, hence const member functions can be invoked concurrently
+ */
+class AES256_CTR {
+    void* schedule_ = nullptr; ///< liboqs key schedule
+
+  public:
+    /**
+     * \brief Constructs an instance and expands the key schedule
+     * \param key oqs::aes::key_length bytes key
+     */
+    explicit AES256_CTR(const byte* key) {
+        C::OQS_AES256_CTR_inc_init(key, &schedule_);
+    }
+
+    /**
+     * \brief Constructs an instance and expands the key schedule
+     * \param key oqs::aes::key_length bytes key
+     */
+    explicit AES256_CTR(const bytes& key) {
+        if (key.size() != key_length)
+            throw std::runtime_error("Incorrect AES-256 key length");
+        C::OQS_AES256_CTR_inc_init(key.data(), &schedule_);
+    }
+
+    AES256_CTR(const AES256_CTR&) = delete;
+
+    AES256_CTR& operator=(const AES256_CTR&) = delete;
+
+    /**
+     * \brief Frees (and zeroes) the key schedule
+     */
+    ~AES256_CTR() { C::OQS_AES256_free_schedule(schedule_); }
+
+    /**
+     * \brief Encrypts/decrypts \a len bytes of \a data in place, starting at
+     * block \a first_block of the key stream
+     * \param nonce oqs::aes::nonce_length bytes nonce
+     * \param first_block Index of the first key stream block
+     * \param data Data
+     * \param len Number of bytes
+     */
+    void crypt(const byte* nonce, std::uint32_t first_block, byte* data,
+               std::size_t len) const {
+        byte iv[block_length];
+        byte stream[4096];
+        std::copy(nonce, nonce + nonce_length, iv);
+        std::uint32_t counter = first_block;
+        while (len > 0) {
+            std::size_t n = len < sizeof(stream) ? len : sizeof(stream);
+            iv[12] = static_cast<byte>(counter >> 24);
+            iv[13] = static_cast<byte>(counter >> 16);
+            iv[14] = static_cast<byte>(counter >> 8);
+            iv[15] = static_cast<byte>(counter);
+            C::OQS_AES256_CTR_inc_stream_iv(iv, block_length, schedule_,
+                                            stream, n);
+            for (std::size_t i = 0; i < n; ++i)
+                data[i] ^= stream[i];
+            data += n;
+            len -= n;
+            counter += static_cast<std::uint32_t>(sizeof(stream) /
+                                                  block_length);
+        }
+        C::OQS_MEM_cleanse(stream, sizeof(stream));
+    }
+}; // class AES256_CTR
+} // namespace aes
+} // namespace oqs
+
+#endif // AES_AES_HPP_
@@ -0,0 +1,388 @@
+/**
+ * \file async/async.hpp
+ * \brief Offloading of blocking liboqs operations to background workers, and
+ * C++20 coroutine awaitables resuming on the caller's executor
+ *
+ * The awaitables (available when compiled as C++20 with coroutine support,
+ * see LIBOQS_CPP_HAS_COROUTINES) run the operation on a
+ * oqs::async::WorkerPool (or a oqs::numa::ShardedPool) and resume the awaiting coroutine by posting it to
+ * an executor, any object with a thread-safe post(std::function<void()>)
+ * member function, so that e.g. an epoll or io_uring loop is never blocked
+ *
+ *     oqs::async::WorkerPool pool;
+ *     oqs::async::QueueExecutor loop{[&] { wake_up_event_loop(); }};
+ *     ...
+ *     oqs::bytes signature =
+ *         co_await oqs::async::sign(signer, message, pool, loop);
+ *
+ * where the event loop calls loop.run_pending() whenever it is woken up.
+ */
+
+#ifndef ASYNC_ASYNC_HPP_
+#define ASYNC_ASYNC_HPP_
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#if __cplusplus >= 202002L && defined(__cpp_impl_coroutine)
+#if __has_include(<coroutine>)
+#include <coroutine>
+#include <optional>
+/**
+ * \brief Defined when the coroutine awaitables are available
+ */
+#define LIBOQS_CPP_HAS_COROUTINES 1
+#endif
+#endif
+
+#include "oqs_cpp.hpp"
+
+namespace oqs {
+/**
+ * \namespace async
+ * \brief Namespace containing the asynchronous API
+ */
+namespace async {
+/**
+ * \class oqs::async::OperationCancelled
+ * \brief Thrown when awaiting an operation that was cancelled
+ */
+class OperationCancelled : public std::runtime_error {
+  public:
+    OperationCancelled() : std::runtime_error{"Operation cancelled"} {}
+}; // class OperationCancelled
+
+/**
+ * \class oqs::async::CancellationToken
+ * \brief Observes the cancellation requested by a
+ * oqs::async::CancellationSource, a default-constructed token is never
+ * cancelled
+ */
+class CancellationToken {
+    friend class CancellationSource;
+    std::shared_ptr<std::atomic<bool>> flag_{};
+
+    explicit CancellationToken(std::shared_ptr<std::atomic<bool>> flag)
+        : flag_{std::move(flag)} {}
+
+  public:
+    /**
+     * \brief Constructs a token that is never cancelled
+     */
+    CancellationToken() = default;
+
+    /**
+     * \brief Whether the cancellation was requested
+     */
+    bool cancelled() const noexcept {
+        return flag_ && flag_->load(std::memory_order_acquire);
+    }
+}; // class CancellationToken
+
+/**
+ * \class oqs::async::CancellationSource
+ * \brief Requests the cancellation of the operations holding its tokens
+ */
+class CancellationSource {
+    std::shared_ptr<std::atomic<bool>> flag_ =
+        std::make_shared<std::atomic<bool>>(false);
+
+  public:
+    /**
+     * \brief Requests the cancellation, thread-safe
+     */
+    void cancel() noexcept { flag_->store(true, std::memory_order_release); }
+
+    /**
+     * \brief Token observing this source
+     */
+    CancellationToken token() const { return CancellationToken{flag_}; }
+}; // class CancellationSource
+
+/**
+ * \class oqs::async::WorkerPool
+ * \brief Fixed-size pool of background threads running posted jobs in FIFO
+ * order
+ */
+class WorkerPool {
+    std::vector<std::thread> threads_{};
+    std::deque<std::function<void()>> jobs_{};
+    std::mutex mutex_{};
+    std::condition_variable cv_{};
+    bool stop_ = false;
+
+    void work() {
+        for (;;) {
+            std::function<void()> job;
+            {
+                std::unique_lock<std::mutex> lock{mutex_};
+                cv_.wait(lock, [this] { return stop_ || !jobs_.empty(); });
+                if (jobs_.empty())
+                    return; // stopped and drained
+                job = std::move(jobs_.front());
+                jobs_.pop_front();
+            }
+            job();
+        }
+    }
+
+  public:
+    /**
+     * \brief Starts the worker threads
+     * \param num_threads Number of threads, 0 means
+     * std::thread::hardware_concurrency()
+     */
+    explicit WorkerPool(std::size_t num_threads = 0) {
+        if (num_threads == 0)
+            num_threads = std::max(1u, std::thread::hardware_concurrency());
+        for (std::size_t i = 0; i < num_threads; ++i)
+            threads_.emplace_back([this] { work(); });
+    }
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    /**
+     * \brief Runs the jobs still queued, then joins the worker threads
+     */
+    ~WorkerPool() {
+        {
+            std::lock_guard<std::mutex> lock{mutex_};
+            stop_ = true;
+        }
+        cv_.notify_all();
+        for (auto&& thread : threads_)
+            thread.join();
+    }
+
+    /**
+     * \brief Queues a job, thread-safe
+     * \param job Job, must not throw
+     */
+    void post(std::function<void()> job) {
+        {
+            std::lock_guard<std::mutex> lock{mutex_};
+            jobs_.emplace_back(std::move(job));
+        }
+        cv_.notify_one();
+    }
+
+    /**
+     * \brief Number of worker threads
+     */
+    std::size_t size() const noexcept { return threads_.size(); }
+}; // class WorkerPool
+
+/**
+ * \class oqs::async::QueueExecutor
+ * \brief Executor for single-threaded event loops: post() queues the job
+ * from any thread and invokes the notification callback (e.g. writing to an
+ * eventfd watched by the loop), the loop runs the jobs with run_pending()
+ */
+class QueueExecutor {
+    std::deque<std::function<void()>> jobs_{};
+    std::mutex mutex_{};
+    std::function<void()> notify_;
+
+  public:
+    /**
+     * \brief Constructor
+     * \param notify Invoked (on the posting thread) after each post(), may be
+     * empty
+     */
+    explicit QueueExecutor(std::function<void()> notify = {})
+        : notify_{std::move(notify)} {}
+
+    QueueExecutor(const QueueExecutor&) = delete;
+    QueueExecutor& operator=(const QueueExecutor&) = delete;
+
+    /**
+     * \brief Queues a job, thread-safe
+     * \param job Job
+     */
+    void post(std::function<void()> job) {
+        {
+            std::lock_guard<std::mutex> lock{mutex_};
+            jobs_.emplace_back(std::move(job));
+        }
+        if (notify_)
+            notify_();
+    }
+
+    /**
+     * \brief Runs the queued jobs (including those they post) on the calling
+     * thread
+     * \return Number of jobs run
+     */
+    std::size_t run_pending() {
+        std::size_t count = 0;
+        for (;;) {
+            std::function<void()> job;
+            {
+                std::lock_guard<std::mutex> lock{mutex_};
+                if (jobs_.empty())
+                    return count;
+                job = std::move(jobs_.front());
+                jobs_.pop_front();
+            }
+            job();
+            ++count;
+        }
+    }
+}; // class QueueExecutor
+
+#ifdef LIBOQS_CPP_HAS_COROUTINES
+/**
+ * \class oqs::async::Awaitable
+ * \brief Runs an operation on a oqs::async::WorkerPool when awaited, and
+ * resumes the awaiting coroutine by posting it to \a Executor
+ *
+ * Cancellation is checked before the operation starts and after it finishes
+ * (a running liboqs call can not be interrupted); in both cases awaiting
+ * throws oqs::async::OperationCancelled. The coroutine is always resumed
+ * exactly once, on the executor.
+ *
+ * \tparam T Result type
+ * \tparam Executor Type with a thread-safe post(std::function<void()>)
+ * \tparam Pool Pool type with the same post(), e.g.
+ * oqs::async::WorkerPool or oqs::numa::ShardedPool
+ */
+template <typename T, typename Executor, typename Pool = WorkerPool>
+class Awaitable {
+    std::function<T()> op_;
+    Pool& pool_;
+    Executor& executor_;
+    CancellationToken token_;
+    std::optional<T> result_{};
+    std::exception_ptr error_{};
+
+  public:
+    /**
+     * \brief Constructor
+     * \param op Blocking operation
+     * \param pool Pool running the operation
+     * \param executor Executor resuming the awaiting coroutine
+     * \param token Cancellation token
+     */
+    Awaitable(std::function<T()> op, Pool& pool, Executor& executor,
+              CancellationToken token)
+        : op_{std::move(op)}, pool_{pool}, executor_{executor},
+          token_{std::move(token)} {}
+
+    bool await_ready() const noexcept { return false; }
+
+    void await_suspend(std::coroutine_handle<> handle) {
+        pool_.post([this, handle] {
+            if (!token_.cancelled()) {
+                try {
+                    result_.emplace(op_());
+                } catch (...) {
+                    error_ = std::current_exception();
+                }
+            }
+            if (!error_ && token_.cancelled())
+                error_ = std::make_exception_ptr(OperationCancelled{});
+            executor_.post([handle] { handle.resume(); });
+        });
+    }
+
+    T await_resume() {
+        if (error_)
+            std::rethrow_exception(error_);
+        return std::move(*result_);
+    }
+}; // class Awaitable
+
+// The wrapper objects are used from the worker thread, they must outlive the
+// co_await and must not be used concurrently. Inputs are copied.
+
+/**
+ * \brief Awaitable oqs::KeyEncapsulation::generate_keypair()
+ * \return Awaitable yielding the public key
+ */
+template <typename Executor, typename Pool>
+Awaitable<bytes, Executor, Pool>
+generate_keypair(KeyEncapsulation& kem, Pool& pool, Executor& executor,
+                 CancellationToken token = {}) {
+    return {[&kem] { return kem.generate_keypair(); }, pool, executor,
+            std::move(token)};
+}
+
+/**
+ * \brief Awaitable oqs::KeyEncapsulation::encap_secret()
+ * \return Awaitable yielding the ciphertext and the shared secret
+ */
+template <typename Executor, typename Pool>
+Awaitable<std::pair<bytes, bytes>, Executor, Pool>
+encap_secret(KeyEncapsulation& kem, bytes public_key, Pool& pool,
+             Executor& executor, CancellationToken token = {}) {
+    return {[&kem, public_key] { return kem.encap_secret(public_key); }, pool,
+            executor, std::move(token)};
+}
+
+/**
+ * \brief Awaitable oqs::KeyEncapsulation::decap_secret()
+ * \return Awaitable yielding the shared secret
+ */
+template <typename Executor, typename Pool>
+Awaitable<bytes, Executor, Pool>
+decap_secret(KeyEncapsulation& kem, bytes ciphertext, Pool& pool,
+             Executor& executor, CancellationToken token = {}) {
+    return {[&kem, ciphertext] { return kem.decap_secret(ciphertext); }, pool,
+            executor, std::move(token)};
+}
+
+/**
+ * \brief Awaitable oqs::Signature::generate_keypair()
+ * \return Awaitable yielding the public key
+ */
+template <typename Executor, typename Pool>
+Awaitable<bytes, Executor, Pool>
+generate_keypair(Signature& sig, Pool& pool, Executor& executor,
+                 CancellationToken token = {}) {
+    return {[&sig] { return sig.generate_keypair(); }, pool, executor,
+            std::move(token)};
+}
+
+/**
+ * \brief Awaitable oqs::Signature::sign()
+ * \return Awaitable yielding the signature
+ */
+template <typename Executor, typename Pool>
+Awaitable<bytes, Executor, Pool> sign(Signature& sig, bytes message,
+                                      Pool& pool, Executor& executor,
+                                      CancellationToken token = {}) {
+    return {[&sig, message] { return sig.sign(message); }, pool, executor,
+            std::move(token)};
+}
+
+/**
+ * \brief Awaitable oqs::Signature::verify()
+ * \return Awaitable yielding whether the signature is valid
+ */
+template <typename Executor, typename Pool>
+Awaitable<bool, Executor, Pool> verify(Signature& sig, bytes message,
+                                       bytes signature, bytes public_key,
+                                       Pool& pool, Executor& executor,
+                                       CancellationToken token = {}) {
+    return {[&sig, message, signature, public_key] {
+                return sig.verify(message, signature, public_key);
+            },
+            pool, executor, std::move(token)};
+}
+#endif // LIBOQS_CPP_HAS_COROUTINES
+} // namespace async
+} // namespace oqs
+
+#endif // ASYNC_ASYNC_HPP_
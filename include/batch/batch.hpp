@@ -0,0 +1,274 @@
+/**
+ * \file batch/batch.hpp
+ * \brief Batch verification of signatures under mixed algorithms and keys
+ *
+ * A batch is reordered before it is verified: items are sorted (stably) by
+ * algorithm, then by public key, and the runs of equal algorithm and key are
+ * cut into groups of at most max_group items. The worker threads take the
+ * groups in that order, so each thread keeps running the same algorithm's
+ * code over the same key for many items in a row instead of alternating
+ * between, e.g., ML-DSA, Falcon and SLH-DSA on every item, and resolves the
+ * algorithm's oqs::Signature handle once per group from a cache shared by
+ * all batches. Results are returned in the original order.
+ */
+
+#ifndef BATCH_BATCH_HPP_
+#define BATCH_BATCH_HPP_
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "async/async.hpp"
+#include "oqs_cpp.hpp"
+
+namespace oqs {
+/**
+ * \namespace batch
+ * \brief Namespace containing the mixed-algorithm batch verifier
+ */
+namespace batch {
+/**
+ * \brief Outcome of verifying one item
+ */
+enum class Status {
+    Valid,      ///< signature is valid
+    Invalid,    ///< signature is invalid
+    Malformed,  ///< wrong public key or signature length
+    Unsupported ///< algorithm not supported or not enabled
+};
+
+/**
+ * \brief Name of a status
+ */
+inline const char* status_name(Status status) {
+    switch (status) {
+        case Status::Valid:
+            return "valid";
+        case Status::Invalid:
+            return "invalid";
+        case Status::Malformed:
+            return "malformed";
+        case Status::Unsupported:
+            return "unsupported";
+    }
+    return "unknown";
+}
+
+/**
+ * \brief One signature to verify
+ */
+struct Item {
+    std::string alg_name; ///< signature algorithm
+    bytes public_key;     ///< signer's public key
+    bytes message;        ///< signed message
+    bytes signature;      ///< signature
+    bytes context;        ///< context string, empty for none
+};
+
+/**
+ * \brief Range [begin, end) of a batch order sharing algorithm and key
+ */
+struct Group {
+    std::size_t begin; ///< first position in the order
+    std::size_t end;   ///< one past the last position
+};
+
+namespace internal {
+/**
+ * \brief Indices of the items sorted by algorithm, then public key, equal
+ * items keeping their original order
+ */
+inline std::vector<std::size_t> order(const std::vector<Item>& items) {
+    std::vector<std::size_t> result(items.size());
+    for (std::size_t i = 0; i < result.size(); ++i)
+        result[i] = i;
+    std::stable_sort(result.begin(), result.end(),
+                     [&items](std::size_t lhs, std::size_t rhs) {
+                         const Item& a = items[lhs];
+                         const Item& b = items[rhs];
+                         if (a.alg_name != b.alg_name)
+                             return a.alg_name < b.alg_name;
+                         return a.public_key < b.public_key;
+                     });
+    return result;
+}
+
+/**
+ * \brief Runs of equal algorithm and public key in \a order, the runs
+ * longer than \a max_group cut into groups of at most \a max_group items
+ */
+inline std::vector<Group> groups(const std::vector<Item>& items,
+                                 const std::vector<std::size_t>& order,
+                                 std::size_t max_group) {
+    std::vector<Group> result;
+    std::size_t begin = 0;
+    for (std::size_t i = 1; i <= order.size(); ++i) {
+        if (i < order.size() && i - begin < max_group) {
+            const Item& first = items[order[begin]];
+            const Item& current = items[order[i]];
+            if (current.alg_name == first.alg_name &&
+                current.public_key == first.public_key)
+                continue;
+        }
+        result.push_back(Group{begin, i});
+        begin = i;
+    }
+    return result;
+}
+} // namespace internal
+
+/**
+ * \class oqs::batch::HandleCache
+ * \brief Thread-safe cache of one oqs::Signature verification handle per
+ * algorithm
+ */
+class HandleCache {
+    std::mutex mutex_{};
+    std::map<std::string, std::unique_ptr<const Signature>> handles_{};
+
+  public:
+    /**
+     * \brief Handle of an algorithm, created on first use; verifying with it
+     * from several threads at once is safe
+     * \param alg_name Signature algorithm
+     * \return Handle, or nullptr if the algorithm is not supported or not
+     * enabled (also cached)
+     */
+    const Signature* get(const std::string& alg_name) {
+        std::lock_guard<std::mutex> lock{mutex_};
+        auto it = handles_.find(alg_name);
+        if (it != handles_.end())
+            return it->second.get();
+        std::unique_ptr<const Signature> handle;
+        try {
+            handle.reset(new Signature{alg_name});
+        } catch (const MechanismNotSupportedError&) {
+        } catch (const MechanismNotEnabledError&) {
+        }
+        return (handles_[alg_name] = std::move(handle)).get();
+    }
+
+    /**
+     * \brief Number of cached algorithms
+     */
+    std::size_t size() {
+        std::lock_guard<std::mutex> lock{mutex_};
+        return handles_.size();
+    }
+}; // class HandleCache
+
+/**
+ * \class oqs::batch::Verifier
+ * \brief Verifies heterogeneous batches of signatures in parallel, grouped
+ * by algorithm and public key
+ */
+class Verifier {
+    async::WorkerPool pool_;
+    HandleCache handles_{};
+    std::size_t max_group_;
+
+    static Status verify_one(const Signature* handle, const Item& item) {
+        if (handle == nullptr)
+            return Status::Unsupported;
+        try {
+            bool valid = item.context.empty()
+                             ? handle->verify(item.message, item.signature,
+                                              item.public_key)
+                             : handle->verify_with_ctx_str(
+                                   item.message, item.signature, item.context,
+                                   item.public_key);
+            return valid ? Status::Valid : Status::Invalid;
+        } catch (const std::runtime_error&) {
+            return Status::Malformed;
+        }
+    }
+
+  public:
+    /**
+     * \brief Starts the worker threads
+     * \param num_threads Number of threads, 0 means
+     * std::thread::hardware_concurrency()
+     * \param max_group Largest number of items a thread verifies in one go,
+     * bounds the imbalance between threads on batches dominated by one key
+     */
+    explicit Verifier(std::size_t num_threads = 0, std::size_t max_group = 64)
+        : pool_{num_threads}, max_group_{max_group} {
+        if (max_group_ == 0)
+            throw std::invalid_argument("max_group must be at least 1");
+    }
+
+    Verifier(const Verifier&) = delete;
+    Verifier& operator=(const Verifier&) = delete;
+
+    /**
+     * \brief Verifies a batch, thread-safe; blocks until done
+     * \param items Items, of any algorithms and keys
+     * \return One status per item, in the order of \a items
+     */
+    std::vector<Status> verify(const std::vector<Item>& items) {
+        std::vector<Status> results(items.size(), Status::Invalid);
+        std::vector<std::size_t> order = internal::order(items);
+        std::vector<Group> groups =
+            internal::groups(items, order, max_group_);
+
+        std::atomic<std::size_t> next{0};
+        auto run = [&] {
+            const std::string* alg_name = nullptr;
+            const Signature* handle = nullptr;
+            for (;;) {
+                std::size_t g = next++;
+                if (g >= groups.size())
+                    return;
+                const std::string& group_alg =
+                    items[order[groups[g].begin]].alg_name;
+                if (alg_name == nullptr || *alg_name != group_alg) {
+                    alg_name = &group_alg;
+                    handle = handles_.get(group_alg);
+                }
+                for (std::size_t i = groups[g].begin; i < groups[g].end; ++i)
+                    results[order[i]] = verify_one(handle, items[order[i]]);
+            }
+        };
+        std::size_t runners = std::min(pool_.size(), groups.size());
+        if (runners <= 1) {
+            run();
+            return results;
+        }
+
+        std::mutex mutex;
+        std::condition_variable cv;
+        std::size_t running = runners;
+        for (std::size_t i = 0; i < runners; ++i)
+            pool_.post([&] {
+                run();
+                std::lock_guard<std::mutex> lock{mutex};
+                if (--running == 0)
+                    cv.notify_one();
+            });
+        std::unique_lock<std::mutex> lock{mutex};
+        cv.wait(lock, [&running] { return running == 0; });
+        return results;
+    }
+
+    /**
+     * \brief Handle cache shared by all batches
+     */
+    HandleCache& handles() noexcept { return handles_; }
+
+    /**
+     * \brief Number of worker threads
+     */
+    std::size_t size() const noexcept { return pool_.size(); }
+}; // class Verifier
+} // namespace batch
+} // namespace oqs
+
+#endif // BATCH_BATCH_HPP_
@@ -6,16 +6,28 @@
 #ifndef COMMON_HPP_
 #define COMMON_HPP_
 
+#include <algorithm>
 #include <chrono>
+#include <cmath>
 #include <cstdint>
 #include <cstdlib>
+#include <ctime>
+#include <exception>
 #include <iomanip>
+#include <mutex>
 #include <ostream>
 #include <sstream>
 #include <string>
+#include <thread>
 #include <utility>
 #include <vector>
 
+#if defined(_MSC_VER)
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
 namespace oqs {
 namespace C {
 // Everything in liboqs has C linkage
@@ -167,6 +179,65 @@ class HexChop {
         return os;
     }
 }; // class HexChop
+
+/**
+ * \brief Invokes \a f(i) for every i in [0, \a n), splitting the range into
+ * contiguous chunks processed by at most \a num_threads threads
+ * \note The calling thread processes the first chunk. Threads are spawned
+ * with the platform default stack size, which is 512Kb on macOS and is too
+ * small for some schemes (e.g., Classic McEliece)
+ * \note The first exception thrown by \a f is rethrown after all threads
+ * have been joined
+ * \tparam F Callable with signature void(std::size_t)
+ * \param n Number of iterations
+ * \param num_threads Maximum number of threads, 0 means
+ * std::thread::hardware_concurrency()
+ * \param f Callable
+ */
+template <typename F>
+void parallel_for(std::size_t n, std::size_t num_threads, F&& f) {
+    if (num_threads == 0)
+        num_threads = std::thread::hardware_concurrency();
+    if (num_threads == 0)
+        num_threads = 1;
+    if (num_threads > n)
+        num_threads = n;
+    if (num_threads <= 1) {
+        for (std::size_t i = 0; i < n; ++i)
+            f(i);
+        return;
+    }
+
+    std::exception_ptr first_exception = nullptr;
+    std::mutex mu;
+    auto run_chunk = [&](std::size_t begin, std::size_t end) {
+        try {
+            for (std::size_t i = begin; i < end; ++i)
+                f(i);
+        } catch (...) {
+            std::lock_guard<std::mutex> lg{mu};
+            if (!first_exception)
+                first_exception = std::current_exception();
+        }
+    };
+
+    std::size_t chunk = n / num_threads;
+    std::size_t remainder = n % num_threads;
+    std::vector<std::thread> thread_pool;
+    thread_pool.reserve(num_threads - 1);
+    std::size_t begin = chunk + (remainder > 0 ? 1 : 0);
+    for (std::size_t t = 1; t < num_threads; ++t) {
+        std::size_t end = begin + chunk + (t < remainder ? 1 : 0);
+        thread_pool.emplace_back(run_chunk, begin, end);
+        begin = end;
+    }
+    run_chunk(0, chunk + (remainder > 0 ? 1 : 0));
+    for (auto&& elem : thread_pool)
+        elem.join();
+
+    if (first_exception)
+        std::rethrow_exception(first_exception);
+}
 } // namespace internal
 
 /* code from
@@ -255,6 +326,345 @@ class Timer {
     }
 }; // class Timer
 
+/**
+ * \namespace clocks
+ * \brief Clocks usable as the CLOCK_T parameter of oqs::Timer and
+ * oqs::AccumulatingTimer
+ */
+namespace clocks {
+#if defined(__unix__) || defined(__APPLE__)
+/**
+ * \class oqs::clocks::thread_cpu_clock
+ * \brief CPU time consumed by the calling thread, i.e.,
+ * clock_gettime(CLOCK_THREAD_CPUTIME_ID), with a std::chrono clock interface
+ * \note Time points are only comparable within the same thread
+ */
+struct thread_cpu_clock {
+    using duration = std::chrono::nanoseconds;
+    using rep = duration::rep;
+    using period = duration::period;
+    using time_point = std::chrono::time_point<thread_cpu_clock>;
+    static constexpr bool is_steady = true;
+
+    static time_point now() noexcept {
+        timespec ts{};
+        clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+        return time_point{duration{static_cast<rep>(ts.tv_sec) * 1000000000 +
+                                   static_cast<rep>(ts.tv_nsec)}};
+    }
+};
+
+/**
+ * \class oqs::clocks::process_cpu_clock
+ * \brief CPU time consumed by all threads of the process, i.e.,
+ * clock_gettime(CLOCK_PROCESS_CPUTIME_ID), with a std::chrono clock interface
+ */
+struct process_cpu_clock {
+    using duration = std::chrono::nanoseconds;
+    using rep = duration::rep;
+    using period = duration::period;
+    using time_point = std::chrono::time_point<process_cpu_clock>;
+    static constexpr bool is_steady = true;
+
+    static time_point now() noexcept {
+        timespec ts{};
+        clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+        return time_point{duration{static_cast<rep>(ts.tv_sec) * 1000000000 +
+                                   static_cast<rep>(ts.tv_nsec)}};
+    }
+};
+#endif // defined(__unix__) || defined(__APPLE__)
+
+/**
+ * \class oqs::clocks::cycle_clock
+ * \brief Hardware cycle counter with a std::chrono clock interface: the time
+ * stamp counter (RDTSC) on x86, the virtual counter (CNTVCT_EL0) on AArch64,
+ * and std::chrono::steady_clock nanoseconds elsewhere
+ *
+ * One tick of cycle_clock::duration is one counter increment, hence use it
+ * as oqs::Timer<oqs::clocks::cycle_clock::duration, oqs::clocks::cycle_clock>
+ * so that tics() returns counts. The counter is not serializing and, on x86,
+ * runs at the nominal (not the current) frequency
+ */
+struct cycle_clock {
+    using rep = std::int64_t;
+    using period = std::ratio<1>;
+    using duration = std::chrono::duration<rep, period>;
+    using time_point = std::chrono::time_point<cycle_clock>;
+    static constexpr bool is_steady = true;
+
+    static time_point now() noexcept {
+#if defined(_MSC_VER) || defined(__x86_64__) || defined(__i386__)
+        return time_point{duration{static_cast<rep>(__rdtsc())}};
+#elif defined(__aarch64__)
+        std::uint64_t ticks;
+        __asm__ __volatile__("mrs %0, cntvct_el0" : "=r"(ticks));
+        return time_point{duration{static_cast<rep>(ticks)}};
+#else
+        return time_point{duration{static_cast<rep>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch())
+                .count())}};
+#endif
+    }
+};
+} // namespace clocks
+
+/**
+ * \class oqs::Histogram
+ * \brief Log-linear histogram of non-negative values, with exact count, min,
+ * mean and max, and percentiles within ~1.6% relative error
+ *
+ * Every power-of-two range in [2^-40, 2^40) is split into 32 equal buckets;
+ * smaller values fall in the first bucket and larger ones in the last.
+ * Recording is O(1) and does not allocate. Not thread safe: record into one
+ * histogram per thread, then merge()
+ */
+class Histogram {
+    enum : int {
+        min_exponent = -40,                          ///< smallest exponent
+        max_exponent = 40,                           ///< largest exponent
+        sub_buckets = 32,                            ///< buckets per octave
+        num_buckets = (max_exponent - min_exponent) * sub_buckets ///< total
+    };
+
+    std::vector<std::uint64_t> buckets_; ///< bucket counts
+    std::uint64_t count_ = 0;            ///< number of recorded values
+    double sum_ = 0;                     ///< sum of recorded values
+    double min_ = 0;                     ///< smallest recorded value
+    double max_ = 0;                     ///< largest recorded value
+
+    static std::size_t bucket(double value) noexcept {
+        if (!(value > 0))
+            return 0;
+        int exponent;
+        double mantissa = std::frexp(value, &exponent); // in [0.5, 1)
+        if (exponent < min_exponent)
+            return 0;
+        if (exponent >= max_exponent)
+            return num_buckets - 1;
+        return static_cast<std::size_t>(
+            (exponent - min_exponent) * sub_buckets +
+            static_cast<int>((mantissa - 0.5) * (2 * sub_buckets)));
+    }
+
+    // Midpoint of a bucket
+    static double midpoint(std::size_t idx) noexcept {
+        int exponent = static_cast<int>(idx) / sub_buckets + min_exponent;
+        int sub = static_cast<int>(idx) % sub_buckets;
+        return std::ldexp(0.5 + (sub + 0.5) / (2 * sub_buckets), exponent);
+    }
+
+  public:
+    /**
+     * \brief Constructs an empty histogram
+     */
+    Histogram() : buckets_(num_buckets, 0) {}
+
+    /**
+     * \brief Records a value
+     * \param value Value, negative values are recorded as 0
+     */
+    void record(double value) noexcept {
+        value = value > 0 ? value : 0;
+        ++buckets_[bucket(value)];
+        min_ = count_ == 0 ? value : std::min(min_, value);
+        max_ = count_ == 0 ? value : std::max(max_, value);
+        sum_ += value;
+        ++count_;
+    }
+
+    /**
+     * \brief Adds the values recorded by \a rhs
+     * \return Reference to the current instance
+     */
+    Histogram& merge(const Histogram& rhs) noexcept {
+        if (rhs.count_ == 0)
+            return *this;
+        for (std::size_t i = 0; i < buckets_.size(); ++i)
+            buckets_[i] += rhs.buckets_[i];
+        min_ = count_ == 0 ? rhs.min_ : std::min(min_, rhs.min_);
+        max_ = count_ == 0 ? rhs.max_ : std::max(max_, rhs.max_);
+        sum_ += rhs.sum_;
+        count_ += rhs.count_;
+        return *this;
+    }
+
+    /**
+     * \brief Forgets all recorded values
+     */
+    void reset() noexcept {
+        std::fill(buckets_.begin(), buckets_.end(), 0);
+        count_ = 0;
+        sum_ = min_ = max_ = 0;
+    }
+
+    /**
+     * \brief Number of recorded values
+     */
+    std::uint64_t count() const noexcept { return count_; }
+
+    /**
+     * \brief Smallest recorded value, 0 if empty
+     */
+    double min() const noexcept { return min_; }
+
+    /**
+     * \brief Largest recorded value, 0 if empty
+     */
+    double max() const noexcept { return max_; }
+
+    /**
+     * \brief Arithmetic mean of the recorded values, 0 if empty
+     */
+    double mean() const noexcept {
+        return count_ == 0 ? 0 : sum_ / static_cast<double>(count_);
+    }
+
+    /**
+     * \brief Nearest-rank percentile of the recorded values
+     * \param p Percentile in [0, 100]
+     * \return min() for p = 0, max() for p = 100, otherwise the midpoint of
+     * the bucket containing the percentile clamped to [min(), max()], 0 if
+     * empty
+     */
+    double percentile(double p) const noexcept {
+        if (count_ == 0)
+            return 0;
+        if (p <= 0)
+            return min_;
+        if (p >= 100)
+            return max_;
+        auto rank = static_cast<std::uint64_t>(
+            std::ceil(p / 100 * static_cast<double>(count_)));
+        rank = std::max<std::uint64_t>(rank, 1);
+        std::uint64_t seen = 0;
+        for (std::size_t i = 0; i < buckets_.size(); ++i) {
+            seen += buckets_[i];
+            if (seen >= rank) {
+                if (i == 0) // underflow bucket
+                    return min_;
+                if (i + 1 == buckets_.size()) // overflow bucket
+                    return max_;
+                return std::min(std::max(midpoint(i), min_), max_);
+            }
+        }
+        return max_;
+    }
+
+    friend std::ostream& operator<<(std::ostream& os, const Histogram& rhs) {
+        return os << "n=" << rhs.count() << " min=" << rhs.min()
+                  << " mean=" << rhs.mean() << " p50=" << rhs.percentile(50)
+                  << " p99=" << rhs.percentile(99) << " max=" << rhs.max();
+    }
+}; // class Histogram
+
+/**
+ * \class oqs::AccumulatingTimer
+ * \brief Timer that accumulates every measured interval into an
+ * oqs::Histogram
+ * \tparam T Tics duration, default is std::chrono::duration<double>,
+ * i.e. seconds in double precision
+ * \tparam CLOCK_T Clock's type, default is std::chrono::steady_clock, see
+ * also oqs::clocks
+ */
+template <typename T = std::chrono::duration<double>,
+          typename CLOCK_T = std::chrono::steady_clock>
+class AccumulatingTimer {
+    typename CLOCK_T::time_point start_;
+    Histogram histogram_;
+
+  public:
+    using clock_type = CLOCK_T; ///< clock
+    using duration = T;         ///< tics duration
+
+    /**
+     * \brief Constructs an instance with the current time as the start point
+     */
+    AccumulatingTimer() : start_{CLOCK_T::now()}, histogram_{} {}
+
+    /**
+     * \brief Starts an interval at the current time
+     * \return Reference to the current instance
+     */
+    AccumulatingTimer& tic() noexcept {
+        start_ = CLOCK_T::now();
+        return *this;
+    }
+
+    /**
+     * \brief Ends the interval started by tic() and records it
+     * \return Reference to the current instance
+     */
+    AccumulatingTimer& toc() noexcept {
+        record(CLOCK_T::now() - start_);
+        return *this;
+    }
+
+    /**
+     * \brief Records an interval
+     * \param interval Interval measured with CLOCK_T
+     */
+    void record(typename CLOCK_T::duration interval) noexcept {
+        histogram_.record(static_cast<double>(
+            std::chrono::duration_cast<T>(interval).count()));
+    }
+
+    /**
+     * \brief Recorded intervals, in tics of T
+     */
+    const Histogram& histogram() const noexcept { return histogram_; }
+
+    /**
+     * \brief Forgets all recorded intervals
+     */
+    void reset() noexcept { histogram_.reset(); }
+
+    friend std::ostream& operator<<(std::ostream& os,
+                                    const AccumulatingTimer& rhs) {
+        return os << rhs.histogram_;
+    }
+}; // class AccumulatingTimer
+
+/**
+ * \class oqs::ScopedSample
+ * \brief RAII sampler, records the lifetime of the instance into an
+ * oqs::AccumulatingTimer (or any type with a clock_type and a
+ * record(clock_type::duration) member function)
+ *
+ * Example:
+ * \code
+ * oqs::AccumulatingTimer<std::chrono::microseconds> sign_timer;
+ * {
+ *     oqs::ScopedSample<decltype(sign_timer)> sample{sign_timer};
+ *     signature = signer.sign(message);
+ * }
+ * std::cout << sign_timer << '\n';
+ * \endcode
+ */
+template <typename TIMER>
+class ScopedSample {
+    TIMER& timer_;
+    typename TIMER::clock_type::time_point start_;
+
+  public:
+    /**
+     * \brief Starts the sample
+     * \param timer Timer that records the sample on destruction
+     */
+    explicit ScopedSample(TIMER& timer) noexcept
+        : timer_(timer), start_{TIMER::clock_type::now()} {}
+
+    ScopedSample(const ScopedSample&) = delete;
+
+    ScopedSample& operator=(const ScopedSample&) = delete;
+
+    /**
+     * \brief Records the sample
+     */
+    ~ScopedSample() { timer_.record(TIMER::clock_type::now() - start_); }
+}; // class ScopedSample
+
 /**
  * \brief Constructs an instance of oqs::internal::HexChop
  * \param v Vector of bytes
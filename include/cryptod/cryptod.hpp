@@ -0,0 +1,445 @@
+/**
+ * \file cryptod/cryptod.hpp
+ * \brief Client of the local crypto daemon (oqs-cryptod) and its wire
+ * protocol, POSIX only
+ *
+ * The daemon holds the secret keys of a host and serves sign, verify, decap
+ * and public key requests over a Unix domain stream socket. Every message is
+ * a frame (all integers big-endian)
+ *
+ *     body length (4) | body
+ *
+ *     request body    op (1) | request id (4) | key id length (2) | key id |
+ *                     number of fields (2) | fields[]
+ *     response body   request id (4) | status (1) | number of fields (2) |
+ *                     fields[]
+ *     field           length (4) | data
+ *
+ * Requests may be pipelined on a connection; responses carry the request id
+ * and may arrive out of order, since the daemon processes requests in
+ * per-key batches on several worker threads.
+ */
+
+#ifndef CRYPTOD_CRYPTOD_HPP_
+#define CRYPTOD_CRYPTOD_HPP_
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "common.hpp"
+
+namespace oqs {
+/**
+ * \namespace cryptod
+ * \brief Namespace containing the crypto daemon client and protocol
+ */
+namespace cryptod {
+constexpr std::size_t max_frame_length = std::size_t{1} << 26; ///< 64 MiB
+
+/**
+ * \brief Request operation
+ */
+enum class Op : byte {
+    Sign = 1,     ///< fields: message; result: signature
+    Verify = 2,   ///< fields: message, signature, public key (empty for the
+                  ///< key's own); result: one byte, 1 if valid
+    Decap = 3,    ///< fields: ciphertext; result: shared secret
+    PublicKey = 4 ///< no fields; result: public key
+};
+
+/**
+ * \brief Response status
+ */
+enum class Status : byte {
+    Ok = 0,   ///< fields hold the result
+    Error = 1 ///< the only field holds the error message
+};
+
+/**
+ * \brief Decoded request
+ */
+struct Request {
+    Op op;                     ///< operation
+    std::uint32_t id;          ///< request id, echoed in the response
+    std::string key;           ///< key id
+    std::vector<bytes> fields; ///< operation inputs
+};
+
+/**
+ * \brief Decoded response
+ */
+struct Response {
+    std::uint32_t id;          ///< request id
+    Status status;             ///< status
+    std::vector<bytes> fields; ///< operation results or error message
+};
+
+namespace internal {
+inline void put_u32(bytes& out, std::size_t value) {
+    for (int shift = 24; shift >= 0; shift -= 8)
+        out.push_back(static_cast<byte>(value >> shift));
+}
+
+inline void put_u16(bytes& out, std::size_t value) {
+    out.push_back(static_cast<byte>(value >> 8));
+    out.push_back(static_cast<byte>(value));
+}
+
+inline void put_fields(bytes& out, const std::vector<bytes>& fields) {
+    if (fields.size() > 0xFFFF)
+        throw std::runtime_error("Too many fields");
+    put_u16(out, fields.size());
+    for (auto&& field : fields) {
+        put_u32(out, field.size());
+        out.insert(out.end(), field.begin(), field.end());
+    }
+}
+
+// Writes the frame length in front of the body starting at out[4]
+inline void finish_frame(bytes& out) {
+    std::size_t length = out.size() - 4;
+    if (length > max_frame_length)
+        throw std::runtime_error("Frame too long");
+    for (std::size_t i = 0; i < 4; ++i)
+        out[i] = static_cast<byte>(length >> (24 - 8 * i));
+}
+
+/**
+ * \class oqs::cryptod::internal::Reader
+ * \brief Bounds-checked big-endian reader of a frame body
+ */
+class Reader {
+    const byte* data_;
+    std::size_t len_;
+    std::size_t pos_ = 0;
+
+    void need(std::size_t n) const {
+        if (len_ - pos_ < n)
+            throw std::runtime_error("Malformed frame");
+    }
+
+  public:
+    Reader(const byte* data, std::size_t len) : data_{data}, len_{len} {}
+    Reader(const Reader&) = delete;
+    Reader& operator=(const Reader&) = delete;
+
+    std::size_t u8() {
+        need(1);
+        return data_[pos_++];
+    }
+
+    std::size_t u16() {
+        std::size_t high = u8();
+        return (high << 8) | u8();
+    }
+
+    std::size_t u32() {
+        std::size_t high = u16();
+        return (high << 16) | u16();
+    }
+
+    bytes field(std::size_t n) {
+        need(n);
+        bytes result(data_ + pos_, data_ + pos_ + n);
+        pos_ += n;
+        return result;
+    }
+
+    std::vector<bytes> fields() {
+        std::vector<bytes> result(u16());
+        for (auto&& f : result)
+            f = field(u32());
+        return result;
+    }
+
+    bool done() const noexcept { return pos_ == len_; }
+};
+
+// Length of the complete frame at the start of data, 0 if incomplete
+inline std::size_t frame_length(const byte* data, std::size_t len) {
+    if (len < 4)
+        return 0;
+    std::size_t body = Reader{data, 4}.u32();
+    if (body > max_frame_length)
+        throw std::runtime_error("Frame too long");
+    return len < 4 + body ? 0 : 4 + body;
+}
+} // namespace internal
+
+/**
+ * \brief Serializes a request as a frame
+ */
+inline bytes encode(const Request& request) {
+    if (request.key.size() > 0xFFFF)
+        throw std::runtime_error("Key id too long");
+    bytes out(4, 0);
+    out.push_back(static_cast<byte>(request.op));
+    internal::put_u32(out, request.id);
+    internal::put_u16(out, request.key.size());
+    out.insert(out.end(), request.key.begin(), request.key.end());
+    internal::put_fields(out, request.fields);
+    internal::finish_frame(out);
+    return out;
+}
+
+/**
+ * \brief Serializes a response as a frame
+ */
+inline bytes encode(const Response& response) {
+    bytes out(4, 0);
+    internal::put_u32(out, response.id);
+    out.push_back(static_cast<byte>(response.status));
+    internal::put_fields(out, response.fields);
+    internal::finish_frame(out);
+    return out;
+}
+
+/**
+ * \brief Decodes the request frame at the start of a buffer
+ * \param data Buffer
+ * \param len Buffer length
+ * \param [out] request Decoded request
+ * \return Length of the frame, 0 if the buffer does not hold a complete
+ * frame yet
+ */
+inline std::size_t decode(const byte* data, std::size_t len,
+                          Request& request) {
+    std::size_t n = internal::frame_length(data, len);
+    if (n == 0)
+        return 0;
+    internal::Reader reader{data + 4, n - 4};
+    std::size_t op = reader.u8();
+    if (op < static_cast<byte>(Op::Sign) ||
+        op > static_cast<byte>(Op::PublicKey))
+        throw std::runtime_error("Unknown operation");
+    request.op = static_cast<Op>(op);
+    request.id = static_cast<std::uint32_t>(reader.u32());
+    bytes key = reader.field(reader.u16());
+    request.key.assign(key.begin(), key.end());
+    request.fields = reader.fields();
+    if (!reader.done())
+        throw std::runtime_error("Malformed frame");
+    return n;
+}
+
+/**
+ * \brief Decodes the response frame at the start of a buffer
+ * \param data Buffer
+ * \param len Buffer length
+ * \param [out] response Decoded response
+ * \return Length of the frame, 0 if the buffer does not hold a complete
+ * frame yet
+ */
+inline std::size_t decode(const byte* data, std::size_t len,
+                          Response& response) {
+    std::size_t n = internal::frame_length(data, len);
+    if (n == 0)
+        return 0;
+    internal::Reader reader{data + 4, n - 4};
+    response.id = static_cast<std::uint32_t>(reader.u32());
+    std::size_t status = reader.u8();
+    if (status > static_cast<byte>(Status::Error))
+        throw std::runtime_error("Unknown status");
+    response.status = static_cast<Status>(status);
+    response.fields = reader.fields();
+    if (!reader.done())
+        throw std::runtime_error("Malformed frame");
+    return n;
+}
+
+/**
+ * \class oqs::cryptod::Client
+ * \brief Blocking client of oqs-cryptod, one connection per instance
+ *
+ * The overloads taking several inputs pipeline all requests on the
+ * connection before reading the responses, so that the daemon can batch
+ * them. An instance must not be used concurrently.
+ */
+class Client {
+    int fd_ = -1;
+    std::uint32_t next_id_ = 1;
+    bytes inbuf_{};
+
+    void send_all(const bytes& frame) {
+#ifdef MSG_NOSIGNAL
+        const int flags = MSG_NOSIGNAL;
+#else
+        const int flags = 0;
+#endif
+        std::size_t sent = 0;
+        while (sent < frame.size()) {
+            ssize_t n = ::send(fd_, frame.data() + sent, frame.size() - sent,
+                               flags);
+            if (n < 0 && errno == EINTR)
+                continue;
+            if (n <= 0)
+                throw std::runtime_error("Can not write to oqs-cryptod");
+            sent += static_cast<std::size_t>(n);
+        }
+    }
+
+    Response receive() {
+        for (;;) {
+            Response response{};
+            std::size_t n = decode(inbuf_.data(), inbuf_.size(), response);
+            if (n != 0) {
+                inbuf_.erase(inbuf_.begin(),
+                             inbuf_.begin() + static_cast<std::ptrdiff_t>(n));
+                return response;
+            }
+            byte buf[65536];
+            ssize_t got = ::read(fd_, buf, sizeof(buf));
+            if (got < 0 && errno == EINTR)
+                continue;
+            if (got <= 0)
+                throw std::runtime_error("Connection to oqs-cryptod closed");
+            inbuf_.insert(inbuf_.end(), buf, buf + got);
+        }
+    }
+
+    // Sends every request, then returns the responses in request order
+    std::vector<Response> call(Op op, const std::string& key,
+                               const std::vector<std::vector<bytes>>& inputs) {
+        std::map<std::uint32_t, std::size_t> index;
+        bytes frames;
+        for (std::size_t i = 0; i < inputs.size(); ++i) {
+            Request request{op, next_id_++, key, inputs[i]};
+            index[request.id] = i;
+            bytes frame = encode(request);
+            frames.insert(frames.end(), frame.begin(), frame.end());
+        }
+        send_all(frames);
+        std::vector<Response> responses(inputs.size(), Response{});
+        for (std::size_t i = 0; i < inputs.size(); ++i) {
+            Response response = receive();
+            auto it = index.find(response.id);
+            if (it == index.end())
+                throw std::runtime_error("Unexpected response id");
+            if (response.status != Status::Ok) {
+                std::string what = response.fields.empty()
+                                       ? "unknown error"
+                                       : std::string(response.fields[0].begin(),
+                                                     response.fields[0].end());
+                throw std::runtime_error("oqs-cryptod: " + what);
+            }
+            if (response.fields.size() != 1)
+                throw std::runtime_error("Malformed response");
+            responses[it->second] = std::move(response);
+        }
+        return responses;
+    }
+
+    bytes call_one(Op op, const std::string& key, std::vector<bytes> fields) {
+        return std::move(call(op, key, {std::move(fields)})[0].fields[0]);
+    }
+
+  public:
+    /**
+     * \brief Connects to the daemon
+     * \param socket_path Path of the daemon's Unix domain socket
+     */
+    explicit Client(const std::string& socket_path) {
+        sockaddr_un addr{};
+        if (socket_path.size() >= sizeof(addr.sun_path))
+            throw std::runtime_error("Socket path too long");
+        addr.sun_family = AF_UNIX;
+        std::memcpy(addr.sun_path, socket_path.c_str(), socket_path.size());
+        fd_ = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd_ < 0)
+            throw std::runtime_error("Can not create socket");
+        if (::connect(fd_, reinterpret_cast<const sockaddr*>(&addr),
+                      sizeof(addr)) != 0) {
+            ::close(fd_);
+            throw std::runtime_error("Can not connect to " + socket_path);
+        }
+    }
+
+    Client(const Client&) = delete;
+    Client& operator=(const Client&) = delete;
+
+    /**
+     * \brief Closes the connection
+     */
+    ~Client() { ::close(fd_); }
+
+    /**
+     * \brief Public key of a daemon key
+     */
+    bytes public_key(const std::string& key) {
+        return call_one(Op::PublicKey, key, {});
+    }
+
+    /**
+     * \brief Signs a message with a daemon signature key
+     */
+    bytes sign(const std::string& key, const bytes& message) {
+        return call_one(Op::Sign, key, {message});
+    }
+
+    /**
+     * \brief Signs several messages with a daemon signature key, pipelined
+     * \return Signatures, in the order of \a messages
+     */
+    std::vector<bytes> sign(const std::string& key,
+                            const std::vector<bytes>& messages) {
+        std::vector<std::vector<bytes>> inputs;
+        for (auto&& message : messages)
+            inputs.push_back({message});
+        std::vector<bytes> result;
+        for (auto&& response : call(Op::Sign, key, inputs))
+            result.emplace_back(std::move(response.fields[0]));
+        return result;
+    }
+
+    /**
+     * \brief Verifies a signature on the daemon
+     * \param key Daemon signature key, selects the algorithm
+     * \param message Message
+     * \param signature Signature
+     * \param public_key Public key, empty for the public key of \a key
+     * \return True if the signature is valid, false otherwise
+     */
+    bool verify(const std::string& key, const bytes& message,
+                const bytes& signature, const bytes& public_key = {}) {
+        bytes valid =
+            call_one(Op::Verify, key, {message, signature, public_key});
+        return valid.size() == 1 && valid[0] == 1;
+    }
+
+    /**
+     * \brief Decapsulates a ciphertext with a daemon KEM key
+     * \return Shared secret
+     */
+    bytes decap_secret(const std::string& key, const bytes& ciphertext) {
+        return call_one(Op::Decap, key, {ciphertext});
+    }
+
+    /**
+     * \brief Decapsulates several ciphertexts with a daemon KEM key, pipelined
+     * \return Shared secrets, in the order of \a ciphertexts
+     */
+    std::vector<bytes> decap_secret(const std::string& key,
+                                    const std::vector<bytes>& ciphertexts) {
+        std::vector<std::vector<bytes>> inputs;
+        for (auto&& ciphertext : ciphertexts)
+            inputs.push_back({ciphertext});
+        std::vector<bytes> result;
+        for (auto&& response : call(Op::Decap, key, inputs))
+            result.emplace_back(std::move(response.fields[0]));
+        return result;
+    }
+}; // class Client
+} // namespace cryptod
+} // namespace oqs
+
+#endif // CRYPTOD_CRYPTOD_HPP_
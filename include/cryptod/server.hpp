@@ -0,0 +1,482 @@
+/**
+ * \file cryptod/server.hpp
+ * \brief Local crypto daemon server (oqs-cryptod), POSIX only
+ *
+ * One I/O thread polls the listening Unix domain socket and the client
+ * connections, decodes the requests (see cryptod/cryptod.hpp) and queues them
+ * per key. Worker threads take whole batches of up to batch_max requests for
+ * one key, optionally waiting up to batch_delay for a batch to fill, process
+ * them back-to-back with the single shared copy of the key, and hand the
+ * encoded responses of a batch back to the I/O thread with one wake-up per
+ * batch. liboqs has no multi-message API, so batching amortizes the
+ * queueing, wake-ups and socket writes, and keeps the key and the algorithm's
+ * code hot on the worker.
+ */
+
+#ifndef CRYPTOD_SERVER_HPP_
+#define CRYPTOD_SERVER_HPP_
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "cryptod/cryptod.hpp"
+#include "oqs_cpp.hpp"
+
+namespace oqs {
+namespace cryptod {
+/**
+ * \brief Server configuration
+ */
+struct ServerOptions {
+    std::string socket_path{};                ///< Unix domain socket path
+    std::size_t num_threads = 0;              ///< 0 means all CPUs
+    std::size_t batch_max = 64;               ///< largest batch
+    std::chrono::microseconds batch_delay{0}; ///< batch fill wait
+};
+
+/**
+ * \brief Server counters
+ */
+struct ServerStats {
+    std::uint64_t requests = 0;    ///< requests processed by the workers
+    std::uint64_t batches = 0;     ///< batches processed by the workers
+    std::uint64_t connections = 0; ///< accepted connections
+};
+
+/**
+ * \class oqs::cryptod::Server
+ * \brief Serves sign/verify/decap/public key requests for the keys it holds
+ */
+class Server {
+    using clock = std::chrono::steady_clock;
+
+    // A key, shared read-only by all workers
+    struct Key {
+        std::unique_ptr<KeyEncapsulation> kem;
+        std::unique_ptr<Signature> sig;
+        bytes public_key;
+    };
+
+    // Written by the I/O thread (input) and the workers (output)
+    struct Connection {
+        int fd;
+        bytes input{};
+        std::mutex mutex{};
+        bytes output{};      // guarded by mutex
+        bool closed = false; // guarded by mutex
+
+        explicit Connection(int socket) : fd{socket} {}
+    };
+
+    struct Job {
+        std::shared_ptr<Connection> connection;
+        Request request;
+        clock::time_point arrival;
+    };
+
+    ServerOptions options_;
+    std::map<std::string, Key> keys_{};
+    int listen_fd_ = -1;
+    int wake_[2] = {-1, -1};
+    std::atomic<bool> stopping_{false};
+
+    std::mutex mutex_{};
+    std::condition_variable cv_{};
+    std::map<std::string, std::deque<Job>> queues_{}; // guarded by mutex_
+    std::size_t pending_ = 0;                          // guarded by mutex_
+    bool workers_stop_ = false;                        // guarded by mutex_
+    ServerStats stats_{};                              // guarded by mutex_
+
+    void wake() const noexcept {
+        byte b = 0;
+        ssize_t rc = ::write(wake_[1], &b, 1); // EAGAIN: already woken
+        (void) rc;
+    }
+
+    Response process(const Request& request) const {
+        Response response{request.id, Status::Ok, {}};
+        try {
+            auto it = keys_.find(request.key);
+            if (it == keys_.end())
+                throw std::runtime_error("Unknown key " + request.key);
+            const Key& key = it->second;
+            auto expect = [&request](std::size_t n, bool ok) {
+                if (request.fields.size() != n)
+                    throw std::runtime_error("Wrong number of fields");
+                if (!ok)
+                    throw std::runtime_error("Operation not supported by key");
+            };
+            switch (request.op) {
+                case Op::Sign:
+                    expect(1, key.sig != nullptr);
+                    response.fields.emplace_back(
+                        key.sig->sign(request.fields[0]));
+                    break;
+                case Op::Verify:
+                    expect(3, key.sig != nullptr);
+                    response.fields.emplace_back(
+                        1, key.sig->verify(request.fields[0], request.fields[1],
+                                           request.fields[2].empty()
+                                               ? key.public_key
+                                               : request.fields[2]));
+                    break;
+                case Op::Decap:
+                    expect(1, key.kem != nullptr);
+                    response.fields.emplace_back(
+                        key.kem->decap_secret(request.fields[0]));
+                    break;
+                case Op::PublicKey:
+                    expect(0, true);
+                    response.fields.emplace_back(key.public_key);
+                    break;
+            }
+        } catch (const std::exception& e) {
+            std::string what = e.what();
+            response.status = Status::Error;
+            response.fields.assign(1, bytes(what.begin(), what.end()));
+        }
+        return response;
+    }
+
+    void work() {
+        std::unique_lock<std::mutex> lock{mutex_};
+        for (;;) {
+            cv_.wait(lock, [this] { return workers_stop_ || pending_ > 0; });
+            if (pending_ == 0)
+                return; // stopped and drained
+
+            // The key whose oldest request waited the longest
+            auto queue = queues_.end();
+            for (auto it = queues_.begin(); it != queues_.end(); ++it)
+                if (!it->second.empty() &&
+                    (queue == queues_.end() ||
+                     it->second.front().arrival <
+                         queue->second.front().arrival))
+                    queue = it;
+            std::deque<Job>& jobs = queue->second;
+            clock::time_point ready =
+                jobs.front().arrival + options_.batch_delay;
+            if (jobs.size() < options_.batch_max && !workers_stop_ &&
+                clock::now() < ready) {
+                cv_.wait_until(lock, ready);
+                continue;
+            }
+
+            std::size_t n = std::min(jobs.size(), options_.batch_max);
+            std::vector<Job> batch;
+            for (std::size_t i = 0; i < n; ++i) {
+                batch.emplace_back(std::move(jobs.front()));
+                jobs.pop_front();
+            }
+            if (jobs.empty())
+                queues_.erase(queue);
+            pending_ -= n;
+            stats_.requests += n;
+            ++stats_.batches;
+            lock.unlock();
+
+            // Process, then append each connection's responses at once
+            std::map<Connection*, bytes> output;
+            for (auto&& job : batch) {
+                bytes frame = encode(process(job.request));
+                bytes& out = output[job.connection.get()];
+                out.insert(out.end(), frame.begin(), frame.end());
+            }
+            for (auto&& elem : output) {
+                std::lock_guard<std::mutex> guard{elem.first->mutex};
+                if (!elem.first->closed)
+                    elem.first->output.insert(elem.first->output.end(),
+                                              elem.second.begin(),
+                                              elem.second.end());
+            }
+            batch.clear(); // releases the connections outside of the lock
+            wake();
+            lock.lock();
+        }
+    }
+
+    // Queues the complete requests of a connection, false on protocol error
+    bool read_requests(const std::shared_ptr<Connection>& connection) {
+        std::size_t offset = 0;
+        std::vector<Job> jobs;
+        try {
+            for (;;) {
+                Request request{};
+                std::size_t n =
+                    decode(connection->input.data() + offset,
+                           connection->input.size() - offset, request);
+                if (n == 0)
+                    break;
+                offset += n;
+                jobs.push_back({connection, std::move(request), clock::now()});
+            }
+        } catch (const std::exception&) {
+            return false;
+        }
+        connection->input.erase(connection->input.begin(),
+                                connection->input.begin() +
+                                    static_cast<std::ptrdiff_t>(offset));
+        if (!jobs.empty()) {
+            std::lock_guard<std::mutex> lock{mutex_};
+            for (auto&& job : jobs)
+                queues_[job.request.key].emplace_back(std::move(job));
+            pending_ += jobs.size();
+        }
+        cv_.notify_all();
+        return true;
+    }
+
+    // Writes as much pending output as possible, false on error
+    static bool write_output(Connection& connection) {
+#ifdef MSG_NOSIGNAL
+        const int flags = MSG_NOSIGNAL;
+#else
+        const int flags = 0;
+#endif
+        std::lock_guard<std::mutex> lock{connection.mutex};
+        std::size_t sent = 0;
+        while (sent < connection.output.size()) {
+            ssize_t n = ::send(connection.fd, connection.output.data() + sent,
+                               connection.output.size() - sent, flags);
+            if (n < 0 && errno == EINTR)
+                continue;
+            if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+                break;
+            if (n <= 0)
+                return false;
+            sent += static_cast<std::size_t>(n);
+        }
+        connection.output.erase(connection.output.begin(),
+                                connection.output.begin() +
+                                    static_cast<std::ptrdiff_t>(sent));
+        return true;
+    }
+
+    static void close_connection(Connection& connection) {
+        std::lock_guard<std::mutex> lock{connection.mutex};
+        connection.closed = true;
+        connection.output.clear();
+        ::close(connection.fd);
+    }
+
+    static void set_nonblocking(int fd) {
+        ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL) | O_NONBLOCK);
+        ::fcntl(fd, F_SETFD, FD_CLOEXEC);
+    }
+
+    void add_key(const std::string& id, Key key) {
+        if (id.empty() || id.size() > 0xFFFF)
+            throw std::runtime_error("Invalid key id");
+        if (!keys_.emplace(id, std::move(key)).second)
+            throw std::runtime_error("Duplicate key id " + id);
+    }
+
+  public:
+    /**
+     * \brief Creates the listening socket (replacing a stale socket file),
+     * accessible by the owner only
+     * \param options Configuration
+     */
+    explicit Server(ServerOptions options) : options_{std::move(options)} {
+        if (options_.batch_max == 0)
+            throw std::runtime_error("batch_max must be at least 1");
+        sockaddr_un addr{};
+        if (options_.socket_path.size() >= sizeof(addr.sun_path))
+            throw std::runtime_error("Socket path too long");
+        addr.sun_family = AF_UNIX;
+        std::memcpy(addr.sun_path, options_.socket_path.c_str(),
+                    options_.socket_path.size());
+        if (::pipe(wake_) != 0)
+            throw std::runtime_error("Can not create the wake-up pipe");
+        set_nonblocking(wake_[0]);
+        set_nonblocking(wake_[1]);
+        listen_fd_ = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        ::unlink(options_.socket_path.c_str());
+        mode_t mask = ::umask(0077);
+        bool ok = listen_fd_ >= 0 &&
+                  ::bind(listen_fd_, reinterpret_cast<const sockaddr*>(&addr),
+                         sizeof(addr)) == 0 &&
+                  ::listen(listen_fd_, SOMAXCONN) == 0;
+        ::umask(mask);
+        if (!ok) {
+            ::close(listen_fd_);
+            ::close(wake_[0]);
+            ::close(wake_[1]);
+            throw std::runtime_error("Can not listen on " +
+                                     options_.socket_path);
+        }
+        set_nonblocking(listen_fd_);
+    }
+
+    Server(const Server&) = delete;
+    Server& operator=(const Server&) = delete;
+
+    /**
+     * \brief Closes and removes the socket
+     */
+    ~Server() {
+        ::close(listen_fd_);
+        ::unlink(options_.socket_path.c_str());
+        ::close(wake_[0]);
+        ::close(wake_[1]);
+    }
+
+    /**
+     * \brief Adds a KEM key, before run()
+     * \param id Key id used by the clients
+     * \param alg_name KEM algorithm name
+     * \param secret_key Secret key
+     * \param public_key Public key, returned to the clients
+     */
+    void add_kem_key(const std::string& id, const std::string& alg_name,
+                     const bytes& secret_key, const bytes& public_key) {
+        Key key{std::unique_ptr<KeyEncapsulation>{
+                    new KeyEncapsulation{alg_name, secret_key}},
+                nullptr, public_key};
+        add_key(id, std::move(key));
+    }
+
+    /**
+     * \brief Adds a signature key, before run()
+     * \param id Key id used by the clients
+     * \param alg_name Signature algorithm name
+     * \param secret_key Secret key
+     * \param public_key Public key, returned to the clients and used by
+     * verify requests without a public key
+     */
+    void add_sig_key(const std::string& id, const std::string& alg_name,
+                     const bytes& secret_key, const bytes& public_key) {
+        Key key{nullptr,
+                std::unique_ptr<Signature>{new Signature{alg_name, secret_key}},
+                public_key};
+        add_key(id, std::move(key));
+    }
+
+    /**
+     * \brief Serves requests until stop() is called
+     */
+    void run() {
+        std::size_t num_threads = options_.num_threads;
+        if (num_threads == 0)
+            num_threads = std::max(1u, std::thread::hardware_concurrency());
+        {
+            std::lock_guard<std::mutex> lock{mutex_};
+            workers_stop_ = false;
+        }
+        std::vector<std::thread> workers;
+        for (std::size_t i = 0; i < num_threads; ++i)
+            workers.emplace_back([this] { work(); });
+
+        std::vector<std::shared_ptr<Connection>> connections;
+        std::vector<pollfd> fds;
+        while (!stopping_) {
+            fds.assign(2, pollfd{});
+            fds[0] = {listen_fd_, POLLIN, 0};
+            fds[1] = {wake_[0], POLLIN, 0};
+            for (auto&& connection : connections) {
+                std::lock_guard<std::mutex> lock{connection->mutex};
+                short events = POLLIN;
+                if (!connection->output.empty())
+                    events |= POLLOUT;
+                fds.push_back({connection->fd, events, 0});
+            }
+            if (::poll(fds.data(), fds.size(), -1) < 0 && errno != EINTR)
+                break;
+
+            if (fds[1].revents & POLLIN) {
+                byte buf[256];
+                while (::read(wake_[0], buf, sizeof(buf)) > 0) {
+                }
+            }
+            std::vector<std::shared_ptr<Connection>> alive;
+            for (std::size_t i = 0; i < connections.size(); ++i) {
+                auto& connection = connections[i];
+                short revents = fds[i + 2].revents;
+                bool ok = true;
+                if (revents & (POLLIN | POLLHUP | POLLERR)) {
+                    byte buf[65536];
+                    ssize_t n = ::read(connection->fd, buf, sizeof(buf));
+                    if (n > 0) {
+                        connection->input.insert(connection->input.end(), buf,
+                                                 buf + n);
+                        ok = read_requests(connection);
+                    } else if (n == 0 || (errno != EAGAIN && errno != EINTR)) {
+                        ok = false;
+                    }
+                }
+                // Also flushes the output queued since poll() was called
+                if (ok)
+                    ok = write_output(*connection);
+                if (ok)
+                    alive.emplace_back(connection);
+                else
+                    close_connection(*connection);
+            }
+            connections.swap(alive);
+
+            if (fds[0].revents & POLLIN) {
+                int fd;
+                while ((fd = ::accept(listen_fd_, nullptr, nullptr)) >= 0) {
+                    set_nonblocking(fd);
+                    connections.emplace_back(std::make_shared<Connection>(fd));
+                    std::lock_guard<std::mutex> lock{mutex_};
+                    ++stats_.connections;
+                }
+            }
+        }
+
+        {
+            std::lock_guard<std::mutex> lock{mutex_};
+            workers_stop_ = true;
+        }
+        cv_.notify_all();
+        for (auto&& worker : workers)
+            worker.join();
+        for (auto&& connection : connections) {
+            write_output(*connection);
+            close_connection(*connection);
+        }
+        stopping_ = false;
+    }
+
+    /**
+     * \brief Makes run() return, async-signal-safe
+     */
+    void stop() noexcept {
+        stopping_ = true;
+        wake();
+    }
+
+    /**
+     * \brief Counters, thread-safe
+     */
+    ServerStats stats() {
+        std::lock_guard<std::mutex> lock{mutex_};
+        return stats_;
+    }
+}; // class Server
+} // namespace cryptod
+} // namespace oqs
+
+#endif // CRYPTOD_SERVER_HPP_
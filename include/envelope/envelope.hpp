@@ -0,0 +1,304 @@
+/**
+ * \file envelope/envelope.hpp
+ * \brief Multi-recipient envelope: one content key wrapped for many KEM
+ * public keys
+ *
+ * Header layout (all integers big-endian)
+ *
+ *     magic "OQSE" | version (1) | name length (1) | KEM name |
+ *     number of recipients (4) | entries[]
+ *
+ * Entries have fixed size and are sorted by key id, so a recipient locates
+ * its own entry by binary search, without parsing the others
+ *
+ *     key id (16) | KEM ciphertext | wrapped content key (32) | tag (16)
+ */
+
+#ifndef ENVELOPE_ENVELOPE_HPP_
+#define ENVELOPE_ENVELOPE_HPP_
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "common.hpp"
+#include "oqs_cpp.hpp"
+#include "rand/rand.hpp"
+#include "sha3/sha3.hpp"
+
+namespace oqs {
+/**
+ * \namespace envelope
+ * \brief Namespace containing the multi-recipient envelope API
+ */
+namespace envelope {
+constexpr std::size_t content_key_length = 32; ///< content key length
+constexpr std::size_t key_id_length = 16;      ///< recipient key id length
+constexpr std::size_t tag_length = 16;         ///< wrapped key tag length
+
+/**
+ * \brief Envelope produced by oqs::envelope::seal()
+ */
+struct SealedEnvelope {
+    bytes content_key; ///< content key, to be used by the caller's DEM
+    bytes header;      ///< serialized header, to be sent to the recipients
+};
+
+namespace internal {
+constexpr byte magic[4] = {'O', 'Q', 'S', 'E'}; ///< header magic
+constexpr byte version = 1;                      ///< header version
+
+/**
+ * \brief Fixed part of a serialized header
+ */
+struct HeaderView {
+    std::string kem_name;        ///< KEM algorithm name
+    std::size_t num_recipients;  ///< number of entries
+    std::size_t entries_offset;  ///< offset of the first entry
+};
+
+/**
+ * \brief Derives the key-wrapping pad and the tag key from a shared secret
+ * \param kem_name KEM algorithm name
+ * \param shared_secret KEM shared secret
+ * \param key_id Recipient key id
+ * \param [out] kek 32-byte pad followed by the 32-byte tag key
+ */
+inline void derive_kek(const std::string& kem_name, const bytes& shared_secret,
+                       const byte* key_id, byte* kek) {
+    static const char label[] = "liboqs-cpp envelope v1";
+    sha3::SHAKE256 xof;
+    xof.absorb(reinterpret_cast<const byte*>(label), sizeof(label) - 1)
+        .absorb(reinterpret_cast<const byte*>(kem_name.data()),
+                kem_name.size())
+        .absorb(shared_secret)
+        .absorb(key_id, key_id_length)
+        .finalize()
+        .squeeze(kek, 2 * content_key_length);
+}
+
+/**
+ * \brief Tag over an entry's ciphertext and wrapped key
+ * \param tag_key 32-byte tag key
+ * \param entry Pointer to the entry's ciphertext
+ * \param len Length of ciphertext + wrapped key
+ * \param [out] tag oqs::envelope::tag_length bytes
+ */
+inline void compute_tag(const byte* tag_key, const byte* entry,
+                        std::size_t len, byte* tag) {
+    byte digest[sha3::sha3_256_length];
+    sha3::SHA3_256 h;
+    h.absorb(tag_key, content_key_length).absorb(entry, len).digest(digest);
+    std::memcpy(tag, digest, tag_length);
+}
+
+/**
+ * \brief Parses and validates the fixed part of a serialized header
+ * \param header Serialized header
+ * \return Parsed view
+ */
+inline HeaderView parse_header(const bytes& header) {
+    if (header.size() < 6 || !std::equal(magic, magic + 4, header.begin()))
+        throw std::runtime_error("Invalid envelope header");
+    if (header[4] != version)
+        throw std::runtime_error("Unsupported envelope header version");
+
+    HeaderView view{};
+    std::size_t name_len = header[5];
+    std::size_t offset = 6 + name_len;
+    if (header.size() < offset + 4)
+        throw std::runtime_error("Invalid envelope header");
+    view.kem_name.assign(header.begin() + 6, header.begin() + 6 + name_len);
+    view.num_recipients = (std::size_t{header[offset]} << 24) |
+                          (std::size_t{header[offset + 1]} << 16) |
+                          (std::size_t{header[offset + 2]} << 8) |
+                          std::size_t{header[offset + 3]};
+    view.entries_offset = offset + 4;
+
+    return view;
+}
+} // namespace internal
+
+/**
+ * \brief Key id of a recipient public key, truncated SHA3-256
+ * \param public_key Recipient public key
+ * \return oqs::envelope::key_id_length bytes
+ */
+inline bytes key_id(const bytes& public_key) {
+    bytes result = sha3::sha3_256(public_key);
+    result.resize(key_id_length);
+    return result;
+}
+
+/**
+ * \brief Generates a fresh content key and wraps it for every recipient
+ * \note Encapsulations run in parallel, see oqs::internal::parallel_for()
+ * \param kem_name KEM algorithm name, shared by all recipients
+ * \param recipient_public_keys Recipient public keys
+ * \param num_threads Maximum number of threads, 0 means
+ * std::thread::hardware_concurrency()
+ * \return Content key and serialized header
+ */
+inline SealedEnvelope seal(const std::string& kem_name,
+                           const std::vector<bytes>& recipient_public_keys,
+                           std::size_t num_threads = 0) {
+    if (kem_name.size() > 255)
+        throw std::runtime_error("KEM name too long");
+    if (recipient_public_keys.size() > 0xFFFFFFFFu)
+        throw std::runtime_error("Too many recipients");
+
+    KeyEncapsulation kem{kem_name};
+    const auto& details = kem.get_details();
+    const std::size_t n = recipient_public_keys.size();
+    const std::size_t entry_length = key_id_length +
+                                     details.length_ciphertext +
+                                     content_key_length + tag_length;
+
+    // Sort the recipients by key id, entries are written in that order
+    std::vector<bytes> key_ids(n);
+    for (std::size_t i = 0; i < n; ++i)
+        key_ids[i] = key_id(recipient_public_keys[i]);
+    std::vector<std::size_t> order(n);
+    std::iota(order.begin(), order.end(), std::size_t{0});
+    std::sort(order.begin(), order.end(),
+              [&key_ids](std::size_t lhs, std::size_t rhs) {
+                  return key_ids[lhs] < key_ids[rhs];
+              });
+    for (std::size_t i = 1; i < n; ++i)
+        if (key_ids[order[i - 1]] == key_ids[order[i]])
+            throw std::runtime_error("Duplicate recipient public key");
+
+    SealedEnvelope result{rand::randombytes(content_key_length), bytes{}};
+    bytes& header = result.header;
+    std::size_t entries_offset = 6 + kem_name.size() + 4;
+    header.resize(entries_offset + n * entry_length);
+    std::copy(internal::magic, internal::magic + 4, header.begin());
+    header[4] = internal::version;
+    header[5] = static_cast<byte>(kem_name.size());
+    std::copy(kem_name.begin(), kem_name.end(), header.begin() + 6);
+    for (std::size_t i = 0; i < 4; ++i)
+        header[6 + kem_name.size() + i] =
+            static_cast<byte>(static_cast<std::uint32_t>(n) >> (24 - 8 * i));
+
+    // Each thread writes its own, disjoint, slots of the header
+    oqs::internal::parallel_for(n, num_threads, [&](std::size_t slot) {
+        std::size_t idx = order[slot];
+        byte* entry = header.data() + entries_offset + slot * entry_length;
+        std::copy(key_ids[idx].begin(), key_ids[idx].end(), entry);
+
+        bytes ciphertext, shared_secret;
+        std::tie(ciphertext, shared_secret) =
+            kem.encap_secret(recipient_public_keys[idx]);
+        byte* ct = entry + key_id_length;
+        std::copy(ciphertext.begin(), ciphertext.end(), ct);
+
+        byte kek[2 * content_key_length];
+        internal::derive_kek(kem_name, shared_secret, entry, kek);
+        mem_cleanse(shared_secret);
+        byte* wrapped = ct + details.length_ciphertext;
+        for (std::size_t i = 0; i < content_key_length; ++i)
+            wrapped[i] = result.content_key[i] ^ kek[i];
+        internal::compute_tag(kek + content_key_length, ct,
+                              details.length_ciphertext + content_key_length,
+                              wrapped + content_key_length);
+        C::OQS_MEM_cleanse(kek, sizeof(kek));
+    });
+
+    return result;
+}
+
+/**
+ * \brief Locates the entry of a recipient in a serialized header, by binary
+ * search over the sorted key ids
+ * \param header Serialized header
+ * \param recipient_key_id Recipient key id, see oqs::envelope::key_id()
+ * \param ciphertext_length KEM ciphertext length
+ * \return Index of the recipient's entry
+ */
+inline std::size_t find_recipient(const bytes& header,
+                                  const bytes& recipient_key_id,
+                                  std::size_t ciphertext_length) {
+    if (recipient_key_id.size() != key_id_length)
+        throw std::runtime_error("Incorrect key id length");
+
+    internal::HeaderView view = internal::parse_header(header);
+    std::size_t entry_length =
+        key_id_length + ciphertext_length + content_key_length + tag_length;
+    if ((header.size() - view.entries_offset) / entry_length !=
+            view.num_recipients ||
+        (header.size() - view.entries_offset) % entry_length != 0)
+        throw std::runtime_error("Invalid envelope header");
+
+    std::size_t lo = 0, hi = view.num_recipients;
+    while (lo < hi) {
+        std::size_t mid = lo + (hi - lo) / 2;
+        const byte* id =
+            header.data() + view.entries_offset + mid * entry_length;
+        int cmp = std::memcmp(id, recipient_key_id.data(), key_id_length);
+        if (cmp == 0)
+            return mid;
+        if (cmp < 0)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    throw std::runtime_error("Recipient not found in envelope");
+}
+
+/**
+ * \brief Recovers the content key, touching only the recipient's entry
+ * \param header Serialized header
+ * \param recipient oqs::KeyEncapsulation instance holding the recipient's
+ * secret key
+ * \param recipient_public_key Recipient public key, used to locate the entry
+ * \return Content key
+ */
+inline bytes open(const bytes& header, const KeyEncapsulation& recipient,
+                  const bytes& recipient_public_key) {
+    const auto& details = recipient.get_details();
+    internal::HeaderView view = internal::parse_header(header);
+    if (view.kem_name != details.name)
+        throw std::runtime_error("Envelope KEM mismatch");
+
+    std::size_t slot = find_recipient(header, key_id(recipient_public_key),
+                                      details.length_ciphertext);
+    std::size_t entry_length = key_id_length + details.length_ciphertext +
+                               content_key_length + tag_length;
+    const byte* entry =
+        header.data() + view.entries_offset + slot * entry_length;
+    const byte* ct = entry + key_id_length;
+    const byte* wrapped = ct + details.length_ciphertext;
+
+    bytes shared_secret =
+        recipient.decap_secret(bytes(ct, ct + details.length_ciphertext));
+    byte kek[2 * content_key_length];
+    internal::derive_kek(view.kem_name, shared_secret, entry, kek);
+    mem_cleanse(shared_secret);
+
+    byte tag[tag_length];
+    internal::compute_tag(kek + content_key_length, ct,
+                          details.length_ciphertext + content_key_length, tag);
+    if (C::OQS_MEM_secure_bcmp(tag, wrapped + content_key_length,
+                               tag_length) != 0) {
+        C::OQS_MEM_cleanse(kek, sizeof(kek));
+        throw std::runtime_error("Can not unwrap content key");
+    }
+
+    bytes content_key(content_key_length);
+    for (std::size_t i = 0; i < content_key_length; ++i)
+        content_key[i] = wrapped[i] ^ kek[i];
+    C::OQS_MEM_cleanse(kek, sizeof(kek));
+
+    return content_key;
+}
+} // namespace envelope
+} // namespace oqs
+
+#endif // ENVELOPE_ENVELOPE_HPP_
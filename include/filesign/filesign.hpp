@@ -0,0 +1,646 @@
+/**
+ * \file filesign/filesign.hpp
+ * \brief Batch signing and verification of files with a detached-signature
+ * manifest, overlapping file I/O, hashing and signing, POSIX only
+ *
+ * Files are read in chunks with many reads in flight (io_uring on Linux when
+ * available, see filesign/uring.hpp, otherwise one blocking reader per
+ * worker thread). Every chunk is absorbed into the file's SHAKE256 state by
+ * a worker pool as soon as it arrives, in file order, while the next reads
+ * are in flight; when the last chunk of a file is hashed the same worker
+ * signs (or verifies) it, while other files are still being read and hashed.
+ *
+ * Every file is signed as
+ *
+ *     "oqs-filesign 1" | 0 | path | 0 | size (8, big-endian) |
+ *     SHAKE256(contents) (64)
+ *
+ * so that the signature also covers the path recorded in the manifest. The
+ * manifest is a text file
+ *
+ *     oqs-filesign 1 <algorithm>
+ *     <size> <hex digest> <hex signature> <path>
+ *     ...
+ */
+
+#ifndef FILESIGN_FILESIGN_HPP_
+#define FILESIGN_FILESIGN_HPP_
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <istream>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "async/async.hpp"
+#include "filesign/uring.hpp"
+#include "oqs_cpp.hpp"
+#include "sha3/sha3.hpp"
+
+namespace oqs {
+/**
+ * \namespace filesign
+ * \brief Namespace containing the batch file signing pipeline
+ */
+namespace filesign {
+constexpr std::size_t digest_length = 64; ///< SHAKE256 output length
+
+/**
+ * \brief File reader of the pipeline
+ */
+enum class Backend {
+    Auto,   ///< io_uring if available, otherwise Threads
+    Uring,  ///< io_uring, throws if unavailable
+    Threads ///< blocking reads on the worker threads
+};
+
+/**
+ * \brief Pipeline configuration
+ */
+struct Options {
+    std::size_t queue_depth = 64;        ///< reads in flight (io_uring)
+    std::size_t chunk_size = 256 * 1024; ///< bytes per read
+    std::size_t num_threads = 0;         ///< workers, 0 means all CPUs
+    Backend backend = Backend::Auto;     ///< file reader
+};
+
+/**
+ * \brief One file of a manifest
+ */
+struct Entry {
+    std::string path;   ///< path, as given
+    std::uint64_t size; ///< size in bytes
+    bytes digest;       ///< SHAKE256 of the contents
+    bytes signature;    ///< signature of signed_message()
+    std::string error;  ///< empty on success, otherwise what failed
+};
+
+/**
+ * \brief Called on a worker thread once a file is hashed, with the file's
+ * index, size and digest, or an error message (then the digest is empty)
+ */
+using HashCallback = std::function<void(
+    std::size_t index, std::uint64_t size, const bytes& digest,
+    const std::string& error)>;
+
+namespace internal {
+// Fixed set of read buffers, bounds the memory of the chunks in flight
+class BufferPool {
+    std::vector<std::unique_ptr<byte[]>> storage_{};
+    std::vector<byte*> free_{};
+    std::mutex mutex_{};
+    std::condition_variable cv_{};
+
+  public:
+    BufferPool(std::size_t count, std::size_t size) {
+        for (std::size_t i = 0; i < count; ++i) {
+            storage_.emplace_back(new byte[size]);
+            free_.emplace_back(storage_.back().get());
+        }
+    }
+
+    // nullptr if none is free and !wait
+    byte* acquire(bool wait) {
+        std::unique_lock<std::mutex> lock{mutex_};
+        if (wait)
+            cv_.wait(lock, [this] { return !free_.empty(); });
+        if (free_.empty())
+            return nullptr;
+        byte* buffer = free_.back();
+        free_.pop_back();
+        return buffer;
+    }
+
+    void release(byte* buffer) {
+        {
+            std::lock_guard<std::mutex> lock{mutex_};
+            free_.emplace_back(buffer);
+        }
+        cv_.notify_one();
+    }
+};
+
+// Counts the files still to be reported, waited for by the calling thread
+class Countdown {
+    std::size_t left_;
+    std::mutex mutex_{};
+    std::condition_variable cv_{};
+
+  public:
+    explicit Countdown(std::size_t count) : left_{count} {}
+
+    void done() {
+        std::lock_guard<std::mutex> lock{mutex_};
+        if (--left_ == 0)
+            cv_.notify_all();
+    }
+
+    void wait() {
+        std::unique_lock<std::mutex> lock{mutex_};
+        cv_.wait(lock, [this] { return left_ == 0; });
+    }
+};
+
+inline std::string error_message(const std::string& what) {
+    return what + ": " + std::strerror(errno);
+}
+
+// Reads and hashes whole files on the worker threads
+inline void hash_with_threads(const std::vector<std::string>& paths,
+                              const Options& options,
+                              async::WorkerPool& pool,
+                              const HashCallback& done) {
+    std::atomic<std::size_t> next{0};
+    Countdown workers{pool.size()};
+    for (std::size_t w = 0; w < pool.size(); ++w)
+        pool.post([&] {
+            std::unique_ptr<byte[]> buffer{new byte[options.chunk_size]};
+            sha3::SHAKE256 hash;
+            for (std::size_t i = next++; i < paths.size(); i = next++) {
+                int fd = ::open(paths[i].c_str(), O_RDONLY | O_CLOEXEC);
+                if (fd < 0) {
+                    done(i, 0, {}, error_message(paths[i]));
+                    continue;
+                }
+                hash.reset();
+                std::uint64_t size = 0;
+                std::string error;
+                for (;;) {
+                    ssize_t n = ::pread(fd, buffer.get(), options.chunk_size,
+                                        static_cast<off_t>(size));
+                    if (n < 0 && errno == EINTR)
+                        continue;
+                    if (n < 0)
+                        error = error_message(paths[i]);
+                    if (n <= 0)
+                        break;
+                    hash.absorb(buffer.get(), static_cast<std::size_t>(n));
+                    size += static_cast<std::uint64_t>(n);
+                }
+                ::close(fd);
+                if (!error.empty()) {
+                    done(i, size, {}, error);
+                    continue;
+                }
+                done(i, size, hash.finalize().squeeze(digest_length), {});
+            }
+            workers.done();
+        });
+    workers.wait();
+}
+
+#ifdef LIBOQS_CPP_HAS_IO_URING
+// Reads with io_uring on the calling thread, hashes on the worker threads
+class UringHasher {
+    struct Chunk {
+        byte* buffer;
+        std::size_t len;
+        bool last;
+        std::string error;
+    };
+
+    struct File {
+        std::size_t index;
+        int fd;
+        std::uint64_t size;
+        std::uint64_t offset = 0; // of the next read, I/O thread only
+        byte* reading = nullptr;  // buffer of the read in flight, ditto
+        std::mutex mutex{};
+        std::deque<Chunk> chunks{}; // guarded by mutex
+        bool hashing = false;       // guarded by mutex
+        std::unique_ptr<sha3::SHAKE256> hash{new sha3::SHAKE256};
+
+        File(std::size_t i, int f, std::uint64_t s)
+            : index{i}, fd{f}, size{s} {}
+        File(const File&) = delete;
+        File& operator=(const File&) = delete;
+    };
+
+    const std::vector<std::string>& paths_;
+    const Options& options_;
+    async::WorkerPool& pool_;
+    const HashCallback& done_;
+    Uring ring_;
+    BufferPool buffers_;
+    Countdown files_left_;
+    std::vector<std::unique_ptr<File>> files_{};
+
+    // Hashes the queued chunks of a file in order, on one worker at a time
+    void drain(File& file) {
+        for (;;) {
+            Chunk chunk{nullptr, 0, false, {}};
+            {
+                std::lock_guard<std::mutex> lock{file.mutex};
+                if (file.chunks.empty()) {
+                    file.hashing = false;
+                    return;
+                }
+                chunk = std::move(file.chunks.front());
+                file.chunks.pop_front();
+            }
+            if (chunk.buffer != nullptr) {
+                if (chunk.error.empty())
+                    file.hash->absorb(chunk.buffer, chunk.len);
+                buffers_.release(chunk.buffer);
+            }
+            if (!chunk.error.empty()) {
+                file.hash.reset();
+                done_(file.index, file.offset, {}, chunk.error);
+                files_left_.done();
+                return; // the error is the file's last chunk
+            }
+            if (chunk.last) {
+                bytes digest = file.hash->finalize().squeeze(digest_length);
+                file.hash.reset();
+                done_(file.index, file.size, digest, {});
+                files_left_.done();
+                return;
+            }
+        }
+    }
+
+    void push(File& file, Chunk chunk) {
+        {
+            std::lock_guard<std::mutex> lock{file.mutex};
+            file.chunks.emplace_back(std::move(chunk));
+            if (file.hashing)
+                return;
+            file.hashing = true;
+        }
+        pool_.post([this, &file] { drain(file); });
+    }
+
+    // Opens the next file, nullptr if it needs no read
+    File* open(std::size_t index) {
+        int fd = ::open(paths_[index].c_str(), O_RDONLY | O_CLOEXEC);
+        struct stat st {};
+        if (fd >= 0 && (::fstat(fd, &st) != 0 || !S_ISREG(st.st_mode))) {
+            int err = S_ISDIR(st.st_mode) ? EISDIR : errno;
+            ::close(fd);
+            errno = err;
+            fd = -1;
+        }
+        if (fd < 0) {
+            done_(index, 0, {}, error_message(paths_[index]));
+            files_left_.done();
+            return nullptr;
+        }
+        files_[index].reset(
+            new File{index, fd, static_cast<std::uint64_t>(st.st_size)});
+        File& file = *files_[index];
+        if (file.size > 0)
+            return &file;
+        ::close(fd);
+        push(file, Chunk{nullptr, 0, true, {}});
+        return nullptr;
+    }
+
+    void complete(File& file, int res) {
+        byte* buffer = file.reading;
+        file.reading = nullptr;
+        if (res < 0) {
+            errno = -res;
+            ::close(file.fd);
+            push(file,
+                 Chunk{buffer, 0, true, error_message(paths_[file.index])});
+            return;
+        }
+        file.offset += static_cast<std::uint64_t>(res);
+        if (res == 0) // shrunk while being read
+            file.size = file.offset;
+        bool last = file.offset >= file.size;
+        if (last)
+            ::close(file.fd);
+        push(file, Chunk{buffer, static_cast<std::size_t>(res), last, {}});
+    }
+
+  public:
+    UringHasher(const std::vector<std::string>& paths, const Options& options,
+                async::WorkerPool& pool, const HashCallback& done)
+        : paths_{paths}, options_{options}, pool_{pool}, done_{done},
+          ring_{static_cast<unsigned>(options.queue_depth)},
+          buffers_{2 * options.queue_depth + pool.size(), options.chunk_size},
+          files_left_{paths.size()} {
+        files_.resize(paths.size());
+    }
+
+    UringHasher(const UringHasher&) = delete;
+    UringHasher& operator=(const UringHasher&) = delete;
+
+    void run() {
+        std::size_t next = 0;      // next file to open
+        std::deque<File*> ready{}; // open files without a read in flight
+        std::size_t in_flight = 0;
+        std::size_t depth =
+            std::min<std::size_t>(options_.queue_depth, ring_.capacity());
+        for (;;) {
+            while (in_flight < depth) {
+                if (ready.empty()) {
+                    if (next == paths_.size())
+                        break;
+                    if (File* file = open(next++))
+                        ready.push_back(file);
+                    continue;
+                }
+                byte* buffer = buffers_.acquire(in_flight == 0);
+                if (buffer == nullptr)
+                    break;
+                File& file = *ready.front();
+                ready.pop_front();
+                std::uint64_t len = std::min<std::uint64_t>(
+                    options_.chunk_size, file.size - file.offset);
+                file.reading = buffer;
+                if (!ring_.read(file.fd, buffer, static_cast<unsigned>(len),
+                                file.offset, file.index))
+                    throw std::runtime_error("io_uring submission queue full");
+                ++in_flight;
+            }
+            if (in_flight == 0)
+                break; // every file is opened and read
+            ring_.submit(1);
+            in_flight -= ring_.reap([&](std::uint64_t index, int res) {
+                File& file = *files_[index];
+                complete(file, res);
+                if (file.reading == nullptr && file.offset < file.size &&
+                    res > 0)
+                    ready.push_back(&file);
+            });
+        }
+        files_left_.wait();
+    }
+}; // class UringHasher
+#endif // LIBOQS_CPP_HAS_IO_URING
+} // namespace internal
+
+/**
+ * \brief Whether the io_uring reader can be used on this host
+ */
+inline bool uring_available() {
+#ifdef LIBOQS_CPP_HAS_IO_URING
+    try {
+        internal::Uring ring{1};
+        return true;
+    } catch (const std::runtime_error&) {
+        return false;
+    }
+#else
+    return false;
+#endif
+}
+
+/**
+ * \brief Hashes files, overlapping reads and hashing; \a done is called on
+ * the worker threads and may itself sign or verify
+ * \param paths Files
+ * \param options Configuration
+ * \param done Called once per file, concurrently
+ */
+inline void hash_files(const std::vector<std::string>& paths,
+                       const Options& options, const HashCallback& done) {
+    if (options.queue_depth == 0 || options.chunk_size == 0 ||
+        options.chunk_size > (1u << 30))
+        throw std::invalid_argument("Invalid queue depth or chunk size");
+    async::WorkerPool pool{options.num_threads};
+    Backend backend = options.backend;
+    if (backend == Backend::Auto)
+        backend = uring_available() ? Backend::Uring : Backend::Threads;
+    if (backend == Backend::Threads) {
+        internal::hash_with_threads(paths, options, pool, done);
+        return;
+    }
+#ifdef LIBOQS_CPP_HAS_IO_URING
+    internal::UringHasher{paths, options, pool, done}.run();
+#else
+    throw std::runtime_error("io_uring is not available");
+#endif
+}
+
+/**
+ * \brief Message signed for a file, see filesign/filesign.hpp
+ */
+inline bytes signed_message(const std::string& path, std::uint64_t size,
+                            const bytes& digest) {
+    static const std::string tag = "oqs-filesign 1";
+    bytes message{tag.begin(), tag.end()};
+    message.push_back(0);
+    message.insert(message.end(), path.begin(), path.end());
+    message.push_back(0);
+    for (int shift = 56; shift >= 0; shift -= 8)
+        message.push_back(static_cast<byte>(size >> shift));
+    message.insert(message.end(), digest.begin(), digest.end());
+    return message;
+}
+
+/**
+ * \brief Hashes and signs files
+ * \param signer Signature object holding the secret key, shared by the
+ * workers
+ * \param paths Files
+ * \param options Configuration
+ * \return One entry per file, in the order of \a paths; failed files have a
+ * non-empty error
+ */
+inline std::vector<Entry> sign_files(const Signature& signer,
+                                     const std::vector<std::string>& paths,
+                                     const Options& options = {}) {
+    std::vector<Entry> entries;
+    for (auto&& path : paths) {
+        if (path.find('\n') != std::string::npos)
+            throw std::invalid_argument("Path with a newline");
+        entries.push_back(Entry{path, 0, {}, {}, {}});
+    }
+    hash_files(paths, options,
+               [&](std::size_t index, std::uint64_t size, const bytes& digest,
+                   const std::string& error) {
+                   Entry& entry = entries[index];
+                   entry.size = size;
+                   entry.digest = digest;
+                   entry.error = error;
+                   if (!error.empty())
+                       return;
+                   try {
+                       entry.signature = signer.sign(
+                           signed_message(entry.path, size, digest));
+                   } catch (const std::exception& e) {
+                       entry.error = e.what();
+                   }
+               });
+    return entries;
+}
+
+/**
+ * \brief Hashes files and checks them against their manifest entries
+ * \param verifier Signature object of the manifest's algorithm
+ * \param public_key Signer's public key
+ * \param manifest Entries to check
+ * \param options Configuration
+ * \param root Directory the manifest paths are relative to, empty for the
+ * current directory
+ * \return The entries, with an empty error for the valid ones
+ */
+inline std::vector<Entry> verify_files(const Signature& verifier,
+                                       const bytes& public_key,
+                                       const std::vector<Entry>& manifest,
+                                       const Options& options = {},
+                                       const std::string& root = "") {
+    std::vector<Entry> entries = manifest;
+    std::vector<std::string> paths;
+    for (auto&& entry : entries)
+        paths.emplace_back(root.empty() ? entry.path
+                                        : root + "/" + entry.path);
+    hash_files(paths, options,
+               [&](std::size_t index, std::uint64_t size, const bytes& digest,
+                   const std::string& error) {
+                   Entry& entry = entries[index];
+                   entry.error = error;
+                   if (!error.empty())
+                       return;
+                   if (size != entry.size || digest != entry.digest) {
+                       entry.error = "contents differ from the manifest";
+                       return;
+                   }
+                   if (!verifier.verify(
+                           signed_message(entry.path, size, digest),
+                           entry.signature, public_key))
+                       entry.error = "invalid signature";
+               });
+    return entries;
+}
+
+namespace internal {
+inline std::string to_hex(const bytes& data) {
+    static const char digits[] = "0123456789abcdef";
+    std::string hex;
+    hex.reserve(2 * data.size());
+    for (byte b : data) {
+        hex.push_back(digits[b >> 4]);
+        hex.push_back(digits[b & 0x0F]);
+    }
+    return hex;
+}
+
+inline bytes from_hex(const std::string& hex) {
+    auto nibble = [](char c) -> int {
+        if (c >= '0' && c <= '9')
+            return c - '0';
+        if (c >= 'a' && c <= 'f')
+            return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F')
+            return c - 'A' + 10;
+        throw std::runtime_error("Invalid hex digit in manifest");
+    };
+    if (hex.size() % 2 != 0)
+        throw std::runtime_error("Odd hex length in manifest");
+    bytes data(hex.size() / 2);
+    for (std::size_t i = 0; i < data.size(); ++i)
+        data[i] = static_cast<byte>(nibble(hex[2 * i]) << 4 |
+                                    nibble(hex[2 * i + 1]));
+    return data;
+}
+} // namespace internal
+
+/**
+ * \brief Writes a manifest, see filesign/filesign.hpp
+ * \param os Output stream
+ * \param alg_name Signature algorithm
+ * \param entries Signed entries
+ * \throws std::runtime_error if an entry failed
+ */
+inline void write_manifest(std::ostream& os, const std::string& alg_name,
+                           const std::vector<Entry>& entries) {
+    os << "oqs-filesign 1 " << alg_name << '\n';
+    for (auto&& entry : entries) {
+        if (!entry.error.empty())
+            throw std::runtime_error("Can not write failed entry " +
+                                     entry.path + ": " + entry.error);
+        os << entry.size << ' ' << internal::to_hex(entry.digest) << ' '
+           << internal::to_hex(entry.signature) << ' ' << entry.path << '\n';
+    }
+}
+
+/**
+ * \brief Reads a manifest, see filesign/filesign.hpp
+ * \param is Input stream
+ * \param alg_name Receives the signature algorithm
+ * \return Entries
+ * \throws std::runtime_error on malformed input
+ */
+inline std::vector<Entry> read_manifest(std::istream& is,
+                                        std::string& alg_name) {
+    std::string line;
+    std::string magic, version;
+    if (!std::getline(is, line) ||
+        !(std::istringstream{line} >> magic >> version >> alg_name) ||
+        magic != "oqs-filesign" || version != "1")
+        throw std::runtime_error("Not an oqs-filesign manifest");
+    std::vector<Entry> entries;
+    while (std::getline(is, line)) {
+        if (line.empty())
+            continue;
+        std::istringstream ss{line};
+        std::string digest, signature;
+        Entry entry{{}, 0, {}, {}, {}};
+        if (!(ss >> entry.size >> digest >> signature) || ss.get() != ' ' ||
+            !std::getline(ss, entry.path) || entry.path.empty())
+            throw std::runtime_error("Malformed manifest line: " + line);
+        entry.digest = internal::from_hex(digest);
+        entry.signature = internal::from_hex(signature);
+        entries.emplace_back(std::move(entry));
+    }
+    return entries;
+}
+
+/**
+ * \brief Regular files under a path, recursively, sorted; symbolic links
+ * are not followed
+ * \param root File or directory
+ */
+inline std::vector<std::string> list_files(const std::string& root) {
+    std::vector<std::string> files;
+    struct stat st {};
+    if (::lstat(root.c_str(), &st) != 0)
+        throw std::runtime_error(internal::error_message(root));
+    if (S_ISREG(st.st_mode)) {
+        files.emplace_back(root);
+        return files;
+    }
+    if (!S_ISDIR(st.st_mode))
+        return files;
+    DIR* dir = ::opendir(root.c_str());
+    if (dir == nullptr)
+        throw std::runtime_error(internal::error_message(root));
+    std::vector<std::string> children;
+    while (dirent* entry = ::readdir(dir)) {
+        std::string name = entry->d_name;
+        if (name != "." && name != "..")
+            children.emplace_back(root + (root.back() == '/' ? "" : "/") +
+                                  name);
+    }
+    ::closedir(dir);
+    for (auto&& child : children) {
+        std::vector<std::string> sub = list_files(child);
+        files.insert(files.end(), sub.begin(), sub.end());
+    }
+    std::sort(files.begin(), files.end());
+    return files;
+}
+} // namespace filesign
+} // namespace oqs
+
+#endif // FILESIGN_FILESIGN_HPP_
@@ -0,0 +1,213 @@
+/**
+ * \file filesign/uring.hpp
+ * \brief Minimal io_uring reader on raw system calls (Linux, no liburing)
+ *
+ * Only what oqs::filesign needs: queueing reads into caller-owned buffers,
+ * submitting them and reaping their completions from a single thread. When
+ * the kernel headers lack io_uring, LIBOQS_CPP_HAS_IO_URING is not defined
+ * and oqs::filesign uses its thread-pool reader instead.
+ */
+
+#ifndef FILESIGN_URING_HPP_
+#define FILESIGN_URING_HPP_
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#if defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter)
+/**
+ * \brief Defined when oqs::filesign::internal::Uring is available
+ */
+#define LIBOQS_CPP_HAS_IO_URING 1
+#endif
+#endif
+#endif
+
+#ifdef LIBOQS_CPP_HAS_IO_URING
+namespace oqs {
+namespace filesign {
+namespace internal {
+/**
+ * \class oqs::filesign::internal::Uring
+ * \brief Submission and completion rings of one io_uring instance, used by
+ * a single thread
+ */
+class Uring {
+    int fd_ = -1;
+    io_uring_params params_{};
+    void* sq_ring_ = MAP_FAILED;
+    void* cq_ring_ = MAP_FAILED;
+    std::size_t sq_ring_size_ = 0;
+    std::size_t cq_ring_size_ = 0;
+    io_uring_sqe* sqes_ = nullptr;
+    unsigned queued_ = 0; // filled but not yet submitted
+
+    template <typename T>
+    T* at(void* ring, std::uint32_t offset) const {
+        return reinterpret_cast<T*>(static_cast<char*>(ring) + offset);
+    }
+
+    void release() noexcept {
+        if (sqes_ != nullptr)
+            munmap(sqes_, params_.sq_entries * sizeof(io_uring_sqe));
+        if (cq_ring_ != MAP_FAILED && cq_ring_ != sq_ring_)
+            munmap(cq_ring_, cq_ring_size_);
+        if (sq_ring_ != MAP_FAILED)
+            munmap(sq_ring_, sq_ring_size_);
+        if (fd_ >= 0)
+            ::close(fd_);
+    }
+
+    [[noreturn]] void fail(const std::string& what) {
+        int err = errno;
+        release();
+        throw std::runtime_error(what + ": " + std::strerror(err));
+    }
+
+  public:
+    /**
+     * \brief Sets up the rings
+     * \param entries Submission queue size
+     * \throws std::runtime_error if io_uring is unavailable, e.g. disabled
+     * by seccomp or sysctl
+     */
+    explicit Uring(unsigned entries) {
+        fd_ = static_cast<int>(
+            syscall(__NR_io_uring_setup, entries, &params_));
+        if (fd_ < 0)
+            fail("io_uring_setup");
+        sq_ring_size_ =
+            params_.sq_off.array + params_.sq_entries * sizeof(std::uint32_t);
+        cq_ring_size_ =
+            params_.cq_off.cqes + params_.cq_entries * sizeof(io_uring_cqe);
+        bool single = (params_.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if (single)
+            sq_ring_size_ = cq_ring_size_ =
+                std::max(sq_ring_size_, cq_ring_size_);
+        sq_ring_ = mmap(nullptr, sq_ring_size_, PROT_READ | PROT_WRITE,
+                        MAP_SHARED | MAP_POPULATE, fd_, IORING_OFF_SQ_RING);
+        if (sq_ring_ == MAP_FAILED)
+            fail("io_uring mmap");
+        cq_ring_ = single ? sq_ring_
+                          : mmap(nullptr, cq_ring_size_,
+                                 PROT_READ | PROT_WRITE,
+                                 MAP_SHARED | MAP_POPULATE, fd_,
+                                 IORING_OFF_CQ_RING);
+        if (cq_ring_ == MAP_FAILED)
+            fail("io_uring mmap");
+        void* sqes = mmap(nullptr, params_.sq_entries * sizeof(io_uring_sqe),
+                          PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                          fd_, IORING_OFF_SQES);
+        if (sqes == MAP_FAILED)
+            fail("io_uring mmap");
+        sqes_ = static_cast<io_uring_sqe*>(sqes);
+    }
+
+    Uring(const Uring&) = delete;
+    Uring& operator=(const Uring&) = delete;
+
+    /**
+     * \brief Unmaps the rings and closes the instance
+     */
+    ~Uring() { release(); }
+
+    /**
+     * \brief Submission queue size
+     */
+    unsigned capacity() const noexcept { return params_.sq_entries; }
+
+    /**
+     * \brief Queues a read, submitted by the next submit()
+     * \param fd File descriptor
+     * \param buffer Destination, must stay valid until completion
+     * \param len Number of bytes
+     * \param offset File offset
+     * \param user_data Returned with the completion
+     * \return False if the submission queue is full
+     */
+    bool read(int fd, void* buffer, unsigned len, std::uint64_t offset,
+              std::uint64_t user_data) {
+        std::uint32_t* head = at<std::uint32_t>(sq_ring_, params_.sq_off.head);
+        std::uint32_t* tail = at<std::uint32_t>(sq_ring_, params_.sq_off.tail);
+        std::uint32_t mask =
+            *at<std::uint32_t>(sq_ring_, params_.sq_off.ring_mask);
+        std::uint32_t current = *tail;
+        if (current - __atomic_load_n(head, __ATOMIC_ACQUIRE) >=
+            params_.sq_entries)
+            return false;
+        std::uint32_t index = current & mask;
+        io_uring_sqe& sqe = sqes_[index];
+        std::memset(&sqe, 0, sizeof(sqe));
+        sqe.opcode = IORING_OP_READ;
+        sqe.fd = fd;
+        sqe.addr = reinterpret_cast<std::uint64_t>(buffer);
+        sqe.len = len;
+        sqe.off = offset;
+        sqe.user_data = user_data;
+        at<std::uint32_t>(sq_ring_, params_.sq_off.array)[index] = index;
+        __atomic_store_n(tail, current + 1, __ATOMIC_RELEASE);
+        ++queued_;
+        return true;
+    }
+
+    /**
+     * \brief Submits the queued reads and waits for completions
+     * \param wait_nr Number of completions to wait for, 0 to not wait
+     */
+    void submit(unsigned wait_nr) {
+        for (;;) {
+            long rc = syscall(__NR_io_uring_enter, fd_, queued_, wait_nr,
+                              wait_nr > 0 ? IORING_ENTER_GETEVENTS : 0u,
+                              nullptr, 0);
+            if (rc >= 0) {
+                queued_ -= static_cast<unsigned>(rc);
+                return;
+            }
+            if (errno != EINTR)
+                throw std::runtime_error(std::string{"io_uring_enter: "} +
+                                         std::strerror(errno));
+        }
+    }
+
+    /**
+     * \brief Consumes the available completions
+     * \param on_completion Invoked with the user data and the result (bytes
+     * read, or minus the error number) of every completion
+     * \return Number of completions
+     */
+    template <typename F>
+    unsigned reap(F on_completion) {
+        std::uint32_t* head = at<std::uint32_t>(cq_ring_, params_.cq_off.head);
+        std::uint32_t* tail = at<std::uint32_t>(cq_ring_, params_.cq_off.tail);
+        std::uint32_t mask =
+            *at<std::uint32_t>(cq_ring_, params_.cq_off.ring_mask);
+        io_uring_cqe* cqes = at<io_uring_cqe>(cq_ring_, params_.cq_off.cqes);
+        std::uint32_t current = *head;
+        unsigned count = 0;
+        while (current != __atomic_load_n(tail, __ATOMIC_ACQUIRE)) {
+            const io_uring_cqe& cqe = cqes[current & mask];
+            on_completion(cqe.user_data, cqe.res);
+            __atomic_store_n(head, ++current, __ATOMIC_RELEASE);
+            ++count;
+        }
+        return count;
+    }
+}; // class Uring
+} // namespace internal
+} // namespace filesign
+} // namespace oqs
+#endif // LIBOQS_CPP_HAS_IO_URING
+
+#endif // FILESIGN_URING_HPP_
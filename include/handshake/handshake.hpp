@@ -0,0 +1,438 @@
+/**
+ * \file handshake/handshake.hpp
+ * \brief Reusable KEM + signature handshake engine with preallocated buffers
+ *
+ * The client sends an ephemeral KEM public key, the server encapsulates to
+ * it and authenticates the transcript with its long-term signature key, and
+ * both sides confirm the derived keys with finished MACs
+ *
+ *     ClientHello     magic "OQSH" | version (1) | random (32) |
+ *                     ephemeral KEM public key
+ *     ServerHello     random (32) | KEM ciphertext | signature length (4) |
+ *                     signature (padded to the maximum length) |
+ *                     server finished (32)
+ *     ClientFinished  client finished (32)
+ *
+ * The server signs the SHA3-256 transcript hash up to and including the KEM
+ * ciphertext. Keys are derived with SHAKE256 from the shared secret and the
+ * transcript hash including the signature. The transcript is hashed
+ * incrementally as messages are produced/consumed.
+ *
+ * All messages have a fixed size for a given (KEM, signature) pair, and all
+ * buffers are sized once, at construction, from get_details(). An instance
+ * can be reused for any number of consecutive handshakes; after the first
+ * one, the C++ side performs no further allocations.
+ */
+
+#ifndef HANDSHAKE_HANDSHAKE_HPP_
+#define HANDSHAKE_HANDSHAKE_HPP_
+
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include "common.hpp"
+#include "oqs_cpp.hpp"
+#include "rand/rand.hpp"
+#include "sha3/sha3.hpp"
+
+namespace oqs {
+/**
+ * \namespace handshake
+ * \brief Namespace containing the handshake engine
+ */
+namespace handshake {
+constexpr std::size_t random_length = 32;   ///< hello random length
+constexpr std::size_t finished_length = 32; ///< finished MAC length
+constexpr std::size_t key_length = 32;      ///< traffic key length
+
+/**
+ * \brief Handshake state
+ */
+enum class State {
+    Idle,               ///< no handshake in progress
+    WaitServerHello,    ///< client sent ClientHello
+    WaitClientFinished, ///< server sent ServerHello
+    Established,        ///< keys are available
+    Failed              ///< handshake aborted, keys were erased
+};
+
+/**
+ * \brief Traffic keys of an established session
+ */
+struct SessionKeys {
+    bytes client_write; ///< client to server key
+    bytes server_write; ///< server to client key
+};
+
+namespace internal {
+constexpr byte magic[4] = {'O', 'Q', 'S', 'H'}; ///< ClientHello magic
+constexpr byte version = 1;                      ///< protocol version
+constexpr std::size_t hello_prefix = 5;          ///< magic + version
+constexpr std::size_t length_field = 4;          ///< signature length field
+
+/**
+ * \class oqs::handshake::internal::Endpoint
+ * \brief State and buffers shared by oqs::handshake::Client and
+ * oqs::handshake::Server
+ */
+class Endpoint {
+  protected:
+    KeyEncapsulation kem_;           ///< ephemeral KEM
+    std::string sig_name_;           ///< signature algorithm name
+    std::size_t max_signature_;      ///< maximum signature length
+    std::size_t client_hello_len_;   ///< ClientHello length
+    std::size_t server_hello_len_;   ///< ServerHello length
+    sha3::SHA3_256 transcript_{};    ///< running transcript hash
+    sha3::SHA3_256 scratch_{};       ///< transcript snapshots and MACs
+    sha3::SHAKE256 kdf_{};           ///< key derivation
+    bytes th_;                       ///< last transcript hash
+    bytes shared_secret_;            ///< KEM shared secret
+    bytes ciphertext_;               ///< KEM ciphertext
+    bytes signature_;                ///< server signature
+    bytes finished_keys_;            ///< server | client finished keys
+    bytes client_hello_;             ///< ClientHello
+    bytes server_hello_;             ///< ServerHello
+    bytes client_finished_;          ///< ClientFinished
+    SessionKeys keys_;               ///< traffic keys
+    State state_ = State::Idle;      ///< handshake state
+
+    /**
+     * \brief Sizes every buffer from the algorithm details
+     * \param kem_name KEM algorithm name
+     * \param sig_name Signature algorithm name
+     * \param max_signature Maximum signature length
+     */
+    Endpoint(const std::string& kem_name, std::string sig_name,
+             std::size_t max_signature)
+        : kem_{kem_name}, sig_name_{std::move(sig_name)},
+          max_signature_{max_signature},
+          client_hello_len_{hello_prefix + random_length +
+                            kem_.get_details().length_public_key},
+          server_hello_len_{random_length +
+                            kem_.get_details().length_ciphertext +
+                            length_field + max_signature + finished_length},
+          th_(sha3::sha3_256_length),
+          shared_secret_(kem_.get_details().length_shared_secret),
+          ciphertext_(kem_.get_details().length_ciphertext), signature_(),
+          finished_keys_(2 * finished_length),
+          client_hello_(client_hello_len_), server_hello_(server_hello_len_),
+          client_finished_(finished_length),
+          keys_{bytes(key_length), bytes(key_length)} {
+        signature_.reserve(max_signature);
+    }
+
+    /**
+     * \brief Starts a new transcript, bound to the algorithm names
+     */
+    void start_transcript() {
+        static const char label[] = "liboqs-cpp handshake v1";
+        const std::string& kem_name = kem_.get_details().name;
+        byte lengths[2] = {static_cast<byte>(kem_name.size()),
+                           static_cast<byte>(sig_name_.size())};
+        transcript_.reset()
+            .absorb(reinterpret_cast<const byte*>(label), sizeof(label) - 1)
+            .absorb(lengths, sizeof(lengths))
+            .absorb(reinterpret_cast<const byte*>(kem_name.data()),
+                    kem_name.size())
+            .absorb(reinterpret_cast<const byte*>(sig_name_.data()),
+                    sig_name_.size());
+    }
+
+    /**
+     * \brief Snapshots the running transcript hash into th_
+     */
+    void snapshot_transcript() {
+        scratch_ = transcript_;
+        scratch_.finalize(th_.data());
+    }
+
+    /**
+     * \brief Finished MAC, SHA3-256(key || th_)
+     * \param key Finished key
+     * \param [out] out oqs::handshake::finished_length bytes
+     */
+    void finished_mac(const byte* key, byte* out) {
+        scratch_.reset()
+            .absorb(key, finished_length)
+            .absorb(th_)
+            .finalize(out);
+    }
+
+    /**
+     * \brief Derives the finished keys and the traffic keys from the shared
+     * secret and th_, then erases the shared secret
+     */
+    void derive_keys() {
+        static const char label[] = "liboqs-cpp handshake v1 keys";
+        kdf_.reset()
+            .absorb(reinterpret_cast<const byte*>(label), sizeof(label) - 1)
+            .absorb(shared_secret_)
+            .absorb(th_)
+            .finalize()
+            .squeeze(finished_keys_.data(), finished_keys_.size())
+            .squeeze(keys_.client_write.data(), key_length)
+            .squeeze(keys_.server_write.data(), key_length);
+        mem_cleanse(shared_secret_);
+    }
+
+    /**
+     * \brief Erases every secret and marks the handshake as failed
+     * \param what Error message
+     */
+    [[noreturn]] void fail(const char* what) {
+        mem_cleanse(shared_secret_);
+        mem_cleanse(finished_keys_);
+        mem_cleanse(keys_.client_write);
+        mem_cleanse(keys_.server_write);
+        state_ = State::Failed;
+        throw std::runtime_error(what);
+    }
+
+  public:
+    /**
+     * \brief Virtual default destructor, erases every secret
+     */
+    virtual ~Endpoint() {
+        mem_cleanse(shared_secret_);
+        mem_cleanse(finished_keys_);
+        mem_cleanse(keys_.client_write);
+        mem_cleanse(keys_.server_write);
+    }
+
+    /**
+     * \brief Handshake state
+     * \return Handshake state
+     */
+    State get_state() const { return state_; }
+
+    /**
+     * \brief Traffic keys, available once the handshake is established
+     * \return Traffic keys
+     */
+    const SessionKeys& session_keys() const {
+        if (state_ != State::Established)
+            throw std::runtime_error("Handshake not established");
+        return keys_;
+    }
+
+    /**
+     * \brief ClientHello length in bytes
+     * \return ClientHello length in bytes
+     */
+    std::size_t client_hello_length() const { return client_hello_len_; }
+
+    /**
+     * \brief ServerHello length in bytes
+     * \return ServerHello length in bytes
+     */
+    std::size_t server_hello_length() const { return server_hello_len_; }
+
+    /**
+     * \brief ClientFinished length in bytes
+     * \return ClientFinished length in bytes
+     */
+    std::size_t client_finished_length() const { return finished_length; }
+}; // class Endpoint
+} // namespace internal
+
+/**
+ * \class oqs::handshake::Client
+ * \brief Client side, authenticates the server against a pinned signature
+ * public key
+ */
+class Client : public internal::Endpoint {
+    Signature verifier_;      ///< server signature verifier
+    bytes server_public_key_; ///< pinned server signature public key
+    bytes ephemeral_public_key_; ///< ephemeral KEM public key
+
+  public:
+    /**
+     * \brief Constructs a client
+     * \param kem_name KEM algorithm name
+     * \param sig_name Signature algorithm name
+     * \param server_public_key Server signature public key
+     */
+    Client(const std::string& kem_name, const std::string& sig_name,
+           bytes server_public_key)
+        : Endpoint{kem_name, sig_name,
+                   Signature{sig_name}.get_details().max_length_signature},
+          verifier_{sig_name},
+          server_public_key_{std::move(server_public_key)},
+          ephemeral_public_key_(kem_.get_details().length_public_key) {
+        if (server_public_key_.size() !=
+            verifier_.get_details().length_public_key)
+            throw std::runtime_error("Incorrect public key length");
+    }
+
+    /**
+     * \brief Starts a new handshake, aborting any handshake in progress
+     * \return ClientHello, valid until the next call on this instance
+     */
+    const bytes& client_hello() {
+        kem_.generate_keypair(ephemeral_public_key_);
+        std::copy(internal::magic, internal::magic + 4,
+                  client_hello_.begin());
+        client_hello_[4] = internal::version;
+        C::OQS_randombytes(client_hello_.data() + internal::hello_prefix,
+                           random_length);
+        std::copy(ephemeral_public_key_.begin(), ephemeral_public_key_.end(),
+                  client_hello_.begin() + internal::hello_prefix +
+                      random_length);
+
+        start_transcript();
+        transcript_.absorb(client_hello_);
+        state_ = State::WaitServerHello;
+
+        return client_hello_;
+    }
+
+    /**
+     * \brief Consumes the ServerHello, establishes the session
+     * \param server_hello ServerHello
+     * \return ClientFinished, valid until the next call on this instance
+     */
+    const bytes& process_server_hello(const bytes& server_hello) {
+        if (state_ != State::WaitServerHello)
+            fail("Unexpected ServerHello");
+        if (server_hello.size() != server_hello_len_)
+            fail("Incorrect ServerHello length");
+
+        const std::size_t ct_len = ciphertext_.size();
+        const byte* ct = server_hello.data() + random_length;
+        const byte* sig_field = ct + ct_len;
+        const byte* server_finished = server_hello.data() +
+                                      server_hello_len_ - finished_length;
+        std::copy(ct, ct + ct_len, ciphertext_.begin());
+
+        // Server signature over the transcript up to the ciphertext
+        transcript_.absorb(server_hello.data(), random_length + ct_len);
+        snapshot_transcript();
+        std::size_t sig_len = (std::size_t{sig_field[0]} << 24) |
+                              (std::size_t{sig_field[1]} << 16) |
+                              (std::size_t{sig_field[2]} << 8) |
+                              std::size_t{sig_field[3]};
+        if (sig_len > max_signature_)
+            fail("Incorrect signature length");
+        signature_.assign(sig_field + internal::length_field,
+                          sig_field + internal::length_field + sig_len);
+        if (!verifier_.verify(th_, signature_, server_public_key_))
+            fail("Server signature verification failed");
+
+        transcript_.absorb(sig_field, internal::length_field + max_signature_);
+        snapshot_transcript();
+        kem_.decap_secret(ciphertext_, shared_secret_);
+        derive_keys();
+
+        byte expected[finished_length];
+        finished_mac(finished_keys_.data(), expected);
+        if (C::OQS_MEM_secure_bcmp(expected, server_finished,
+                                   finished_length) != 0)
+            fail("Server finished verification failed");
+
+        transcript_.absorb(server_finished, finished_length);
+        snapshot_transcript();
+        finished_mac(finished_keys_.data() + finished_length,
+                     client_finished_.data());
+        state_ = State::Established;
+
+        return client_finished_;
+    }
+}; // class Client
+
+/**
+ * \class oqs::handshake::Server
+ * \brief Server side, holds the long-term signature key
+ */
+class Server : public internal::Endpoint {
+    Signature signer_;           ///< long-term signer (holds the secret key)
+    bytes peer_public_key_;      ///< client ephemeral KEM public key
+    bytes expected_finished_;    ///< expected ClientFinished
+
+  public:
+    /**
+     * \brief Constructs a server
+     * \param kem_name KEM algorithm name
+     * \param signer oqs::Signature instance holding the server secret key
+     */
+    Server(const std::string& kem_name, Signature signer)
+        : Endpoint{kem_name, signer.get_details().name,
+                   signer.get_details().max_length_signature},
+          signer_{std::move(signer)},
+          peer_public_key_(kem_.get_details().length_public_key),
+          expected_finished_(finished_length) {}
+
+    /**
+     * \brief Consumes a ClientHello, aborting any handshake in progress
+     * \param client_hello ClientHello
+     * \return ServerHello, valid until the next call on this instance
+     */
+    const bytes& process_client_hello(const bytes& client_hello) {
+        if (client_hello.size() != client_hello_len_ ||
+            !std::equal(internal::magic, internal::magic + 4,
+                        client_hello.begin()) ||
+            client_hello[4] != internal::version)
+            fail("Invalid ClientHello");
+
+        std::copy(client_hello.begin() + internal::hello_prefix +
+                      random_length,
+                  client_hello.end(), peer_public_key_.begin());
+        start_transcript();
+        transcript_.absorb(client_hello);
+
+        const std::size_t ct_len = ciphertext_.size();
+        byte* ct = server_hello_.data() + random_length;
+        byte* sig_field = ct + ct_len;
+        byte* server_finished =
+            server_hello_.data() + server_hello_len_ - finished_length;
+        C::OQS_randombytes(server_hello_.data(), random_length);
+        kem_.encap_secret(peer_public_key_, ciphertext_, shared_secret_);
+        std::copy(ciphertext_.begin(), ciphertext_.end(), ct);
+
+        transcript_.absorb(server_hello_.data(), random_length + ct_len);
+        snapshot_transcript();
+        signer_.sign(th_, signature_);
+        std::size_t sig_len = signature_.size();
+        sig_field[0] = static_cast<byte>(sig_len >> 24);
+        sig_field[1] = static_cast<byte>(sig_len >> 16);
+        sig_field[2] = static_cast<byte>(sig_len >> 8);
+        sig_field[3] = static_cast<byte>(sig_len);
+        byte* sig = sig_field + internal::length_field;
+        std::copy(signature_.begin(), signature_.end(), sig);
+        std::fill(sig + sig_len, sig + max_signature_, byte{0});
+
+        transcript_.absorb(sig_field, internal::length_field + max_signature_);
+        snapshot_transcript();
+        derive_keys();
+        finished_mac(finished_keys_.data(), server_finished);
+
+        transcript_.absorb(server_finished, finished_length);
+        snapshot_transcript();
+        finished_mac(finished_keys_.data() + finished_length,
+                     expected_finished_.data());
+        state_ = State::WaitClientFinished;
+
+        return server_hello_;
+    }
+
+    /**
+     * \brief Consumes the ClientFinished, establishes the session
+     * \param client_finished ClientFinished
+     */
+    void process_client_finished(const bytes& client_finished) {
+        if (state_ != State::WaitClientFinished)
+            fail("Unexpected ClientFinished");
+        if (client_finished.size() != finished_length ||
+            C::OQS_MEM_secure_bcmp(client_finished.data(),
+                                   expected_finished_.data(),
+                                   finished_length) != 0)
+            fail("Client finished verification failed");
+        state_ = State::Established;
+    }
+}; // class Server
+} // namespace handshake
+} // namespace oqs
+
+#endif // HANDSHAKE_HANDSHAKE_HPP_
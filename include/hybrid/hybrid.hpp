@@ -0,0 +1,391 @@
+/**
+ * \file hybrid/hybrid.hpp
+ * \brief Hybrid X25519 + ML-KEM-768 key encapsulation (X-Wing), presented
+ * as a single KEM
+ *
+ * Layouts (pk_M, sk_M, ct_M, ss_M from ML-KEM-768, the others from X25519)
+ *
+ *     public key    = pk_M (1184) | pk_X (32)
+ *     ciphertext    = ct_M (1088) | ct_X (32)
+ *     secret key    = sk_M (2400) | sk_X (32) | pk_X (32)
+ *     shared secret = SHA3-256(ss_M | ss_X | ct_X | pk_X | "\.//^\")
+ *
+ * with the X-Wing combiner of draft-connolly-cfrg-xwing-kem. Encapsulation
+ * draws an ephemeral X25519 key ek_X and sets ct_X = X25519(ek_X, 9),
+ * ss_X = X25519(ek_X, pk_X); decapsulation computes ss_X = X25519(sk_X,
+ * ct_X).
+ *
+ * Both halves write straight into the caller's buffers: the ML-KEM
+ * ciphertext and the X25519 ciphertext are the two ends of one ciphertext
+ * buffer, and the combiner input is a fixed-size stack buffer, so the
+ * pointer overloads never allocate and let the ciphertext and the shared
+ * secret live in one buffer (e.g., a message being built). Given an
+ * oqs::async::WorkerPool, the X25519 half runs on the pool while the
+ * calling thread runs the ML-KEM half.
+ *
+ * \note liboqs has no deterministic ML-KEM key generation from a seed, hence
+ * the secret key is stored expanded (as in the early X-Wing drafts) instead
+ * of as the 32-byte seed of the final draft; public keys, ciphertexts and
+ * shared secrets follow the final draft.
+ */
+
+#ifndef HYBRID_HYBRID_HPP_
+#define HYBRID_HYBRID_HPP_
+
+#include <algorithm>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include "async/async.hpp"
+#include "common.hpp"
+#include "oqs_cpp.hpp"
+#include "sha3/sha3.hpp"
+#include "x25519/x25519.hpp"
+
+namespace oqs {
+/**
+ * \namespace hybrid
+ * \brief Namespace containing the hybrid KEMs
+ */
+namespace hybrid {
+/**
+ * \brief X-Wing combiner label "\.//^\"
+ */
+constexpr byte xwing_label[6] = {0x5c, 0x2e, 0x2f, 0x2f, 0x5e, 0x5c};
+
+namespace internal {
+/**
+ * \brief Runs \a first on the calling thread and \a second on \a pool (on
+ * the calling thread too without a pool), returns once both are done
+ * \note Neither may throw; must not be called from the pool's own threads
+ */
+template <typename F, typename G>
+void run_both(async::WorkerPool* pool, F first, G second) {
+    if (pool == nullptr) {
+        first();
+        second();
+        return;
+    }
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool done = false;
+    pool->post([&] {
+        second();
+        // Notifies under the lock, as the waiter destroys cv once it returns
+        std::lock_guard<std::mutex> lock{mutex};
+        done = true;
+        cv.notify_one();
+    });
+    first();
+    std::unique_lock<std::mutex> lock{mutex};
+    cv.wait(lock, [&] { return done; });
+}
+} // namespace internal
+
+/**
+ * \class oqs::hybrid::XWing
+ * \brief X-Wing hybrid KEM, see hybrid/hybrid.hpp
+ * \note Const member functions are thread-safe, and copies share the secret
+ * key, as for oqs::KeyEncapsulation
+ */
+class XWing {
+    std::shared_ptr<C::OQS_KEM> kem_{nullptr, [](C::OQS_KEM* p) {
+                                         C::OQS_KEM_free(p);
+                                     }}; ///< ML-KEM-768
+    SharedSecretKey secret_key_{};       ///< sk_M | sk_X | pk_X
+    async::WorkerPool* pool_ = nullptr;  ///< runs the X25519 half, optional
+    KeyEncapsulation::KeyEncapsulationDetails alg_details_{}; ///< details
+
+    std::size_t length_mlkem_public_key() const {
+        return kem_->length_public_key;
+    }
+
+    std::size_t length_mlkem_secret_key() const {
+        return kem_->length_secret_key;
+    }
+
+    std::size_t length_mlkem_ciphertext() const {
+        return kem_->length_ciphertext;
+    }
+
+    /**
+     * \brief Shared secret from the combiner input ss_M | ss_X | ct_X |
+     * pk_X | label, zeroed afterwards
+     */
+    static void combine(byte* input, byte* shared_secret) {
+        std::copy(xwing_label, xwing_label + sizeof(xwing_label),
+                  input + 4 * x25519::key_length);
+        std::size_t length = 4 * x25519::key_length + sizeof(xwing_label);
+        C::OQS_SHA3_sha3_256(shared_secret, input, length);
+        C::OQS_MEM_cleanse(input, length);
+    }
+
+    void check_secret_key() const {
+        if (secret_key_.size() != alg_details_.length_secret_key)
+            throw std::runtime_error(
+                "Incorrect secret key length, make sure you "
+                "specify one in the constructor or run "
+                "oqs::hybrid::XWing::generate_keypair()");
+    }
+
+  public:
+    /**
+     * \brief Constructs an instance of oqs::hybrid::XWing
+     * \param secret_key Secret key (optional), not copied
+     * \param pool Worker pool running the X25519 half concurrently with the
+     * ML-KEM half (optional), must outlive the instance
+     */
+    explicit XWing(bytes secret_key = {}, async::WorkerPool* pool = nullptr)
+        : secret_key_{std::move(secret_key)}, pool_{pool} {
+        const std::string mlkem_name = "ML-KEM-768";
+        if (!KEMs::is_KEM_enabled(mlkem_name)) {
+            if (KEMs::is_KEM_supported(mlkem_name))
+                throw MechanismNotEnabledError(mlkem_name);
+            else
+                throw MechanismNotSupportedError(mlkem_name);
+        }
+        kem_.reset(C::OQS_KEM_new(mlkem_name.c_str()),
+                   [](C::OQS_KEM* p) { C::OQS_KEM_free(p); });
+
+        alg_details_.name = "X-Wing";
+        alg_details_.version = std::string{"X25519 + "} + kem_->method_name +
+                               " " + kem_->alg_version;
+        alg_details_.claimed_nist_level = kem_->claimed_nist_level;
+        alg_details_.is_ind_cca = kem_->ind_cca;
+        alg_details_.length_public_key =
+            length_mlkem_public_key() + x25519::key_length;
+        alg_details_.length_secret_key =
+            length_mlkem_secret_key() + 2 * x25519::key_length;
+        alg_details_.length_ciphertext =
+            length_mlkem_ciphertext() + x25519::key_length;
+        alg_details_.length_shared_secret = sha3::sha3_256_length;
+    }
+
+    /**
+     * \brief Constructs an instance of oqs::hybrid::XWing sharing
+     * \a secret_key, e.g., obtained with share_secret_key()
+     * \param secret_key Secret key
+     * \param pool Worker pool (optional), must outlive the instance
+     */
+    explicit XWing(SharedSecretKey secret_key,
+                   async::WorkerPool* pool = nullptr)
+        : XWing{bytes{}, pool} {
+        secret_key_ = std::move(secret_key);
+    }
+
+    /**
+     * \brief Default copy constructor, the copy shares the liboqs handle,
+     * the secret key and the pool
+     */
+    XWing(const XWing&) = default;
+
+    /**
+     * \brief Default copy assignment operator
+     * \return Reference to the current instance
+     */
+    XWing& operator=(const XWing&) = default;
+
+    /**
+     * \brief Hybrid KEM details, in the format of oqs::KeyEncapsulation
+     * \return Details
+     */
+    const KeyEncapsulation::KeyEncapsulationDetails& get_details() const {
+        return alg_details_;
+    }
+
+    /**
+     * \brief Generate public key/secret key pair in place
+     * \param [out] public_key Public key, get_details().length_public_key
+     * bytes
+     */
+    void generate_keypair(byte* public_key) {
+        bytes secret_key(alg_details_.length_secret_key);
+        byte* sk_x = secret_key.data() + length_mlkem_secret_key();
+        byte* pk_x = public_key + length_mlkem_public_key();
+        C::OQS_randombytes(sk_x, x25519::key_length);
+
+        OQS_STATUS rv_ = OQS_STATUS::OQS_ERROR;
+        internal::run_both(
+            pool_,
+            [&] {
+                rv_ = C::OQS_KEM_keypair(kem_.get(), public_key,
+                                         secret_key.data());
+            },
+            [&] { x25519::scalarmult_base(pk_x, sk_x); });
+        if (rv_ != OQS_STATUS::OQS_SUCCESS) {
+            mem_cleanse(secret_key);
+            throw std::runtime_error("Can not generate keypair");
+        }
+        std::copy(pk_x, pk_x + x25519::key_length,
+                  sk_x + x25519::key_length);
+        secret_key_ = SharedSecretKey{std::move(secret_key)};
+    }
+
+    /**
+     * \brief Generate public key/secret key pair in place
+     * \note Reuses the storage of \a public_key
+     * \param [out] public_key Public key
+     */
+    void generate_keypair(bytes& public_key) {
+        public_key.resize(alg_details_.length_public_key);
+        generate_keypair(public_key.data());
+    }
+
+    /**
+     * \brief Generate public key/secret key pair
+     * \return Public key
+     */
+    bytes generate_keypair() {
+        bytes public_key;
+        generate_keypair(public_key);
+        return public_key;
+    }
+
+    /**
+     * \brief Export secret key
+     * \return Secret key
+     */
+    bytes export_secret_key() const { return secret_key_.to_bytes(); }
+
+    /**
+     * \brief Share the secret key, without copying it
+     * \return Secret key, shared with the current instance
+     */
+    SharedSecretKey share_secret_key() const { return secret_key_; }
+
+    /**
+     * \brief Encapsulate secret into caller-provided buffers, which may be
+     * parts of one buffer; does not allocate
+     * \param public_key Public key, get_details().length_public_key bytes
+     * \param [out] ciphertext Ciphertext,
+     * get_details().length_ciphertext bytes
+     * \param [out] shared_secret Shared secret,
+     * get_details().length_shared_secret bytes
+     */
+    void encap_secret(const byte* public_key, byte* ciphertext,
+                      byte* shared_secret) const {
+        const byte* pk_x = public_key + length_mlkem_public_key();
+        byte* ct_x = ciphertext + length_mlkem_ciphertext();
+        byte input[4 * x25519::key_length + sizeof(xwing_label)];
+        byte ek_x[x25519::key_length];
+        C::OQS_randombytes(ek_x, sizeof(ek_x));
+
+        OQS_STATUS rv_ = OQS_STATUS::OQS_ERROR;
+        internal::run_both(
+            pool_,
+            [&] {
+                rv_ = C::OQS_KEM_encaps(kem_.get(), ciphertext, input,
+                                        public_key);
+            },
+            [&] {
+                x25519::scalarmult_base(ct_x, ek_x);
+                x25519::scalarmult(input + x25519::key_length, ek_x, pk_x);
+            });
+        C::OQS_MEM_cleanse(ek_x, sizeof(ek_x));
+        if (rv_ != OQS_STATUS::OQS_SUCCESS) {
+            C::OQS_MEM_cleanse(input, sizeof(input));
+            throw std::runtime_error("Can not encapsulate secret");
+        }
+        std::copy(ct_x, ct_x + x25519::key_length,
+                  input + 2 * x25519::key_length);
+        std::copy(pk_x, pk_x + x25519::key_length,
+                  input + 3 * x25519::key_length);
+        combine(input, shared_secret);
+    }
+
+    /**
+     * \brief Encapsulate secret in-place
+     * \note Reuses the storage of \a ciphertext and \a shared_secret, hence
+     * does not allocate once they have the right size
+     * \param public_key Public key
+     * \param [out] ciphertext Ciphertext
+     * \param [out] shared_secret Shared secret
+     */
+    void encap_secret(const bytes& public_key, bytes& ciphertext,
+                      bytes& shared_secret) const {
+        if (public_key.size() != alg_details_.length_public_key)
+            throw std::runtime_error("Incorrect public key length");
+        ciphertext.resize(alg_details_.length_ciphertext);
+        shared_secret.resize(alg_details_.length_shared_secret);
+        encap_secret(public_key.data(), ciphertext.data(),
+                     shared_secret.data());
+    }
+
+    /**
+     * \brief Encapsulate secret
+     * \param public_key Public key
+     * \return Pair consisting of 1) ciphertext, and 2) shared secret
+     */
+    std::pair<bytes, bytes> encap_secret(const bytes& public_key) const {
+        std::pair<bytes, bytes> result;
+        encap_secret(public_key, result.first, result.second);
+        return result;
+    }
+
+    /**
+     * \brief Decapsulate secret into a caller-provided buffer; does not
+     * allocate
+     * \param ciphertext Ciphertext, get_details().length_ciphertext bytes
+     * \param [out] shared_secret Shared secret,
+     * get_details().length_shared_secret bytes
+     */
+    void decap_secret(const byte* ciphertext, byte* shared_secret) const {
+        check_secret_key();
+        const byte* sk_x = secret_key_.data() + length_mlkem_secret_key();
+        const byte* ct_x = ciphertext + length_mlkem_ciphertext();
+        byte input[4 * x25519::key_length + sizeof(xwing_label)];
+
+        OQS_STATUS rv_ = OQS_STATUS::OQS_ERROR;
+        internal::run_both(
+            pool_,
+            [&] {
+                rv_ = C::OQS_KEM_decaps(kem_.get(), input, ciphertext,
+                                        secret_key_.data());
+            },
+            [&] {
+                x25519::scalarmult(input + x25519::key_length, sk_x, ct_x);
+            });
+        if (rv_ != OQS_STATUS::OQS_SUCCESS) {
+            C::OQS_MEM_cleanse(input, sizeof(input));
+            throw std::runtime_error("Can not decapsulate secret");
+        }
+        std::copy(ct_x, ct_x + x25519::key_length,
+                  input + 2 * x25519::key_length);
+        std::copy(sk_x + x25519::key_length, sk_x + 2 * x25519::key_length,
+                  input + 3 * x25519::key_length);
+        combine(input, shared_secret);
+    }
+
+    /**
+     * \brief Decapsulate secret in-place
+     * \note Reuses the storage of \a shared_secret, hence does not allocate
+     * once it has the right size
+     * \param ciphertext Ciphertext
+     * \param [out] shared_secret Shared secret
+     */
+    void decap_secret(const bytes& ciphertext, bytes& shared_secret) const {
+        if (ciphertext.size() != alg_details_.length_ciphertext)
+            throw std::runtime_error("Incorrect ciphertext length");
+        shared_secret.resize(alg_details_.length_shared_secret);
+        decap_secret(ciphertext.data(), shared_secret.data());
+    }
+
+    /**
+     * \brief Decapsulate secret
+     * \param ciphertext Ciphertext
+     * \return Shared secret
+     */
+    bytes decap_secret(const bytes& ciphertext) const {
+        bytes shared_secret;
+        decap_secret(ciphertext, shared_secret);
+        return shared_secret;
+    }
+}; // class XWing
+} // namespace hybrid
+} // namespace oqs
+
+#endif // HYBRID_HYBRID_HPP_
@@ -0,0 +1,559 @@
+/**
+ * \file kemdem/kemdem.hpp
+ * \brief HPKE-style KEM-DEM streaming seal/open, AES-256-CTR + SHA3-256
+ * (encrypt-then-MAC) over independently authenticated chunks
+ *
+ * Stream layout (all integers big-endian)
+ *
+ *     magic "OQSD" | version (1) | name length (1) | KEM name |
+ *     chunk size (4) | KEM ciphertext | records[]
+ *
+ * Every record carries one chunk of at most "chunk size" bytes
+ *
+ *     length (4, top bit set on the final record) | ciphertext | tag (32)
+ *
+ * All records but the final one are full. The tag covers the record index,
+ * the length field and the ciphertext, hence reordering, truncation and
+ * extension are detected. Encryption, decryption and authentication of the
+ * chunks of a batch run in parallel, so only a bounded number of chunks are
+ * ever held in memory.
+ */
+
+#ifndef KEMDEM_KEMDEM_HPP_
+#define KEMDEM_KEMDEM_HPP_
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#if defined(_WIN32)
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+#include "aes/aes.hpp"
+#include "common.hpp"
+#include "oqs_cpp.hpp"
+#include "sha3/sha3.hpp"
+
+namespace oqs {
+/**
+ * \namespace kemdem
+ * \brief Namespace containing the KEM-DEM streaming seal/open API
+ */
+namespace kemdem {
+constexpr std::size_t default_chunk_size = 64 * 1024; ///< default chunk size
+constexpr std::size_t max_chunk_size = 16 * 1024 * 1024; ///< max chunk size
+constexpr std::size_t tag_length = 32; ///< per-record tag length
+
+namespace internal {
+constexpr byte magic[4] = {'O', 'Q', 'S', 'D'}; ///< stream magic
+constexpr byte version = 1;                      ///< stream version
+constexpr std::uint32_t final_flag = 0x80000000u; ///< final record flag
+constexpr std::size_t length_field = 4; ///< record length field size
+
+/**
+ * \brief Keys derived from the KEM shared secret and the stream header
+ */
+struct Keys {
+    byte enc[aes::key_length];      ///< AES-256 key
+    byte mac[32];                   ///< SHA3-256 tag key
+    byte nonce[aes::nonce_length]; ///< base nonce
+
+    /**
+     * \brief Zeroes the keys
+     */
+    ~Keys() { C::OQS_MEM_cleanse(this, sizeof(*this)); }
+};
+
+/**
+ * \brief Derives the stream keys
+ * \param header Serialized stream header, including the KEM ciphertext
+ * \param shared_secret KEM shared secret
+ * \param [out] keys Derived keys
+ */
+inline void derive_keys(const bytes& header, const bytes& shared_secret,
+                        Keys& keys) {
+    static const char label[] = "liboqs-cpp kemdem v1";
+    sha3::SHAKE256 xof;
+    xof.absorb(reinterpret_cast<const byte*>(label), sizeof(label) - 1)
+        .absorb(header)
+        .absorb(shared_secret)
+        .finalize()
+        .squeeze(keys.enc, sizeof(keys.enc))
+        .squeeze(keys.mac, sizeof(keys.mac))
+        .squeeze(keys.nonce, sizeof(keys.nonce));
+}
+
+/**
+ * \brief Writes \a value big-endian into 4 bytes
+ */
+inline void store_u32(byte* out, std::uint32_t value) {
+    out[0] = static_cast<byte>(value >> 24);
+    out[1] = static_cast<byte>(value >> 16);
+    out[2] = static_cast<byte>(value >> 8);
+    out[3] = static_cast<byte>(value);
+}
+
+/**
+ * \brief Reads a big-endian 32-bit value
+ */
+inline std::uint32_t load_u32(const byte* in) {
+    return (std::uint32_t{in[0]} << 24) | (std::uint32_t{in[1]} << 16) |
+           (std::uint32_t{in[2]} << 8) | std::uint32_t{in[3]};
+}
+
+/**
+ * \brief Per-record nonce, the base nonce XOR-ed with the record index
+ * \param base Base nonce
+ * \param index Record index
+ * \param [out] nonce Record nonce
+ */
+inline void record_nonce(const byte* base, std::uint64_t index, byte* nonce) {
+    std::copy(base, base + aes::nonce_length, nonce);
+    for (std::size_t i = 0; i < 8; ++i)
+        nonce[aes::nonce_length - 1 - i] ^= static_cast<byte>(index >> (8 * i));
+}
+
+/**
+ * \brief Record tag, SHA3-256(mac key || index || length field || ciphertext)
+ * \param mac_key Tag key
+ * \param index Record index
+ * \param record Record, starting with the length field
+ * \param len Ciphertext length
+ * \param [out] tag oqs::kemdem::tag_length bytes
+ */
+inline void record_tag(const byte* mac_key, std::uint64_t index,
+                       const byte* record, std::size_t len, byte* tag) {
+    byte idx[8];
+    for (std::size_t i = 0; i < 8; ++i)
+        idx[i] = static_cast<byte>(index >> (56 - 8 * i));
+    sha3::SHA3_256 h;
+    h.absorb(mac_key, 32)
+        .absorb(idx, sizeof(idx))
+        .absorb(record, length_field + len)
+        .digest(tag);
+}
+
+/**
+ * \brief Reads until \a len bytes have been read or the reader is exhausted
+ * \return Number of bytes read
+ */
+template <typename Reader>
+std::size_t read_full(Reader& in, byte* buf, std::size_t len) {
+    std::size_t total = 0;
+    while (total < len) {
+        std::size_t n = in(buf + total, len - total);
+        if (n == 0)
+            break;
+        total += n;
+    }
+    return total;
+}
+
+/**
+ * \brief Reads exactly \a len bytes, throws on a short read
+ */
+template <typename Reader>
+void read_exact(Reader& in, byte* buf, std::size_t len) {
+    if (read_full(in, buf, len) != len)
+        throw std::runtime_error("Truncated stream");
+}
+
+/**
+ * \brief Number of chunks processed per batch
+ */
+inline std::size_t batch_size(std::size_t num_threads) {
+    if (num_threads == 0)
+        num_threads = std::thread::hardware_concurrency();
+    return 4 * (num_threads == 0 ? 1 : num_threads);
+}
+
+/**
+ * \class oqs::kemdem::internal::FdReader
+ * \brief Reader over a file descriptor
+ */
+struct FdReader {
+    int fd; ///< file descriptor
+
+    /**
+     * \brief Reads at most \a len bytes
+     * \return Number of bytes read, 0 at end of file
+     */
+    std::size_t operator()(byte* buf, std::size_t len) const {
+        for (;;) {
+#if defined(_WIN32)
+            int n = ::_read(fd, buf,
+                            static_cast<unsigned>(std::min<std::size_t>(
+                                len, 1u << 30)));
+#else
+            ssize_t n = ::read(fd, buf, len);
+#endif
+            if (n >= 0)
+                return static_cast<std::size_t>(n);
+            if (errno != EINTR)
+                throw std::runtime_error("Can not read from file descriptor");
+        }
+    }
+};
+
+/**
+ * \class oqs::kemdem::internal::FdWriter
+ * \brief Writer over a file descriptor
+ */
+struct FdWriter {
+    int fd; ///< file descriptor
+
+    /**
+     * \brief Writes \a len bytes
+     */
+    void operator()(const byte* buf, std::size_t len) const {
+        while (len > 0) {
+#if defined(_WIN32)
+            int n = ::_write(fd, buf,
+                             static_cast<unsigned>(std::min<std::size_t>(
+                                 len, 1u << 30)));
+#else
+            ssize_t n = ::write(fd, buf, len);
+#endif
+            if (n < 0) {
+                if (errno == EINTR)
+                    continue;
+                throw std::runtime_error("Can not write to file descriptor");
+            }
+            buf += n;
+            len -= static_cast<std::size_t>(n);
+        }
+    }
+};
+} // namespace internal
+
+/**
+ * \brief Encapsulates to \a public_key and seals everything \a in produces
+ * into \a out
+ * \tparam Reader Callable std::size_t(oqs::byte* buf, std::size_t len),
+ * returns the number of bytes read (at most \a len), 0 at end of input
+ * \tparam Writer Callable void(const oqs::byte* buf, std::size_t len)
+ * \param kem_name KEM algorithm name
+ * \param public_key Recipient public key
+ * \param in Reader
+ * \param out Writer
+ * \param chunk_size Chunk size in bytes
+ * \param num_threads Maximum number of threads, 0 means
+ * std::thread::hardware_concurrency()
+ */
+template <typename Reader, typename Writer>
+void seal_stream(const std::string& kem_name, const bytes& public_key,
+                 Reader&& in, Writer&& out,
+                 std::size_t chunk_size = default_chunk_size,
+                 std::size_t num_threads = 0) {
+    if (chunk_size == 0 || chunk_size > max_chunk_size)
+        throw std::runtime_error("Invalid chunk size");
+    if (kem_name.size() > 255)
+        throw std::runtime_error("KEM name too long");
+
+    KeyEncapsulation kem{kem_name};
+    bytes ciphertext, shared_secret;
+    std::tie(ciphertext, shared_secret) = kem.encap_secret(public_key);
+
+    bytes header(6 + kem_name.size() + 4);
+    std::copy(internal::magic, internal::magic + 4, header.begin());
+    header[4] = internal::version;
+    header[5] = static_cast<byte>(kem_name.size());
+    std::copy(kem_name.begin(), kem_name.end(), header.begin() + 6);
+    internal::store_u32(&header[6 + kem_name.size()],
+                        static_cast<std::uint32_t>(chunk_size));
+    header.insert(header.end(), ciphertext.begin(), ciphertext.end());
+    out(header.data(), header.size());
+
+    internal::Keys keys;
+    internal::derive_keys(header, shared_secret, keys);
+    mem_cleanse(shared_secret);
+    aes::AES256_CTR cipher{keys.enc};
+
+    // Records are assembled in place: length field | chunk | tag
+    const std::size_t record_size =
+        internal::length_field + chunk_size + tag_length;
+    const std::size_t batch = internal::batch_size(num_threads);
+    std::vector<bytes> records(batch, bytes(record_size));
+    std::vector<std::size_t> lens(batch);
+    bytes next(record_size);
+
+    std::size_t next_len = internal::read_full(
+        in, next.data() + internal::length_field, chunk_size);
+    std::uint64_t index = 0;
+    bool done = false;
+    while (!done) {
+        // Fill the batch, reading one chunk ahead to spot the final one
+        std::size_t count = 0;
+        while (count < batch) {
+            std::swap(records[count], next);
+            lens[count] = next_len;
+            ++count;
+            if (lens[count - 1] < chunk_size) {
+                done = true;
+                break;
+            }
+            next_len = internal::read_full(
+                in, next.data() + internal::length_field, chunk_size);
+            if (next_len == 0) {
+                done = true;
+                break;
+            }
+        }
+
+        oqs::internal::parallel_for(count, num_threads, [&](std::size_t i) {
+            byte* record = records[i].data();
+            std::uint32_t field = static_cast<std::uint32_t>(lens[i]);
+            if (done && i == count - 1)
+                field |= internal::final_flag;
+            internal::store_u32(record, field);
+            byte nonce[aes::nonce_length];
+            internal::record_nonce(keys.nonce, index + i, nonce);
+            cipher.crypt(nonce, 0, record + internal::length_field, lens[i]);
+            internal::record_tag(keys.mac, index + i, record, lens[i],
+                                 record + internal::length_field + lens[i]);
+        });
+
+        for (std::size_t i = 0; i < count; ++i)
+            out(records[i].data(),
+                internal::length_field + lens[i] + tag_length);
+        index += count;
+    }
+}
+
+/**
+ * \brief Decapsulates with \a recipient and opens everything \a in produces
+ * into \a out
+ * \note Plaintext is released batch by batch, after every chunk of the batch
+ * has been authenticated. A truncated or extended stream is only detected
+ * once the reader is exhausted, in which case an exception is thrown and the
+ * output written so far must be discarded
+ * \tparam Reader Callable std::size_t(oqs::byte* buf, std::size_t len),
+ * returns the number of bytes read (at most \a len), 0 at end of input
+ * \tparam Writer Callable void(const oqs::byte* buf, std::size_t len)
+ * \param recipient oqs::KeyEncapsulation instance holding the recipient's
+ * secret key
+ * \param in Reader
+ * \param out Writer
+ * \param num_threads Maximum number of threads, 0 means
+ * std::thread::hardware_concurrency()
+ */
+template <typename Reader, typename Writer>
+void open_stream(const KeyEncapsulation& recipient, Reader&& in, Writer&& out,
+                 std::size_t num_threads = 0) {
+    const auto& details = recipient.get_details();
+
+    bytes header(6);
+    internal::read_exact(in, header.data(), header.size());
+    if (!std::equal(internal::magic, internal::magic + 4, header.begin()))
+        throw std::runtime_error("Invalid stream header");
+    if (header[4] != internal::version)
+        throw std::runtime_error("Unsupported stream header version");
+    std::size_t name_len = header[5];
+    header.resize(6 + name_len + 4 + details.length_ciphertext);
+    internal::read_exact(in, header.data() + 6, name_len + 4);
+    if (std::string(header.begin() + 6, header.begin() + 6 + name_len) !=
+        details.name)
+        throw std::runtime_error("Stream KEM mismatch");
+    std::size_t chunk_size = internal::load_u32(&header[6 + name_len]);
+    if (chunk_size == 0 || chunk_size > max_chunk_size)
+        throw std::runtime_error("Invalid chunk size");
+    byte* ct = &header[6 + name_len + 4];
+    internal::read_exact(in, ct, details.length_ciphertext);
+
+    bytes shared_secret =
+        recipient.decap_secret(bytes(ct, ct + details.length_ciphertext));
+    internal::Keys keys;
+    internal::derive_keys(header, shared_secret, keys);
+    mem_cleanse(shared_secret);
+    aes::AES256_CTR cipher{keys.enc};
+
+    const std::size_t record_size =
+        internal::length_field + chunk_size + tag_length;
+    const std::size_t batch = internal::batch_size(num_threads);
+    std::vector<bytes> records(batch, bytes(record_size));
+    std::vector<std::size_t> lens(batch);
+    std::vector<char> valid(batch);
+    std::uint64_t index = 0;
+    bool done = false;
+    while (!done) {
+        std::size_t count = 0;
+        while (count < batch) {
+            byte* record = records[count].data();
+            std::size_t n =
+                internal::read_full(in, record, internal::length_field);
+            if (n != internal::length_field)
+                throw std::runtime_error("Truncated stream");
+            std::uint32_t field = internal::load_u32(record);
+            std::size_t len = field & ~internal::final_flag;
+            bool is_final = (field & internal::final_flag) != 0;
+            if (len > chunk_size || (!is_final && len != chunk_size))
+                throw std::runtime_error("Invalid record length");
+            internal::read_exact(in, record + internal::length_field,
+                                 len + tag_length);
+            lens[count++] = len;
+            if (is_final) {
+                byte extra;
+                if (internal::read_full(in, &extra, 1) != 0)
+                    throw std::runtime_error("Trailing data after stream");
+                done = true;
+                break;
+            }
+        }
+
+        oqs::internal::parallel_for(count, num_threads, [&](std::size_t i) {
+            byte* record = records[i].data();
+            byte tag[tag_length];
+            internal::record_tag(keys.mac, index + i, record, lens[i], tag);
+            valid[i] = C::OQS_MEM_secure_bcmp(
+                           tag, record + internal::length_field + lens[i],
+                           tag_length) == 0;
+            if (!valid[i])
+                return;
+            byte nonce[aes::nonce_length];
+            internal::record_nonce(keys.nonce, index + i, nonce);
+            cipher.crypt(nonce, 0, record + internal::length_field, lens[i]);
+        });
+
+        for (std::size_t i = 0; i < count; ++i)
+            if (!valid[i])
+                throw std::runtime_error("Can not open stream");
+        for (std::size_t i = 0; i < count; ++i)
+            out(records[i].data() + internal::length_field, lens[i]);
+        index += count;
+    }
+}
+
+/**
+ * \brief Seals the content of file descriptor \a fd_in into \a fd_out
+ * \see oqs::kemdem::seal_stream()
+ */
+inline void seal_fd(const std::string& kem_name, const bytes& public_key,
+                    int fd_in, int fd_out,
+                    std::size_t chunk_size = default_chunk_size,
+                    std::size_t num_threads = 0) {
+    seal_stream(kem_name, public_key, internal::FdReader{fd_in},
+                internal::FdWriter{fd_out}, chunk_size, num_threads);
+}
+
+/**
+ * \brief Opens the content of file descriptor \a fd_in into \a fd_out
+ * \see oqs::kemdem::open_stream()
+ */
+inline void open_fd(const KeyEncapsulation& recipient, int fd_in, int fd_out,
+                    std::size_t num_threads = 0) {
+    open_stream(recipient, internal::FdReader{fd_in},
+                internal::FdWriter{fd_out}, num_threads);
+}
+
+/**
+ * \brief Seals the content of \a is into \a os
+ * \see oqs::kemdem::seal_stream()
+ */
+inline void seal_iostream(const std::string& kem_name,
+                          const bytes& public_key, std::istream& is,
+                          std::ostream& os,
+                          std::size_t chunk_size = default_chunk_size,
+                          std::size_t num_threads = 0) {
+    seal_stream(
+        kem_name, public_key,
+        [&is](byte* buf, std::size_t len) {
+            is.read(reinterpret_cast<char*>(buf),
+                    static_cast<std::streamsize>(len));
+            return static_cast<std::size_t>(is.gcount());
+        },
+        [&os](const byte* buf, std::size_t len) {
+            if (!os.write(reinterpret_cast<const char*>(buf),
+                          static_cast<std::streamsize>(len)))
+                throw std::runtime_error("Can not write to stream");
+        },
+        chunk_size, num_threads);
+}
+
+/**
+ * \brief Opens the content of \a is into \a os
+ * \see oqs::kemdem::open_stream()
+ */
+inline void open_iostream(const KeyEncapsulation& recipient, std::istream& is,
+                          std::ostream& os, std::size_t num_threads = 0) {
+    open_stream(
+        recipient,
+        [&is](byte* buf, std::size_t len) {
+            is.read(reinterpret_cast<char*>(buf),
+                    static_cast<std::streamsize>(len));
+            return static_cast<std::size_t>(is.gcount());
+        },
+        [&os](const byte* buf, std::size_t len) {
+            if (!os.write(reinterpret_cast<const char*>(buf),
+                          static_cast<std::streamsize>(len)))
+                throw std::runtime_error("Can not write to stream");
+        },
+        num_threads);
+}
+
+/**
+ * \brief Seals an in-memory message
+ * \see oqs::kemdem::seal_stream()
+ * \return Sealed stream
+ */
+inline bytes seal(const std::string& kem_name, const bytes& public_key,
+                  const bytes& plaintext,
+                  std::size_t chunk_size = default_chunk_size,
+                  std::size_t num_threads = 0) {
+    bytes result;
+    std::size_t offset = 0;
+    seal_stream(
+        kem_name, public_key,
+        [&](byte* buf, std::size_t len) {
+            std::size_t n = std::min(len, plaintext.size() - offset);
+            std::copy(plaintext.begin() + offset,
+                      plaintext.begin() + offset + n, buf);
+            offset += n;
+            return n;
+        },
+        [&result](const byte* buf, std::size_t len) {
+            result.insert(result.end(), buf, buf + len);
+        },
+        chunk_size, num_threads);
+    return result;
+}
+
+/**
+ * \brief Opens an in-memory sealed stream
+ * \see oqs::kemdem::open_stream()
+ * \return Plaintext
+ */
+inline bytes open(const KeyEncapsulation& recipient, const bytes& sealed,
+                  std::size_t num_threads = 0) {
+    bytes result;
+    std::size_t offset = 0;
+    open_stream(
+        recipient,
+        [&](byte* buf, std::size_t len) {
+            std::size_t n = std::min(len, sealed.size() - offset);
+            std::copy(sealed.begin() + offset, sealed.begin() + offset + n,
+                      buf);
+            offset += n;
+            return n;
+        },
+        [&result](const byte* buf, std::size_t len) {
+            result.insert(result.end(), buf, buf + len);
+        },
+        num_threads);
+    return result;
+}
+} // namespace kemdem
+} // namespace oqs
+
+#endif // KEMDEM_KEMDEM_HPP_
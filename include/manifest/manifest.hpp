@@ -0,0 +1,658 @@
+/**
+ * \file manifest/manifest.hpp
+ * \brief Indexed detached-signature manifest: the signatures of many objects
+ * in a single file, looked up by object id without parsing the file
+ *
+ * File layout (all integers big-endian)
+ *
+ *     magic "OQSM" | version (1) | flags (1) | name length (1) |
+ *     signature name | key id (32) | maximum id length (2) |
+ *     number of entries (8) |
+ *     [Merkle root (32) | root signature length (4) | root signature] |
+ *     entries[] | signatures
+ *
+ * The Merkle root and its signature are present when bit 0 of flags is set.
+ * Entries have fixed size and are sorted by object id, so the entry of an
+ * object is found by binary search, touching O(log n) pages of a mapped
+ * file
+ *
+ *     id length (2) | id (zero-padded to the maximum id length) |
+ *     digest (32) | signature offset (8) | signature length (4)
+ *
+ * with signature offsets relative to the start of the signatures. The key id
+ * is the SHA3-256 of the signer's public key, the digest is the SHA3-256 of
+ * the object's contents (see oqs::manifest::digest()). Each entry's
+ * signature covers
+ *
+ *     "oqs-manifest 1" | 0 | key id | id length (2) | id | digest
+ *
+ * The Merkle tree is a SHA3-256 tree over the entries in index order, with
+ * leaves SHA3-256(0 | id length (2) | id | digest), nodes SHA3-256(1 | left |
+ * right) and an unpaired last node carried up to the next level; the root
+ * signature covers
+ *
+ *     "oqs-manifest 1 root" | 0 | key id | number of entries (8) | root
+ *
+ * so one signature authenticates the whole set of (id, digest) pairs.
+ */
+
+#ifndef MANIFEST_MANIFEST_HPP_
+#define MANIFEST_MANIFEST_HPP_
+
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "common.hpp"
+#include "oqs_cpp.hpp"
+#include "sha3/sha3.hpp"
+
+namespace oqs {
+/**
+ * \namespace manifest
+ * \brief Namespace containing the indexed detached-signature manifest
+ */
+namespace manifest {
+constexpr std::size_t digest_length = sha3::sha3_256_length; ///< digest
+constexpr std::size_t key_id_length = sha3::sha3_256_length; ///< key id
+constexpr std::size_t max_id_length = 0xFFFF; ///< longest object id
+
+/**
+ * \brief Digest of an object's contents, SHA3-256
+ */
+inline bytes digest(const bytes& contents) { return sha3::sha3_256(contents); }
+
+/**
+ * \brief Key id of a signer's public key, SHA3-256
+ */
+inline bytes key_id(const bytes& public_key) {
+    return sha3::sha3_256(public_key);
+}
+
+/**
+ * \brief One entry of a manifest
+ */
+struct Entry {
+    std::string id;  ///< object id
+    bytes digest;    ///< digest of the object's contents
+    bytes signature; ///< signature of the entry
+};
+
+namespace internal {
+constexpr byte magic[4] = {'O', 'Q', 'S', 'M'}; ///< file magic
+constexpr byte version = 1;                      ///< file version
+constexpr byte flag_merkle_root = 1;             ///< Merkle root present
+
+inline void put_be(bytes& out, std::uint64_t value, std::size_t len) {
+    for (std::size_t i = len; i-- > 0;)
+        out.push_back(static_cast<byte>(value >> (8 * i)));
+}
+
+inline std::uint64_t get_be(const byte* in, std::size_t len) {
+    std::uint64_t value = 0;
+    for (std::size_t i = 0; i < len; ++i)
+        value = (value << 8) | in[i];
+    return value;
+}
+
+/**
+ * \brief Message signed for an entry, see manifest/manifest.hpp
+ */
+inline bytes entry_message(const byte* key_id, const std::string& id,
+                           const byte* digest) {
+    static const char tag[] = "oqs-manifest 1";
+    bytes message(tag, tag + sizeof(tag)); // with the terminating 0
+    message.insert(message.end(), key_id, key_id + key_id_length);
+    put_be(message, id.size(), 2);
+    message.insert(message.end(), id.begin(), id.end());
+    message.insert(message.end(), digest, digest + digest_length);
+    return message;
+}
+
+/**
+ * \brief Message of the root signature, see manifest/manifest.hpp
+ */
+inline bytes root_message(const byte* key_id, std::uint64_t count,
+                          const byte* root) {
+    static const char tag[] = "oqs-manifest 1 root";
+    bytes message(tag, tag + sizeof(tag));
+    message.insert(message.end(), key_id, key_id + key_id_length);
+    put_be(message, count, 8);
+    message.insert(message.end(), root, root + digest_length);
+    return message;
+}
+
+/**
+ * \brief Merkle leaf of an entry
+ */
+inline bytes merkle_leaf(const std::string& id, const byte* digest) {
+    byte prefix[3] = {0, static_cast<byte>(id.size() >> 8),
+                      static_cast<byte>(id.size())};
+    bytes leaf(digest_length);
+    sha3::SHA3_256 h;
+    h.absorb(prefix, sizeof(prefix))
+        .absorb(reinterpret_cast<const byte*>(id.data()), id.size())
+        .absorb(digest, digest_length)
+        .digest(leaf.data());
+    return leaf;
+}
+
+/**
+ * \brief Merkle root of the leaves, consumed
+ */
+inline bytes merkle_root(std::vector<bytes> level) {
+    if (level.empty())
+        return sha3::sha3_256({});
+    static const byte node_prefix = 1;
+    while (level.size() > 1) {
+        std::vector<bytes> next;
+        for (std::size_t i = 0; i + 1 < level.size(); i += 2) {
+            bytes node(digest_length);
+            sha3::SHA3_256 h;
+            h.absorb(&node_prefix, 1)
+                .absorb(level[i])
+                .absorb(level[i + 1])
+                .digest(node.data());
+            next.emplace_back(std::move(node));
+        }
+        if (level.size() % 2 != 0)
+            next.emplace_back(std::move(level.back()));
+        level = std::move(next);
+    }
+    return level.front();
+}
+} // namespace internal
+
+/**
+ * \class oqs::manifest::Builder
+ * \brief Collects (object id, digest) pairs and produces a signed manifest
+ */
+class Builder {
+    std::vector<std::pair<std::string, bytes>> objects_{};
+
+  public:
+    /**
+     * \brief Adds an object
+     * \param id Object id, 1 to oqs::manifest::max_id_length bytes, unique
+     * \param digest Digest of the object's contents, see
+     * oqs::manifest::digest()
+     */
+    void add(const std::string& id, const bytes& digest) {
+        if (id.empty() || id.size() > max_id_length)
+            throw std::invalid_argument("Invalid object id length");
+        if (digest.size() != digest_length)
+            throw std::invalid_argument("Incorrect digest length");
+        objects_.emplace_back(id, digest);
+    }
+
+    /**
+     * \brief Number of objects added
+     */
+    std::size_t size() const noexcept { return objects_.size(); }
+
+    /**
+     * \brief Signs every object and serializes the manifest
+     * \note Signatures are computed in parallel, see
+     * oqs::internal::parallel_for()
+     * \param signer oqs::Signature instance holding the secret key
+     * \param public_key Signer's public key, identified in the manifest by
+     * its key id
+     * \param with_merkle_root Whether to add the signed Merkle root
+     * \param num_threads Maximum number of threads, 0 means
+     * std::thread::hardware_concurrency()
+     * \return Serialized manifest
+     */
+    bytes build(const Signature& signer, const bytes& public_key,
+                bool with_merkle_root = true,
+                std::size_t num_threads = 0) const {
+        const std::string& alg_name = signer.get_details().name;
+        if (alg_name.size() > 255)
+            throw std::runtime_error("Signature name too long");
+        std::vector<std::size_t> order(objects_.size());
+        for (std::size_t i = 0; i < order.size(); ++i)
+            order[i] = i;
+        std::sort(order.begin(), order.end(),
+                  [this](std::size_t lhs, std::size_t rhs) {
+                      return objects_[lhs].first < objects_[rhs].first;
+                  });
+        std::size_t id_length = 0;
+        for (std::size_t i = 0; i < order.size(); ++i) {
+            if (i > 0 && objects_[order[i - 1]].first ==
+                             objects_[order[i]].first)
+                throw std::runtime_error("Duplicate object id " +
+                                         objects_[order[i]].first);
+            id_length = std::max(id_length, objects_[order[i]].first.size());
+        }
+
+        bytes kid = key_id(public_key);
+        std::vector<bytes> signatures(order.size());
+        oqs::internal::parallel_for(
+            order.size(), num_threads, [&](std::size_t slot) {
+                const auto& object = objects_[order[slot]];
+                signer.sign(internal::entry_message(kid.data(), object.first,
+                                                    object.second.data()),
+                            signatures[slot]);
+            });
+
+        bytes out(internal::magic, internal::magic + 4);
+        out.push_back(internal::version);
+        out.push_back(with_merkle_root ? internal::flag_merkle_root : 0);
+        out.push_back(static_cast<byte>(alg_name.size()));
+        out.insert(out.end(), alg_name.begin(), alg_name.end());
+        out.insert(out.end(), kid.begin(), kid.end());
+        internal::put_be(out, id_length, 2);
+        internal::put_be(out, order.size(), 8);
+        if (with_merkle_root) {
+            std::vector<bytes> leaves(order.size());
+            oqs::internal::parallel_for(
+                order.size(), num_threads, [&](std::size_t slot) {
+                    const auto& object = objects_[order[slot]];
+                    leaves[slot] = internal::merkle_leaf(
+                        object.first, object.second.data());
+                });
+            bytes root = internal::merkle_root(std::move(leaves));
+            bytes root_signature = signer.sign(
+                internal::root_message(kid.data(), order.size(), root.data()));
+            out.insert(out.end(), root.begin(), root.end());
+            internal::put_be(out, root_signature.size(), 4);
+            out.insert(out.end(), root_signature.begin(),
+                       root_signature.end());
+        }
+
+        std::uint64_t offset = 0;
+        for (std::size_t slot = 0; slot < order.size(); ++slot) {
+            const auto& object = objects_[order[slot]];
+            internal::put_be(out, object.first.size(), 2);
+            out.insert(out.end(), object.first.begin(), object.first.end());
+            out.resize(out.size() + id_length - object.first.size(), 0);
+            out.insert(out.end(), object.second.begin(), object.second.end());
+            internal::put_be(out, offset, 8);
+            internal::put_be(out, signatures[slot].size(), 4);
+            offset += signatures[slot].size();
+        }
+        for (auto&& signature : signatures)
+            out.insert(out.end(), signature.begin(), signature.end());
+        return out;
+    }
+}; // class Builder
+
+/**
+ * \class oqs::manifest::Manifest
+ * \brief Read-only view of a serialized manifest, e.g., a mapped file
+ *
+ * Opening parses the header only; entries are decoded on access, so lookups
+ * touch only the index pages on the binary search path. The ordering of the
+ * index is not checked on opening (that would read the whole index), but by
+ * verify_range() and verify_all().
+ */
+class Manifest {
+    const byte* data_;
+    std::size_t size_;
+    std::string alg_name_{};
+    bytes key_id_{};
+    bytes merkle_root_{};
+    bytes root_signature_{};
+    std::size_t id_length_ = 0;
+    std::size_t count_ = 0;
+    std::size_t entries_offset_ = 0;
+    std::size_t entry_length_ = 0;
+    std::size_t signatures_offset_ = 0;
+
+    [[noreturn]] static void invalid() {
+        throw std::runtime_error("Invalid manifest");
+    }
+
+    const byte* entry_data(std::size_t index) const {
+        if (index >= count_)
+            throw std::out_of_range("Manifest entry out of range");
+        return data_ + entries_offset_ + index * entry_length_;
+    }
+
+    void check_verifier(const Signature& verifier,
+                        const bytes& public_key) const {
+        if (verifier.get_details().name != alg_name_)
+            throw std::runtime_error("Manifest signature algorithm mismatch");
+        if (manifest::key_id(public_key) != key_id_)
+            throw std::runtime_error("Manifest key id mismatch");
+    }
+
+    bool verify_entry(const Signature& verifier, const bytes& public_key,
+                      const Entry& entry) const {
+        try {
+            return verifier.verify(
+                internal::entry_message(key_id_.data(), entry.id,
+                                        entry.digest.data()),
+                entry.signature, public_key);
+        } catch (const std::runtime_error&) {
+            return false; // e.g., wrong signature length
+        }
+    }
+
+  public:
+    /**
+     * \brief Opens a serialized manifest, which must outlive the instance
+     * \param data Serialized manifest
+     * \param size Size in bytes
+     * \throws std::runtime_error if the header is malformed
+     */
+    Manifest(const byte* data, std::size_t size) : data_{data}, size_{size} {
+        std::size_t offset = 7;
+        if (size_ < offset || !std::equal(internal::magic,
+                                          internal::magic + 4, data_))
+            invalid();
+        if (data_[4] != internal::version)
+            throw std::runtime_error("Unsupported manifest version");
+        bool has_root = (data_[5] & internal::flag_merkle_root) != 0;
+        std::size_t name_length = data_[6];
+        if (size_ - offset < name_length + key_id_length + 2 + 8)
+            invalid();
+        alg_name_.assign(data_ + offset, data_ + offset + name_length);
+        offset += name_length;
+        key_id_.assign(data_ + offset, data_ + offset + key_id_length);
+        offset += key_id_length;
+        id_length_ =
+            static_cast<std::size_t>(internal::get_be(data_ + offset, 2));
+        std::uint64_t count = internal::get_be(data_ + offset + 2, 8);
+        offset += 10;
+        if (has_root) {
+            if (size_ - offset < digest_length + 4)
+                invalid();
+            merkle_root_.assign(data_ + offset,
+                                data_ + offset + digest_length);
+            std::size_t length = static_cast<std::size_t>(
+                internal::get_be(data_ + offset + digest_length, 4));
+            offset += digest_length + 4;
+            if (size_ - offset < length)
+                invalid();
+            root_signature_.assign(data_ + offset, data_ + offset + length);
+            offset += length;
+        }
+        entry_length_ = 2 + id_length_ + digest_length + 8 + 4;
+        if (count > (size_ - offset) / entry_length_)
+            invalid();
+        count_ = static_cast<std::size_t>(count);
+        entries_offset_ = offset;
+        signatures_offset_ = offset + count_ * entry_length_;
+    }
+
+    /**
+     * \brief Opens a serialized manifest, which must outlive the instance
+     */
+    explicit Manifest(const bytes& data) : Manifest{data.data(), data.size()} {}
+
+    Manifest(const Manifest&) = default;
+    Manifest& operator=(const Manifest&) = default;
+
+    /**
+     * \brief Number of entries
+     */
+    std::size_t size() const noexcept { return count_; }
+
+    /**
+     * \brief Signature algorithm
+     */
+    const std::string& alg_name() const noexcept { return alg_name_; }
+
+    /**
+     * \brief Key id of the signer's public key
+     */
+    const bytes& key_id() const noexcept { return key_id_; }
+
+    /**
+     * \brief Whether the manifest has a signed Merkle root
+     */
+    bool has_merkle_root() const noexcept { return !merkle_root_.empty(); }
+
+    /**
+     * \brief Merkle root, empty if absent
+     */
+    const bytes& merkle_root() const noexcept { return merkle_root_; }
+
+    /**
+     * \brief Object id of an entry, decoded without the digest and signature
+     * \param index Entry index, in id order
+     */
+    std::string id(std::size_t index) const {
+        const byte* entry = entry_data(index);
+        std::size_t length =
+            static_cast<std::size_t>(internal::get_be(entry, 2));
+        if (length > id_length_)
+            invalid();
+        return std::string(entry + 2, entry + 2 + length);
+    }
+
+    /**
+     * \brief Decodes an entry
+     * \param index Entry index, in id order
+     * \throws std::runtime_error if the entry is malformed
+     */
+    Entry entry(std::size_t index) const {
+        const byte* data = entry_data(index);
+        Entry result{id(index), {}, {}};
+        const byte* digest = data + 2 + id_length_;
+        result.digest.assign(digest, digest + digest_length);
+        std::uint64_t offset = internal::get_be(digest + digest_length, 8);
+        std::uint64_t length = internal::get_be(digest + digest_length + 8, 4);
+        std::size_t available = size_ - signatures_offset_;
+        if (offset > available || length > available - offset)
+            invalid();
+        const byte* signature = data_ + signatures_offset_ + offset;
+        result.signature.assign(signature,
+                                signature + static_cast<std::size_t>(length));
+        return result;
+    }
+
+    /**
+     * \brief Index of an object's entry, by binary search
+     * \param id Object id
+     * \return Entry index, or size() if the object is not in the manifest
+     */
+    std::size_t find(const std::string& id) const {
+        std::size_t lo = 0, hi = count_;
+        while (lo < hi) {
+            std::size_t mid = lo + (hi - lo) / 2;
+            int cmp = this->id(mid).compare(id);
+            if (cmp == 0)
+                return mid;
+            if (cmp < 0)
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+        return count_;
+    }
+
+    /**
+     * \brief Verifies one object
+     * \param verifier oqs::Signature instance of the manifest's algorithm
+     * \param public_key Signer's public key
+     * \param id Object id
+     * \param digest Digest of the object's current contents
+     * \return True if the object is in the manifest with this digest and a
+     * valid signature
+     */
+    bool verify(const Signature& verifier, const bytes& public_key,
+                const std::string& id, const bytes& digest) const {
+        check_verifier(verifier, public_key);
+        std::size_t index = find(id);
+        if (index == count_)
+            return false;
+        Entry entry = this->entry(index);
+        return entry.digest == digest &&
+               verify_entry(verifier, public_key, entry);
+    }
+
+    /**
+     * \brief Verifies the signatures of a range of entries, and that their
+     * ids are strictly increasing (including from the entry before \a begin)
+     * \param verifier oqs::Signature instance of the manifest's algorithm
+     * \param public_key Signer's public key
+     * \param begin First entry
+     * \param end One past the last entry
+     * \return Indices of the invalid entries, ascending
+     */
+    std::vector<std::size_t> verify_range(const Signature& verifier,
+                                          const bytes& public_key,
+                                          std::size_t begin,
+                                          std::size_t end) const {
+        check_verifier(verifier, public_key);
+        if (begin > end || end > count_)
+            throw std::out_of_range("Manifest range out of range");
+        std::vector<std::size_t> failed;
+        std::string previous;
+        bool has_previous = false;
+        if (begin > 0) {
+            try {
+                previous = id(begin - 1);
+                has_previous = true;
+            } catch (const std::runtime_error&) {
+            }
+        }
+        for (std::size_t i = begin; i < end; ++i) {
+            bool valid = false;
+            try {
+                Entry entry = this->entry(i);
+                valid = (i == 0 || (has_previous && previous < entry.id)) &&
+                        verify_entry(verifier, public_key, entry);
+                previous = std::move(entry.id);
+                has_previous = true;
+            } catch (const std::runtime_error&) {
+                has_previous = false;
+            }
+            if (!valid)
+                failed.emplace_back(i);
+        }
+        return failed;
+    }
+
+    /**
+     * \brief Verifies all entries, in parallel chunks
+     * \note See oqs::internal::parallel_for()
+     * \param verifier oqs::Signature instance of the manifest's algorithm
+     * \param public_key Signer's public key
+     * \param num_threads Maximum number of threads, 0 means
+     * std::thread::hardware_concurrency()
+     * \param chunk_size Entries per chunk
+     * \return Indices of the invalid entries, ascending
+     */
+    std::vector<std::size_t> verify_all(const Signature& verifier,
+                                        const bytes& public_key,
+                                        std::size_t num_threads = 0,
+                                        std::size_t chunk_size = 1024) const {
+        if (chunk_size == 0)
+            throw std::invalid_argument("chunk_size must be at least 1");
+        std::size_t chunks = (count_ + chunk_size - 1) / chunk_size;
+        std::vector<std::vector<std::size_t>> failed(chunks);
+        oqs::internal::parallel_for(chunks, num_threads, [&](std::size_t c) {
+            failed[c] = verify_range(verifier, public_key, c * chunk_size,
+                                     std::min(count_, (c + 1) * chunk_size));
+        });
+        std::vector<std::size_t> result;
+        for (auto&& chunk : failed)
+            result.insert(result.end(), chunk.begin(), chunk.end());
+        return result;
+    }
+
+    /**
+     * \brief Recomputes the Merkle root from the index and verifies the root
+     * signature, authenticating every (id, digest) pair at once
+     * \param verifier oqs::Signature instance of the manifest's algorithm
+     * \param public_key Signer's public key
+     * \param num_threads Maximum number of threads for the leaves, 0 means
+     * std::thread::hardware_concurrency()
+     * \return True if the root matches and its signature is valid, false
+     * also if the manifest has no Merkle root
+     */
+    bool verify_merkle_root(const Signature& verifier, const bytes& public_key,
+                            std::size_t num_threads = 0) const {
+        check_verifier(verifier, public_key);
+        if (!has_merkle_root())
+            return false;
+        std::vector<bytes> leaves(count_);
+        oqs::internal::parallel_for(count_, num_threads, [&](std::size_t i) {
+            leaves[i] = internal::merkle_leaf(
+                id(i), entry_data(i) + 2 + id_length_);
+        });
+        if (internal::merkle_root(std::move(leaves)) != merkle_root_)
+            return false;
+        try {
+            return verifier.verify(
+                internal::root_message(key_id_.data(), count_,
+                                       merkle_root_.data()),
+                root_signature_, public_key);
+        } catch (const std::runtime_error&) {
+            return false;
+        }
+    }
+}; // class Manifest
+
+#ifndef _WIN32
+/**
+ * \class oqs::manifest::MappedFile
+ * \brief Read-only memory mapping of a whole file, e.g., a manifest
+ */
+class MappedFile {
+    void* data_ = MAP_FAILED;
+    std::size_t size_ = 0;
+
+  public:
+    /**
+     * \brief Maps a file
+     * \param path File path
+     * \throws std::runtime_error if the file can not be opened or mapped
+     */
+    explicit MappedFile(const std::string& path) {
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0)
+            throw std::runtime_error("Can not open " + path);
+        struct stat st {};
+        if (::fstat(fd, &st) != 0) {
+            ::close(fd);
+            throw std::runtime_error("Can not stat " + path);
+        }
+        size_ = static_cast<std::size_t>(st.st_size);
+        if (size_ > 0)
+            data_ = ::mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (size_ > 0 && data_ == MAP_FAILED)
+            throw std::runtime_error("Can not map " + path);
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    /**
+     * \brief Unmaps the file
+     */
+    ~MappedFile() {
+        if (data_ != MAP_FAILED)
+            ::munmap(data_, size_);
+    }
+
+    /**
+     * \brief Mapped contents, nullptr for an empty file
+     */
+    const byte* data() const noexcept {
+        return data_ == MAP_FAILED ? nullptr : static_cast<const byte*>(data_);
+    }
+
+    /**
+     * \brief File size
+     */
+    std::size_t size() const noexcept { return size_; }
+}; // class MappedFile
+#endif // _WIN32
+} // namespace manifest
+} // namespace oqs
+
+#endif // MANIFEST_MANIFEST_HPP_
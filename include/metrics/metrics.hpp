@@ -0,0 +1,442 @@
+/**
+ * \file metrics/metrics.hpp
+ * \brief Per-algorithm operation metrics (call and failure counters, latency
+ * histograms) with a Prometheus text exporter
+ *
+ * oqs::KeyEncapsulation and oqs::Signature record into these metrics only
+ * when compiled with LIBOQS_CPP_METRICS defined (CMake option
+ * LIBOQS_CPP_METRICS); otherwise this header is not included by oqs_cpp.hpp
+ * and the instrumentation compiles to nothing. LIBOQS_CPP_METRICS must be
+ * defined consistently in every translation unit of a program.
+ */
+
+#ifndef METRICS_METRICS_HPP_
+#define METRICS_METRICS_HPP_
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "common.hpp"
+
+namespace oqs {
+/**
+ * \namespace metrics
+ * \brief Namespace containing the operation metrics
+ */
+namespace metrics {
+/**
+ * \brief Instrumented operations
+ */
+enum class Operation { Keypair, Encaps, Decaps, Sign, Verify };
+
+constexpr std::size_t num_operations = 5; ///< number of operations
+constexpr std::size_t max_algorithms = 512; ///< tracked (kind, name) pairs
+constexpr std::size_t latency_octaves = 40; ///< latency range, 1 ns to 2^40 ns
+constexpr std::size_t latency_sub_buckets = 8; ///< buckets per octave
+constexpr std::size_t num_latency_buckets =
+    latency_octaves * latency_sub_buckets; ///< number of latency buckets
+
+/**
+ * \brief Lower-case name of an operation, e.g., "encaps"
+ */
+inline const char* operation_name(Operation op) {
+    switch (op) {
+        case Operation::Keypair:
+            return "keypair";
+        case Operation::Encaps:
+            return "encaps";
+        case Operation::Decaps:
+            return "decaps";
+        case Operation::Sign:
+            return "sign";
+        case Operation::Verify:
+            return "verify";
+    }
+    return "unknown";
+}
+
+/**
+ * \brief Upper bound of a latency bucket, in nanoseconds
+ * \param idx Bucket index
+ */
+inline double latency_bucket_upper_ns(std::size_t idx) {
+    std::size_t octave = idx / latency_sub_buckets;
+    std::size_t sub = idx % latency_sub_buckets;
+    return std::ldexp(1 + static_cast<double>(sub + 1) / latency_sub_buckets,
+                      static_cast<int>(octave));
+}
+
+/**
+ * \brief Latency bucket of a duration
+ * \param ns Duration in nanoseconds
+ */
+inline std::size_t latency_bucket(std::uint64_t ns) noexcept {
+    if (ns <= 1)
+        return 0;
+    int exponent;
+    double mantissa = std::frexp(static_cast<double>(ns), &exponent);
+    auto octave = static_cast<std::size_t>(exponent - 1);
+    if (octave >= latency_octaves)
+        return num_latency_buckets - 1;
+    return octave * latency_sub_buckets +
+           static_cast<std::size_t>((mantissa - 0.5) * 2 *
+                                    latency_sub_buckets);
+}
+
+/**
+ * \brief Snapshot of the metrics of one (algorithm, operation) pair
+ */
+struct OperationStats {
+    std::string algorithm;           ///< algorithm name
+    std::string kind;                ///< "kem" or "sig"
+    Operation operation;             ///< operation
+    std::uint64_t calls;             ///< completed liboqs calls
+    std::uint64_t failures;          ///< calls not returning OQS_SUCCESS
+    double latency_sum;              ///< total latency, in seconds
+    std::vector<std::uint64_t> latency_buckets; ///< latency histogram
+
+    /**
+     * \brief Mean latency, in seconds
+     */
+    double mean() const {
+        return calls == 0 ? 0 : latency_sum / static_cast<double>(calls);
+    }
+
+    /**
+     * \brief Latency percentile, upper bound of the bucket containing it
+     * \param p Percentile in [0, 100]
+     * \return Latency in seconds, 0 if no calls were recorded
+     */
+    double percentile(double p) const {
+        auto rank = static_cast<std::uint64_t>(
+            std::ceil(p / 100 * static_cast<double>(calls)));
+        rank = rank == 0 ? 1 : rank;
+        std::uint64_t seen = 0;
+        for (std::size_t i = 0; i < latency_buckets.size(); ++i) {
+            seen += latency_buckets[i];
+            if (seen >= rank)
+                return latency_bucket_upper_ns(i) * 1e-9;
+        }
+        return 0;
+    }
+};
+
+namespace internal {
+/**
+ * \class oqs::metrics::internal::Cell
+ * \brief Metrics of one (algorithm, operation) pair on one thread, padded on
+ * both sides so that cells of different threads never share a cache line
+ *
+ * Only the owning thread writes (plain load + store, no read-modify-write);
+ * snapshots read concurrently with relaxed atomic loads
+ */
+struct Cell {
+    char pad0_[64]{};
+    std::atomic<std::uint64_t> calls{0};
+    std::atomic<std::uint64_t> failures{0};
+    std::atomic<std::uint64_t> latency_ns{0};
+    std::atomic<std::uint64_t> buckets[num_latency_buckets];
+    char pad1_[64]{};
+
+    Cell() {
+        for (auto&& elem : buckets)
+            elem.store(0, std::memory_order_relaxed);
+    }
+
+    static void add(std::atomic<std::uint64_t>& counter,
+                    std::uint64_t value) noexcept {
+        counter.store(counter.load(std::memory_order_relaxed) + value,
+                      std::memory_order_relaxed);
+    }
+
+    void record(std::uint64_t ns, bool ok) noexcept {
+        add(calls, 1);
+        if (!ok)
+            add(failures, 1);
+        add(latency_ns, ns);
+        add(buckets[latency_bucket(ns)], 1);
+    }
+
+    // Adds the counts of rhs, used when the owner thread exits
+    void merge(const Cell& rhs) noexcept {
+        add(calls, rhs.calls.load(std::memory_order_relaxed));
+        add(failures, rhs.failures.load(std::memory_order_relaxed));
+        add(latency_ns, rhs.latency_ns.load(std::memory_order_relaxed));
+        for (std::size_t i = 0; i < num_latency_buckets; ++i)
+            add(buckets[i], rhs.buckets[i].load(std::memory_order_relaxed));
+    }
+};
+
+/**
+ * \class oqs::metrics::internal::Table
+ * \brief Lazily allocated cells, indexed by (algorithm id, operation)
+ */
+class Table {
+    std::atomic<Cell*> cells_[max_algorithms * num_operations];
+
+  public:
+    Table() {
+        for (auto&& elem : cells_)
+            elem.store(nullptr, std::memory_order_relaxed);
+    }
+
+    Table(const Table&) = delete;
+
+    Table& operator=(const Table&) = delete;
+
+    ~Table() {
+        for (auto&& elem : cells_)
+            delete elem.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * \brief Cell of (id, op), created on first use by the owning thread
+     */
+    Cell& cell(std::size_t id, Operation op) {
+        std::atomic<Cell*>& slot =
+            cells_[id * num_operations + static_cast<std::size_t>(op)];
+        Cell* result = slot.load(std::memory_order_acquire);
+        if (result == nullptr) {
+            result = new Cell;
+            slot.store(result, std::memory_order_release);
+        }
+        return *result;
+    }
+
+    /**
+     * \brief Cell of (id, op) if it exists, nullptr otherwise
+     */
+    const Cell* find(std::size_t id, Operation op) const {
+        return cells_[id * num_operations + static_cast<std::size_t>(op)].load(
+            std::memory_order_acquire);
+    }
+};
+
+/**
+ * \class oqs::metrics::internal::Registry
+ * \brief Algorithm ids and the tables of all live threads
+ */
+class Registry {
+  public:
+    std::mutex mutex_;
+    std::vector<std::pair<std::string, std::string>> algorithms_; ///< kind,name
+    std::vector<const Table*> threads_; ///< tables of the live threads
+    Table retired_;                     ///< counts of the exited threads
+
+    Registry() : mutex_{}, algorithms_{}, threads_{}, retired_{} {}
+
+    /**
+     * \brief Id of (kind, name), allocated on first use
+     * \return Id, or max_algorithms when the registry is full
+     */
+    std::size_t id(const std::string& kind, const std::string& name) {
+        std::lock_guard<std::mutex> lock{mutex_};
+        for (std::size_t i = 0; i < algorithms_.size(); ++i)
+            if (algorithms_[i].first == kind && algorithms_[i].second == name)
+                return i;
+        if (algorithms_.size() == max_algorithms)
+            return max_algorithms;
+        algorithms_.emplace_back(kind, name);
+        return algorithms_.size() - 1;
+    }
+};
+
+/**
+ * \brief Process-wide registry
+ */
+inline Registry& registry() {
+    static Registry instance;
+    return instance;
+}
+
+/**
+ * \class oqs::metrics::internal::ThreadTable
+ * \brief Per-thread table, registered for snapshots while the thread lives
+ * and merged into the retired counts when it exits
+ */
+class ThreadTable {
+    Table table_;
+
+  public:
+    ThreadTable() : table_{} {
+        Registry& r = registry();
+        std::lock_guard<std::mutex> lock{r.mutex_};
+        r.threads_.emplace_back(&table_);
+    }
+
+    ThreadTable(const ThreadTable&) = delete;
+
+    ThreadTable& operator=(const ThreadTable&) = delete;
+
+    ~ThreadTable() {
+        Registry& r = registry();
+        std::lock_guard<std::mutex> lock{r.mutex_};
+        for (std::size_t id = 0; id < r.algorithms_.size(); ++id)
+            for (std::size_t op = 0; op < num_operations; ++op) {
+                const Cell* c = table_.find(id, static_cast<Operation>(op));
+                if (c != nullptr)
+                    r.retired_.cell(id, static_cast<Operation>(op)).merge(*c);
+            }
+        for (auto it = r.threads_.begin(); it != r.threads_.end(); ++it)
+            if (*it == &table_) {
+                r.threads_.erase(it);
+                break;
+            }
+    }
+
+    Table& table() { return table_; }
+};
+
+/**
+ * \brief Id of a KEM or signature algorithm
+ * \param kind "kem" or "sig"
+ * \param name Algorithm name
+ */
+inline std::size_t algorithm_id(const std::string& kind,
+                                const std::string& name) {
+    return registry().id(kind, name);
+}
+
+/**
+ * \class oqs::metrics::internal::Sample
+ * \brief Times one liboqs call, recorded by done()
+ */
+class Sample {
+    Cell* cell_;
+    std::chrono::steady_clock::time_point start_;
+
+  public:
+    Sample(std::size_t id, Operation op)
+        : cell_{nullptr}, start_{std::chrono::steady_clock::now()} {
+        if (id < max_algorithms) {
+            static thread_local ThreadTable local;
+            cell_ = &local.table().cell(id, op);
+        }
+    }
+
+    Sample(const Sample&) = delete;
+
+    Sample& operator=(const Sample&) = delete;
+
+    /**
+     * \brief Records the call
+     * \param ok Whether the call succeeded
+     */
+    void done(bool ok) noexcept {
+        if (cell_ == nullptr)
+            return;
+        auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                      std::chrono::steady_clock::now() - start_)
+                      .count();
+        cell_->record(static_cast<std::uint64_t>(ns), ok);
+    }
+};
+} // namespace internal
+
+/**
+ * \brief Snapshot of all (algorithm, operation) pairs with at least one call,
+ * summed over all threads, past and present
+ */
+inline std::vector<OperationStats> snapshot() {
+    internal::Registry& r = internal::registry();
+    std::lock_guard<std::mutex> lock{r.mutex_};
+    std::vector<OperationStats> result;
+    for (std::size_t id = 0; id < r.algorithms_.size(); ++id)
+        for (std::size_t op = 0; op < num_operations; ++op) {
+            OperationStats stats{r.algorithms_[id].second,
+                                 r.algorithms_[id].first,
+                                 static_cast<Operation>(op),
+                                 0,
+                                 0,
+                                 0,
+                                 std::vector<std::uint64_t>(
+                                     num_latency_buckets, 0)};
+            std::uint64_t latency_ns = 0;
+            auto add = [&](const internal::Cell* c) {
+                if (c == nullptr)
+                    return;
+                stats.calls += c->calls.load(std::memory_order_relaxed);
+                stats.failures += c->failures.load(std::memory_order_relaxed);
+                latency_ns += c->latency_ns.load(std::memory_order_relaxed);
+                for (std::size_t i = 0; i < num_latency_buckets; ++i)
+                    stats.latency_buckets[i] +=
+                        c->buckets[i].load(std::memory_order_relaxed);
+            };
+            add(r.retired_.find(id, stats.operation));
+            for (auto&& table : r.threads_)
+                add(table->find(id, stats.operation));
+            if (stats.calls == 0)
+                continue;
+            stats.latency_sum = static_cast<double>(latency_ns) * 1e-9;
+            result.emplace_back(std::move(stats));
+        }
+    return result;
+}
+
+/**
+ * \brief Prometheus text exposition of snapshot()
+ *
+ * Exposes the counters \<prefix\>_operations_total and
+ * \<prefix\>_operation_failures_total, and the histogram
+ * \<prefix\>_operation_duration_seconds (power-of-two buckets from ~1 us to
+ * ~1 s), labelled by algorithm, kind and operation
+ *
+ * \param prefix Metric name prefix
+ * \return Metrics in the Prometheus text format, version 0.0.4
+ */
+inline std::string prometheus_text(const std::string& prefix = "liboqs_cpp") {
+    std::vector<OperationStats> stats = snapshot();
+    std::ostringstream os;
+    auto labels = [](const OperationStats& s) {
+        return "algorithm=\"" + s.algorithm + "\",kind=\"" + s.kind +
+               "\",operation=\"" + operation_name(s.operation) + "\"";
+    };
+
+    os << "# HELP " << prefix
+       << "_operations_total Number of liboqs operations\n"
+       << "# TYPE " << prefix << "_operations_total counter\n";
+    for (auto&& s : stats)
+        os << prefix << "_operations_total{" << labels(s) << "} " << s.calls
+           << '\n';
+
+    os << "# HELP " << prefix
+       << "_operation_failures_total Number of failed liboqs operations\n"
+       << "# TYPE " << prefix << "_operation_failures_total counter\n";
+    for (auto&& s : stats)
+        os << prefix << "_operation_failures_total{" << labels(s) << "} "
+           << s.failures << '\n';
+
+    os << "# HELP " << prefix
+       << "_operation_duration_seconds Latency of liboqs operations\n"
+       << "# TYPE " << prefix << "_operation_duration_seconds histogram\n";
+    for (auto&& s : stats) {
+        std::uint64_t cumulative = 0;
+        std::size_t idx = 0;
+        // Octave k covers [2^k, 2^(k + 1)) ns
+        for (std::size_t k = 10; k <= 30; ++k) {
+            for (; idx < k * latency_sub_buckets; ++idx)
+                cumulative += s.latency_buckets[idx];
+            os << prefix << "_operation_duration_seconds_bucket{" << labels(s)
+               << ",le=\"" << std::ldexp(1e-9, static_cast<int>(k)) << "\"} "
+               << cumulative << '\n';
+        }
+        os << prefix << "_operation_duration_seconds_bucket{" << labels(s)
+           << ",le=\"+Inf\"} " << s.calls << '\n';
+        os << prefix << "_operation_duration_seconds_sum{" << labels(s)
+           << "} " << s.latency_sum << '\n';
+        os << prefix << "_operation_duration_seconds_count{" << labels(s)
+           << "} " << s.calls << '\n';
+    }
+    return os.str();
+}
+} // namespace metrics
+} // namespace oqs
+
+#endif // METRICS_METRICS_HPP_
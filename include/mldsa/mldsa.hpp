@@ -0,0 +1,216 @@
+/**
+ * \file mldsa/mldsa.hpp
+ * \brief ML-DSA external mu: split signing, where the message representative
+ * is computed next to the data and only 64 bytes travel to the signing key
+ *
+ * The message representative is the one of FIPS 204 (pure ML-DSA)
+ *
+ *     tr = SHAKE256(public key, 64)
+ *     mu = SHAKE256(tr | 0 | context length (1) | context | message, 64)
+ *
+ * computed incrementally by oqs::mldsa::MuHasher from any amount of data.
+ *
+ * \note The liboqs signature API has no entry point taking mu in place of
+ * the message, so oqs::mldsa::sign_mu() signs mu itself, as a message, with
+ * oqs::Signature::sign_with_ctx_str() under the context string
+ * oqs::mldsa::external_mu_context. Such signatures are checked with
+ * oqs::mldsa::verify_mu() (or oqs::mldsa::verify() from the data); they are
+ * not standard ML-DSA signatures of the message.
+ */
+
+#ifndef MLDSA_MLDSA_HPP_
+#define MLDSA_MLDSA_HPP_
+
+#include <istream>
+#include <stdexcept>
+#include <string>
+
+#include "common.hpp"
+#include "oqs_cpp.hpp"
+#include "sha3/sha3.hpp"
+
+namespace oqs {
+/**
+ * \namespace mldsa
+ * \brief Namespace containing the ML-DSA external mu API
+ */
+namespace mldsa {
+constexpr std::size_t mu_length = 64;           ///< message representative
+constexpr std::size_t tr_length = 64;           ///< public key hash
+constexpr std::size_t max_context_length = 255; ///< longest context string
+
+/**
+ * \brief Context string under which oqs::mldsa::sign_mu() signs mu
+ */
+constexpr char external_mu_context[] = "liboqs-cpp ML-DSA external mu";
+
+/**
+ * \brief Whether \a sig is an ML-DSA instance
+ */
+inline bool is_ml_dsa(const Signature& sig) {
+    return sig.get_details().name.compare(0, 7, "ML-DSA-") == 0;
+}
+
+namespace internal {
+inline void check_ml_dsa(const Signature& sig) {
+    if (!is_ml_dsa(sig))
+        throw std::invalid_argument("External mu requires ML-DSA, not " +
+                                    sig.get_details().name);
+}
+
+inline bytes context_bytes() {
+    return bytes(mldsa::external_mu_context,
+                 mldsa::external_mu_context +
+                     sizeof(mldsa::external_mu_context) - 1);
+}
+} // namespace internal
+
+/**
+ * \class oqs::mldsa::MuHasher
+ * \brief Incremental computation of the ML-DSA message representative mu,
+ * needs only the public key
+ */
+class MuHasher {
+    sha3::SHAKE256 xof_{};
+
+  public:
+    /**
+     * \brief Starts the computation of mu
+     * \param sig oqs::Signature instance of the ML-DSA parameter set, no
+     * secret key needed
+     * \param public_key Signer's public key
+     * \param context Context string, at most 255 bytes
+     */
+    MuHasher(const Signature& sig, const bytes& public_key,
+             const bytes& context = {}) {
+        internal::check_ml_dsa(sig);
+        if (public_key.size() != sig.get_details().length_public_key)
+            throw std::invalid_argument("Incorrect public key length");
+        if (context.size() > max_context_length)
+            throw std::invalid_argument("Context string too long");
+        bytes tr = sha3::shake256(public_key, tr_length);
+        byte prefix[2] = {0, static_cast<byte>(context.size())};
+        xof_.absorb(tr).absorb(prefix, sizeof(prefix)).absorb(context);
+    }
+
+    /**
+     * \brief Absorbs the next \a len message bytes
+     * \return Reference to the current instance
+     */
+    MuHasher& update(const byte* data, std::size_t len) {
+        xof_.absorb(data, len);
+        return *this;
+    }
+
+    /**
+     * \brief Absorbs the next message bytes
+     * \return Reference to the current instance
+     */
+    MuHasher& update(const bytes& data) {
+        return update(data.data(), data.size());
+    }
+
+    /**
+     * \brief Absorbs the rest of a stream
+     * \param is Input stream
+     * \param chunk_size Read size
+     * \return Reference to the current instance
+     */
+    MuHasher& update(std::istream& is, std::size_t chunk_size = 64 * 1024) {
+        bytes buffer(chunk_size == 0 ? 1 : chunk_size);
+        while (is) {
+            is.read(reinterpret_cast<char*>(buffer.data()),
+                    static_cast<std::streamsize>(buffer.size()));
+            update(buffer.data(), static_cast<std::size_t>(is.gcount()));
+        }
+        if (is.bad())
+            throw std::runtime_error("Can not read message stream");
+        return *this;
+    }
+
+    /**
+     * \brief Ends the message and returns mu; the instance must not be used
+     * afterwards
+     * \return oqs::mldsa::mu_length bytes
+     */
+    bytes finalize() { return xof_.finalize().squeeze(mu_length); }
+}; // class MuHasher
+
+/**
+ * \brief Message representative of a whole stream, on the data side
+ * \param sig oqs::Signature instance of the ML-DSA parameter set
+ * \param public_key Signer's public key
+ * \param context Context string, at most 255 bytes
+ * \param message Message stream, read to the end
+ * \return mu, oqs::mldsa::mu_length bytes
+ */
+inline bytes compute_mu(const Signature& sig, const bytes& public_key,
+                        const bytes& context, std::istream& message) {
+    return MuHasher{sig, public_key, context}.update(message).finalize();
+}
+
+/**
+ * \brief Message representative of an in-memory message
+ * \param sig oqs::Signature instance of the ML-DSA parameter set
+ * \param public_key Signer's public key
+ * \param context Context string, at most 255 bytes
+ * \param message Message
+ * \return mu, oqs::mldsa::mu_length bytes
+ */
+inline bytes compute_mu(const Signature& sig, const bytes& public_key,
+                        const bytes& context, const bytes& message) {
+    return MuHasher{sig, public_key, context}.update(message).finalize();
+}
+
+/**
+ * \brief Signs a message representative, on the key side
+ * \note See the note of mldsa/mldsa.hpp on the signature format
+ * \param signer oqs::Signature instance of the ML-DSA parameter set,
+ * holding the secret key
+ * \param mu Message representative, see oqs::mldsa::compute_mu()
+ * \return Signature
+ */
+inline bytes sign_mu(const Signature& signer, const bytes& mu) {
+    internal::check_ml_dsa(signer);
+    if (mu.size() != mu_length)
+        throw std::invalid_argument("Incorrect mu length");
+    return signer.sign_with_ctx_str(mu, internal::context_bytes());
+}
+
+/**
+ * \brief Verifies the signature of a message representative
+ * \param verifier oqs::Signature instance of the ML-DSA parameter set
+ * \param mu Message representative, recomputed by the verifier
+ * \param signature Signature, see oqs::mldsa::sign_mu()
+ * \param public_key Signer's public key
+ * \return True if the signature is valid, false otherwise
+ */
+inline bool verify_mu(const Signature& verifier, const bytes& mu,
+                      const bytes& signature, const bytes& public_key) {
+    internal::check_ml_dsa(verifier);
+    if (mu.size() != mu_length)
+        throw std::invalid_argument("Incorrect mu length");
+    return verifier.verify_with_ctx_str(
+        mu, signature, internal::context_bytes(), public_key);
+}
+
+/**
+ * \brief Computes mu from a message stream and verifies its signature
+ * \param verifier oqs::Signature instance of the ML-DSA parameter set
+ * \param public_key Signer's public key
+ * \param context Context string the message was signed with
+ * \param message Message stream, read to the end
+ * \param signature Signature, see oqs::mldsa::sign_mu()
+ * \return True if the signature is valid, false otherwise
+ */
+inline bool verify(const Signature& verifier, const bytes& public_key,
+                   const bytes& context, std::istream& message,
+                   const bytes& signature) {
+    return verify_mu(verifier,
+                     compute_mu(verifier, public_key, context, message),
+                     signature, public_key);
+}
+} // namespace mldsa
+} // namespace oqs
+
+#endif // MLDSA_MLDSA_HPP_
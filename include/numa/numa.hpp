@@ -0,0 +1,515 @@
+/**
+ * \file numa/numa.hpp
+ * \brief NUMA topology and a NUMA- and core-affinity-aware sharded worker
+ * pool
+ *
+ * oqs::numa::ShardedPool runs one worker thread per CPU, pinned to it with
+ * sched_setaffinity(). Every worker has its own job queue; an idle worker
+ * takes work from its own queue first, then steals from the other workers of
+ * its NUMA node and, only then (and only if enabled), from other nodes.
+ *
+ * Per-node replicas (oqs::numa::Replicas) of wrapper objects and secret keys
+ * are constructed by a worker of each node, so that with the default Linux
+ * first-touch policy their memory is allocated on that node; jobs receive
+ * the index of the node they run on and use its replica.
+ *
+ *     oqs::numa::ShardedPool pool;
+ *     auto signers = pool.replicate<oqs::Signature>(
+ *         [&] { return new oqs::Signature{"ML-DSA-65", secret_key}; });
+ *     pool.post(oqs::numa::any_node, [&](std::size_t node) {
+ *         signature = signers[node].sign(message);
+ *     });
+ *
+ * On platforms other than Linux the topology is a single node and threads are
+ * not pinned.
+ */
+
+#ifndef NUMA_NUMA_HPP_
+#define NUMA_NUMA_HPP_
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdlib>
+#include <deque>
+#include <fstream>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#ifdef __linux__
+#include <dirent.h>
+#include <sched.h>
+#endif
+
+namespace oqs {
+/**
+ * \namespace numa
+ * \brief Namespace containing the NUMA-aware worker pool
+ */
+namespace numa {
+/**
+ * \brief Lets oqs::numa::ShardedPool::post() choose the node
+ */
+constexpr std::size_t any_node = static_cast<std::size_t>(-1);
+
+/**
+ * \brief Parses a Linux CPU list, e.g. "0-3,8,10-11"
+ * \param cpulist CPU list
+ * \return CPU numbers, in increasing order
+ */
+inline std::vector<int> parse_cpulist(const std::string& cpulist) {
+    std::vector<int> cpus;
+    std::stringstream ss{cpulist};
+    std::string range;
+    while (std::getline(ss, range, ',')) {
+        if (range.empty() || range == "\n")
+            continue;
+        std::size_t dash = range.find('-');
+        int first = std::atoi(range.c_str());
+        int last = dash == std::string::npos
+                       ? first
+                       : std::atoi(range.c_str() + dash + 1);
+        for (int cpu = first; cpu <= last; ++cpu)
+            cpus.emplace_back(cpu);
+    }
+    std::sort(cpus.begin(), cpus.end());
+    cpus.erase(std::unique(cpus.begin(), cpus.end()), cpus.end());
+    return cpus;
+}
+
+/**
+ * \class oqs::numa::Topology
+ * \brief CPUs of every NUMA node
+ */
+class Topology {
+    std::vector<std::vector<int>> nodes_;
+
+  public:
+    /**
+     * \brief Constructs a topology from the CPUs of every node, empty nodes
+     * are dropped
+     * \param nodes CPUs of every node
+     */
+    explicit Topology(std::vector<std::vector<int>> nodes) : nodes_{} {
+        for (auto&& cpus : nodes)
+            if (!cpus.empty())
+                nodes_.emplace_back(std::move(cpus));
+        if (nodes_.empty())
+            throw std::runtime_error("Topology without CPUs");
+    }
+
+    /**
+     * \brief A single node with CPUs 0 to \a num_cpus - 1
+     * \param num_cpus Number of CPUs, 0 means
+     * std::thread::hardware_concurrency()
+     */
+    static Topology single_node(std::size_t num_cpus = 0) {
+        if (num_cpus == 0)
+            num_cpus = std::max(1u, std::thread::hardware_concurrency());
+        std::vector<int> cpus(num_cpus);
+        for (std::size_t i = 0; i < num_cpus; ++i)
+            cpus[i] = static_cast<int>(i);
+        return Topology{{cpus}};
+    }
+
+    /**
+     * \brief Topology of the host (Linux sysfs), restricted to the CPUs the
+     * process may run on; a single node elsewhere
+     */
+    static Topology detect() {
+#ifdef __linux__
+        cpu_set_t allowed;
+        CPU_ZERO(&allowed);
+        bool have_mask = sched_getaffinity(0, sizeof(allowed), &allowed) == 0;
+        auto is_allowed = [&](int cpu) {
+            return !have_mask ||
+                   (cpu < CPU_SETSIZE && CPU_ISSET(cpu, &allowed));
+        };
+
+        std::vector<int> node_ids;
+        if (DIR* dir = opendir("/sys/devices/system/node")) {
+            while (dirent* entry = readdir(dir)) {
+                std::string name = entry->d_name;
+                if (name.size() > 4 && name.compare(0, 4, "node") == 0 &&
+                    name.find_first_not_of("0123456789", 4) ==
+                        std::string::npos)
+                    node_ids.emplace_back(std::atoi(name.c_str() + 4));
+            }
+            closedir(dir);
+        }
+        std::sort(node_ids.begin(), node_ids.end());
+
+        std::vector<std::vector<int>> nodes;
+        for (int id : node_ids) {
+            std::ifstream in{"/sys/devices/system/node/node" +
+                             std::to_string(id) + "/cpulist"};
+            std::string cpulist;
+            std::getline(in, cpulist);
+            std::vector<int> cpus;
+            for (int cpu : parse_cpulist(cpulist))
+                if (is_allowed(cpu))
+                    cpus.emplace_back(cpu);
+            nodes.emplace_back(std::move(cpus));
+        }
+        for (auto&& cpus : nodes)
+            if (!cpus.empty())
+                return Topology{nodes};
+
+        // No NUMA information, a single node with the allowed CPUs
+        if (have_mask) {
+            std::vector<int> cpus;
+            for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+                if (CPU_ISSET(cpu, &allowed))
+                    cpus.emplace_back(cpu);
+            if (!cpus.empty())
+                return Topology{{cpus}};
+        }
+#endif
+        return single_node();
+    }
+
+    /**
+     * \brief Number of nodes
+     */
+    std::size_t num_nodes() const noexcept { return nodes_.size(); }
+
+    /**
+     * \brief CPUs of a node
+     */
+    const std::vector<int>& cpus(std::size_t node) const {
+        return nodes_.at(node);
+    }
+
+    /**
+     * \brief The first \a n nodes
+     */
+    Topology first_nodes(std::size_t n) const {
+        n = std::min(std::max(n, std::size_t{1}), nodes_.size());
+        return Topology{std::vector<std::vector<int>>(
+            nodes_.begin(), nodes_.begin() + static_cast<std::ptrdiff_t>(n))};
+    }
+}; // class Topology
+
+/**
+ * \class oqs::numa::Replicas
+ * \brief One instance of \a T per NUMA node, see
+ * oqs::numa::ShardedPool::replicate()
+ */
+template <typename T>
+class Replicas {
+    std::vector<std::unique_ptr<T>> items_;
+
+  public:
+    /**
+     * \brief Takes ownership of one instance per node
+     */
+    explicit Replicas(std::vector<std::unique_ptr<T>> items)
+        : items_{std::move(items)} {}
+
+    /**
+     * \brief Replica of a node
+     */
+    T& operator[](std::size_t node) { return *items_.at(node); }
+
+    /**
+     * \brief Replica of a node
+     */
+    const T& operator[](std::size_t node) const { return *items_.at(node); }
+
+    /**
+     * \brief Number of replicas, i.e. of nodes
+     */
+    std::size_t size() const noexcept { return items_.size(); }
+}; // class Replicas
+
+/**
+ * \class oqs::numa::ShardedPool
+ * \brief Worker pool with one pinned thread per CPU, per-worker queues and
+ * node-first work stealing
+ */
+class ShardedPool {
+    struct Job {
+        std::function<void(std::size_t)> run;
+        bool node_bound; // may not be stolen by another node
+    };
+
+    struct Worker {
+        std::size_t node;
+        int cpu;
+        std::mutex mutex{};
+        std::deque<Job> jobs{}; // guarded by mutex
+
+        Worker(std::size_t n, int c) : node{n}, cpu{c} {}
+    };
+
+    Topology topology_;
+    bool steal_across_nodes_;
+    std::vector<std::unique_ptr<Worker>> workers_{};
+    std::vector<std::vector<std::size_t>> node_workers_{};
+    std::vector<std::thread> threads_{};
+    std::atomic<std::size_t> next_{0};
+
+    std::mutex mutex_{};
+    std::vector<std::unique_ptr<std::condition_variable>> cvs_{}; // per node
+    std::vector<std::size_t> queued_{}; // per node, guarded by mutex_
+    std::vector<std::size_t> idle_{};   // per node, guarded by mutex_
+    std::size_t stealable_ = 0;         // jobs not node-bound, ditto
+    bool stop_ = false;                 // guarded by mutex_
+
+    // Pool and index of the calling worker thread
+    struct Current {
+        const ShardedPool* pool;
+        std::size_t index;
+    };
+
+    static Current& current() {
+        static thread_local Current current{nullptr, 0};
+        return current;
+    }
+
+    // Index of the calling worker thread, workers_.size() if none
+    std::size_t current_worker() const {
+        return current().pool == this ? current().index : workers_.size();
+    }
+
+    static bool pop(Worker& worker, bool front, bool other_node, Job& job) {
+        std::lock_guard<std::mutex> lock{worker.mutex};
+        if (front) {
+            if (worker.jobs.empty())
+                return false;
+            job = std::move(worker.jobs.front());
+            worker.jobs.pop_front();
+            return true;
+        }
+        for (auto it = worker.jobs.rbegin(); it != worker.jobs.rend(); ++it)
+            if (!other_node || !it->node_bound) {
+                job = std::move(*it);
+                worker.jobs.erase(std::next(it).base());
+                return true;
+            }
+        return false;
+    }
+
+    // Own queue (FIFO), then the node's workers, then the other nodes' workers
+    bool find_job(std::size_t self, Job& job, std::size_t& from_node) {
+        Worker& me = *workers_[self];
+        from_node = me.node;
+        if (pop(me, true, false, job))
+            return true;
+        const auto& peers = node_workers_[me.node];
+        std::size_t start = next_.load(std::memory_order_relaxed);
+        for (std::size_t i = 0; i < peers.size(); ++i) {
+            std::size_t peer = peers[(start + i) % peers.size()];
+            if (peer != self && pop(*workers_[peer], false, false, job))
+                return true;
+        }
+        if (!steal_across_nodes_)
+            return false;
+        for (std::size_t n = 1; n < topology_.num_nodes(); ++n) {
+            std::size_t node = (me.node + n) % topology_.num_nodes();
+            for (std::size_t peer : node_workers_[node])
+                if (pop(*workers_[peer], false, true, job)) {
+                    from_node = node;
+                    return true;
+                }
+        }
+        return false;
+    }
+
+    void work(std::size_t self) {
+        Worker& me = *workers_[self];
+        current() = Current{this, self};
+#ifdef __linux__
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        CPU_SET(me.cpu, &cpus);
+        sched_setaffinity(0, sizeof(cpus), &cpus); // best effort
+#endif
+        for (;;) {
+            Job job{};
+            std::size_t from_node = me.node;
+            if (find_job(self, job, from_node)) {
+                {
+                    std::lock_guard<std::mutex> lock{mutex_};
+                    --queued_[from_node];
+                    if (!job.node_bound)
+                        --stealable_;
+                }
+                job.run(me.node);
+                continue;
+            }
+            std::unique_lock<std::mutex> lock{mutex_};
+            auto has_work = [&] {
+                return queued_[me.node] > 0 ||
+                       (steal_across_nodes_ && stealable_ > 0);
+            };
+            if (has_work())
+                continue; // posted meanwhile, or being taken by a peer
+            if (stop_)
+                return;
+            ++idle_[me.node];
+            cvs_[me.node]->wait(lock, [&] { return stop_ || has_work(); });
+            --idle_[me.node];
+        }
+    }
+
+    void push(std::size_t node, Job job) {
+        std::size_t self = current_worker();
+        std::size_t target;
+        if (node == any_node) {
+            // The posting worker's own queue keeps the job on its core
+            target = self < workers_.size()
+                         ? self
+                         : next_.fetch_add(1) % workers_.size();
+            node = workers_[target]->node;
+        } else {
+            if (node >= topology_.num_nodes())
+                throw std::out_of_range("NUMA node out of range");
+            const auto& peers = node_workers_[node];
+            target = self < workers_.size() && workers_[self]->node == node
+                         ? self
+                         : peers[next_.fetch_add(1) % peers.size()];
+        }
+        // Counted before being queued, so that a worker never takes a job
+        // that is not counted yet
+        std::lock_guard<std::mutex> lock{mutex_};
+        ++queued_[node];
+        if (!job.node_bound)
+            ++stealable_;
+        {
+            std::lock_guard<std::mutex> worker_lock{workers_[target]->mutex};
+            workers_[target]->jobs.emplace_back(std::move(job));
+        }
+        if (idle_[node] > 0) {
+            cvs_[node]->notify_one();
+            return;
+        }
+        if (steal_across_nodes_)
+            for (std::size_t n = 0; n < topology_.num_nodes(); ++n)
+                if (idle_[n] > 0) {
+                    cvs_[n]->notify_one();
+                    return;
+                }
+    }
+
+  public:
+    /**
+     * \brief Starts one pinned worker per CPU of \a topology
+     * \param topology Nodes and CPUs to use
+     * \param threads_per_node Maximum workers per node, 0 means one per CPU
+     * \param steal_across_nodes Whether idle workers steal jobs from other
+     * nodes once their node has none
+     */
+    explicit ShardedPool(Topology topology = Topology::detect(),
+                         std::size_t threads_per_node = 0,
+                         bool steal_across_nodes = true)
+        : topology_{std::move(topology)},
+          steal_across_nodes_{steal_across_nodes} {
+        std::size_t num_nodes = topology_.num_nodes();
+        node_workers_.resize(num_nodes);
+        queued_.assign(num_nodes, 0);
+        idle_.assign(num_nodes, 0);
+        for (std::size_t node = 0; node < num_nodes; ++node) {
+            cvs_.emplace_back(new std::condition_variable);
+            const auto& cpus = topology_.cpus(node);
+            std::size_t n = threads_per_node == 0
+                                ? cpus.size()
+                                : std::min(threads_per_node, cpus.size());
+            for (std::size_t i = 0; i < n; ++i) {
+                node_workers_[node].emplace_back(workers_.size());
+                workers_.emplace_back(new Worker{node, cpus[i]});
+            }
+        }
+        for (std::size_t i = 0; i < workers_.size(); ++i)
+            threads_.emplace_back([this, i] { work(i); });
+    }
+
+    ShardedPool(const ShardedPool&) = delete;
+    ShardedPool& operator=(const ShardedPool&) = delete;
+
+    /**
+     * \brief Runs the jobs still queued, then joins the workers
+     */
+    ~ShardedPool() {
+        {
+            std::lock_guard<std::mutex> lock{mutex_};
+            stop_ = true;
+        }
+        for (auto&& cv : cvs_)
+            cv->notify_all();
+        for (auto&& thread : threads_)
+            thread.join();
+    }
+
+    /**
+     * \brief Queues a job on any node, thread-safe; compatible with the pools
+     * of oqs::async
+     * \param job Job, must not throw
+     */
+    void post(std::function<void()> job) {
+        push(any_node, Job{[job](std::size_t) { job(); }, false});
+    }
+
+    /**
+     * \brief Queues a job on a node, thread-safe
+     * \param node Node index, or oqs::numa::any_node
+     * \param job Job, invoked with the index of the node it runs on (which
+     * differs from \a node if stolen by another node), must not throw
+     */
+    void post(std::size_t node, std::function<void(std::size_t)> job) {
+        push(node, Job{std::move(job), false});
+    }
+
+    /**
+     * \brief Constructs one instance of \a T per node, each on a worker of
+     * that node; blocks until done
+     * \param factory Returns a new instance (owned by the result)
+     * \return Replicas, indexed by node
+     */
+    template <typename T>
+    Replicas<T> replicate(const std::function<T*()>& factory) {
+        std::vector<std::unique_ptr<T>> items(topology_.num_nodes());
+        std::vector<std::future<void>> done;
+        for (std::size_t node = 0; node < topology_.num_nodes(); ++node) {
+            auto task = std::make_shared<std::packaged_task<void()>>(
+                [&items, &factory, node] { items[node].reset(factory()); });
+            done.emplace_back(task->get_future());
+            push(node, Job{[task](std::size_t) { (*task)(); }, true});
+        }
+        for (auto&& f : done)
+            f.get(); // rethrows the factory's exceptions
+        return Replicas<T>{std::move(items)};
+    }
+
+    /**
+     * \brief Topology used by the pool
+     */
+    const Topology& topology() const noexcept { return topology_; }
+
+    /**
+     * \brief Number of worker threads
+     */
+    std::size_t size() const noexcept { return workers_.size(); }
+
+    /**
+     * \brief Node of the calling worker thread, oqs::numa::any_node when not
+     * called from a worker of this pool
+     */
+    std::size_t current_node() const {
+        std::size_t self = current_worker();
+        return self < workers_.size() ? workers_[self]->node : any_node;
+    }
+}; // class ShardedPool
+} // namespace numa
+} // namespace oqs
+
+#endif // NUMA_NUMA_HPP_
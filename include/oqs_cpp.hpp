@@ -1,12 +1,27 @@
 /**
  * \file oqs_cpp.hpp
  * \brief Main header file for the liboqs C++ wrapper
+ *
+ * Thread safety of oqs::KeyEncapsulation and oqs::Signature: the const member
+ * functions (encapsulation, decapsulation, signing, verification, details,
+ * secret key export) may be called concurrently, without locking, on the same
+ * instance or on copies of it. They only read the liboqs handle and the
+ * secret key, neither of which is modified after it is set, and write
+ * nothing but their own outputs. The non-const member functions (key
+ * generation, assignment) need exclusive access to their instance, as for any
+ * standard library type. Copies share the liboqs handle and the secret key
+ * buffer (oqs::SharedSecretKey), so N threads may each hold a copy, or share
+ * one const instance, with a single copy of the secret key in memory.
+ * Randomness comes from OQS_randombytes(), thread-safe with the default
+ * system RNG; a custom RNG (oqs::rand::randombytes_custom_algorithm()) used
+ * from several threads must be thread-safe itself.
  */
 
 #ifndef OQS_CPP_HPP_
 #define OQS_CPP_HPP_
 
 #include <algorithm>
+#include <atomic>
 #include <cstdlib>
 #include <iostream>
 #include <memory>
@@ -18,6 +33,44 @@
 
 #include "common.hpp"
 
+// Instrumentation around every liboqs call, compiled out unless
+// LIBOQS_CPP_METRICS (operation metrics, see metrics/metrics.hpp) and/or
+// LIBOQS_CPP_USDT (static tracepoints) are defined
+#ifdef LIBOQS_CPP_METRICS
+#include "metrics/metrics.hpp"
+#define LIBOQS_CPP_METRICS_BEGIN_(op)                                          \
+    metrics::internal::Sample metrics_sample_{metrics_id_,                     \
+                                              metrics::Operation::op}
+#define LIBOQS_CPP_METRICS_END_(rv)                                            \
+    metrics_sample_.done(rv == OQS_STATUS::OQS_SUCCESS)
+#else
+#define LIBOQS_CPP_METRICS_BEGIN_(op) static_cast<void>(0)
+#define LIBOQS_CPP_METRICS_END_(rv) static_cast<void>(0)
+#endif
+
+// USDT probes liboqs_cpp:op_entry(kind, op, algorithm, input size) and
+// liboqs_cpp:op_return(kind, op, algorithm, output size, status), see
+// tools/trace
+#ifdef LIBOQS_CPP_USDT
+#include <sys/sdt.h>
+#define LIBOQS_CPP_USDT_BEGIN_(kind, op, in_size)                              \
+    DTRACE_PROBE4(liboqs_cpp, op_entry, kind, #op,                             \
+                  alg_details_.name.c_str(), in_size)
+#define LIBOQS_CPP_USDT_END_(kind, op, rv, out_size)                           \
+    DTRACE_PROBE5(liboqs_cpp, op_return, kind, #op,                            \
+                  alg_details_.name.c_str(), out_size, static_cast<int>(rv))
+#else
+#define LIBOQS_CPP_USDT_BEGIN_(kind, op, in_size) static_cast<void>(0)
+#define LIBOQS_CPP_USDT_END_(kind, op, rv, out_size) static_cast<void>(0)
+#endif
+
+#define LIBOQS_CPP_OP_BEGIN(kind, op, in_size)                                 \
+    LIBOQS_CPP_USDT_BEGIN_(kind, op, in_size);                                 \
+    LIBOQS_CPP_METRICS_BEGIN_(op)
+#define LIBOQS_CPP_OP_END(kind, op, rv, out_size)                              \
+    LIBOQS_CPP_METRICS_END_(rv);                                               \
+    LIBOQS_CPP_USDT_END_(kind, op, rv, out_size)
+
 /**
  * \namespace oqs
  * \brief Main namespace for the liboqs C++ wrapper
@@ -159,15 +212,108 @@ class KEMs final : public internal::Singleton<const KEMs> {
     }
 }; // class KEMs
 
+class KeyEncapsulation;
+class Signature;
+
+/**
+ * \class oqs::SharedSecretKey
+ * \brief Immutable, reference-counted secret key
+ *
+ * Copies share one buffer, never modified while shared and zeroed by the last
+ * copy to go away, so any number of threads can read it through their own
+ * copies without locking.
+ */
+class SharedSecretKey {
+    friend class KeyEncapsulation;
+    friend class Signature;
+
+    std::shared_ptr<bytes> key_{}; ///< shared buffer, null if empty
+
+    /**
+     * \brief Writable buffer for a new secret key of \a length bytes: the
+     * current one if it is not shared and has the right length, so that
+     * repeated key generation does not allocate, otherwise a new one
+     */
+    byte* reset(std::size_t length) {
+        if (key_.use_count() == 1 && key_->size() == length) {
+            // Orders the reads of the former other owners before our writes
+            // (ThreadSanitizer does not model fences, and GCC warns about them)
+#ifndef __SANITIZE_THREAD__
+            std::atomic_thread_fence(std::memory_order_acquire);
+#endif
+            return key_->data();
+        }
+        *this = SharedSecretKey{bytes(length, 0)};
+        return key_ ? key_->data() : nullptr;
+    }
+
+    /**
+     * \brief Zeroes and releases the secret key
+     */
+    void clear() {
+        if (key_.use_count() == 1)
+            C::OQS_MEM_cleanse(key_->data(), key_->size());
+        key_.reset();
+    }
+
+  public:
+    /**
+     * \brief Constructs an empty secret key
+     */
+    SharedSecretKey() = default;
+
+    /**
+     * \brief Takes ownership of \a secret_key, without copying it
+     * \param secret_key Secret key
+     */
+    explicit SharedSecretKey(bytes secret_key) {
+        if (secret_key.empty())
+            return;
+        key_.reset(new bytes(std::move(secret_key)), [](bytes* p) {
+            C::OQS_MEM_cleanse(p->data(), p->size());
+            delete p;
+        });
+    }
+
+    /**
+     * \brief Secret key bytes, nullptr if empty
+     */
+    const byte* data() const noexcept { return key_ ? key_->data() : nullptr; }
+
+    /**
+     * \brief Secret key length
+     */
+    std::size_t size() const noexcept { return key_ ? key_->size() : 0; }
+
+    /**
+     * \brief Whether there is no secret key
+     */
+    bool empty() const noexcept { return size() == 0; }
+
+    /**
+     * \brief Copy of the secret key
+     */
+    bytes to_bytes() const { return key_ ? *key_ : bytes{}; }
+
+    /**
+     * \brief Number of instances sharing the secret key, 0 if empty
+     */
+    long use_count() const noexcept { return key_.use_count(); }
+}; // class SharedSecretKey
+
 /**
  * \class oqs::KeyEncapsulation
  * \brief Key encapsulation mechanisms
+ * \note Const member functions are thread-safe, see oqs_cpp.hpp
  */
 class KeyEncapsulation {
     std::shared_ptr<C::OQS_KEM> kem_{nullptr, [](C::OQS_KEM* p) {
                                          C::OQS_KEM_free(p);
                                      }}; ///< liboqs smart pointer to C::OQS_KEM
-    bytes secret_key_{}; ///< secret key
+    SharedSecretKey secret_key_{}; ///< secret key, shared by copies
+#ifdef LIBOQS_CPP_METRICS
+    std::size_t metrics_id_ = metrics::max_algorithms; ///< metrics slot
+#endif
   public:
     /**
      * \brief KEM algorithm details
@@ -190,7 +336,7 @@ class KeyEncapsulation {
     /**
      * \brief Constructs an instance of oqs::KeyEncapsulation
      * \param alg_name Cryptographic algorithm name
-     * \param secret_key Secret key (optional)
+     * \param secret_key Secret key (optional), not copied
      */
     explicit KeyEncapsulation(const std::string& alg_name,
                               bytes secret_key = {})
@@ -215,10 +361,26 @@ class KeyEncapsulation {
         alg_details_.length_secret_key = kem_->length_secret_key;
         alg_details_.length_ciphertext = kem_->length_ciphertext;
         alg_details_.length_shared_secret = kem_->length_shared_secret;
+#ifdef LIBOQS_CPP_METRICS
+        metrics_id_ =
+            metrics::internal::algorithm_id("kem", alg_details_.name);
+#endif
+    }
+
+    /**
+     * \brief Constructs an instance of oqs::KeyEncapsulation sharing
+     * \a secret_key, e.g., obtained with share_secret_key()
+     * \param alg_name Cryptographic algorithm name
+     * \param secret_key Secret key
+     */
+    KeyEncapsulation(const std::string& alg_name, SharedSecretKey secret_key)
+        : KeyEncapsulation{alg_name} {
+        secret_key_ = std::move(secret_key);
     }
 
     /**
-     * \brief Default copy constructor
+     * \brief Default copy constructor, the copy shares the liboqs handle and
+     * the secret key
      */
     KeyEncapsulation(const KeyEncapsulation&) = default;
 
@@ -229,46 +391,39 @@ class KeyEncapsulation {
     KeyEncapsulation& operator=(const KeyEncapsulation&) = default;
 
     /**
-     * \brief Move constructor, guarantees that the rvalue secret key is always
-     * zeroed
+     * \brief Move constructor, the rvalue no longer references the secret key
      * \param rhs oqs::KeyEncapsulation instance
      */
     KeyEncapsulation(KeyEncapsulation&& rhs) noexcept
-        : kem_{std::move(rhs.kem_)}, alg_details_{std::move(rhs.alg_details_)} {
-        // Paranoid move via copy/clean/resize, see
-        // https://stackoverflow.com/questions/55054187/can-i-resize-a-vector-that-was-moved-from
-        secret_key_ = rhs.secret_key_; // copy
-        // Clean (zero)
-        C::OQS_MEM_cleanse(rhs.secret_key_.data(), rhs.secret_key_.size());
-        rhs.secret_key_.resize(0); // resize
+        : kem_{std::move(rhs.kem_)}, secret_key_{std::move(rhs.secret_key_)},
+          alg_details_{std::move(rhs.alg_details_)} {
+#ifdef LIBOQS_CPP_METRICS
+        metrics_id_ = rhs.metrics_id_;
+#endif
     }
+
     /**
-     * \brief Move assignment operator, guarantees that the rvalue secret key is
-     * always zeroed
+     * \brief Move assignment operator, the rvalue no longer references the
+     * secret key
      * \param rhs oqs::KeyEncapsulation instance
      * \return Reference to the current instance
      */
     KeyEncapsulation& operator=(KeyEncapsulation&& rhs) noexcept {
         kem_ = std::move(rhs.kem_);
+        secret_key_ = std::move(rhs.secret_key_);
         alg_details_ = std::move(rhs.alg_details_);
-
-        // Paranoid move via copy/clean/resize, see
-        // https://stackoverflow.com/questions/55054187/can-i-resize-a-vector-that-was-moved-from
-        secret_key_ = rhs.secret_key_; // copy
-        // Clean (zero)
-        C::OQS_MEM_cleanse(rhs.secret_key_.data(), rhs.secret_key_.size());
-        rhs.secret_key_.resize(0); // resize
+#ifdef LIBOQS_CPP_METRICS
+        metrics_id_ = rhs.metrics_id_;
+#endif
 
         return *this;
     }
 
     /**
-     * \brief Virtual default destructor
+     * \brief Virtual default destructor, the secret key is zeroed by its last
+     * owner
      */
-    virtual ~KeyEncapsulation() {
-        if (!secret_key_.empty())
-            C::OQS_MEM_cleanse(secret_key_.data(), secret_key_.size());
-    }
+    virtual ~KeyEncapsulation() = default;
 
     /**
      * \brief KEM algorithm details, lvalue overload
@@ -288,21 +443,52 @@ class KeyEncapsulation {
      */
     bytes generate_keypair() {
         bytes public_key(alg_details_.length_public_key, 0);
-        secret_key_ = bytes(alg_details_.length_secret_key, 0);
+        byte* secret_key = secret_key_.reset(alg_details_.length_secret_key);
 
-        OQS_STATUS rv_ = C::OQS_KEM_keypair(kem_.get(), public_key.data(),
-                                            secret_key_.data());
-        if (rv_ != OQS_STATUS::OQS_SUCCESS)
+        LIBOQS_CPP_OP_BEGIN("kem", Keypair, 0);
+        OQS_STATUS rv_ =
+            C::OQS_KEM_keypair(kem_.get(), public_key.data(), secret_key);
+        LIBOQS_CPP_OP_END("kem", Keypair, rv_, public_key.size());
+        if (rv_ != OQS_STATUS::OQS_SUCCESS) {
+            secret_key_.clear();
             throw std::runtime_error("Can not generate keypair");
+        }
 
         return public_key;
     }
 
+    /**
+     * \brief Generate public key/secret key pair in-place
+     * \note Reuses the storage of \a public_key and of the secret key, hence
+     * does not allocate once they have the right size, unless copies of the
+     * instance still share the secret key (they keep the previous one)
+     * \param [out] public_key Public key
+     */
+    void generate_keypair(bytes& public_key) {
+        public_key.resize(alg_details_.length_public_key);
+        byte* secret_key = secret_key_.reset(alg_details_.length_secret_key);
+
+        LIBOQS_CPP_OP_BEGIN("kem", Keypair, 0);
+        OQS_STATUS rv_ =
+            C::OQS_KEM_keypair(kem_.get(), public_key.data(), secret_key);
+        LIBOQS_CPP_OP_END("kem", Keypair, rv_, public_key.size());
+        if (rv_ != OQS_STATUS::OQS_SUCCESS) {
+            secret_key_.clear();
+            throw std::runtime_error("Can not generate keypair");
+        }
+    }
+
     /**
      * \brief Export secret key
      * \return Secret key
      */
-    bytes export_secret_key() const { return secret_key_; }
+    bytes export_secret_key() const { return secret_key_.to_bytes(); }
+
+    /**
+     * \brief Share the secret key, without copying it
+     * \return Secret key, shared with the current instance
+     */
+    SharedSecretKey share_secret_key() const { return secret_key_; }
 
     /**
      * \brief Encapsulate secret
@@ -315,15 +501,41 @@ class KeyEncapsulation {
 
         bytes ciphertext(alg_details_.length_ciphertext, 0);
         bytes shared_secret(alg_details_.length_shared_secret, 0);
+        LIBOQS_CPP_OP_BEGIN("kem", Encaps, public_key.size());
         OQS_STATUS rv_ =
             C::OQS_KEM_encaps(kem_.get(), ciphertext.data(),
                               shared_secret.data(), public_key.data());
+        LIBOQS_CPP_OP_END("kem", Encaps, rv_, ciphertext.size());
         if (rv_ != OQS_STATUS::OQS_SUCCESS)
             throw std::runtime_error("Can not encapsulate secret");
 
         return std::make_pair(ciphertext, shared_secret);
     }
 
+    /**
+     * \brief Encapsulate secret in-place
+     * \note Reuses the storage of \a ciphertext and \a shared_secret, hence
+     * does not allocate once they have the right size
+     * \param public_key Public key
+     * \param [out] ciphertext Ciphertext
+     * \param [out] shared_secret Shared secret
+     */
+    void encap_secret(const bytes& public_key, bytes& ciphertext,
+                      bytes& shared_secret) const {
+        if (public_key.size() != alg_details_.length_public_key)
+            throw std::runtime_error("Incorrect public key length");
+
+        ciphertext.resize(alg_details_.length_ciphertext);
+        shared_secret.resize(alg_details_.length_shared_secret);
+        LIBOQS_CPP_OP_BEGIN("kem", Encaps, public_key.size());
+        OQS_STATUS rv_ =
+            C::OQS_KEM_encaps(kem_.get(), ciphertext.data(),
+                              shared_secret.data(), public_key.data());
+        LIBOQS_CPP_OP_END("kem", Encaps, rv_, ciphertext.size());
+        if (rv_ != OQS_STATUS::OQS_SUCCESS)
+            throw std::runtime_error("Can not encapsulate secret");
+    }
+
     /**
      * \brief Decapsulate secret
      * \param ciphertext Ciphertext
@@ -340,9 +552,11 @@ class KeyEncapsulation {
                 "oqs::Signature::generate_keypair()");
 
         bytes shared_secret(alg_details_.length_shared_secret, 0);
+        LIBOQS_CPP_OP_BEGIN("kem", Decaps, ciphertext.size());
         OQS_STATUS rv_ =
             C::OQS_KEM_decaps(kem_.get(), shared_secret.data(),
                               ciphertext.data(), secret_key_.data());
+        LIBOQS_CPP_OP_END("kem", Decaps, rv_, shared_secret.size());
 
         if (rv_ != OQS_STATUS::OQS_SUCCESS)
             throw std::runtime_error("Can not decapsulate secret");
@@ -350,6 +564,34 @@ class KeyEncapsulation {
         return shared_secret;
     }
 
+    /**
+     * \brief Decapsulate secret in-place
+     * \note Reuses the storage of \a shared_secret, hence does not allocate
+     * once it has the right size
+     * \param ciphertext Ciphertext
+     * \param [out] shared_secret Shared secret
+     */
+    void decap_secret(const bytes& ciphertext, bytes& shared_secret) const {
+        if (ciphertext.size() != alg_details_.length_ciphertext)
+            throw std::runtime_error("Incorrect ciphertext length");
+
+        if (secret_key_.size() != alg_details_.length_secret_key)
+            throw std::runtime_error(
+                "Incorrect secret key length, make sure you "
+                "specify one in the constructor or run "
+                "oqs::Signature::generate_keypair()");
+
+        shared_secret.resize(alg_details_.length_shared_secret);
+        LIBOQS_CPP_OP_BEGIN("kem", Decaps, ciphertext.size());
+        OQS_STATUS rv_ =
+            C::OQS_KEM_decaps(kem_.get(), shared_secret.data(),
+                              ciphertext.data(), secret_key_.data());
+        LIBOQS_CPP_OP_END("kem", Decaps, rv_, shared_secret.size());
+
+        if (rv_ != OQS_STATUS::OQS_SUCCESS)
+            throw std::runtime_error("Can not decapsulate secret");
+    }
+
     /**
      * \brief std::ostream extraction operator for the KEM algorithm details
      * \param os Output stream
@@ -479,12 +721,16 @@ class Sigs final : public internal::Singleton<const Sigs> {
 /**
  * \class oqs::Signature
  * \brief Signature mechanisms
+ * \note Const member functions are thread-safe, see oqs_cpp.hpp
  */
 class Signature {
     std::shared_ptr<C::OQS_SIG> sig_{nullptr, [](C::OQS_SIG* p) {
                                          C::OQS_SIG_free(p);
                                      }}; ///< liboqs smart pointer to C::OQS_SIG
-    bytes secret_key_{}; ///< secret key
+    SharedSecretKey secret_key_{}; ///< secret key, shared by copies
+#ifdef LIBOQS_CPP_METRICS
+    std::size_t metrics_id_ = metrics::max_algorithms; ///< metrics slot
+#endif
 
   public:
     /**
@@ -508,7 +754,7 @@ class Signature {
     /**
      * \brief Constructs an instance of oqs::Signature
      * \param alg_name Cryptographic algorithm name
-     * \param secret_key Secret key (optional)
+     * \param secret_key Secret key (optional), not copied
      */
     explicit Signature(const std::string& alg_name, bytes secret_key = {})
         : secret_key_{std::move(secret_key)} {
@@ -532,10 +778,26 @@ class Signature {
         alg_details_.length_public_key = sig_->length_public_key;
         alg_details_.length_secret_key = sig_->length_secret_key;
         alg_details_.max_length_signature = sig_->length_signature;
+#ifdef LIBOQS_CPP_METRICS
+        metrics_id_ =
+            metrics::internal::algorithm_id("sig", alg_details_.name);
+#endif
     }
 
     /**
-     * \brief Default copy constructor
+     * \brief Constructs an instance of oqs::Signature sharing
+     * \a secret_key, e.g., obtained with share_secret_key()
+     * \param alg_name Cryptographic algorithm name
+     * \param secret_key Secret key
+     */
+    Signature(const std::string& alg_name, SharedSecretKey secret_key)
+        : Signature{alg_name} {
+        secret_key_ = std::move(secret_key);
+    }
+
+    /**
+     * \brief Default copy constructor, the copy shares the liboqs handle and
+     * the secret key
      */
     Signature(const Signature&) = default;
 
@@ -546,46 +808,39 @@ class Signature {
     Signature& operator=(const Signature&) = default;
 
     /**
-     * \brief Move constructor, guarantees that the rvalue secret key is always
-     * zeroed
+     * \brief Move constructor, the rvalue no longer references the secret key
      * \param rhs oqs::Signature instance
      */
     Signature(Signature&& rhs) noexcept
-        : sig_{std::move(rhs.sig_)}, alg_details_{std::move(rhs.alg_details_)} {
-        // Paranoid move via copy/clean/resize, see
-        // https://stackoverflow.com/questions/55054187/can-i-resize-a-vector-that-was-moved-from
-        secret_key_ = rhs.secret_key_; // copy
-        // Clean (zero)
-        C::OQS_MEM_cleanse(rhs.secret_key_.data(), rhs.secret_key_.size());
-        rhs.secret_key_.resize(0); // resize
+        : sig_{std::move(rhs.sig_)}, secret_key_{std::move(rhs.secret_key_)},
+          alg_details_{std::move(rhs.alg_details_)} {
+#ifdef LIBOQS_CPP_METRICS
+        metrics_id_ = rhs.metrics_id_;
+#endif
     }
+
     /**
-     * \brief Move assignment operator, guarantees that the rvalue secret key is
-     * always zeroed
+     * \brief Move assignment operator, the rvalue no longer references the
+     * secret key
      * \param rhs oqs::Signature instance
      * \return Reference to the current instance
      */
     Signature& operator=(Signature&& rhs) noexcept {
         sig_ = std::move(rhs.sig_);
+        secret_key_ = std::move(rhs.secret_key_);
         alg_details_ = std::move(rhs.alg_details_);
-
-        // Paranoid move via copy/clean/resize, see
-        // https://stackoverflow.com/questions/55054187/can-i-resize-a-vector-that-was-moved-from
-        secret_key_ = rhs.secret_key_; // copy
-        // Clean (zero)
-        C::OQS_MEM_cleanse(rhs.secret_key_.data(), rhs.secret_key_.size());
-        rhs.secret_key_.resize(0); // resize
+#ifdef LIBOQS_CPP_METRICS
+        metrics_id_ = rhs.metrics_id_;
+#endif
 
         return *this;
     }
 
     /**
-     * \brief Virtual default destructor
+     * \brief Virtual default destructor, the secret key is zeroed by its last
+     * owner
      */
-    virtual ~Signature() {
-        if (!secret_key_.empty())
-            C::OQS_MEM_cleanse(secret_key_.data(), secret_key_.size());
-    }
+    virtual ~Signature() = default;
 
     /**
      * \brief Signature algorithm details, lvalue overload
@@ -605,21 +860,52 @@ class Signature {
      */
     bytes generate_keypair() {
         bytes public_key(get_details().length_public_key, 0);
-        secret_key_ = bytes(alg_details_.length_secret_key, 0);
+        byte* secret_key = secret_key_.reset(alg_details_.length_secret_key);
 
-        OQS_STATUS rv_ = C::OQS_SIG_keypair(sig_.get(), public_key.data(),
-                                            secret_key_.data());
-        if (rv_ != OQS_STATUS::OQS_SUCCESS)
+        LIBOQS_CPP_OP_BEGIN("sig", Keypair, 0);
+        OQS_STATUS rv_ =
+            C::OQS_SIG_keypair(sig_.get(), public_key.data(), secret_key);
+        LIBOQS_CPP_OP_END("sig", Keypair, rv_, public_key.size());
+        if (rv_ != OQS_STATUS::OQS_SUCCESS) {
+            secret_key_.clear();
             throw std::runtime_error("Can not generate keypair");
+        }
 
         return public_key;
     }
 
+    /**
+     * \brief Generate public key/secret key pair in-place
+     * \note Reuses the storage of \a public_key and of the secret key, hence
+     * does not allocate once they have the right size, unless copies of the
+     * instance still share the secret key (they keep the previous one)
+     * \param [out] public_key Public key
+     */
+    void generate_keypair(bytes& public_key) {
+        public_key.resize(alg_details_.length_public_key);
+        byte* secret_key = secret_key_.reset(alg_details_.length_secret_key);
+
+        LIBOQS_CPP_OP_BEGIN("sig", Keypair, 0);
+        OQS_STATUS rv_ =
+            C::OQS_SIG_keypair(sig_.get(), public_key.data(), secret_key);
+        LIBOQS_CPP_OP_END("sig", Keypair, rv_, public_key.size());
+        if (rv_ != OQS_STATUS::OQS_SUCCESS) {
+            secret_key_.clear();
+            throw std::runtime_error("Can not generate keypair");
+        }
+    }
+
     /**
      * \brief Export secret key
      * \return Secret key
      */
-    bytes export_secret_key() const { return secret_key_; }
+    bytes export_secret_key() const { return secret_key_.to_bytes(); }
+
+    /**
+     * \brief Share the secret key, without copying it
+     * \return Secret key, shared with the current instance
+     */
+    SharedSecretKey share_secret_key() const { return secret_key_; }
 
     /**
      * \brief Sign message
@@ -635,10 +921,12 @@ class Signature {
 
         bytes signature(alg_details_.max_length_signature, 0);
 
-        std::size_t len_sig;
+        std::size_t len_sig = 0;
+        LIBOQS_CPP_OP_BEGIN("sig", Sign, message.size());
         OQS_STATUS rv_ =
             C::OQS_SIG_sign(sig_.get(), signature.data(), &len_sig,
                             message.data(), message.size(), secret_key_.data());
+        LIBOQS_CPP_OP_END("sig", Sign, rv_, len_sig);
 
         if (rv_ != OQS_STATUS::OQS_SUCCESS)
             throw std::runtime_error("Can not sign message");
@@ -648,6 +936,35 @@ class Signature {
         return signature;
     }
 
+    /**
+     * \brief Sign message in-place
+     * \note Reuses the storage of \a signature, hence does not allocate once
+     * its capacity reaches the maximum signature length
+     * \param message Message
+     * \param [out] signature Message signature
+     */
+    void sign(const bytes& message, bytes& signature) const {
+        if (secret_key_.size() != alg_details_.length_secret_key)
+            throw std::runtime_error(
+                "Incorrect secret key length, make sure you "
+                "specify one in the constructor or run "
+                "oqs::Signature::generate_keypair()");
+
+        signature.resize(alg_details_.max_length_signature);
+
+        std::size_t len_sig = 0;
+        LIBOQS_CPP_OP_BEGIN("sig", Sign, message.size());
+        OQS_STATUS rv_ =
+            C::OQS_SIG_sign(sig_.get(), signature.data(), &len_sig,
+                            message.data(), message.size(), secret_key_.data());
+        LIBOQS_CPP_OP_END("sig", Sign, rv_, len_sig);
+
+        if (rv_ != OQS_STATUS::OQS_SUCCESS)
+            throw std::runtime_error("Can not sign message");
+
+        signature.resize(len_sig);
+    }
+
     /**
      * \brief Sign message with context string
      * \param message Message
@@ -667,10 +984,12 @@ class Signature {
 
         bytes signature(alg_details_.max_length_signature, 0);
 
-        std::size_t len_sig;
+        std::size_t len_sig = 0;
+        LIBOQS_CPP_OP_BEGIN("sig", Sign, message.size());
         OQS_STATUS rv_ = C::OQS_SIG_sign_with_ctx_str(
             sig_.get(), signature.data(), &len_sig, message.data(),
             message.size(), context.data(), context.size(), secret_key_.data());
+        LIBOQS_CPP_OP_END("sig", Sign, rv_, len_sig);
 
         if (rv_ != OQS_STATUS::OQS_SUCCESS)
             throw std::runtime_error(
@@ -696,9 +1015,11 @@ class Signature {
         if (signature.size() > alg_details_.max_length_signature)
             throw std::runtime_error("Incorrect signature size");
 
+        LIBOQS_CPP_OP_BEGIN("sig", Verify, message.size());
         OQS_STATUS rv_ = C::OQS_SIG_verify(sig_.get(), message.data(),
                                            message.size(), signature.data(),
                                            signature.size(), public_key.data());
+        LIBOQS_CPP_OP_END("sig", Verify, rv_, 0);
 
         return rv_ == OQS_STATUS::OQS_SUCCESS;
     }
@@ -724,10 +1045,12 @@ class Signature {
         if (signature.size() > alg_details_.max_length_signature)
             throw std::runtime_error("Incorrect signature size");
 
+        LIBOQS_CPP_OP_BEGIN("sig", Verify, message.size());
         OQS_STATUS rv_ = C::OQS_SIG_verify_with_ctx_str(
             sig_.get(), message.data(), message.size(), signature.data(),
             signature.size(), context.data(), context.size(),
             public_key.data());
+        LIBOQS_CPP_OP_END("sig", Verify, rv_, 0);
 
         return rv_ == OQS_STATUS::OQS_SUCCESS;
     }
@@ -795,4 +1118,11 @@ static const Sigs& sigs_ =
 } // namespace internal
 } // namespace oqs
 
+#undef LIBOQS_CPP_OP_BEGIN
+#undef LIBOQS_CPP_OP_END
+#undef LIBOQS_CPP_METRICS_BEGIN_
+#undef LIBOQS_CPP_METRICS_END_
+#undef LIBOQS_CPP_USDT_BEGIN_
+#undef LIBOQS_CPP_USDT_END_
+
 #endif // OQS_CPP_HPP_
@@ -0,0 +1,523 @@
+/**
+ * \file sched/sched.hpp
+ * \brief Priority- and deadline-aware scheduler for wrapper operations, with
+ * cost-based admission control and load shedding
+ *
+ * Every request has a priority class, an optional deadline and an estimated
+ * cost, the running mean of the measured duration of its (algorithm,
+ * operation) pair (oqs::sched::CostModel, optionally seeded from
+ * oqs::metrics::snapshot()). Workers always run the most urgent class first,
+ * earliest deadline first within a class, and never run more than
+ * bulk_threads bulk requests at a time, so that a worker stays available for
+ * latency-sensitive requests during bulk key generation or slow signing.
+ *
+ * A request whose deadline can not be met given the work queued ahead of it
+ * is rejected by submit() with oqs::sched::DeadlineExceeded; one whose
+ * deadline can no longer be met when a worker picks it up is shed, its
+ * future then throws oqs::sched::DeadlineExceeded.
+ *
+ *     oqs::sched::CostModel costs;
+ *     oqs::sched::Scheduler scheduler{costs};
+ *     std::future<bool> valid = oqs::sched::verify(
+ *         scheduler, verifier, message, signature, public_key,
+ *         oqs::sched::Priority::Interactive,
+ *         oqs::sched::Clock::now() + std::chrono::milliseconds(5));
+ */
+
+#ifndef SCHED_SCHED_HPP_
+#define SCHED_SCHED_HPP_
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "metrics/metrics.hpp"
+#include "oqs_cpp.hpp"
+
+namespace oqs {
+/**
+ * \namespace sched
+ * \brief Namespace containing the operation scheduler
+ */
+namespace sched {
+using Clock = std::chrono::steady_clock; ///< clock of the deadlines
+using metrics::Operation;
+
+/**
+ * \brief Priority classes, most urgent first
+ */
+enum class Priority { Interactive, Normal, Bulk };
+
+constexpr std::size_t num_priorities = 3; ///< number of priority classes
+
+/**
+ * \brief Lower-case name of a priority class, e.g., "bulk"
+ */
+inline const char* priority_name(Priority priority) {
+    switch (priority) {
+        case Priority::Interactive:
+            return "interactive";
+        case Priority::Normal:
+            return "normal";
+        case Priority::Bulk:
+            return "bulk";
+    }
+    return "unknown";
+}
+
+/**
+ * \class oqs::sched::DeadlineExceeded
+ * \brief Thrown for requests that can not complete before their deadline
+ */
+class DeadlineExceeded : public std::runtime_error {
+  public:
+    DeadlineExceeded() : std::runtime_error{"Deadline can not be met"} {}
+}; // class DeadlineExceeded
+
+/**
+ * \class oqs::sched::CostModel
+ * \brief Thread-safe estimates of the duration of every (algorithm,
+ * operation) pair, exponentially weighted means of the measured durations
+ */
+class CostModel {
+    double default_cost_;
+    double weight_;
+    mutable std::mutex mutex_{};
+    std::map<std::pair<std::string, Operation>, double> costs_{};
+
+  public:
+    /**
+     * \brief Constructor
+     * \param default_cost Estimate of unmeasured pairs, in seconds
+     * \param weight Weight of a new measurement in the running mean
+     */
+    explicit CostModel(double default_cost = 1e-3, double weight = 0.1)
+        : default_cost_{default_cost}, weight_{weight} {}
+
+    CostModel(const CostModel&) = delete;
+    CostModel& operator=(const CostModel&) = delete;
+
+    /**
+     * \brief Estimated duration
+     * \param algorithm Algorithm name
+     * \param operation Operation
+     * \return Duration in seconds
+     */
+    double estimate(const std::string& algorithm, Operation operation) const {
+        std::lock_guard<std::mutex> lock{mutex_};
+        auto it = costs_.find({algorithm, operation});
+        return it == costs_.end() ? default_cost_ : it->second;
+    }
+
+    /**
+     * \brief Adds a measured duration to the running mean
+     * \param algorithm Algorithm name
+     * \param operation Operation
+     * \param seconds Measured duration
+     */
+    void record(const std::string& algorithm, Operation operation,
+                double seconds) {
+        std::lock_guard<std::mutex> lock{mutex_};
+        auto it = costs_.find({algorithm, operation});
+        if (it == costs_.end())
+            costs_.emplace(std::make_pair(algorithm, operation), seconds);
+        else
+            it->second += weight_ * (seconds - it->second);
+    }
+
+    /**
+     * \brief Replaces an estimate
+     * \param algorithm Algorithm name
+     * \param operation Operation
+     * \param seconds Estimated duration
+     */
+    void set(const std::string& algorithm, Operation operation,
+             double seconds) {
+        std::lock_guard<std::mutex> lock{mutex_};
+        costs_[{algorithm, operation}] = seconds;
+    }
+
+    /**
+     * \brief Replaces the estimates with the mean latencies of a metrics
+     * snapshot, see oqs::metrics::snapshot()
+     * \param stats Metrics snapshot
+     */
+    void load(const std::vector<metrics::OperationStats>& stats) {
+        for (auto&& elem : stats)
+            if (elem.calls > 0)
+                set(elem.algorithm, elem.operation, elem.mean());
+    }
+}; // class CostModel
+
+/**
+ * \brief Description of a scheduled request
+ */
+struct Request {
+    std::string algorithm;      ///< algorithm name, for the cost estimate
+    Operation operation;        ///< operation, for the cost estimate
+    Priority priority;          ///< priority class
+    Clock::time_point deadline; ///< latest completion time
+
+    /**
+     * \brief Constructor
+     * \param alg_name Algorithm name
+     * \param op Operation
+     * \param prio Priority class
+     * \param until Deadline, none by default
+     */
+    Request(std::string alg_name, Operation op,
+            Priority prio = Priority::Normal,
+            Clock::time_point until = Clock::time_point::max())
+        : algorithm{std::move(alg_name)}, operation{op}, priority{prio},
+          deadline{until} {}
+};
+
+/**
+ * \brief Scheduler configuration
+ */
+struct SchedulerOptions {
+    std::size_t num_threads = 0;  ///< 0 means all CPUs
+    std::size_t bulk_threads = 0; ///< 0 means all threads but one
+};
+
+/**
+ * \brief Scheduler counters, indexed by priority class
+ */
+struct SchedulerStats {
+    std::array<std::uint64_t, num_priorities> started{};  ///< run requests
+    std::array<std::uint64_t, num_priorities> rejected{}; ///< by submit()
+    std::array<std::uint64_t, num_priorities> shed{};     ///< dropped when due
+};
+
+/**
+ * \class oqs::sched::Scheduler
+ * \brief Pool of worker threads running requests by priority class and
+ * deadline, see sched/sched.hpp
+ */
+class Scheduler {
+    struct Job {
+        Request request;
+        double cost;                   // estimate, in seconds
+        std::function<void(bool)> run; // argument: shed instead of running
+    };
+
+    // Records the duration of its scope into the cost model, before the
+    // result is made ready
+    class Measure {
+        CostModel& costs_;
+        const Request& request_;
+        Clock::time_point start_{Clock::now()};
+
+      public:
+        Measure(CostModel& costs, const Request& request)
+            : costs_{costs}, request_{request} {}
+        Measure(const Measure&) = delete;
+        Measure& operator=(const Measure&) = delete;
+        ~Measure() {
+            costs_.record(request_.algorithm, request_.operation,
+                          std::chrono::duration<double>(Clock::now() - start_)
+                              .count());
+        }
+    };
+
+    // Earliest deadline first, then FIFO
+    using Key = std::pair<Clock::time_point, std::uint64_t>;
+
+    // Currently running request of a worker
+    struct Running {
+        bool busy;
+        Clock::time_point start;
+        double cost;
+    };
+
+    CostModel& costs_;
+    std::size_t bulk_threads_;
+    std::vector<std::thread> threads_{};
+
+    std::mutex mutex_{};
+    std::condition_variable cv_{};
+    std::array<std::map<Key, Job>, num_priorities> queues_{}; // mutex_
+    std::array<double, num_priorities> queued_cost_{};        // mutex_
+    std::vector<Running> running_{};                          // mutex_
+    std::size_t running_bulk_ = 0;                            // mutex_
+    std::uint64_t sequence_ = 0;                              // mutex_
+    SchedulerStats stats_{};                                  // mutex_
+    bool stop_ = false;                                       // mutex_
+
+    static Clock::duration to_duration(double seconds) {
+        return std::chrono::duration_cast<Clock::duration>(
+            std::chrono::duration<double>(seconds));
+    }
+
+    // Most urgent runnable class, num_priorities if none
+    std::size_t next_class() const {
+        for (std::size_t p = 0; p < num_priorities; ++p)
+            if (!queues_[p].empty() &&
+                (p != static_cast<std::size_t>(Priority::Bulk) ||
+                 running_bulk_ < bulk_threads_))
+                return p;
+        return num_priorities;
+    }
+
+    // Estimated time until a request of class p would start running
+    double wait_estimate(std::size_t p, Clock::time_point now) const {
+        double ahead = 0;
+        for (std::size_t q = 0; q <= p; ++q)
+            ahead += queued_cost_[q];
+        for (auto&& elem : running_)
+            if (elem.busy)
+                ahead += std::max(
+                    0.0, elem.cost - std::chrono::duration<double>(
+                                         now - elem.start)
+                                         .count());
+        return ahead / static_cast<double>(running_.size());
+    }
+
+    void work(std::size_t self) {
+        for (;;) {
+            std::unique_lock<std::mutex> lock{mutex_};
+            std::size_t p = num_priorities;
+            cv_.wait(lock, [&] {
+                p = next_class();
+                return p < num_priorities || (stop_ && all_empty());
+            });
+            if (p == num_priorities)
+                return; // stopped and drained
+
+            auto it = queues_[p].begin();
+            Job job = std::move(it->second);
+            queues_[p].erase(it);
+            queued_cost_[p] = queues_[p].empty()
+                                  ? 0
+                                  : std::max(0.0, queued_cost_[p] - job.cost);
+            Clock::time_point now = Clock::now();
+            if (job.request.deadline != Clock::time_point::max() &&
+                now + to_duration(job.cost) > job.request.deadline) {
+                ++stats_.shed[p];
+                lock.unlock();
+                job.run(true);
+                continue;
+            }
+            bool bulk = p == static_cast<std::size_t>(Priority::Bulk);
+            running_[self] = Running{true, now, job.cost};
+            ++stats_.started[p];
+            if (bulk)
+                ++running_bulk_;
+            lock.unlock();
+
+            job.run(false);
+
+            lock.lock();
+            running_[self].busy = false;
+            if (bulk) {
+                --running_bulk_;
+                lock.unlock();
+                cv_.notify_one(); // a bulk slot is free
+            }
+        }
+    }
+
+    bool all_empty() const {
+        for (auto&& queue : queues_)
+            if (!queue.empty())
+                return false;
+        return true;
+    }
+
+  public:
+    /**
+     * \brief Starts the worker threads
+     * \param costs Cost model, updated with the measured durations; must
+     * outlive the scheduler
+     * \param options Configuration
+     */
+    explicit Scheduler(CostModel& costs, SchedulerOptions options = {})
+        : costs_{costs}, bulk_threads_{options.bulk_threads} {
+        std::size_t num_threads = options.num_threads;
+        if (num_threads == 0)
+            num_threads = std::max(1u, std::thread::hardware_concurrency());
+        if (bulk_threads_ == 0 || bulk_threads_ > num_threads)
+            bulk_threads_ = std::max<std::size_t>(1, num_threads - 1);
+        running_.assign(num_threads, Running{false, Clock::time_point{}, 0});
+        for (std::size_t i = 0; i < num_threads; ++i)
+            threads_.emplace_back([this, i] { work(i); });
+    }
+
+    Scheduler(const Scheduler&) = delete;
+    Scheduler& operator=(const Scheduler&) = delete;
+
+    /**
+     * \brief Runs (or sheds) the requests still queued, then joins the
+     * worker threads
+     */
+    ~Scheduler() {
+        {
+            std::lock_guard<std::mutex> lock{mutex_};
+            stop_ = true;
+        }
+        cv_.notify_all();
+        for (auto&& thread : threads_)
+            thread.join();
+    }
+
+    /**
+     * \brief Queues a request, thread-safe
+     * \param request Description of the request
+     * \param fn Operation, run on a worker thread
+     * \return Future result of \a fn, throws oqs::sched::DeadlineExceeded if
+     * the request is shed
+     * \throws oqs::sched::DeadlineExceeded if the deadline can not be met
+     */
+    template <typename F>
+    auto submit(const Request& request, F fn) -> std::future<decltype(fn())> {
+        using R = decltype(fn());
+        auto task = std::make_shared<std::packaged_task<R(bool)>>(
+            [this, fn, request](bool shed) -> R {
+                if (shed)
+                    throw DeadlineExceeded{};
+                Measure measure{costs_, request};
+                return fn();
+            });
+        std::future<R> result = task->get_future();
+
+        double cost = costs_.estimate(request.algorithm, request.operation);
+        auto p = static_cast<std::size_t>(request.priority);
+        {
+            std::lock_guard<std::mutex> lock{mutex_};
+            if (request.deadline != Clock::time_point::max()) {
+                Clock::time_point now = Clock::now();
+                if (now + to_duration(wait_estimate(p, now) + cost) >
+                    request.deadline) {
+                    ++stats_.rejected[p];
+                    throw DeadlineExceeded{};
+                }
+            }
+            queues_[p].emplace(
+                Key{request.deadline, sequence_++},
+                Job{request, cost, [task](bool shed) { (*task)(shed); }});
+            queued_cost_[p] += cost;
+        }
+        cv_.notify_one();
+        return result;
+    }
+
+    /**
+     * \brief Counters, thread-safe
+     */
+    SchedulerStats stats() {
+        std::lock_guard<std::mutex> lock{mutex_};
+        return stats_;
+    }
+
+    /**
+     * \brief Number of worker threads
+     */
+    std::size_t size() const noexcept { return threads_.size(); }
+}; // class Scheduler
+
+// The wrapper objects are used from a worker thread, they must outlive the
+// request. Inputs are copied. The default priorities put latency-sensitive
+// operations first and key generation last.
+
+/**
+ * \brief Scheduled oqs::Signature::verify()
+ * \return Future validity of the signature
+ */
+inline std::future<bool>
+verify(Scheduler& scheduler, const Signature& sig, bytes message,
+       bytes signature, bytes public_key,
+       Priority priority = Priority::Interactive,
+       Clock::time_point deadline = Clock::time_point::max()) {
+    return scheduler.submit(
+        Request{sig.get_details().name, Operation::Verify, priority,
+                deadline},
+        [&sig, message, signature, public_key] {
+            return sig.verify(message, signature, public_key);
+        });
+}
+
+/**
+ * \brief Scheduled oqs::Signature::sign()
+ * \return Future signature
+ */
+inline std::future<bytes>
+sign(Scheduler& scheduler, const Signature& sig, bytes message,
+     Priority priority = Priority::Normal,
+     Clock::time_point deadline = Clock::time_point::max()) {
+    return scheduler.submit(
+        Request{sig.get_details().name, Operation::Sign, priority, deadline},
+        [&sig, message] { return sig.sign(message); });
+}
+
+/**
+ * \brief Scheduled oqs::KeyEncapsulation::decap_secret()
+ * \return Future shared secret
+ */
+inline std::future<bytes>
+decap_secret(Scheduler& scheduler, const KeyEncapsulation& kem,
+             bytes ciphertext, Priority priority = Priority::Interactive,
+             Clock::time_point deadline = Clock::time_point::max()) {
+    return scheduler.submit(
+        Request{kem.get_details().name, Operation::Decaps, priority,
+                deadline},
+        [&kem, ciphertext] { return kem.decap_secret(ciphertext); });
+}
+
+/**
+ * \brief Scheduled oqs::KeyEncapsulation::encap_secret()
+ * \return Future ciphertext and shared secret
+ */
+inline std::future<std::pair<bytes, bytes>>
+encap_secret(Scheduler& scheduler, const KeyEncapsulation& kem,
+             bytes public_key, Priority priority = Priority::Interactive,
+             Clock::time_point deadline = Clock::time_point::max()) {
+    return scheduler.submit(
+        Request{kem.get_details().name, Operation::Encaps, priority,
+                deadline},
+        [&kem, public_key] { return kem.encap_secret(public_key); });
+}
+
+/**
+ * \brief Scheduled oqs::KeyEncapsulation::generate_keypair()
+ * \return Future public key
+ */
+inline std::future<bytes>
+generate_keypair(Scheduler& scheduler, KeyEncapsulation& kem,
+                 Priority priority = Priority::Bulk,
+                 Clock::time_point deadline = Clock::time_point::max()) {
+    return scheduler.submit(
+        Request{kem.get_details().name, Operation::Keypair, priority,
+                deadline},
+        [&kem] { return kem.generate_keypair(); });
+}
+
+/**
+ * \brief Scheduled oqs::Signature::generate_keypair()
+ * \return Future public key
+ */
+inline std::future<bytes>
+generate_keypair(Scheduler& scheduler, Signature& sig,
+                 Priority priority = Priority::Bulk,
+                 Clock::time_point deadline = Clock::time_point::max()) {
+    return scheduler.submit(
+        Request{sig.get_details().name, Operation::Keypair, priority,
+                deadline},
+        [&sig] { return sig.generate_keypair(); });
+}
+} // namespace sched
+} // namespace oqs
+
+#endif // SCHED_SCHED_HPP_
@@ -0,0 +1,291 @@
+/**
+ * \file sha3/sha3.hpp
+ * \brief Provides support for the SHA3/SHAKE functions exported by liboqs
+ */
+
+#ifndef SHA3_SHA3_HPP_
+#define SHA3_SHA3_HPP_
+
+#include <cstdint>
+#include <cstdlib>
+#include <stdexcept>
+
+#include "common.hpp"
+
+namespace oqs {
+namespace C {
+// everything in liboqs has C linkage
+extern "C" {
+#include <oqs/sha3_ops.h>
+#include <oqs/sha3x4_ops.h>
+}
+} // namespace C
+
+/**
+ * \namespace sha3
+ * \brief Namespace containing SHA3/SHAKE-related functions
+ */
+namespace sha3 {
+constexpr std::size_t sha3_256_length = 32; ///< SHA3-256 digest length
+constexpr std::size_t sha3_512_length = 64; ///< SHA3-512 digest length
+
+/**
+ * \brief SHA3-256 digest of \a input
+ * \param input Input bytes
+ * \return 32-byte digest
+ */
+inline bytes sha3_256(const bytes& input) {
+    bytes result(sha3_256_length);
+    C::OQS_SHA3_sha3_256(result.data(), input.data(), input.size());
+    return result;
+}
+
+/**
+ * \brief SHA3-512 digest of \a input
+ * \param input Input bytes
+ * \return 64-byte digest
+ */
+inline bytes sha3_512(const bytes& input) {
+    bytes result(sha3_512_length);
+    C::OQS_SHA3_sha3_512(result.data(), input.data(), input.size());
+    return result;
+}
+
+/**
+ * \brief SHAKE256 extendable output of \a input
+ * \param input Input bytes
+ * \param output_len Number of output bytes
+ * \return \a output_len bytes of SHAKE256 output
+ */
+inline bytes shake256(const bytes& input, std::size_t output_len) {
+    bytes result(output_len);
+    C::OQS_SHA3_shake256(result.data(), output_len, input.data(),
+                         input.size());
+    return result;
+}
+
+/**
+ * \brief SHAKE256 of four equal-length inputs at once, using the 4-lane
+ * Keccak of liboqs (AVX2 when available)
+ * \param output Four output buffers of \a output_len bytes each
+ * \param output_len Number of output bytes per input
+ * \param input Four inputs of \a input_len bytes each
+ * \param input_len Number of bytes per input
+ */
+inline void shake256_x4(byte* const output[4], std::size_t output_len,
+                        const byte* const input[4], std::size_t input_len) {
+    C::OQS_SHA3_shake256_x4(output[0], output[1], output[2], output[3],
+                            output_len, input[0], input[1], input[2],
+                            input[3], input_len);
+}
+
+/**
+ * \class oqs::sha3::SHA3_256
+ * \brief Incremental SHA3-256, owns the liboqs incremental context
+ */
+class SHA3_256 {
+    C::OQS_SHA3_sha3_256_inc_ctx ctx_{}; ///< liboqs incremental context
+
+  public:
+    /**
+     * \brief Constructs an instance ready to absorb input
+     */
+    SHA3_256() { C::OQS_SHA3_sha3_256_inc_init(&ctx_); }
+
+    /**
+     * \brief Copy constructor, clones the absorbed state
+     * \param rhs oqs::sha3::SHA3_256 instance
+     */
+    SHA3_256(const SHA3_256& rhs) {
+        C::OQS_SHA3_sha3_256_inc_init(&ctx_);
+        C::OQS_SHA3_sha3_256_inc_ctx_clone(&ctx_, &rhs.ctx_);
+    }
+
+    /**
+     * \brief Copy assignment operator, clones the absorbed state
+     * \param rhs oqs::sha3::SHA3_256 instance
+     * \return Reference to the current instance
+     */
+    SHA3_256& operator=(const SHA3_256& rhs) {
+        if (this != &rhs)
+            C::OQS_SHA3_sha3_256_inc_ctx_clone(&ctx_, &rhs.ctx_);
+        return *this;
+    }
+
+    /**
+     * \brief Releases the liboqs incremental context
+     */
+    ~SHA3_256() { C::OQS_SHA3_sha3_256_inc_ctx_release(&ctx_); }
+
+    /**
+     * \brief Absorbs \a len bytes starting at \a input
+     * \param input Pointer to the input bytes
+     * \param len Number of bytes
+     * \return Reference to the current instance
+     */
+    SHA3_256& absorb(const byte* input, std::size_t len) {
+        C::OQS_SHA3_sha3_256_inc_absorb(&ctx_, input, len);
+        return *this;
+    }
+
+    /**
+     * \brief Absorbs \a input
+     * \param input Input bytes
+     * \return Reference to the current instance
+     */
+    SHA3_256& absorb(const bytes& input) {
+        return absorb(input.data(), input.size());
+    }
+
+    /**
+     * \brief Writes the digest of everything absorbed so far into \a output,
+     * without disturbing the running state (the state is cloned first)
+     * \note Does not allocate on the C++ side, use it for transcript hashes
+     * \param output Output buffer of at least oqs::sha3::sha3_256_length bytes
+     */
+    void digest(byte* output) const {
+        C::OQS_SHA3_sha3_256_inc_ctx tmp{};
+        C::OQS_SHA3_sha3_256_inc_init(&tmp);
+        C::OQS_SHA3_sha3_256_inc_ctx_clone(&tmp, &ctx_);
+        C::OQS_SHA3_sha3_256_inc_finalize(output, &tmp);
+        C::OQS_SHA3_sha3_256_inc_ctx_release(&tmp);
+    }
+
+    /**
+     * \brief Digest of everything absorbed so far, the running state is
+     * preserved
+     * \return 32-byte digest
+     */
+    bytes digest() const {
+        bytes result(sha3_256_length);
+        digest(result.data());
+        return result;
+    }
+
+    /**
+     * \brief Writes the digest of everything absorbed so far into \a output,
+     * consuming the state
+     * \note Invoke oqs::sha3::SHA3_256::reset() or assign another instance
+     * before reusing it. Unlike oqs::sha3::SHA3_256::digest(), does not
+     * create a temporary liboqs context
+     * \param output Output buffer of at least oqs::sha3::sha3_256_length bytes
+     */
+    void finalize(byte* output) {
+        C::OQS_SHA3_sha3_256_inc_finalize(output, &ctx_);
+    }
+
+    /**
+     * \brief Resets the state, as if freshly constructed
+     * \return Reference to the current instance
+     */
+    SHA3_256& reset() {
+        C::OQS_SHA3_sha3_256_inc_ctx_reset(&ctx_);
+        return *this;
+    }
+}; // class SHA3_256
+
+/**
+ * \class oqs::sha3::SHAKE256
+ * \brief Incremental SHAKE256, owns the liboqs incremental context
+ *
+ * Absorb with oqs::sha3::SHAKE256::absorb(), then call
+ * oqs::sha3::SHAKE256::finalize() once, and squeeze as many bytes as needed
+ */
+class SHAKE256 {
+    C::OQS_SHA3_shake256_inc_ctx ctx_{}; ///< liboqs incremental context
+
+  public:
+    /**
+     * \brief Constructs an instance ready to absorb input
+     */
+    SHAKE256() { C::OQS_SHA3_shake256_inc_init(&ctx_); }
+
+    /**
+     * \brief Copy constructor, clones the absorbed state
+     * \param rhs oqs::sha3::SHAKE256 instance
+     */
+    SHAKE256(const SHAKE256& rhs) {
+        C::OQS_SHA3_shake256_inc_init(&ctx_);
+        C::OQS_SHA3_shake256_inc_ctx_clone(&ctx_, &rhs.ctx_);
+    }
+
+    /**
+     * \brief Copy assignment operator, clones the absorbed state
+     * \param rhs oqs::sha3::SHAKE256 instance
+     * \return Reference to the current instance
+     */
+    SHAKE256& operator=(const SHAKE256& rhs) {
+        if (this != &rhs)
+            C::OQS_SHA3_shake256_inc_ctx_clone(&ctx_, &rhs.ctx_);
+        return *this;
+    }
+
+    /**
+     * \brief Releases the liboqs incremental context
+     */
+    ~SHAKE256() { C::OQS_SHA3_shake256_inc_ctx_release(&ctx_); }
+
+    /**
+     * \brief Absorbs \a len bytes starting at \a input
+     * \param input Pointer to the input bytes
+     * \param len Number of bytes
+     * \return Reference to the current instance
+     */
+    SHAKE256& absorb(const byte* input, std::size_t len) {
+        C::OQS_SHA3_shake256_inc_absorb(&ctx_, input, len);
+        return *this;
+    }
+
+    /**
+     * \brief Absorbs \a input
+     * \param input Input bytes
+     * \return Reference to the current instance
+     */
+    SHAKE256& absorb(const bytes& input) {
+        return absorb(input.data(), input.size());
+    }
+
+    /**
+     * \brief Ends the absorb phase
+     * \return Reference to the current instance
+     */
+    SHAKE256& finalize() {
+        C::OQS_SHA3_shake256_inc_finalize(&ctx_);
+        return *this;
+    }
+
+    /**
+     * \brief Squeezes \a len bytes into \a output
+     * \param output Output buffer of at least \a len bytes
+     * \param len Number of bytes
+     * \return Reference to the current instance
+     */
+    SHAKE256& squeeze(byte* output, std::size_t len) {
+        C::OQS_SHA3_shake256_inc_squeeze(output, len, &ctx_);
+        return *this;
+    }
+
+    /**
+     * \brief Squeezes \a len bytes
+     * \param len Number of bytes
+     * \return Squeezed bytes
+     */
+    bytes squeeze(std::size_t len) {
+        bytes result(len);
+        squeeze(result.data(), len);
+        return result;
+    }
+
+    /**
+     * \brief Resets the state, as if freshly constructed
+     * \return Reference to the current instance
+     */
+    SHAKE256& reset() {
+        C::OQS_SHA3_shake256_inc_ctx_reset(&ctx_);
+        return *this;
+    }
+}; // class SHAKE256
+} // namespace sha3
+} // namespace oqs
+
+#endif // SHA3_SHA3_HPP_
@@ -0,0 +1,338 @@
+/**
+ * \file treehash/treehash.hpp
+ * \brief Parallel tree hashing of large inputs, and signing of the root
+ *
+ * The input is cut into leaves of leaf_size bytes (the last one possibly
+ * shorter, a single empty leaf for an empty input). Leaves are hashed on all
+ * cores, four at a time with the 4-lane SHAKE256 of liboqs, then combined in
+ * a binary tree
+ *
+ *     leaf = SHAKE256(leaf bytes, 64)
+ *     node = SHAKE256(1 | left (64) | right (64), 64)
+ *
+ * level by level, pairing adjacent nodes and carrying an unpaired last node
+ * up to the next level. The root is
+ *
+ *     root = SHAKE256(2 | leaf_size (8, big-endian) |
+ *                     input length (8, big-endian) | top node (64), 64)
+ *
+ * The leaf size and input length fix the shape of the tree, so every
+ * position is unambiguous. The root is signed with
+ * oqs::Signature::sign_with_ctx_str() under the context string returned by
+ * oqs::treehash::context(), which records the mode and the leaf size, so a
+ * root is never confused with a plain message or a root of another leaf
+ * size; the signature algorithm must support context strings (e.g.,
+ * ML-DSA).
+ */
+
+#ifndef TREEHASH_TREEHASH_HPP_
+#define TREEHASH_TREEHASH_HPP_
+
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifndef _WIN32
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "common.hpp"
+#include "oqs_cpp.hpp"
+#include "sha3/sha3.hpp"
+
+namespace oqs {
+/**
+ * \namespace treehash
+ * \brief Namespace containing the parallel tree hash
+ */
+namespace treehash {
+constexpr std::size_t digest_length = 64; ///< node and root length
+
+/**
+ * \brief Tree hash configuration
+ */
+struct Options {
+    std::size_t leaf_size = 1 << 20; ///< bytes per leaf, part of the hash
+    std::size_t num_threads = 0;     ///< threads, 0 means all CPUs
+    bool use_x4 = true;              ///< 4-lane SHAKE256, same output
+};
+
+/**
+ * \brief Context string under which roots are signed, e.g.,
+ * "oqs-treehash 1 shake256 leaf 1048576"
+ */
+inline bytes context(const Options& options) {
+    std::string ctx =
+        "oqs-treehash 1 shake256 leaf " + std::to_string(options.leaf_size);
+    return bytes(ctx.begin(), ctx.end());
+}
+
+namespace internal {
+/**
+ * \brief Hashes the leaves into \a digests (digest_length bytes per leaf) on
+ * up to options.num_threads threads, each owning a contiguous range of
+ * leaves
+ * \tparam Read Callable const byte*(std::size_t first, std::size_t count,
+ * bytes& buffer) returning the \a count leaves starting at leaf \a first,
+ * contiguous, possibly read into \a buffer (the thread's own)
+ */
+template <typename Read>
+void hash_leaves(std::uint64_t length, const Options& options,
+                 bytes& digests, Read read) {
+    const std::size_t leaf_size = options.leaf_size;
+    std::size_t num_leaves =
+        length == 0 ? 1
+                    : static_cast<std::size_t>((length - 1) / leaf_size + 1);
+    digests.assign(num_leaves * digest_length, 0);
+    auto leaf_length = [&](std::size_t leaf) {
+        std::uint64_t begin = static_cast<std::uint64_t>(leaf) * leaf_size;
+        return static_cast<std::size_t>(
+            std::min<std::uint64_t>(leaf_size, length - begin));
+    };
+
+    // Groups of 4 leaves, split in contiguous ranges among the threads
+    std::size_t num_groups = (num_leaves + 3) / 4;
+    std::size_t num_threads = options.num_threads;
+    if (num_threads == 0)
+        num_threads = std::max(1u, std::thread::hardware_concurrency());
+    num_threads = std::min(num_threads, num_groups);
+    oqs::internal::parallel_for(
+        num_threads, num_threads, [&](std::size_t thread) {
+            bytes buffer;
+            std::size_t begin = num_groups * thread / num_threads;
+            std::size_t end = num_groups * (thread + 1) / num_threads;
+            for (std::size_t group = begin; group < end; ++group) {
+                std::size_t first = 4 * group;
+                std::size_t count =
+                    std::min<std::size_t>(4, num_leaves - first);
+                const byte* data = read(first, count, buffer);
+                byte* out = digests.data() + first * digest_length;
+                if (options.use_x4 && count == 4 &&
+                    leaf_length(first + 3) == leaf_size) {
+                    const byte* in[4] = {data, data + leaf_size,
+                                         data + 2 * leaf_size,
+                                         data + 3 * leaf_size};
+                    byte* outs[4] = {out, out + digest_length,
+                                     out + 2 * digest_length,
+                                     out + 3 * digest_length};
+                    sha3::shake256_x4(outs, digest_length, in, leaf_size);
+                    continue;
+                }
+                for (std::size_t i = 0; i < count; ++i)
+                    C::OQS_SHA3_shake256(out + i * digest_length,
+                                         digest_length, data + i * leaf_size,
+                                         leaf_length(first + i));
+            }
+        });
+}
+
+/**
+ * \brief Combines the leaf digests into the root, see
+ * treehash/treehash.hpp
+ */
+inline bytes combine(bytes level, std::uint64_t length,
+                     const Options& options) {
+    const std::size_t node_input = 1 + 2 * digest_length;
+    while (level.size() > digest_length) {
+        std::size_t nodes = level.size() / digest_length;
+        std::size_t pairs = nodes / 2;
+        bytes next((pairs + nodes % 2) * digest_length);
+        // Node inputs, 1 | left | right, hashed 4 at a time
+        bytes inputs(pairs * node_input);
+        for (std::size_t i = 0; i < pairs; ++i) {
+            inputs[i * node_input] = 1;
+            std::copy(level.begin() + 2 * i * digest_length,
+                      level.begin() + (2 * i + 2) * digest_length,
+                      inputs.begin() + i * node_input + 1);
+        }
+        std::size_t i = 0;
+        for (; options.use_x4 && i + 4 <= pairs; i += 4) {
+            const byte* in[4];
+            byte* out[4];
+            for (std::size_t lane = 0; lane < 4; ++lane) {
+                in[lane] = inputs.data() + (i + lane) * node_input;
+                out[lane] = next.data() + (i + lane) * digest_length;
+            }
+            sha3::shake256_x4(out, digest_length, in, node_input);
+        }
+        for (; i < pairs; ++i)
+            C::OQS_SHA3_shake256(next.data() + i * digest_length,
+                                 digest_length,
+                                 inputs.data() + i * node_input, node_input);
+        if (nodes % 2 != 0)
+            std::copy(level.end() - digest_length, level.end(),
+                      next.end() - digest_length);
+        level = std::move(next);
+    }
+
+    bytes header{2};
+    for (int shift = 56; shift >= 0; shift -= 8)
+        header.push_back(static_cast<byte>(
+            static_cast<std::uint64_t>(options.leaf_size) >> shift));
+    for (int shift = 56; shift >= 0; shift -= 8)
+        header.push_back(static_cast<byte>(length >> shift));
+    sha3::SHAKE256 xof;
+    return xof.absorb(header)
+        .absorb(level.data(), digest_length)
+        .finalize()
+        .squeeze(digest_length);
+}
+
+inline void check(const Options& options) {
+    if (options.leaf_size == 0)
+        throw std::invalid_argument("leaf_size must be at least 1");
+}
+} // namespace internal
+
+/**
+ * \brief Tree hash root of an in-memory input, e.g., a mapped file
+ * \param data Input
+ * \param length Input length
+ * \param options Configuration
+ * \return oqs::treehash::digest_length bytes
+ */
+inline bytes root(const byte* data, std::size_t length,
+                  const Options& options = {}) {
+    internal::check(options);
+    bytes digests;
+    internal::hash_leaves(
+        length, options, digests,
+        [&](std::size_t first, std::size_t, bytes&) {
+            return data + first * options.leaf_size;
+        });
+    return internal::combine(std::move(digests), length, options);
+}
+
+/**
+ * \brief Tree hash root of an in-memory input
+ * \param data Input
+ * \param options Configuration
+ * \return oqs::treehash::digest_length bytes
+ */
+inline bytes root(const bytes& data, const Options& options = {}) {
+    return root(data.data(), data.size(), options);
+}
+
+#ifndef _WIN32
+/**
+ * \brief Tree hash root of a file, every thread reading its own range of
+ * leaves with pread()
+ * \param path File path
+ * \param options Configuration
+ * \return oqs::treehash::digest_length bytes
+ * \throws std::runtime_error if the file can not be read, or is modified
+ * while it is hashed
+ */
+inline bytes root_file(const std::string& path, const Options& options = {}) {
+    internal::check(options);
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        throw std::runtime_error("Can not open " + path);
+    struct stat st {};
+    if (::fstat(fd, &st) != 0) {
+        ::close(fd);
+        throw std::runtime_error("Can not stat " + path);
+    }
+    std::uint64_t length = static_cast<std::uint64_t>(st.st_size);
+    bytes digests;
+    try {
+        internal::hash_leaves(
+            length, options, digests,
+            [&](std::size_t first, std::size_t count, bytes& buffer) {
+                std::uint64_t offset =
+                    static_cast<std::uint64_t>(first) * options.leaf_size;
+                std::size_t len = static_cast<std::size_t>(
+                    std::min<std::uint64_t>(count * options.leaf_size,
+                                            length - offset));
+                buffer.resize(4 * options.leaf_size);
+                for (std::size_t done = 0; done < len;) {
+                    ssize_t rc = ::pread(fd, buffer.data() + done, len - done,
+                                         static_cast<off_t>(offset + done));
+                    if (rc < 0 && errno == EINTR)
+                        continue;
+                    if (rc <= 0)
+                        throw std::runtime_error("Can not read " + path);
+                    done += static_cast<std::size_t>(rc);
+                }
+                return static_cast<const byte*>(buffer.data());
+            });
+    } catch (...) {
+        ::close(fd);
+        throw;
+    }
+    ::close(fd);
+    return internal::combine(std::move(digests), length, options);
+}
+#endif // _WIN32
+
+/**
+ * \brief Signs a tree hash root under oqs::treehash::context()
+ * \param signer oqs::Signature instance holding the secret key
+ * \param root Root, see oqs::treehash::root()
+ * \param options Configuration the root was computed with
+ * \return Signature
+ */
+inline bytes sign_root(const Signature& signer, const bytes& root,
+                       const Options& options = {}) {
+    if (root.size() != digest_length)
+        throw std::invalid_argument("Incorrect root length");
+    return signer.sign_with_ctx_str(root, context(options));
+}
+
+/**
+ * \brief Verifies the signature of a tree hash root
+ * \param verifier oqs::Signature instance of the signer's algorithm
+ * \param root Root recomputed by the verifier
+ * \param signature Signature
+ * \param public_key Signer's public key
+ * \param options Configuration the root was computed with
+ * \return True if the signature is valid, false otherwise
+ */
+inline bool verify_root(const Signature& verifier, const bytes& root,
+                        const bytes& signature, const bytes& public_key,
+                        const Options& options = {}) {
+    if (root.size() != digest_length)
+        throw std::invalid_argument("Incorrect root length");
+    return verifier.verify_with_ctx_str(root, signature, context(options),
+                                        public_key);
+}
+
+/**
+ * \brief Tree-hashes and signs an in-memory input
+ * \param signer oqs::Signature instance holding the secret key
+ * \param data Input
+ * \param length Input length
+ * \param options Configuration
+ * \return Signature
+ */
+inline bytes sign(const Signature& signer, const byte* data,
+                  std::size_t length, const Options& options = {}) {
+    return sign_root(signer, root(data, length, options), options);
+}
+
+/**
+ * \brief Tree-hashes an in-memory input and verifies its signature
+ * \param verifier oqs::Signature instance of the signer's algorithm
+ * \param data Input
+ * \param length Input length
+ * \param signature Signature
+ * \param public_key Signer's public key
+ * \param options Configuration the input was signed with
+ * \return True if the signature is valid, false otherwise
+ */
+inline bool verify(const Signature& verifier, const byte* data,
+                   std::size_t length, const bytes& signature,
+                   const bytes& public_key, const Options& options = {}) {
+    return verify_root(verifier, root(data, length, options), signature,
+                       public_key, options);
+}
+} // namespace treehash
+} // namespace oqs
+
+#endif // TREEHASH_TREEHASH_HPP_
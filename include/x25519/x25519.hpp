@@ -0,0 +1,338 @@
+/**
+ * \file x25519/x25519.hpp
+ * \brief Self-contained X25519 (RFC 7748), for the hybrid KEMs of
+ * hybrid/hybrid.hpp
+ *
+ * Montgomery ladder over GF(2^255 - 19) with five 51-bit limbs, constant
+ * time (no secret-dependent branches or memory accesses). Uses 128-bit
+ * products where the compiler has them, a portable emulation otherwise.
+ */
+
+#ifndef X25519_X25519_HPP_
+#define X25519_X25519_HPP_
+
+#include <cstdint>
+#include <stdexcept>
+
+#include "common.hpp"
+#include "oqs_cpp.hpp"
+
+namespace oqs {
+/**
+ * \namespace x25519
+ * \brief Namespace containing the X25519 function
+ */
+namespace x25519 {
+constexpr std::size_t key_length = 32; ///< scalar and u-coordinate length
+
+namespace internal {
+#if defined(__SIZEOF_INT128__)
+__extension__ typedef unsigned __int128 uint128;
+
+inline uint128 mul(std::uint64_t a, std::uint64_t b) {
+    return static_cast<uint128>(a) * b;
+}
+
+inline std::uint64_t low(uint128 x) { return static_cast<std::uint64_t>(x); }
+
+inline std::uint64_t shift51(uint128 x) {
+    return static_cast<std::uint64_t>(x >> 51);
+}
+#else
+/**
+ * \brief Portable unsigned 128-bit accumulator
+ */
+struct uint128 {
+    std::uint64_t lo; ///< low 64 bits
+    std::uint64_t hi; ///< high 64 bits
+
+    uint128& operator+=(const uint128& rhs) {
+        lo += rhs.lo;
+        hi += rhs.hi + (lo < rhs.lo ? 1 : 0);
+        return *this;
+    }
+
+    uint128 operator+(const uint128& rhs) const {
+        uint128 result = *this;
+        return result += rhs;
+    }
+
+    uint128& operator+=(std::uint64_t rhs) { return *this += uint128{rhs, 0}; }
+};
+
+inline uint128 mul(std::uint64_t a, std::uint64_t b) {
+    std::uint64_t a0 = a & 0xffffffff, a1 = a >> 32;
+    std::uint64_t b0 = b & 0xffffffff, b1 = b >> 32;
+    std::uint64_t p00 = a0 * b0, p01 = a0 * b1, p10 = a1 * b0, p11 = a1 * b1;
+    std::uint64_t middle = (p00 >> 32) + (p01 & 0xffffffff) + p10;
+    return uint128{(middle << 32) | (p00 & 0xffffffff),
+                   p11 + (p01 >> 32) + (middle >> 32)};
+}
+
+inline std::uint64_t low(const uint128& x) { return x.lo; }
+
+inline std::uint64_t shift51(const uint128& x) {
+    return (x.lo >> 51) | (x.hi << 13);
+}
+#endif
+
+constexpr std::uint64_t mask51 = (std::uint64_t{1} << 51) - 1;
+
+/**
+ * \brief Field element, value sum(f[i] 2^(51 i)); limbs of products are
+ * below 2^52, of sums and differences below 2^54
+ */
+typedef std::uint64_t fe[5];
+
+inline std::uint64_t load64(const byte* s) {
+    std::uint64_t result = 0;
+    for (int i = 7; i >= 0; --i)
+        result = (result << 8) | s[i];
+    return result;
+}
+
+inline void store64(byte* s, std::uint64_t v) {
+    for (int i = 0; i < 8; ++i)
+        s[i] = static_cast<byte>(v >> (8 * i));
+}
+
+/**
+ * \brief Decodes a u-coordinate, ignoring the top bit
+ */
+inline void fe_frombytes(fe h, const byte* s) {
+    h[0] = load64(s) & mask51;
+    h[1] = (load64(s + 6) >> 3) & mask51;
+    h[2] = (load64(s + 12) >> 6) & mask51;
+    h[3] = (load64(s + 19) >> 1) & mask51;
+    h[4] = (load64(s + 24) >> 12) & mask51;
+}
+
+inline void fe_carry(fe t) {
+    for (int i = 0; i < 4; ++i) {
+        t[i + 1] += t[i] >> 51;
+        t[i] &= mask51;
+    }
+    t[0] += 19 * (t[4] >> 51);
+    t[4] &= mask51;
+}
+
+/**
+ * \brief Encodes the canonical representative of \a f
+ */
+inline void fe_tobytes(byte* s, const fe f) {
+    fe t = {f[0], f[1], f[2], f[3], f[4]};
+    fe_carry(t);
+    fe_carry(t);
+    // Now t < 2^255; t + 19 wraps around iff t >= p, which leaves
+    // (t mod p) + 19 in both cases
+    t[0] += 19;
+    fe_carry(t);
+    // Adds 2^255 - 19 and drops 2^255
+    t[0] += mask51 - 18;
+    for (int i = 1; i < 5; ++i)
+        t[i] += mask51;
+    for (int i = 0; i < 4; ++i) {
+        t[i + 1] += t[i] >> 51;
+        t[i] &= mask51;
+    }
+    t[4] &= mask51;
+    store64(s, t[0] | (t[1] << 51));
+    store64(s + 8, (t[1] >> 13) | (t[2] << 38));
+    store64(s + 16, (t[2] >> 26) | (t[3] << 25));
+    store64(s + 24, (t[3] >> 39) | (t[4] << 12));
+}
+
+inline void fe_add(fe h, const fe f, const fe g) {
+    for (int i = 0; i < 5; ++i)
+        h[i] = f[i] + g[i];
+}
+
+/**
+ * \brief h = f - g, computed as f + 4 p - g so that limbs stay positive
+ */
+inline void fe_sub(fe h, const fe f, const fe g) {
+    h[0] = f[0] + 4 * (mask51 - 18) - g[0];
+    for (int i = 1; i < 5; ++i)
+        h[i] = f[i] + 4 * mask51 - g[i];
+}
+
+inline void fe_mul(fe h, const fe f, const fe g) {
+    std::uint64_t g19[5];
+    for (int i = 1; i < 5; ++i)
+        g19[i] = 19 * g[i];
+    uint128 r0 = mul(f[0], g[0]) + mul(f[1], g19[4]) + mul(f[2], g19[3]) +
+                 mul(f[3], g19[2]) + mul(f[4], g19[1]);
+    uint128 r1 = mul(f[0], g[1]) + mul(f[1], g[0]) + mul(f[2], g19[4]) +
+                 mul(f[3], g19[3]) + mul(f[4], g19[2]);
+    uint128 r2 = mul(f[0], g[2]) + mul(f[1], g[1]) + mul(f[2], g[0]) +
+                 mul(f[3], g19[4]) + mul(f[4], g19[3]);
+    uint128 r3 = mul(f[0], g[3]) + mul(f[1], g[2]) + mul(f[2], g[1]) +
+                 mul(f[3], g[0]) + mul(f[4], g19[4]);
+    uint128 r4 = mul(f[0], g[4]) + mul(f[1], g[3]) + mul(f[2], g[2]) +
+                 mul(f[3], g[1]) + mul(f[4], g[0]);
+    r1 += shift51(r0);
+    h[0] = low(r0) & mask51;
+    r2 += shift51(r1);
+    h[1] = low(r1) & mask51;
+    r3 += shift51(r2);
+    h[2] = low(r2) & mask51;
+    r4 += shift51(r3);
+    h[3] = low(r3) & mask51;
+    h[0] += 19 * shift51(r4);
+    h[4] = low(r4) & mask51;
+    h[1] += h[0] >> 51;
+    h[0] &= mask51;
+}
+
+inline void fe_sq(fe h, const fe f) { fe_mul(h, f, f); }
+
+/**
+ * \brief h = f^(2^n)
+ */
+inline void fe_sq_times(fe h, const fe f, int n) {
+    fe_sq(h, f);
+    for (int i = 1; i < n; ++i)
+        fe_sq(h, h);
+}
+
+/**
+ * \brief h = z^(p - 2) = 1 / z
+ */
+inline void fe_invert(fe h, const fe z) {
+    fe z2, z9, z11, a, b, c;
+    fe_sq(z2, z);
+    fe_sq_times(a, z2, 2);
+    fe_mul(z9, a, z);
+    fe_mul(z11, z9, z2);
+    fe_sq(a, z11);
+    fe_mul(a, a, z9); // z^(2^5 - 1)
+    fe_sq_times(b, a, 5);
+    fe_mul(b, b, a); // z^(2^10 - 1)
+    fe_sq_times(c, b, 10);
+    fe_mul(c, c, b); // z^(2^20 - 1)
+    fe_sq_times(h, c, 20);
+    fe_mul(c, h, c); // z^(2^40 - 1)
+    fe_sq_times(c, c, 10);
+    fe_mul(b, c, b); // z^(2^50 - 1)
+    fe_sq_times(c, b, 50);
+    fe_mul(c, c, b); // z^(2^100 - 1)
+    fe_sq_times(h, c, 100);
+    fe_mul(c, h, c); // z^(2^200 - 1)
+    fe_sq_times(c, c, 50);
+    fe_mul(c, c, b); // z^(2^250 - 1)
+    fe_sq_times(c, c, 5);
+    fe_mul(h, c, z11); // z^(2^255 - 21)
+}
+
+inline void fe_cswap(fe f, fe g, std::uint64_t swap) {
+    std::uint64_t mask = 0 - swap;
+    for (int i = 0; i < 5; ++i) {
+        std::uint64_t x = mask & (f[i] ^ g[i]);
+        f[i] ^= x;
+        g[i] ^= x;
+    }
+}
+} // namespace internal
+
+/**
+ * \brief X25519(scalar, u), RFC 7748 section 5
+ * \param [out] out oqs::x25519::key_length bytes result
+ * \param scalar oqs::x25519::key_length bytes scalar, clamped here
+ * \param u oqs::x25519::key_length bytes u-coordinate
+ * \note \a out may alias \a scalar or \a u
+ */
+inline void scalarmult(byte* out, const byte* scalar, const byte* u) {
+    using namespace internal;
+    byte k[key_length];
+    for (std::size_t i = 0; i < key_length; ++i)
+        k[i] = scalar[i];
+    k[0] &= 248;
+    k[31] &= 127;
+    k[31] |= 64;
+
+    fe x1, x2 = {1}, z2 = {0}, x3, z3 = {1};
+    fe a, aa, b, bb, e, c, d, da, cb;
+    const fe a24 = {121665};
+    fe_frombytes(x1, u);
+    for (int i = 0; i < 5; ++i)
+        x3[i] = x1[i];
+    std::uint64_t swap = 0;
+    for (int t = 254; t >= 0; --t) {
+        std::uint64_t bit = (k[t >> 3] >> (t & 7)) & 1;
+        swap ^= bit;
+        fe_cswap(x2, x3, swap);
+        fe_cswap(z2, z3, swap);
+        swap = bit;
+
+        fe_add(a, x2, z2);
+        fe_sq(aa, a);
+        fe_sub(b, x2, z2);
+        fe_sq(bb, b);
+        fe_sub(e, aa, bb);
+        fe_add(c, x3, z3);
+        fe_sub(d, x3, z3);
+        fe_mul(da, d, a);
+        fe_mul(cb, c, b);
+        fe_add(x3, da, cb);
+        fe_sq(x3, x3);
+        fe_sub(z3, da, cb);
+        fe_sq(z3, z3);
+        fe_mul(z3, z3, x1);
+        fe_mul(x2, aa, bb);
+        fe_mul(z2, a24, e);
+        fe_add(z2, z2, aa);
+        fe_mul(z2, z2, e);
+    }
+    fe_cswap(x2, x3, swap);
+    fe_cswap(z2, z3, swap);
+
+    fe_invert(z2, z2);
+    fe_mul(x2, x2, z2);
+    fe_tobytes(out, x2);
+    C::OQS_MEM_cleanse(k, sizeof(k));
+    C::OQS_MEM_cleanse(x2, sizeof(x2));
+    C::OQS_MEM_cleanse(z2, sizeof(z2));
+    C::OQS_MEM_cleanse(x3, sizeof(x3));
+    C::OQS_MEM_cleanse(z3, sizeof(z3));
+}
+
+/**
+ * \brief X25519(scalar, 9), the public key of \a scalar
+ * \param [out] out oqs::x25519::key_length bytes public key
+ * \param scalar oqs::x25519::key_length bytes secret key
+ */
+inline void scalarmult_base(byte* out, const byte* scalar) {
+    const byte base[key_length] = {9};
+    scalarmult(out, scalar, base);
+}
+
+/**
+ * \brief X25519(scalar, u)
+ * \param scalar Secret key
+ * \param u Peer's public key
+ * \return Shared secret
+ */
+inline bytes x25519(const bytes& scalar, const bytes& u) {
+    if (scalar.size() != key_length || u.size() != key_length)
+        throw std::runtime_error("Incorrect X25519 key length");
+    bytes result(key_length);
+    scalarmult(result.data(), scalar.data(), u.data());
+    return result;
+}
+
+/**
+ * \brief Public key of an X25519 secret key
+ * \param secret_key Secret key
+ * \return Public key
+ */
+inline bytes public_key(const bytes& secret_key) {
+    if (secret_key.size() != key_length)
+        throw std::runtime_error("Incorrect X25519 key length");
+    bytes result(key_length);
+    scalarmult_base(result.data(), secret_key.data());
+    return result;
+}
+} // namespace x25519
+} // namespace oqs
+
+#endif // X25519_X25519_HPP_
@@ -0,0 +1,172 @@
+// oqs-cryptod: local crypto daemon
+//
+// Holds the host's KEM and signature secret keys and serves sign, verify,
+// decap and public key requests from local processes over a Unix domain
+// socket, coalescing them into per-key batches processed by a thread pool.
+// Clients use oqs::cryptod::Client, see include/cryptod/cryptod.hpp.
+//
+// Keys are loaded from raw secret/public key files, or generated at startup
+// (ephemeral, for testing). SIGINT/SIGTERM stop the daemon, which then prints
+// its batching statistics.
+//
+// Usage: oqs-cryptod --socket PATH [--threads N] [--batch-max 64]
+//                    [--batch-delay-us 0]
+//                    [--sig-key ID:ALG:SECRET_FILE:PUBLIC_FILE]...
+//                    [--kem-key ID:ALG:SECRET_FILE:PUBLIC_FILE]...
+//                    [--generate-sig ID:ALG]... [--generate-kem ID:ALG]...
+
+#include <csignal>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// liboqs C++ wrapper
+#include "oqs_cpp.hpp"
+
+#include "cryptod/server.hpp"
+
+namespace {
+oqs::cryptod::Server* running = nullptr;
+
+extern "C" void on_signal(int) {
+    if (running)
+        running->stop();
+}
+
+void usage(std::ostream& os) {
+    os << "Usage: oqs-cryptod --socket PATH [--threads N] [--batch-max N] "
+          "[--batch-delay-us N]\n"
+          "                   [--sig-key ID:ALG:SECRET_FILE:PUBLIC_FILE]...\n"
+          "                   [--kem-key ID:ALG:SECRET_FILE:PUBLIC_FILE]...\n"
+          "                   [--generate-sig ID:ALG]... "
+          "[--generate-kem ID:ALG]...\n";
+}
+
+oqs::bytes read_file(const std::string& path) {
+    std::ifstream in{path, std::ios::binary};
+    if (!in)
+        throw std::runtime_error("Can not read " + path);
+    return oqs::bytes{std::istreambuf_iterator<char>{in},
+                      std::istreambuf_iterator<char>{}};
+}
+
+// Splits "a:b:c:d" into at most n parts, the last one keeps the remaining
+// colons
+std::vector<std::string> split(const std::string& s, std::size_t n) {
+    std::vector<std::string> parts;
+    std::size_t pos = 0;
+    while (parts.size() + 1 < n) {
+        std::size_t colon = s.find(':', pos);
+        if (colon == std::string::npos)
+            break;
+        parts.emplace_back(s.substr(pos, colon - pos));
+        pos = colon + 1;
+    }
+    parts.emplace_back(s.substr(pos));
+    return parts;
+}
+
+struct KeySpec {
+    bool kem;
+    std::vector<std::string> parts; // ID, ALG[, SECRET_FILE, PUBLIC_FILE]
+};
+} // namespace
+
+int main(int argc, char** argv) {
+    oqs::cryptod::ServerOptions options;
+    std::vector<KeySpec> keys;
+    try {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            if (arg == "-h" || arg == "--help") {
+                usage(std::cout);
+                return EXIT_SUCCESS;
+            }
+            if (i + 1 >= argc)
+                throw std::invalid_argument("Missing value for " + arg);
+            std::string value = argv[++i];
+            if (arg == "--socket") {
+                options.socket_path = value;
+            } else if (arg == "--threads") {
+                options.num_threads = std::stoul(value);
+            } else if (arg == "--batch-max") {
+                options.batch_max = std::stoul(value);
+            } else if (arg == "--batch-delay-us") {
+                options.batch_delay =
+                    std::chrono::microseconds(std::stol(value));
+            } else if (arg == "--sig-key" || arg == "--kem-key") {
+                keys.push_back({arg == "--kem-key", split(value, 4)});
+                if (keys.back().parts.size() != 4)
+                    throw std::invalid_argument("Invalid " + arg + " " + value);
+            } else if (arg == "--generate-sig" || arg == "--generate-kem") {
+                keys.push_back({arg == "--generate-kem", split(value, 2)});
+                if (keys.back().parts.size() != 2)
+                    throw std::invalid_argument("Invalid " + arg + " " + value);
+            } else {
+                throw std::invalid_argument("Unknown option " + arg);
+            }
+        }
+        if (options.socket_path.empty())
+            throw std::invalid_argument("--socket is required");
+        if (keys.empty())
+            throw std::invalid_argument("No key given");
+    } catch (const std::exception& e) {
+        std::cerr << "oqs-cryptod: " << e.what() << "\n\n";
+        usage(std::cerr);
+        return EXIT_FAILURE;
+    }
+
+    try {
+        oqs::cryptod::Server server{options};
+        for (auto&& key : keys) {
+            const std::string& id = key.parts[0];
+            const std::string& alg = key.parts[1];
+            oqs::bytes secret_key, public_key;
+            if (key.parts.size() == 4) {
+                secret_key = read_file(key.parts[2]);
+                public_key = read_file(key.parts[3]);
+            } else if (key.kem) {
+                oqs::KeyEncapsulation kem{alg};
+                public_key = kem.generate_keypair();
+                secret_key = kem.export_secret_key();
+            } else {
+                oqs::Signature sig{alg};
+                public_key = sig.generate_keypair();
+                secret_key = sig.export_secret_key();
+            }
+            if (key.kem)
+                server.add_kem_key(id, alg, secret_key, public_key);
+            else
+                server.add_sig_key(id, alg, secret_key, public_key);
+            oqs::mem_cleanse(secret_key);
+            std::cerr << "oqs-cryptod: " << (key.kem ? "KEM" : "signature")
+                      << " key " << id << " (" << alg << ")\n";
+        }
+
+        running = &server;
+        std::signal(SIGINT, on_signal);
+        std::signal(SIGTERM, on_signal);
+        std::signal(SIGPIPE, SIG_IGN);
+        std::cerr << "oqs-cryptod: listening on " << options.socket_path
+                  << std::endl;
+        server.run();
+        running = nullptr;
+
+        oqs::cryptod::ServerStats stats = server.stats();
+        std::cerr << "oqs-cryptod: " << stats.connections << " connection(s), "
+                  << stats.requests << " request(s) in " << stats.batches
+                  << " batch(es)";
+        if (stats.batches)
+            std::cerr << ", mean batch size "
+                      << static_cast<double>(stats.requests) /
+                             static_cast<double>(stats.batches);
+        std::cerr << '\n';
+    } catch (const std::exception& e) {
+        std::cerr << "oqs-cryptod: " << e.what() << '\n';
+        return EXIT_FAILURE;
+    }
+}
@@ -0,0 +1,235 @@
+// oqs-filesign: batch file signing and verification
+//
+// Signs whole file trees into a detached-signature manifest, and verifies
+// trees against one, with file reads (io_uring where available), SHAKE256
+// hashing and signing overlapped on a worker pool. See
+// include/filesign/filesign.hpp for the manifest format.
+//
+// Usage: oqs-filesign keygen --alg ALG --secret-key FILE --public-key FILE
+//        oqs-filesign sign --alg ALG --secret-key FILE --manifest FILE
+//                     [options] PATH...
+//        oqs-filesign verify --public-key FILE --manifest FILE [--root DIR]
+//                     [options]
+// Options: --threads N --depth 64 --chunk-kib 256 --backend auto|uring|threads
+
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// liboqs C++ wrapper
+#include "oqs_cpp.hpp"
+
+#include "filesign/filesign.hpp"
+
+namespace {
+void usage(std::ostream& os) {
+    os << "Usage: oqs-filesign keygen --alg ALG --secret-key FILE "
+          "--public-key FILE\n"
+          "       oqs-filesign sign --alg ALG --secret-key FILE --manifest "
+          "FILE [options] PATH...\n"
+          "       oqs-filesign verify --public-key FILE --manifest FILE "
+          "[--root DIR] [options]\n"
+          "Options: --threads N --depth 64 --chunk-kib 256 "
+          "--backend auto|uring|threads\n";
+}
+
+oqs::bytes read_file(const std::string& path) {
+    std::ifstream in{path, std::ios::binary};
+    if (!in)
+        throw std::runtime_error("Can not read " + path);
+    return oqs::bytes{std::istreambuf_iterator<char>{in},
+                      std::istreambuf_iterator<char>{}};
+}
+
+void write_file(const std::string& path, const oqs::bytes& data) {
+    std::ofstream out{path, std::ios::binary};
+    out.write(reinterpret_cast<const char*>(data.data()),
+              static_cast<std::streamsize>(data.size()));
+    if (!out)
+        throw std::runtime_error("Can not write " + path);
+}
+
+struct Args {
+    std::string command{};
+    std::string alg{};
+    std::string secret_key{};
+    std::string public_key{};
+    std::string manifest{};
+    std::string root{};
+    std::vector<std::string> paths{};
+    oqs::filesign::Options options{};
+};
+
+Args parse(int argc, char** argv) {
+    Args args;
+    if (argc < 2)
+        throw std::invalid_argument("Missing command");
+    args.command = argv[1];
+    for (int i = 2; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg.compare(0, 2, "--") != 0) {
+            args.paths.emplace_back(arg);
+            continue;
+        }
+        if (i + 1 >= argc)
+            throw std::invalid_argument("Missing value for " + arg);
+        std::string value = argv[++i];
+        if (arg == "--alg") {
+            args.alg = value;
+        } else if (arg == "--secret-key") {
+            args.secret_key = value;
+        } else if (arg == "--public-key") {
+            args.public_key = value;
+        } else if (arg == "--manifest") {
+            args.manifest = value;
+        } else if (arg == "--root") {
+            args.root = value;
+        } else if (arg == "--threads") {
+            args.options.num_threads = std::stoul(value);
+        } else if (arg == "--depth") {
+            args.options.queue_depth = std::stoul(value);
+        } else if (arg == "--chunk-kib") {
+            args.options.chunk_size = std::stoul(value) * 1024;
+        } else if (arg == "--backend") {
+            if (value == "auto")
+                args.options.backend = oqs::filesign::Backend::Auto;
+            else if (value == "uring")
+                args.options.backend = oqs::filesign::Backend::Uring;
+            else if (value == "threads")
+                args.options.backend = oqs::filesign::Backend::Threads;
+            else
+                throw std::invalid_argument("Unknown backend " + value);
+        } else {
+            throw std::invalid_argument("Unknown option " + arg);
+        }
+    }
+    auto require = [](const std::string& value, const char* name) {
+        if (value.empty())
+            throw std::invalid_argument(std::string{name} + " is required");
+    };
+    if (args.command == "keygen" || args.command == "sign") {
+        require(args.alg, "--alg");
+        require(args.secret_key, "--secret-key");
+    }
+    if (args.command == "keygen" || args.command == "verify")
+        require(args.public_key, "--public-key");
+    if (args.command == "sign" || args.command == "verify")
+        require(args.manifest, "--manifest");
+    if (args.command == "sign" && args.paths.empty())
+        throw std::invalid_argument("No path given");
+    if (args.command != "keygen" && args.command != "sign" &&
+        args.command != "verify")
+        throw std::invalid_argument("Unknown command " + args.command);
+    return args;
+}
+
+// Reader actually used for the given options
+const char* backend_name(const oqs::filesign::Options& options) {
+    bool uring = options.backend == oqs::filesign::Backend::Uring ||
+                 (options.backend == oqs::filesign::Backend::Auto &&
+                  oqs::filesign::uring_available());
+    return uring ? "io_uring" : "threads";
+}
+
+void report(const char* what, const std::vector<oqs::filesign::Entry>& entries,
+            const oqs::filesign::Options& options, double seconds) {
+    std::uint64_t total = 0;
+    for (auto&& entry : entries)
+        total += entry.size;
+    double mib = static_cast<double>(total) / (1 << 20);
+    std::cerr << "oqs-filesign: " << what << ' ' << entries.size()
+              << " file(s), " << mib << " MiB in " << seconds << " s ("
+              << static_cast<double>(entries.size()) / seconds
+              << " files/s, " << mib / seconds << " MiB/s, "
+              << backend_name(options) << ")\n";
+}
+
+// Number of failed entries, each reported on stderr
+std::size_t failures(const std::vector<oqs::filesign::Entry>& entries) {
+    std::size_t count = 0;
+    for (auto&& entry : entries)
+        if (!entry.error.empty()) {
+            std::cerr << "oqs-filesign: " << entry.path << ": " << entry.error
+                      << '\n';
+            ++count;
+        }
+    return count;
+}
+} // namespace
+
+int main(int argc, char** argv) {
+    Args args;
+    try {
+        if (argc >= 2 && (std::string{argv[1]} == "-h" ||
+                          std::string{argv[1]} == "--help")) {
+            usage(std::cout);
+            return EXIT_SUCCESS;
+        }
+        args = parse(argc, argv);
+    } catch (const std::exception& e) {
+        std::cerr << "oqs-filesign: " << e.what() << "\n\n";
+        usage(std::cerr);
+        return EXIT_FAILURE;
+    }
+
+    try {
+        if (args.command == "keygen") {
+            oqs::Signature signer{args.alg};
+            write_file(args.public_key, signer.generate_keypair());
+            oqs::bytes secret_key = signer.export_secret_key();
+            write_file(args.secret_key, secret_key);
+            oqs::mem_cleanse(secret_key);
+            return EXIT_SUCCESS;
+        }
+
+        oqs::Timer<> timer;
+        if (args.command == "sign") {
+            oqs::bytes secret_key = read_file(args.secret_key);
+            oqs::Signature signer{args.alg, secret_key};
+            oqs::mem_cleanse(secret_key);
+            std::vector<std::string> paths;
+            for (auto&& path : args.paths) {
+                std::vector<std::string> files =
+                    oqs::filesign::list_files(path);
+                paths.insert(paths.end(), files.begin(), files.end());
+            }
+            std::vector<oqs::filesign::Entry> entries =
+                oqs::filesign::sign_files(signer, paths, args.options);
+            timer.toc();
+            if (failures(entries) > 0)
+                return EXIT_FAILURE;
+            std::ofstream out{args.manifest};
+            oqs::filesign::write_manifest(out, args.alg, entries);
+            if (!out.flush())
+                throw std::runtime_error("Can not write " + args.manifest);
+            report("signed", entries, args.options, timer.tics());
+            return EXIT_SUCCESS;
+        }
+
+        std::ifstream in{args.manifest};
+        if (!in)
+            throw std::runtime_error("Can not read " + args.manifest);
+        std::string alg;
+        std::vector<oqs::filesign::Entry> manifest =
+            oqs::filesign::read_manifest(in, alg);
+        oqs::Signature verifier{alg};
+        std::vector<oqs::filesign::Entry> entries =
+            oqs::filesign::verify_files(verifier, read_file(args.public_key),
+                                        manifest, args.options, args.root);
+        timer.toc();
+        std::size_t failed = failures(entries);
+        report("verified", entries, args.options, timer.tics());
+        if (failed > 0) {
+            std::cerr << "oqs-filesign: " << failed << " file(s) FAILED\n";
+            return EXIT_FAILURE;
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "oqs-filesign: " << e.what() << '\n';
+        return EXIT_FAILURE;
+    }
+}
@@ -0,0 +1,592 @@
+// oqs-speed: liboqs throughput, similar to "openssl speed"
+//
+// Prints the number of keygen/encaps/decaps (KEMs) and keygen/sign/verify
+// (signatures) operations per second for every enabled algorithm whose name
+// contains one of the (optional) ALGORITHM filters. Each operation runs for
+// -seconds on -multi threads, each thread using its own wrapper objects, and
+// the per-thread rates are summed. Signatures are measured for each message
+// size in -bytes.
+//
+// With -cold, reports instead the per-call latency of every operation when
+// warm (called in a tight loop) and when cold, i.e., after the caches were
+// evicted by writing a thrash buffer of -thrash-mib MiB (by default twice the
+// largest per-core cache) and, with -flush-bp, after the branch predictor was
+// trained on unrelated random branches. Eviction is not timed. Since the
+// thrash buffer goes through the unified L2, the liboqs code is evicted from
+// it as well.
+//
+// Usage: oqs-speed [-seconds 3] [-multi 1] [-bytes 64,1024] [-json]
+//                  [-cold [-thrash-mib N] [-flush-bp]] [ALGORITHM...]
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstdint>
+#include <exception>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+// liboqs C++ wrapper
+#include "oqs_cpp.hpp"
+
+namespace {
+struct Options {
+    double seconds = 3;
+    std::size_t multi = 1;
+    std::vector<std::size_t> bytes{64};
+    bool json = false;
+    bool cold = false;
+    std::size_t thrash_bytes = 0; // 0 selects the default
+    bool flush_bp = false;
+    std::vector<std::string> filters{};
+};
+
+void usage(std::ostream& os) {
+    os << "Usage: oqs-speed [-seconds N] [-multi N] [-bytes N[,N...]] [-json] "
+          "[-cold [-thrash-mib N] [-flush-bp]] [ALGORITHM...]\n\n"
+          "  -seconds N   run each operation for N seconds (default 3)\n"
+          "  -multi N     run N threads in parallel (default 1)\n"
+          "  -bytes N,... signature message sizes (default 64)\n"
+          "  -json        print the results as JSON\n"
+          "  -cold        report warm vs cold (evicted caches) call latency\n"
+          "  -thrash-mib N  cache thrash buffer size for -cold (default twice\n"
+          "               the largest per-core cache)\n"
+          "  -flush-bp    also scramble the branch predictor for -cold\n"
+          "  ALGORITHM    only algorithms whose name contains ALGORITHM\n";
+}
+
+double to_number(const std::string& flag, const std::string& value) {
+    char* end = nullptr;
+    double result = std::strtod(value.c_str(), &end);
+    if (value.empty() || *end != '\0' || result < 0)
+        throw std::invalid_argument("Invalid value for " + flag + ": " +
+                                    value);
+    return result;
+}
+
+Options parse_options(int argc, char** argv) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto value = [&]() -> std::string {
+            if (i + 1 >= argc)
+                throw std::invalid_argument("Missing value for " + arg);
+            return argv[++i];
+        };
+        if (arg == "-seconds") {
+            options.seconds = to_number(arg, value());
+        } else if (arg == "-multi") {
+            options.multi = static_cast<std::size_t>(to_number(arg, value()));
+            if (options.multi == 0)
+                throw std::invalid_argument("-multi must be at least 1");
+        } else if (arg == "-bytes") {
+            options.bytes.clear();
+            std::stringstream ss{value()};
+            std::string item;
+            while (std::getline(ss, item, ','))
+                options.bytes.emplace_back(
+                    static_cast<std::size_t>(to_number(arg, item)));
+            if (options.bytes.empty())
+                throw std::invalid_argument("-bytes needs at least one size");
+        } else if (arg == "-json") {
+            options.json = true;
+        } else if (arg == "-cold") {
+            options.cold = true;
+        } else if (arg == "-thrash-mib") {
+            options.thrash_bytes =
+                static_cast<std::size_t>(to_number(arg, value()) * (1 << 20));
+        } else if (arg == "-flush-bp") {
+            options.flush_bp = true;
+        } else if (arg == "-h" || arg == "-help" || arg == "--help") {
+            usage(std::cout);
+            std::exit(EXIT_SUCCESS);
+        } else if (!arg.empty() && arg[0] == '-') {
+            throw std::invalid_argument("Unknown option " + arg);
+        } else {
+            options.filters.emplace_back(arg);
+        }
+    }
+    if (options.cold && options.multi != 1)
+        throw std::invalid_argument("-cold measures a single thread, "
+                                    "-multi is not supported");
+    return options;
+}
+
+bool matches(const std::string& name, const std::vector<std::string>& filters) {
+    if (filters.empty())
+        return true;
+    for (auto&& filter : filters)
+        if (name.find(filter) != std::string::npos)
+            return true;
+    return false;
+}
+
+// Creates the per-thread state of an operation and returns the operation
+using OpFactory = std::function<std::function<void()>()>;
+
+/**
+ * \brief Runs the operations made by \a factory on \a threads threads for
+ * \a seconds each, all threads starting together
+ * \return Total operations per second
+ */
+double ops_per_second(const OpFactory& factory, std::size_t threads,
+                      double seconds) {
+    std::vector<double> rates(threads, 0);
+    std::vector<std::exception_ptr> errors(threads);
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::size_t ready = 0;
+    bool go = false;
+
+    auto worker = [&](std::size_t t) {
+        try {
+            std::function<void()> op = factory();
+            {
+                std::unique_lock<std::mutex> lock{mutex};
+                ++ready;
+                cv.notify_all();
+                cv.wait(lock, [&] { return go; });
+            }
+            using clock = std::chrono::steady_clock;
+            auto start = clock::now();
+            auto deadline =
+                start + std::chrono::duration_cast<clock::duration>(
+                            std::chrono::duration<double>(seconds));
+            std::size_t count = 0;
+            clock::time_point now;
+            do {
+                op();
+                ++count;
+                now = clock::now();
+            } while (now < deadline);
+            rates[t] = static_cast<double>(count) /
+                       std::chrono::duration<double>(now - start).count();
+        } catch (...) {
+            errors[t] = std::current_exception();
+            std::lock_guard<std::mutex> lock{mutex};
+            ++ready;
+            cv.notify_all();
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for (std::size_t t = 0; t < threads; ++t)
+        pool.emplace_back(worker, t);
+    {
+        std::unique_lock<std::mutex> lock{mutex};
+        cv.wait(lock, [&] { return ready == threads; });
+        go = true;
+        cv.notify_all();
+    }
+    for (auto&& thread : pool)
+        thread.join();
+    double total = 0;
+    for (std::size_t t = 0; t < threads; ++t) {
+        if (errors[t])
+            std::rethrow_exception(errors[t]);
+        total += rates[t];
+    }
+    return total;
+}
+
+/**
+ * \brief Size of the largest level 1 or 2 cache of CPU 0 (Linux sysfs), 0 if
+ * unknown
+ */
+std::size_t per_core_cache_bytes() {
+    std::size_t largest = 0;
+    for (int index = 0;; ++index) {
+        std::string dir = "/sys/devices/system/cpu/cpu0/cache/index" +
+                          std::to_string(index) + "/";
+        std::ifstream level_file{dir + "level"}, size_file{dir + "size"};
+        int level = 0;
+        std::string size; // e.g. "2048K"
+        if (!(level_file >> level) || !(size_file >> size))
+            break;
+        std::size_t bytes = std::strtoul(size.c_str(), nullptr, 10);
+        if (size.back() == 'K')
+            bytes <<= 10;
+        else if (size.back() == 'M')
+            bytes <<= 20;
+        if (level <= 2 && bytes > largest)
+            largest = bytes;
+    }
+    return largest;
+}
+
+/**
+ * \brief Evicts the caches (and optionally the branch predictor state) of
+ * the calling thread
+ */
+class Evictor {
+    std::vector<std::uint64_t> buffer_;
+    bool flush_bp_;
+    std::uint64_t state_ = 0x9e3779b97f4a7c15; // xorshift state
+    volatile std::uint64_t sink_ = 0;
+
+  public:
+    Evictor(std::size_t bytes, bool flush_bp)
+        : buffer_(bytes / sizeof(std::uint64_t) + 1, 0), flush_bp_{flush_bp} {}
+
+    void operator()() {
+        // One write per cache line makes every line dirty and resident
+        constexpr std::size_t stride = 64 / sizeof(std::uint64_t);
+        for (std::size_t i = 0; i < buffer_.size(); i += stride)
+            buffer_[i] += i;
+        if (!flush_bp_)
+            return;
+        // Random outcomes of many conditional and indirect branches
+        std::uint64_t acc = 0;
+        for (int i = 0; i < (1 << 16); ++i) {
+            state_ ^= state_ << 13;
+            state_ ^= state_ >> 7;
+            state_ ^= state_ << 17;
+            if (state_ & 1)
+                acc += state_;
+            switch ((state_ >> 1) & 15) {
+                case 0:
+                    acc ^= 1;
+                    break;
+                case 1:
+                    acc += 3;
+                    break;
+                case 2:
+                    acc *= 5;
+                    break;
+                case 3:
+                    acc -= 7;
+                    break;
+                case 4:
+                    acc ^= acc >> 3;
+                    break;
+                case 5:
+                    acc += acc << 1;
+                    break;
+                case 6:
+                    acc ^= 11;
+                    break;
+                case 7:
+                    acc += 13;
+                    break;
+                default:
+                    acc ^= state_ >> 5;
+                    break;
+            }
+        }
+        sink_ = acc;
+    }
+};
+
+/**
+ * \brief Per-call latency in nanoseconds, warm (back-to-back calls) and cold
+ * (calls after \a evict), each for about \a seconds and at least 10 calls
+ */
+std::pair<oqs::Histogram, oqs::Histogram>
+warm_cold_latency(const OpFactory& factory, double seconds, Evictor& evict) {
+    using clock = std::chrono::steady_clock;
+    std::function<void()> op = factory();
+    auto sample = [&](oqs::Histogram& histogram, bool cold) {
+        auto deadline =
+            clock::now() + std::chrono::duration_cast<clock::duration>(
+                               std::chrono::duration<double>(seconds));
+        op(); // warm-up, not recorded
+        do {
+            if (cold)
+                evict();
+            auto start = clock::now();
+            op();
+            histogram.record(
+                std::chrono::duration<double, std::nano>(clock::now() - start)
+                    .count());
+        } while (histogram.count() < 10 || clock::now() < deadline);
+    };
+    std::pair<oqs::Histogram, oqs::Histogram> result;
+    sample(result.first, false);
+    sample(result.second, true);
+    return result;
+}
+
+struct KemState {
+    oqs::KeyEncapsulation kem;
+    oqs::bytes public_key, ciphertext{}, shared_secret{};
+    explicit KemState(const std::string& name)
+        : kem{name}, public_key{kem.generate_keypair()} {
+        kem.encap_secret(public_key, ciphertext, shared_secret);
+    }
+};
+
+struct SigState {
+    oqs::Signature sig;
+    oqs::bytes public_key, message, signature{};
+    SigState(const std::string& name, std::size_t msg_bytes)
+        : sig{name}, public_key{sig.generate_keypair()},
+          message(msg_bytes, 0x5a) {
+        sig.sign(message, signature);
+    }
+};
+
+struct KemResult {
+    std::string alg;
+    double keygen, encaps, decaps;
+};
+
+struct SigResult {
+    std::string alg;
+    std::size_t bytes;
+    double keygen, sign, verify;
+};
+
+struct LatencyResult {
+    std::string alg;
+    std::string op;
+    std::string bytes; // empty when not applicable
+    oqs::Histogram warm, cold;
+};
+
+class Speed {
+    const Options& options_;
+    std::size_t thrash_bytes_;
+    Evictor evict_;
+    std::vector<LatencyResult> latencies_{};
+
+    // Operations per second, or 0 with -cold, which records the latencies
+    double run(const std::string& alg, const std::string& op,
+               const OpFactory& factory, const std::string& bytes = "") {
+        std::string label =
+            alg + (bytes.empty() ? "" : " (" + bytes + " bytes)");
+        if (options_.cold) {
+            std::cerr << "Doing " << label << " " << op << " warm and cold for "
+                      << options_.seconds << "s each" << std::endl;
+            LatencyResult result{alg, op, bytes, {}, {}};
+            std::tie(result.warm, result.cold) =
+                warm_cold_latency(factory, options_.seconds, evict_);
+            latencies_.emplace_back(result);
+            return 0;
+        }
+        std::cerr << "Doing " << label << " " << op << " for "
+                  << options_.seconds << "s on " << options_.multi
+                  << " thread(s)" << std::endl;
+        return ops_per_second(factory, options_.multi, options_.seconds);
+    }
+
+  public:
+    explicit Speed(const Options& options)
+        : options_{options}, thrash_bytes_{options.thrash_bytes},
+          evict_{0, options.flush_bp} {
+        if (options_.cold && thrash_bytes_ == 0) {
+            std::size_t cache = per_core_cache_bytes();
+            thrash_bytes_ = cache ? 2 * cache : std::size_t{8} << 20;
+        }
+        if (options_.cold)
+            evict_ = Evictor{thrash_bytes_, options_.flush_bp};
+    }
+
+    std::size_t thrash_bytes() const { return thrash_bytes_; }
+
+    const std::vector<LatencyResult>& latencies() const { return latencies_; }
+
+    KemResult kem(const std::string& name) {
+        KemResult result{name, 0, 0, 0};
+        result.keygen = run(name, "keygen", [&name] {
+            auto s = std::make_shared<KemState>(name);
+            return std::function<void()>{
+                [s] { s->kem.generate_keypair(s->public_key); }};
+        });
+        result.encaps = run(name, "encaps", [&name] {
+            auto s = std::make_shared<KemState>(name);
+            return std::function<void()>{[s] {
+                s->kem.encap_secret(s->public_key, s->ciphertext,
+                                    s->shared_secret);
+            }};
+        });
+        result.decaps = run(name, "decaps", [&name] {
+            auto s = std::make_shared<KemState>(name);
+            return std::function<void()>{
+                [s] { s->kem.decap_secret(s->ciphertext, s->shared_secret); }};
+        });
+        return result;
+    }
+
+    std::vector<SigResult> sig(const std::string& name) {
+        double keygen = run(name, "keygen", [&name] {
+            auto s = std::make_shared<SigState>(name, 0);
+            return std::function<void()>{
+                [s] { s->sig.generate_keypair(s->public_key); }};
+        });
+        std::vector<SigResult> results;
+        for (std::size_t bytes : options_.bytes) {
+            std::string label = std::to_string(bytes);
+            SigResult result{name, bytes, keygen, 0, 0};
+            result.sign = run(
+                name, "sign",
+                [&name, bytes] {
+                    auto s = std::make_shared<SigState>(name, bytes);
+                    return std::function<void()>{
+                        [s] { s->sig.sign(s->message, s->signature); }};
+                },
+                label);
+            result.verify = run(
+                name, "verify",
+                [&name, bytes] {
+                    auto s = std::make_shared<SigState>(name, bytes);
+                    return std::function<void()>{[s] {
+                        if (!s->sig.verify(s->message, s->signature,
+                                           s->public_key))
+                            throw std::runtime_error("Verification failed");
+                    }};
+                },
+                label);
+            results.emplace_back(result);
+        }
+        return results;
+    }
+};
+
+void print_table(const std::vector<KemResult>& kems,
+                 const std::vector<SigResult>& sigs) {
+    std::cout << std::fixed << std::setprecision(1);
+    if (!kems.empty()) {
+        std::cout << std::left << std::setw(40) << "KEM" << std::right
+                  << std::setw(13) << "keygen/s" << std::setw(13) << "encaps/s"
+                  << std::setw(13) << "decaps/s" << '\n';
+        for (auto&& r : kems)
+            std::cout << std::left << std::setw(40) << r.alg << std::right
+                      << std::setw(13) << r.keygen << std::setw(13) << r.encaps
+                      << std::setw(13) << r.decaps << '\n';
+    }
+    if (!sigs.empty()) {
+        if (!kems.empty())
+            std::cout << '\n';
+        std::cout << std::left << std::setw(32) << "SIG" << std::right
+                  << std::setw(8) << "bytes" << std::setw(13) << "keygen/s"
+                  << std::setw(13) << "sign/s" << std::setw(13) << "verify/s"
+                  << '\n';
+        for (auto&& r : sigs)
+            std::cout << std::left << std::setw(32) << r.alg << std::right
+                      << std::setw(8) << r.bytes << std::setw(13) << r.keygen
+                      << std::setw(13) << r.sign << std::setw(13) << r.verify
+                      << '\n';
+    }
+}
+
+void print_latency_table(const Options& options, std::size_t thrash_bytes,
+                         const std::vector<LatencyResult>& latencies) {
+    std::cout << "Latency in microseconds, cold after writing "
+              << (thrash_bytes >> 10) << " KiB"
+              << (options.flush_bp ? " and scrambling the branch predictor"
+                                   : "")
+              << "\n\n";
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << std::left << std::setw(32) << "ALG" << std::setw(8) << "OP"
+              << std::right << std::setw(8) << "bytes" << std::setw(11)
+              << "warm p50" << std::setw(11) << "warm p99" << std::setw(11)
+              << "cold p50" << std::setw(11) << "cold p99" << std::setw(11)
+              << "cold/warm" << '\n';
+    for (auto&& r : latencies)
+        std::cout << std::left << std::setw(32) << r.alg << std::setw(8)
+                  << r.op << std::right << std::setw(8)
+                  << (r.bytes.empty() ? "-" : r.bytes) << std::setw(11)
+                  << r.warm.percentile(50) / 1e3 << std::setw(11)
+                  << r.warm.percentile(99) / 1e3 << std::setw(11)
+                  << r.cold.percentile(50) / 1e3 << std::setw(11)
+                  << r.cold.percentile(99) / 1e3 << std::setprecision(2)
+                  << std::setw(10)
+                  << r.cold.percentile(50) / r.warm.percentile(50) << "x"
+                  << std::setprecision(1) << '\n';
+}
+
+void print_latency_json(const Options& options, std::size_t thrash_bytes,
+                        const std::vector<LatencyResult>& latencies) {
+    std::cout << std::fixed << std::setprecision(3);
+    std::cout << "{\n  \"liboqs\": \"" << oqs::oqs_version()
+              << "\",\n  \"liboqs-cpp\": \"" << oqs::oqs_cpp_version()
+              << "\",\n  \"seconds\": " << options.seconds
+              << ",\n  \"thrash_bytes\": " << thrash_bytes
+              << ",\n  \"flush_bp\": " << (options.flush_bp ? "true" : "false")
+              << ",\n  \"latency_us\": [";
+    for (std::size_t i = 0; i < latencies.size(); ++i) {
+        const LatencyResult& r = latencies[i];
+        std::cout << (i ? ",\n" : "\n") << "    {\"alg\": \"" << r.alg
+                  << "\", \"op\": \"" << r.op << "\", \"bytes\": "
+                  << (r.bytes.empty() ? "null" : r.bytes)
+                  << ", \"warm_p50\": " << r.warm.percentile(50) / 1e3
+                  << ", \"warm_p99\": " << r.warm.percentile(99) / 1e3
+                  << ", \"cold_p50\": " << r.cold.percentile(50) / 1e3
+                  << ", \"cold_p99\": " << r.cold.percentile(99) / 1e3 << "}";
+    }
+    std::cout << (latencies.empty() ? "" : "\n  ") << "]\n}\n";
+}
+
+void print_json(const Options& options, const std::vector<KemResult>& kems,
+                const std::vector<SigResult>& sigs) {
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << "{\n  \"liboqs\": \"" << oqs::oqs_version()
+              << "\",\n  \"liboqs-cpp\": \"" << oqs::oqs_cpp_version()
+              << "\",\n  \"seconds\": " << options.seconds
+              << ",\n  \"multi\": " << options.multi << ",\n  \"kems\": [";
+    for (std::size_t i = 0; i < kems.size(); ++i)
+        std::cout << (i ? ",\n" : "\n") << "    {\"alg\": \"" << kems[i].alg
+                  << "\", \"keygen\": " << kems[i].keygen
+                  << ", \"encaps\": " << kems[i].encaps
+                  << ", \"decaps\": " << kems[i].decaps << "}";
+    std::cout << (kems.empty() ? "" : "\n  ") << "],\n  \"sigs\": [";
+    for (std::size_t i = 0; i < sigs.size(); ++i)
+        std::cout << (i ? ",\n" : "\n") << "    {\"alg\": \"" << sigs[i].alg
+                  << "\", \"bytes\": " << sigs[i].bytes
+                  << ", \"keygen\": " << sigs[i].keygen
+                  << ", \"sign\": " << sigs[i].sign
+                  << ", \"verify\": " << sigs[i].verify << "}";
+    std::cout << (sigs.empty() ? "" : "\n  ") << "]\n}\n";
+}
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    try {
+        options = parse_options(argc, argv);
+    } catch (const std::exception& e) {
+        std::cerr << "oqs-speed: " << e.what() << "\n\n";
+        usage(std::cerr);
+        return EXIT_FAILURE;
+    }
+
+    try {
+        Speed speed{options};
+        std::vector<KemResult> kems;
+        std::vector<SigResult> sigs;
+        for (auto&& name : oqs::KEMs::get_enabled_KEMs())
+            if (matches(name, options.filters))
+                kems.emplace_back(speed.kem(name));
+        for (auto&& name : oqs::Sigs::get_enabled_sigs())
+            if (matches(name, options.filters))
+                for (auto&& r : speed.sig(name))
+                    sigs.emplace_back(r);
+        if (kems.empty() && sigs.empty())
+            throw std::runtime_error("No enabled algorithm matches");
+
+        if (options.cold && options.json)
+            print_latency_json(options, speed.thrash_bytes(),
+                               speed.latencies());
+        else if (options.cold)
+            print_latency_table(options, speed.thrash_bytes(),
+                                speed.latencies());
+        else if (options.json)
+            print_json(options, kems, sigs);
+        else
+            print_table(kems, sigs);
+    } catch (const std::exception& e) {
+        std::cerr << "oqs-speed: " << e.what() << '\n';
+        return EXIT_FAILURE;
+    }
+}
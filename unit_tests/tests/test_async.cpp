@@ -0,0 +1,162 @@
+// Unit testing oqs::async
+
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+#include "async/async.hpp"
+#include "numa/numa.hpp"
+
+TEST(oqs_async, WorkerPool) {
+    std::atomic<int> sum{0};
+    {
+        oqs::async::WorkerPool pool{3};
+        EXPECT_EQ(pool.size(), 3u);
+        for (int i = 1; i <= 100; ++i)
+            pool.post([&sum, i] { sum += i; });
+    } // drains the queue
+    EXPECT_EQ(sum, 5050);
+}
+
+TEST(oqs_async, QueueExecutor) {
+    std::atomic<int> notified{0};
+    oqs::async::QueueExecutor loop{[&notified] { ++notified; }};
+    int runs = 0;
+    loop.post([&] {
+        ++runs;
+        loop.post([&] { ++runs; });
+    });
+    EXPECT_EQ(notified, 1);
+    EXPECT_EQ(loop.run_pending(), 2u);
+    EXPECT_EQ(runs, 2);
+    EXPECT_EQ(notified, 2);
+    EXPECT_EQ(loop.run_pending(), 0u);
+}
+
+TEST(oqs_async, Cancellation) {
+    oqs::async::CancellationToken never;
+    EXPECT_FALSE(never.cancelled());
+    oqs::async::CancellationSource source;
+    oqs::async::CancellationToken token = source.token();
+    EXPECT_FALSE(token.cancelled());
+    source.cancel();
+    EXPECT_TRUE(token.cancelled());
+}
+
+#ifdef LIBOQS_CPP_HAS_COROUTINES
+// Runs the executor's jobs on the calling thread until done, 10 s at most
+static void run_until(oqs::async::QueueExecutor& loop,
+                      const std::atomic<bool>& done) {
+    auto deadline =
+        std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (!done && std::chrono::steady_clock::now() < deadline) {
+        if (loop.run_pending() == 0)
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+namespace {
+// Fire-and-forget coroutine
+struct Detached {
+    struct promise_type {
+        Detached get_return_object() noexcept { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() noexcept {}
+        void unhandled_exception() noexcept { std::terminate(); }
+    };
+};
+
+Detached kem_round_trip(oqs::async::WorkerPool& pool,
+                        oqs::async::QueueExecutor& loop,
+                        std::thread::id loop_thread, std::atomic<bool>& done) {
+    oqs::KeyEncapsulation client{"ML-KEM-768"}, server{"ML-KEM-768"};
+    oqs::bytes public_key =
+        co_await oqs::async::generate_keypair(server, pool, loop);
+    EXPECT_EQ(std::this_thread::get_id(), loop_thread);
+    auto [ciphertext, shared_secret_client] =
+        co_await oqs::async::encap_secret(client, public_key, pool, loop);
+    oqs::bytes shared_secret_server =
+        co_await oqs::async::decap_secret(server, ciphertext, pool, loop);
+    EXPECT_EQ(shared_secret_client, shared_secret_server);
+    EXPECT_EQ(std::this_thread::get_id(), loop_thread);
+    done = true;
+}
+
+template <typename Pool>
+Detached sig_round_trip(Pool& pool, oqs::async::QueueExecutor& loop,
+                        std::atomic<bool>& done) {
+    oqs::Signature signer{"ML-DSA-44"};
+    oqs::bytes message{'a', 'b', 'c'};
+    oqs::bytes public_key =
+        co_await oqs::async::generate_keypair(signer, pool, loop);
+    oqs::bytes signature =
+        co_await oqs::async::sign(signer, message, pool, loop);
+    EXPECT_TRUE(co_await oqs::async::verify(signer, message, signature,
+                                            public_key, pool, loop));
+    message[0] ^= 1;
+    EXPECT_FALSE(co_await oqs::async::verify(signer, message, signature,
+                                             public_key, pool, loop));
+    done = true;
+}
+
+Detached cancelled(oqs::async::WorkerPool& pool,
+                   oqs::async::QueueExecutor& loop,
+                   oqs::async::CancellationToken token,
+                   std::atomic<bool>& done) {
+    oqs::KeyEncapsulation kem{"ML-KEM-768"};
+    EXPECT_THROW(
+        co_await oqs::async::generate_keypair(kem, pool, loop, token),
+        oqs::async::OperationCancelled);
+    done = true;
+}
+
+Detached failing(oqs::async::WorkerPool& pool, oqs::async::QueueExecutor& loop,
+                 std::atomic<bool>& done) {
+    oqs::KeyEncapsulation kem{"ML-KEM-768"};
+    // Wrong public key length, the exception is rethrown on resumption
+    EXPECT_THROW(co_await oqs::async::encap_secret(kem, oqs::bytes(3), pool,
+                                                   loop),
+                 std::runtime_error);
+    done = true;
+}
+} // namespace
+
+TEST(oqs_async, Coroutines) {
+    oqs::async::WorkerPool pool{2};
+    oqs::async::QueueExecutor loop;
+    std::atomic<bool> kem_done{false}, sig_done{false};
+    kem_round_trip(pool, loop, std::this_thread::get_id(), kem_done);
+    sig_round_trip(pool, loop, sig_done);
+    run_until(loop, kem_done);
+    run_until(loop, sig_done);
+    EXPECT_TRUE(kem_done);
+    EXPECT_TRUE(sig_done);
+}
+
+TEST(oqs_async, CoroutinesOnShardedPool) {
+    oqs::numa::ShardedPool pool{oqs::numa::Topology::single_node(2)};
+    oqs::async::QueueExecutor loop;
+    std::atomic<bool> done{false};
+    sig_round_trip(pool, loop, done);
+    run_until(loop, done);
+    EXPECT_TRUE(done);
+}
+
+TEST(oqs_async, CoroutineCancellationAndErrors) {
+    oqs::async::WorkerPool pool{1};
+    oqs::async::QueueExecutor loop;
+    oqs::async::CancellationSource source;
+    source.cancel();
+    std::atomic<bool> cancelled_done{false}, failing_done{false};
+    cancelled(pool, loop, source.token(), cancelled_done);
+    failing(pool, loop, failing_done);
+    run_until(loop, cancelled_done);
+    run_until(loop, failing_done);
+    EXPECT_TRUE(cancelled_done);
+    EXPECT_TRUE(failing_done);
+}
+#endif // LIBOQS_CPP_HAS_COROUTINES
@@ -0,0 +1,120 @@
+// Unit testing oqs::batch
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "batch/batch.hpp"
+#include "oqs_cpp.hpp"
+
+namespace {
+// Signer of one algorithm and key
+struct Key {
+    std::string alg_name;
+    oqs::Signature signer;
+    oqs::bytes public_key;
+
+    explicit Key(const std::string& name)
+        : alg_name{name}, signer{name}, public_key{signer.generate_keypair()} {}
+
+    oqs::batch::Item item(const oqs::bytes& message) {
+        return oqs::batch::Item{alg_name, public_key, message,
+                                signer.sign(message), {}};
+    }
+};
+
+oqs::batch::Item plain(const std::string& alg_name, oqs::bytes public_key) {
+    return oqs::batch::Item{alg_name, public_key, {}, {}, {}};
+}
+} // namespace
+
+TEST(oqs_batch, Grouping) {
+    std::vector<oqs::batch::Item> items{
+        plain("B", {1}), plain("A", {2}), plain("B", {1}), plain("A", {1}),
+        plain("A", {2}), plain("A", {2}), plain("B", {1})};
+    std::vector<std::size_t> order = oqs::batch::internal::order(items);
+    EXPECT_EQ(order, (std::vector<std::size_t>{3, 1, 4, 5, 0, 2, 6}));
+
+    std::vector<oqs::batch::Group> groups =
+        oqs::batch::internal::groups(items, order, 2);
+    ASSERT_EQ(groups.size(), 5u);
+    std::vector<std::size_t> sizes;
+    for (auto&& group : groups)
+        sizes.emplace_back(group.end - group.begin);
+    EXPECT_EQ(sizes, (std::vector<std::size_t>{1, 2, 1, 2, 1}));
+    EXPECT_EQ(groups.back().end, items.size());
+
+    EXPECT_EQ(oqs::batch::internal::groups(items, order, 64).size(), 3u);
+    EXPECT_TRUE(oqs::batch::internal::groups({}, {}, 64).empty());
+}
+
+TEST(oqs_batch, MixedBatch) {
+    std::vector<std::string> sigs = oqs::Sigs::get_enabled_sigs();
+    std::vector<std::string> names;
+    for (auto&& name : {"ML-DSA-44", "ML-DSA-65", "Falcon-512"})
+        if (std::find(sigs.begin(), sigs.end(), name) != sigs.end())
+            names.emplace_back(name);
+    if (names.empty())
+        GTEST_SKIP() << "No tested signature algorithm enabled";
+
+    std::vector<Key*> keys;
+    std::vector<std::unique_ptr<Key>> storage;
+    for (auto&& name : names)
+        for (int i = 0; i < 2; ++i) {
+            storage.emplace_back(new Key{name});
+            keys.emplace_back(storage.back().get());
+        }
+
+    std::vector<oqs::batch::Item> items;
+    std::vector<oqs::batch::Status> expected;
+    for (std::size_t i = 0; i < 60; ++i) {
+        oqs::bytes message(i + 1, static_cast<oqs::byte>(i));
+        items.emplace_back(keys[(i * 7) % keys.size()]->item(message));
+        expected.emplace_back(oqs::batch::Status::Valid);
+        if (i % 5 == 1) {
+            items.back().message[0] ^= 1;
+            expected.back() = oqs::batch::Status::Invalid;
+        } else if (i % 11 == 3) {
+            items.back().public_key.pop_back();
+            expected.back() = oqs::batch::Status::Malformed;
+        }
+    }
+    items.emplace_back(plain("No-Such-Signature", {1, 2, 3}));
+    expected.emplace_back(oqs::batch::Status::Unsupported);
+
+    oqs::batch::Verifier verifier{3, 4};
+    EXPECT_EQ(verifier.verify(items), expected);
+    EXPECT_EQ(verifier.handles().size(), names.size() + 1);
+    // Handles are reused by later batches
+    EXPECT_EQ(verifier.verify(items), expected);
+    EXPECT_EQ(verifier.handles().size(), names.size() + 1);
+
+    oqs::batch::Verifier single{1};
+    EXPECT_EQ(single.verify(items), expected);
+    EXPECT_TRUE(single.verify({}).empty());
+    EXPECT_THROW(oqs::batch::Verifier(1, 0), std::invalid_argument);
+}
+
+TEST(oqs_batch, ContextString) {
+    Key key{"ML-DSA-44"};
+    if (!key.signer.get_details().sig_with_ctx_support)
+        GTEST_SKIP() << "Context strings not supported";
+    oqs::bytes message{1, 2, 3};
+    oqs::bytes context{4, 5};
+    oqs::batch::Item item{key.alg_name, key.public_key, message,
+                          key.signer.sign_with_ctx_str(message, context),
+                          context};
+    oqs::batch::Item wrong = item;
+    wrong.context = {4, 6};
+
+    oqs::batch::Verifier verifier{2};
+    EXPECT_EQ(verifier.verify({item, wrong}),
+              (std::vector<oqs::batch::Status>{oqs::batch::Status::Valid,
+                                               oqs::batch::Status::Invalid}));
+    EXPECT_STREQ(oqs::batch::status_name(oqs::batch::Status::Malformed),
+                 "malformed");
+}
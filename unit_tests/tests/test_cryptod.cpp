@@ -0,0 +1,125 @@
+// Unit testing oqs::cryptod
+
+#ifndef _WIN32
+
+#include <chrono>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <unistd.h>
+
+#include "cryptod/cryptod.hpp"
+#include "cryptod/server.hpp"
+#include "oqs_cpp.hpp"
+
+TEST(oqs_cryptod, Protocol) {
+    oqs::cryptod::Request request{oqs::cryptod::Op::Verify, 42, "signer",
+                                  {{1, 2, 3}, {}, {4}}};
+    oqs::bytes frame = oqs::cryptod::encode(request);
+
+    oqs::cryptod::Request decoded{};
+    EXPECT_EQ(oqs::cryptod::decode(frame.data(), frame.size() - 1, decoded),
+              0u);
+    EXPECT_EQ(oqs::cryptod::decode(frame.data(), frame.size(), decoded),
+              frame.size());
+    EXPECT_EQ(decoded.op, oqs::cryptod::Op::Verify);
+    EXPECT_EQ(decoded.id, 42u);
+    EXPECT_EQ(decoded.key, "signer");
+    EXPECT_EQ(decoded.fields, request.fields);
+
+    oqs::cryptod::Response response{7, oqs::cryptod::Status::Ok, {{9, 9}}};
+    frame = oqs::cryptod::encode(response);
+    oqs::cryptod::Response decoded_response{};
+    EXPECT_EQ(
+        oqs::cryptod::decode(frame.data(), frame.size(), decoded_response),
+        frame.size());
+    EXPECT_EQ(decoded_response.id, 7u);
+    EXPECT_EQ(decoded_response.fields, response.fields);
+
+    // Field length past the end of the frame
+    frame[frame.size() - 3] = 0xFF;
+    EXPECT_THROW(
+        oqs::cryptod::decode(frame.data(), frame.size(), decoded_response),
+        std::runtime_error);
+}
+
+TEST(oqs_cryptod, ServerAndClient) {
+    std::string socket_path =
+        "/tmp/oqs-cryptod-test-" + std::to_string(::getpid()) + ".sock";
+    oqs::cryptod::ServerOptions options;
+    options.socket_path = socket_path;
+    options.num_threads = 2;
+    options.batch_max = 8;
+    options.batch_delay = std::chrono::microseconds(200);
+    oqs::cryptod::Server server{options};
+
+    oqs::Signature signer{"ML-DSA-44"};
+    oqs::bytes sig_public_key = signer.generate_keypair();
+    server.add_sig_key("signer", "ML-DSA-44", signer.export_secret_key(),
+                       sig_public_key);
+    oqs::KeyEncapsulation kem{"ML-KEM-768"};
+    oqs::bytes kem_public_key = kem.generate_keypair();
+    server.add_kem_key("kem", "ML-KEM-768", kem.export_secret_key(),
+                       kem_public_key);
+    EXPECT_THROW(server.add_kem_key("kem", "ML-KEM-768",
+                                    kem.export_secret_key(), kem_public_key),
+                 std::runtime_error);
+
+    std::thread daemon{[&server] { server.run(); }};
+    {
+        oqs::cryptod::Client client{socket_path};
+        EXPECT_EQ(client.public_key("signer"), sig_public_key);
+        EXPECT_EQ(client.public_key("kem"), kem_public_key);
+
+        // Signatures made by the daemon verify locally, and vice versa
+        oqs::bytes message{'a', 'b', 'c'};
+        oqs::bytes signature = client.sign("signer", message);
+        EXPECT_TRUE(signer.verify(message, signature, sig_public_key));
+        EXPECT_TRUE(client.verify("signer", message, signer.sign(message)));
+        message[0] ^= 1;
+        EXPECT_FALSE(client.verify("signer", message, signature));
+        EXPECT_FALSE(
+            client.verify("signer", message, signature, sig_public_key));
+
+        // Pipelined requests, batched by the daemon
+        std::vector<oqs::bytes> messages, ciphertexts, shared_secrets;
+        for (int i = 0; i < 20; ++i) {
+            messages.push_back(oqs::bytes(static_cast<std::size_t>(i), 0x5a));
+            oqs::bytes ciphertext, shared_secret;
+            std::tie(ciphertext, shared_secret) =
+                oqs::KeyEncapsulation{"ML-KEM-768"}.encap_secret(
+                    kem_public_key);
+            ciphertexts.push_back(ciphertext);
+            shared_secrets.push_back(shared_secret);
+        }
+        std::vector<oqs::bytes> signatures = client.sign("signer", messages);
+        ASSERT_EQ(signatures.size(), messages.size());
+        for (std::size_t i = 0; i < messages.size(); ++i)
+            EXPECT_TRUE(
+                signer.verify(messages[i], signatures[i], sig_public_key));
+        EXPECT_EQ(client.decap_secret("kem", ciphertexts), shared_secrets);
+        EXPECT_EQ(client.decap_secret("kem", ciphertexts[0]),
+                  shared_secrets[0]);
+
+        // Errors are reported, the connection stays usable
+        EXPECT_THROW(client.sign("nobody", message), std::runtime_error);
+        EXPECT_THROW(client.sign("kem", message), std::runtime_error);
+        EXPECT_THROW(client.decap_secret("kem", oqs::bytes(3)),
+                     std::runtime_error);
+        EXPECT_EQ(client.public_key("kem"), kem_public_key);
+    }
+    server.stop();
+    daemon.join();
+
+    oqs::cryptod::ServerStats stats = server.stats();
+    EXPECT_EQ(stats.connections, 1u);
+    EXPECT_EQ(stats.requests, 51u);
+    EXPECT_LT(stats.batches, stats.requests);
+}
+
+#endif // _WIN32
@@ -0,0 +1,75 @@
+// Unit testing oqs::envelope
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "envelope/envelope.hpp"
+#include "oqs_cpp.hpp"
+
+// no_thread_KEM_patterns lists KEM patterns that have issues running in a
+// separate thread
+static std::vector<std::string> no_thread_KEM_patterns{"Classic-McEliece",
+                                                       "HQC-256"};
+
+static std::size_t num_threads_for(const std::string& kem_name) {
+    for (auto&& no_thread_kem : no_thread_KEM_patterns)
+        if (kem_name.find(no_thread_kem) != std::string::npos)
+            return 1;
+    return 0;
+}
+
+TEST(oqs_envelope, Correctness) {
+    for (auto&& kem_name : oqs::KEMs::get_enabled_KEMs()) {
+        std::cout << "Correctness - " << kem_name << std::endl;
+        std::vector<oqs::KeyEncapsulation> recipients;
+        std::vector<oqs::bytes> public_keys;
+        for (std::size_t i = 0; i < 5; ++i) {
+            recipients.emplace_back(kem_name);
+            public_keys.emplace_back(recipients.back().generate_keypair());
+        }
+        oqs::envelope::SealedEnvelope sealed = oqs::envelope::seal(
+            kem_name, public_keys, num_threads_for(kem_name));
+        EXPECT_EQ(sealed.content_key.size(),
+                  oqs::envelope::content_key_length);
+        for (std::size_t i = 0; i < recipients.size(); ++i)
+            EXPECT_EQ(oqs::envelope::open(sealed.header, recipients[i],
+                                          public_keys[i]),
+                      sealed.content_key);
+    }
+}
+
+TEST(oqs_envelope, NotARecipient) {
+    std::string kem_name = oqs::KEMs::get_enabled_KEMs().front();
+    oqs::KeyEncapsulation recipient{kem_name};
+    oqs::bytes public_key = recipient.generate_keypair();
+    oqs::KeyEncapsulation outsider{kem_name};
+    oqs::bytes outsider_public_key = outsider.generate_keypair();
+    oqs::envelope::SealedEnvelope sealed =
+        oqs::envelope::seal(kem_name, {public_key});
+    EXPECT_THROW(
+        oqs::envelope::open(sealed.header, outsider, outsider_public_key),
+        std::runtime_error);
+}
+
+TEST(oqs_envelope, TamperedEntry) {
+    std::string kem_name = oqs::KEMs::get_enabled_KEMs().front();
+    oqs::KeyEncapsulation recipient{kem_name};
+    oqs::bytes public_key = recipient.generate_keypair();
+    oqs::envelope::SealedEnvelope sealed =
+        oqs::envelope::seal(kem_name, {public_key});
+    // flip one bit of the wrapped content key
+    sealed.header[sealed.header.size() - oqs::envelope::tag_length - 1] ^= 1;
+    EXPECT_THROW(oqs::envelope::open(sealed.header, recipient, public_key),
+                 std::runtime_error);
+}
+
+TEST(oqs_envelope, DuplicateRecipient) {
+    std::string kem_name = oqs::KEMs::get_enabled_KEMs().front();
+    oqs::KeyEncapsulation recipient{kem_name};
+    oqs::bytes public_key = recipient.generate_keypair();
+    EXPECT_THROW(oqs::envelope::seal(kem_name, {public_key, public_key}),
+                 std::runtime_error);
+}
@@ -0,0 +1,237 @@
+// Unit testing oqs::filesign
+
+#ifndef _WIN32
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "filesign/filesign.hpp"
+#include "oqs_cpp.hpp"
+#include "sha3/sha3.hpp"
+
+namespace {
+const std::string sig_name = "ML-DSA-44";
+
+// Temporary directory tree, removed on destruction
+class TempTree {
+    std::string root_{};
+
+  public:
+    TempTree() {
+        std::string pattern = "/tmp/oqs-filesign-test-XXXXXX";
+        if (::mkdtemp(&pattern[0]) == nullptr)
+            throw std::runtime_error("mkdtemp failed");
+        root_ = pattern;
+    }
+    TempTree(const TempTree&) = delete;
+    TempTree& operator=(const TempTree&) = delete;
+    ~TempTree() {
+        std::string command = "rm -rf '" + root_ + "'";
+        if (std::system(command.c_str()) != 0)
+            std::cerr << "Can not remove " << root_ << '\n';
+    }
+
+    const std::string& root() const { return root_; }
+
+    std::string write(const std::string& name, const oqs::bytes& contents) {
+        std::string path = root_ + "/" + name;
+        std::ofstream out{path, std::ios::binary};
+        out.write(reinterpret_cast<const char*>(contents.data()),
+                  static_cast<std::streamsize>(contents.size()));
+        return path;
+    }
+};
+
+oqs::bytes pattern(std::size_t len) {
+    oqs::bytes result(len);
+    for (std::size_t i = 0; i < len; ++i)
+        result[i] = static_cast<oqs::byte>(i * 7 + i / 251);
+    return result;
+}
+
+oqs::bytes shake256(const oqs::bytes& data) {
+    oqs::sha3::SHAKE256 xof;
+    return xof.absorb(data).finalize().squeeze(oqs::filesign::digest_length);
+}
+
+std::vector<oqs::filesign::Backend> backends() {
+    std::vector<oqs::filesign::Backend> result{
+        oqs::filesign::Backend::Threads};
+    if (oqs::filesign::uring_available())
+        result.emplace_back(oqs::filesign::Backend::Uring);
+    return result;
+}
+
+oqs::filesign::Options options(oqs::filesign::Backend backend) {
+    oqs::filesign::Options result;
+    result.backend = backend;
+    result.chunk_size = 4096; // several chunks per file
+    result.queue_depth = 4;
+    result.num_threads = 3;
+    return result;
+}
+} // namespace
+
+TEST(oqs_filesign, SignedMessage) {
+    oqs::bytes digest(oqs::filesign::digest_length, 0xab);
+    oqs::bytes message = oqs::filesign::signed_message("a/b", 258, digest);
+    std::string tag = "oqs-filesign 1";
+    ASSERT_EQ(message.size(), tag.size() + 1 + 3 + 1 + 8 + digest.size());
+    EXPECT_EQ(std::string(message.begin(), message.begin() + 14), tag);
+    EXPECT_EQ(message[tag.size() + 5 + 6], 0x01);
+    EXPECT_EQ(message[tag.size() + 5 + 7], 0x02);
+    EXPECT_NE(message, oqs::filesign::signed_message("a/c", 258, digest));
+}
+
+TEST(oqs_filesign, HashFiles) {
+    TempTree tree;
+    std::vector<oqs::bytes> contents{pattern(0), pattern(1), pattern(4096),
+                                     pattern(100000)};
+    std::vector<std::string> paths;
+    for (std::size_t i = 0; i < contents.size(); ++i)
+        paths.emplace_back(tree.write(std::to_string(i), contents[i]));
+    paths.emplace_back(tree.root() + "/missing");
+
+    for (auto backend : backends()) {
+        std::vector<oqs::bytes> digests(paths.size());
+        std::vector<std::string> errors(paths.size());
+        oqs::filesign::hash_files(
+            paths, options(backend),
+            [&](std::size_t index, std::uint64_t size,
+                const oqs::bytes& digest, const std::string& error) {
+                if (index < contents.size())
+                    EXPECT_EQ(size, contents[index].size());
+                digests[index] = digest;
+                errors[index] = error;
+            });
+        for (std::size_t i = 0; i < contents.size(); ++i) {
+            EXPECT_TRUE(errors[i].empty()) << errors[i];
+            EXPECT_EQ(digests[i], shake256(contents[i]));
+        }
+        EXPECT_FALSE(errors.back().empty());
+        EXPECT_TRUE(digests.back().empty());
+    }
+
+    oqs::filesign::Options invalid;
+    invalid.chunk_size = 0;
+    EXPECT_THROW(oqs::filesign::hash_files(paths, invalid, {}),
+                 std::invalid_argument);
+}
+
+TEST(oqs_filesign, SignAndVerify) {
+    TempTree tree;
+    tree.write("big", pattern(50000));
+    tree.write("empty", {});
+    ::mkdir((tree.root() + "/sub").c_str(), 0700);
+    tree.write("sub/small", pattern(10));
+    std::vector<std::string> paths = oqs::filesign::list_files(tree.root());
+    ASSERT_EQ(paths.size(), 3u);
+    EXPECT_EQ(paths[0], tree.root() + "/big");
+    EXPECT_EQ(paths[2], tree.root() + "/sub/small");
+
+    oqs::Signature signer{sig_name};
+    oqs::bytes public_key = signer.generate_keypair();
+    oqs::Signature verifier{sig_name};
+
+    for (auto backend : backends()) {
+        std::vector<oqs::filesign::Entry> signed_entries =
+            oqs::filesign::sign_files(signer, paths, options(backend));
+        ASSERT_EQ(signed_entries.size(), paths.size());
+        for (auto&& entry : signed_entries)
+            EXPECT_TRUE(entry.error.empty()) << entry.error;
+        EXPECT_EQ(signed_entries[1].size, 0u);
+
+        std::stringstream manifest;
+        oqs::filesign::write_manifest(manifest, sig_name, signed_entries);
+        std::string alg_name;
+        std::vector<oqs::filesign::Entry> read =
+            oqs::filesign::read_manifest(manifest, alg_name);
+        EXPECT_EQ(alg_name, sig_name);
+        ASSERT_EQ(read.size(), signed_entries.size());
+        for (std::size_t i = 0; i < read.size(); ++i) {
+            EXPECT_EQ(read[i].path, signed_entries[i].path);
+            EXPECT_EQ(read[i].size, signed_entries[i].size);
+            EXPECT_EQ(read[i].digest, signed_entries[i].digest);
+            EXPECT_EQ(read[i].signature, signed_entries[i].signature);
+        }
+
+        for (auto&& entry : oqs::filesign::verify_files(
+                 verifier, public_key, read, options(backend)))
+            EXPECT_TRUE(entry.error.empty()) << entry.error;
+
+        // Tampered signature
+        read[0].signature[0] ^= 1;
+        // Entry claimed for a different path
+        read[2].path = read[1].path;
+        std::vector<oqs::filesign::Entry> checked =
+            oqs::filesign::verify_files(verifier, public_key, read,
+                                        options(backend));
+        EXPECT_EQ(checked[0].error, "invalid signature");
+        EXPECT_TRUE(checked[1].error.empty());
+        EXPECT_EQ(checked[2].error, "contents differ from the manifest");
+    }
+
+    // Modified contents
+    std::vector<oqs::filesign::Entry> entries =
+        oqs::filesign::sign_files(signer, paths);
+    tree.write("sub/small", pattern(11));
+    std::vector<oqs::filesign::Entry> checked =
+        oqs::filesign::verify_files(verifier, public_key, entries);
+    EXPECT_TRUE(checked[0].error.empty());
+    EXPECT_EQ(checked[2].error, "contents differ from the manifest");
+}
+
+TEST(oqs_filesign, VerifyRelativeToRoot) {
+    TempTree tree;
+    tree.write("file", pattern(300));
+    oqs::Signature signer{sig_name};
+    oqs::bytes public_key = signer.generate_keypair();
+
+    oqs::filesign::Entry entry{"file", 0, {}, {}, {}};
+    oqs::filesign::hash_files(
+        {tree.root() + "/file"}, {},
+        [&](std::size_t, std::uint64_t size, const oqs::bytes& digest,
+            const std::string&) {
+            entry.size = size;
+            entry.digest = digest;
+        });
+    entry.signature = signer.sign(
+        oqs::filesign::signed_message(entry.path, entry.size, entry.digest));
+
+    oqs::Signature verifier{sig_name};
+    std::vector<oqs::filesign::Entry> checked = oqs::filesign::verify_files(
+        verifier, public_key, {entry}, {}, tree.root());
+    EXPECT_TRUE(checked[0].error.empty()) << checked[0].error;
+    checked = oqs::filesign::verify_files(verifier, public_key, {entry});
+    EXPECT_FALSE(checked[0].error.empty());
+}
+
+TEST(oqs_filesign, MalformedManifest) {
+    std::string alg_name;
+    std::istringstream not_manifest{"hello\n"};
+    EXPECT_THROW(oqs::filesign::read_manifest(not_manifest, alg_name),
+                 std::runtime_error);
+    std::istringstream bad_hex{"oqs-filesign 1 ML-DSA-44\n1 zz 00 a\n"};
+    EXPECT_THROW(oqs::filesign::read_manifest(bad_hex, alg_name),
+                 std::runtime_error);
+    std::istringstream no_path{"oqs-filesign 1 ML-DSA-44\n1 00 00\n"};
+    EXPECT_THROW(oqs::filesign::read_manifest(no_path, alg_name),
+                 std::runtime_error);
+
+    oqs::Signature signer{sig_name};
+    signer.generate_keypair();
+    EXPECT_THROW(oqs::filesign::sign_files(signer, {"a\nb"}),
+                 std::invalid_argument);
+}
+
+#endif // _WIN32
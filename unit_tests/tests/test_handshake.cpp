@@ -0,0 +1,141 @@
+// Unit testing oqs::handshake
+
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "handshake/handshake.hpp"
+#include "oqs_cpp.hpp"
+
+// counts the C++ heap allocations of the whole test binary
+static std::atomic<std::size_t> num_allocations{0};
+
+void* operator new(std::size_t size) {
+    ++num_allocations;
+    if (void* p = std::malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc{};
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+// slow_patterns lists KEM/sig patterns skipped when testing every KEM/sig
+// combination, for speed only
+static std::vector<std::string> slow_patterns{"Classic-McEliece", "SPHINCS+",
+                                              "cross-rsdp"};
+
+static bool is_slow(const std::string& alg_name) {
+    for (auto&& pattern : slow_patterns)
+        if (alg_name.find(pattern) != std::string::npos)
+            return true;
+    return false;
+}
+
+static void run_handshake(oqs::handshake::Client& client,
+                          oqs::handshake::Server& server) {
+    const oqs::bytes& client_hello = client.client_hello();
+    const oqs::bytes& server_hello = server.process_client_hello(client_hello);
+    const oqs::bytes& client_finished =
+        client.process_server_hello(server_hello);
+    server.process_client_finished(client_finished);
+}
+
+TEST(oqs_handshake, Correctness) {
+    for (auto&& kem_name : oqs::KEMs::get_enabled_KEMs()) {
+        for (auto&& sig_name : oqs::Sigs::get_enabled_sigs()) {
+            if (is_slow(kem_name) || is_slow(sig_name))
+                continue;
+            std::cout << "Correctness - " << kem_name << " + " << sig_name
+                      << std::endl;
+            oqs::Signature signer{sig_name};
+            oqs::bytes server_public_key = signer.generate_keypair();
+            oqs::handshake::Server server{kem_name, std::move(signer)};
+            oqs::handshake::Client client{kem_name, sig_name,
+                                          server_public_key};
+            run_handshake(client, server);
+            EXPECT_EQ(client.get_state(),
+                      oqs::handshake::State::Established);
+            EXPECT_EQ(server.get_state(),
+                      oqs::handshake::State::Established);
+            EXPECT_EQ(client.session_keys().client_write,
+                      server.session_keys().client_write);
+            EXPECT_EQ(client.session_keys().server_write,
+                      server.session_keys().server_write);
+            EXPECT_NE(client.session_keys().client_write,
+                      client.session_keys().server_write);
+        }
+    }
+}
+
+TEST(oqs_handshake, SteadyStateDoesNotAllocate) {
+    std::string kem_name = oqs::KEMs::get_enabled_KEMs().front();
+    std::string sig_name = oqs::Sigs::get_enabled_sigs().front();
+    oqs::Signature signer{sig_name};
+    oqs::bytes server_public_key = signer.generate_keypair();
+    oqs::handshake::Server server{kem_name, std::move(signer)};
+    oqs::handshake::Client client{kem_name, sig_name, server_public_key};
+    run_handshake(client, server); // warm-up
+    oqs::bytes previous_key = client.session_keys().client_write;
+
+    std::size_t before = num_allocations;
+    for (std::size_t i = 0; i < 10; ++i)
+        run_handshake(client, server);
+    std::size_t after = num_allocations;
+
+    EXPECT_EQ(after, before);
+    EXPECT_EQ(client.session_keys().client_write,
+              server.session_keys().client_write);
+    EXPECT_NE(client.session_keys().client_write, previous_key);
+}
+
+TEST(oqs_handshake, WrongServerKey) {
+    std::string kem_name = oqs::KEMs::get_enabled_KEMs().front();
+    std::string sig_name = oqs::Sigs::get_enabled_sigs().front();
+    oqs::Signature signer{sig_name};
+    signer.generate_keypair();
+    oqs::Signature impostor{sig_name};
+    oqs::bytes impostor_public_key = impostor.generate_keypair();
+    oqs::handshake::Server server{kem_name, std::move(signer)};
+    oqs::handshake::Client client{kem_name, sig_name, impostor_public_key};
+    const oqs::bytes& server_hello =
+        server.process_client_hello(client.client_hello());
+    EXPECT_THROW(client.process_server_hello(server_hello),
+                 std::runtime_error);
+    EXPECT_EQ(client.get_state(), oqs::handshake::State::Failed);
+    EXPECT_THROW(client.session_keys(), std::runtime_error);
+}
+
+TEST(oqs_handshake, Tampering) {
+    std::string kem_name = oqs::KEMs::get_enabled_KEMs().front();
+    std::string sig_name = oqs::Sigs::get_enabled_sigs().front();
+    oqs::Signature signer{sig_name};
+    oqs::bytes server_public_key = signer.generate_keypair();
+    oqs::handshake::Server server{kem_name, std::move(signer)};
+    oqs::handshake::Client client{kem_name, sig_name, server_public_key};
+
+    // tampered server finished
+    oqs::bytes server_hello =
+        server.process_client_hello(client.client_hello());
+    server_hello.back() ^= 1;
+    EXPECT_THROW(client.process_server_hello(server_hello),
+                 std::runtime_error);
+
+    // tampered client finished
+    server_hello = server.process_client_hello(client.client_hello());
+    oqs::bytes client_finished = client.process_server_hello(server_hello);
+    client_finished.front() ^= 1;
+    EXPECT_THROW(server.process_client_finished(client_finished),
+                 std::runtime_error);
+    EXPECT_EQ(server.get_state(), oqs::handshake::State::Failed);
+
+    // out of order
+    EXPECT_THROW(server.process_client_finished(client_finished),
+                 std::runtime_error);
+}
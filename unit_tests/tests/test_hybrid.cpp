@@ -0,0 +1,127 @@
+// Unit testing oqs::hybrid
+
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "async/async.hpp"
+#include "hybrid/hybrid.hpp"
+#include "oqs_cpp.hpp"
+#include "sha3/sha3.hpp"
+#include "x25519/x25519.hpp"
+
+namespace {
+oqs::bytes slice(const oqs::bytes& v, std::size_t begin, std::size_t end) {
+    return oqs::bytes(v.begin() + static_cast<std::ptrdiff_t>(begin),
+                      v.begin() + static_cast<std::ptrdiff_t>(end));
+}
+} // namespace
+
+TEST(oqs_hybrid, XWingRoundTrip) {
+    oqs::hybrid::XWing server;
+    const auto& details = server.get_details();
+    oqs::KeyEncapsulation mlkem{"ML-KEM-768"};
+    const auto& mlkem_details = mlkem.get_details();
+    EXPECT_EQ(details.name, "X-Wing");
+    EXPECT_EQ(details.length_public_key, mlkem_details.length_public_key + 32);
+    EXPECT_EQ(details.length_ciphertext, mlkem_details.length_ciphertext + 32);
+    EXPECT_EQ(details.length_secret_key, mlkem_details.length_secret_key + 64);
+    EXPECT_EQ(details.length_shared_secret, 32u);
+
+    oqs::bytes public_key = server.generate_keypair();
+    ASSERT_EQ(public_key.size(), details.length_public_key);
+    oqs::hybrid::XWing client;
+    auto encaps = client.encap_secret(public_key);
+    EXPECT_EQ(encaps.first.size(), details.length_ciphertext);
+    EXPECT_EQ(server.decap_secret(encaps.first), encaps.second);
+    EXPECT_NE(client.encap_secret(public_key).second, encaps.second);
+
+    // From the exported secret key
+    oqs::hybrid::XWing restored{server.export_secret_key()};
+    EXPECT_EQ(restored.decap_secret(encaps.first), encaps.second);
+
+    // Either half of the ciphertext changes the shared secret
+    oqs::bytes ciphertext = encaps.first;
+    ciphertext.back() ^= 1;
+    EXPECT_NE(server.decap_secret(ciphertext), encaps.second);
+    ciphertext = encaps.first;
+    ciphertext.front() ^= 1;
+    EXPECT_NE(server.decap_secret(ciphertext), encaps.second);
+
+    EXPECT_THROW(client.encap_secret(oqs::bytes(10)), std::runtime_error);
+    EXPECT_THROW(server.decap_secret(oqs::bytes(10)), std::runtime_error);
+    EXPECT_THROW(client.decap_secret(encaps.first), std::runtime_error);
+}
+
+TEST(oqs_hybrid, XWingCombiner) {
+    oqs::hybrid::XWing server;
+    oqs::bytes public_key = server.generate_keypair();
+    oqs::bytes secret_key = server.export_secret_key();
+    std::size_t pk_m = public_key.size() - 32;
+    std::size_t sk_m = secret_key.size() - 64;
+
+    // pk_M | pk_X and sk_M | sk_X | pk_X
+    oqs::bytes pk_x = slice(public_key, pk_m, public_key.size());
+    oqs::bytes sk_x = slice(secret_key, sk_m, sk_m + 32);
+    EXPECT_EQ(oqs::x25519::public_key(sk_x), pk_x);
+    EXPECT_EQ(slice(secret_key, sk_m + 32, secret_key.size()), pk_x);
+
+    // The shared secret, recomputed from the two halves
+    auto encaps = oqs::hybrid::XWing{}.encap_secret(public_key);
+    std::size_t ct_m = encaps.first.size() - 32;
+    oqs::bytes ct_x = slice(encaps.first, ct_m, encaps.first.size());
+    oqs::KeyEncapsulation mlkem{"ML-KEM-768", slice(secret_key, 0, sk_m)};
+    oqs::bytes input = mlkem.decap_secret(slice(encaps.first, 0, ct_m));
+    oqs::bytes ss_x = oqs::x25519::x25519(sk_x, ct_x);
+    input.insert(input.end(), ss_x.begin(), ss_x.end());
+    input.insert(input.end(), ct_x.begin(), ct_x.end());
+    input.insert(input.end(), pk_x.begin(), pk_x.end());
+    input.insert(input.end(), {0x5c, 0x2e, 0x2f, 0x2f, 0x5e, 0x5c});
+    EXPECT_EQ(oqs::sha3::sha3_256(input), encaps.second);
+
+    // The ML-KEM half is a plain ML-KEM-768 key pair
+    auto mlkem_encaps = mlkem.encap_secret(slice(public_key, 0, pk_m));
+    EXPECT_EQ(mlkem.decap_secret(mlkem_encaps.first), mlkem_encaps.second);
+}
+
+TEST(oqs_hybrid, XWingSingleBufferAndPool) {
+    oqs::async::WorkerPool pool{2};
+    oqs::hybrid::XWing server{oqs::bytes{}, &pool};
+    oqs::bytes public_key;
+    server.generate_keypair(public_key);
+    oqs::hybrid::XWing sequential{server.share_secret_key()};
+    EXPECT_EQ(sequential.share_secret_key().data(),
+              server.share_secret_key().data());
+
+    // Ciphertext and shared secret in one buffer
+    const auto& details = server.get_details();
+    oqs::bytes message(details.length_ciphertext +
+                       details.length_shared_secret);
+    oqs::byte* shared_secret = message.data() + details.length_ciphertext;
+    oqs::hybrid::XWing client{oqs::bytes{}, &pool};
+    client.encap_secret(public_key.data(), message.data(), shared_secret);
+    oqs::bytes expected(shared_secret, message.data() + message.size());
+    oqs::bytes decapsulated(details.length_shared_secret);
+    sequential.decap_secret(message.data(), decapsulated.data());
+    EXPECT_EQ(decapsulated, expected);
+
+    // Concurrent callers, each running its X25519 half on the pool
+    std::atomic<std::size_t> failures{0};
+    std::vector<std::thread> threads;
+    for (std::size_t t = 0; t < 4; ++t)
+        threads.emplace_back([&] {
+            oqs::bytes ciphertext, ss, ss_server;
+            for (int i = 0; i < 8; ++i) {
+                client.encap_secret(public_key, ciphertext, ss);
+                server.decap_secret(ciphertext, ss_server);
+                failures += ss != ss_server;
+                failures += sequential.decap_secret(ciphertext) != ss;
+            }
+        });
+    for (auto&& thread : threads)
+        thread.join();
+    EXPECT_EQ(failures, 0u);
+}
@@ -128,6 +128,19 @@ TEST(oqs_KeyEncapsulation, WrongCiphertext) {
         elem.join();
 }
 
+TEST(oqs_KeyEncapsulation, InPlace) {
+    std::string kem_name = oqs::KEMs::get_enabled_KEMs().front();
+    oqs::KeyEncapsulation client{kem_name};
+    oqs::bytes client_public_key;
+    client.generate_keypair(client_public_key);
+    oqs::KeyEncapsulation server{kem_name};
+    oqs::bytes ciphertext, shared_secret_server, shared_secret_client;
+    server.encap_secret(client_public_key, ciphertext, shared_secret_server);
+    client.decap_secret(ciphertext, shared_secret_client);
+    EXPECT_EQ(shared_secret_client, shared_secret_server);
+    EXPECT_EQ(client.decap_secret(ciphertext), shared_secret_server);
+}
+
 TEST(oqs_KeyEncapsulation, NotSupported) {
     EXPECT_THROW(oqs::KeyEncapsulation{"unsupported_kem"},
                  oqs::MechanismNotSupportedError);
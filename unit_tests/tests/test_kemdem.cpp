@@ -0,0 +1,101 @@
+// Unit testing oqs::kemdem
+
+#include <cstdio>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "kemdem/kemdem.hpp"
+#include "oqs_cpp.hpp"
+#include "rand/rand.hpp"
+
+static const std::string kem_name = oqs::KEMs::get_enabled_KEMs().front();
+
+TEST(oqs_kemdem, Correctness) {
+    oqs::KeyEncapsulation recipient{kem_name};
+    oqs::bytes public_key = recipient.generate_keypair();
+    const std::size_t chunk_size = 64;
+    for (std::size_t len : {std::size_t{0}, std::size_t{1}, chunk_size - 1,
+                            chunk_size, chunk_size + 1, 50 * chunk_size}) {
+        oqs::bytes plaintext = oqs::rand::randombytes(len);
+        oqs::bytes sealed =
+            oqs::kemdem::seal(kem_name, public_key, plaintext, chunk_size, 3);
+        EXPECT_EQ(oqs::kemdem::open(recipient, sealed, 3), plaintext);
+        EXPECT_EQ(oqs::kemdem::open(recipient, sealed, 1), plaintext);
+    }
+}
+
+TEST(oqs_kemdem, IOStream) {
+    oqs::KeyEncapsulation recipient{kem_name};
+    oqs::bytes public_key = recipient.generate_keypair();
+    std::string plaintext(100000, 'x');
+    std::istringstream is{plaintext};
+    std::stringstream sealed;
+    oqs::kemdem::seal_iostream(kem_name, public_key, is, sealed, 4096);
+    std::ostringstream os;
+    oqs::kemdem::open_iostream(recipient, sealed, os);
+    EXPECT_EQ(os.str(), plaintext);
+}
+
+#if !defined(_WIN32)
+TEST(oqs_kemdem, FileDescriptor) {
+    oqs::KeyEncapsulation recipient{kem_name};
+    oqs::bytes public_key = recipient.generate_keypair();
+    oqs::bytes plaintext = oqs::rand::randombytes(123457);
+    std::FILE* in = std::tmpfile();
+    std::FILE* sealed = std::tmpfile();
+    std::FILE* out = std::tmpfile();
+    ASSERT_TRUE(in && sealed && out);
+    ASSERT_EQ(std::fwrite(plaintext.data(), 1, plaintext.size(), in),
+              plaintext.size());
+    std::fflush(in);
+    std::rewind(in);
+    oqs::kemdem::seal_fd(kem_name, public_key, fileno(in), fileno(sealed),
+                         1000);
+    ::lseek(fileno(sealed), 0, SEEK_SET);
+    oqs::kemdem::open_fd(recipient, fileno(sealed), fileno(out));
+    ::lseek(fileno(out), 0, SEEK_SET);
+    oqs::bytes result(plaintext.size() + 1);
+    EXPECT_EQ(::read(fileno(out), result.data(), result.size()),
+              static_cast<ssize_t>(plaintext.size()));
+    result.resize(plaintext.size());
+    EXPECT_EQ(result, plaintext);
+    std::fclose(in);
+    std::fclose(sealed);
+    std::fclose(out);
+}
+#endif
+
+TEST(oqs_kemdem, Tampering) {
+    oqs::KeyEncapsulation recipient{kem_name};
+    oqs::bytes public_key = recipient.generate_keypair();
+    const std::size_t chunk_size = 64;
+    const std::size_t record_size = 4 + chunk_size + oqs::kemdem::tag_length;
+    oqs::bytes plaintext = oqs::rand::randombytes(3 * chunk_size + 10);
+    oqs::bytes sealed =
+        oqs::kemdem::seal(kem_name, public_key, plaintext, chunk_size);
+    std::size_t last_record = sealed.size() - (4 + 10 + 32);
+
+    // flipped ciphertext bit
+    oqs::bytes flipped = sealed;
+    flipped[last_record - record_size + 10] ^= 1;
+    EXPECT_THROW(oqs::kemdem::open(recipient, flipped), std::runtime_error);
+
+    // dropped final record
+    oqs::bytes truncated(sealed.begin(), sealed.begin() + last_record);
+    EXPECT_THROW(oqs::kemdem::open(recipient, truncated), std::runtime_error);
+
+    // swapped records
+    oqs::bytes swapped = sealed;
+    std::swap_ranges(swapped.begin() + last_record - 2 * record_size,
+                     swapped.begin() + last_record - record_size,
+                     swapped.begin() + last_record - record_size);
+    EXPECT_THROW(oqs::kemdem::open(recipient, swapped), std::runtime_error);
+
+    // trailing garbage
+    oqs::bytes extended = sealed;
+    extended.push_back(0);
+    EXPECT_THROW(oqs::kemdem::open(recipient, extended), std::runtime_error);
+}
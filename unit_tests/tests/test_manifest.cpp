@@ -0,0 +1,171 @@
+// Unit testing oqs::manifest
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+#include "manifest/manifest.hpp"
+#include "oqs_cpp.hpp"
+
+namespace {
+const std::string sig_name = "ML-DSA-44";
+
+// Object contents and ids of a small corpus
+struct Corpus {
+    std::vector<std::string> ids{};
+    std::vector<oqs::bytes> contents{};
+
+    explicit Corpus(std::size_t n) {
+        for (std::size_t i = 0; i < n; ++i) {
+            // Inserted out of order, with ids of different lengths
+            ids.emplace_back("object/" + std::to_string((i * 37) % n));
+            contents.emplace_back(i + 1, static_cast<oqs::byte>(i));
+        }
+    }
+
+    oqs::manifest::Builder builder() const {
+        oqs::manifest::Builder result;
+        for (std::size_t i = 0; i < ids.size(); ++i)
+            result.add(ids[i], oqs::manifest::digest(contents[i]));
+        return result;
+    }
+};
+} // namespace
+
+TEST(oqs_manifest, BuildAndLookup) {
+    Corpus corpus{101};
+    oqs::Signature signer{sig_name};
+    oqs::bytes public_key = signer.generate_keypair();
+    oqs::bytes file = corpus.builder().build(signer, public_key, true, 3);
+
+    oqs::manifest::Manifest manifest{file};
+    EXPECT_EQ(manifest.size(), corpus.ids.size());
+    EXPECT_EQ(manifest.alg_name(), sig_name);
+    EXPECT_EQ(manifest.key_id(), oqs::manifest::key_id(public_key));
+    EXPECT_TRUE(manifest.has_merkle_root());
+    for (std::size_t i = 1; i < manifest.size(); ++i)
+        EXPECT_LT(manifest.id(i - 1), manifest.id(i));
+
+    oqs::Signature verifier{sig_name};
+    for (std::size_t i = 0; i < corpus.ids.size(); ++i) {
+        std::size_t index = manifest.find(corpus.ids[i]);
+        ASSERT_LT(index, manifest.size());
+        oqs::manifest::Entry entry = manifest.entry(index);
+        EXPECT_EQ(entry.id, corpus.ids[i]);
+        EXPECT_EQ(entry.digest, oqs::manifest::digest(corpus.contents[i]));
+        EXPECT_TRUE(manifest.verify(verifier, public_key, corpus.ids[i],
+                                    entry.digest));
+    }
+    EXPECT_EQ(manifest.find("object/"), manifest.size());
+    EXPECT_EQ(manifest.find("object/999"), manifest.size());
+    EXPECT_FALSE(manifest.verify(verifier, public_key, "missing",
+                                 oqs::manifest::digest({})));
+    // Modified object
+    EXPECT_FALSE(manifest.verify(verifier, public_key, corpus.ids[0],
+                                 oqs::manifest::digest({1})));
+
+    EXPECT_TRUE(manifest.verify_all(verifier, public_key, 3, 8).empty());
+    EXPECT_TRUE(manifest.verify_merkle_root(verifier, public_key, 2));
+
+    oqs::Signature other{sig_name};
+    EXPECT_THROW(manifest.verify_all(verifier, other.generate_keypair()),
+                 std::runtime_error);
+}
+
+TEST(oqs_manifest, Tampering) {
+    Corpus corpus{20};
+    oqs::Signature signer{sig_name};
+    oqs::bytes public_key = signer.generate_keypair();
+    oqs::bytes file = corpus.builder().build(signer, public_key);
+    oqs::Signature verifier{sig_name};
+
+    // The last entry's signature ends the file
+    oqs::manifest::Manifest good{file};
+    std::size_t last_length = good.entry(good.size() - 1).signature.size();
+    oqs::bytes bad_signature = file;
+    bad_signature[file.size() - last_length] ^= 1;
+    oqs::manifest::Manifest manifest{bad_signature};
+    EXPECT_EQ(manifest.verify_all(verifier, public_key, 2, 3),
+              std::vector<std::size_t>{manifest.size() - 1});
+    EXPECT_TRUE(manifest.verify_merkle_root(verifier, public_key));
+
+    // Changing a digest breaks the entry signature and the Merkle root
+    oqs::manifest::Entry entry = good.entry(5);
+    oqs::bytes bad_digest = file;
+    auto it = std::search(bad_digest.begin(), bad_digest.end(),
+                          entry.digest.begin(), entry.digest.end());
+    ASSERT_NE(it, bad_digest.end());
+    *it ^= 1;
+    oqs::manifest::Manifest modified{bad_digest};
+    EXPECT_EQ(modified.verify_all(verifier, public_key),
+              std::vector<std::size_t>{5});
+    EXPECT_FALSE(modified.verify_merkle_root(verifier, public_key));
+
+    EXPECT_THROW(oqs::manifest::Manifest(oqs::bytes{'O', 'Q', 'S', 'M'}),
+                 std::runtime_error);
+    oqs::bytes truncated(file.begin(), file.begin() + 60);
+    EXPECT_THROW(oqs::manifest::Manifest{truncated}, std::runtime_error);
+}
+
+TEST(oqs_manifest, WithoutMerkleRootAndEmpty) {
+    oqs::Signature signer{sig_name};
+    oqs::bytes public_key = signer.generate_keypair();
+    oqs::Signature verifier{sig_name};
+
+    Corpus corpus{3};
+    oqs::manifest::Manifest manifest{
+        corpus.builder().build(signer, public_key, false)};
+    EXPECT_FALSE(manifest.has_merkle_root());
+    EXPECT_FALSE(manifest.verify_merkle_root(verifier, public_key));
+
+    oqs::bytes empty_file = oqs::manifest::Builder{}.build(signer, public_key);
+    oqs::manifest::Manifest empty{empty_file};
+    EXPECT_EQ(empty.size(), 0u);
+    EXPECT_EQ(empty.find("a"), 0u);
+    EXPECT_TRUE(empty.verify_all(verifier, public_key).empty());
+    EXPECT_TRUE(empty.verify_merkle_root(verifier, public_key));
+
+    oqs::manifest::Builder duplicates;
+    duplicates.add("a", oqs::manifest::digest({}));
+    duplicates.add("a", oqs::manifest::digest({1}));
+    EXPECT_THROW(duplicates.build(signer, public_key), std::runtime_error);
+    EXPECT_THROW(duplicates.add("", oqs::manifest::digest({})),
+                 std::invalid_argument);
+    EXPECT_THROW(duplicates.add("b", {1, 2}), std::invalid_argument);
+}
+
+#ifndef _WIN32
+TEST(oqs_manifest, MappedFile) {
+    Corpus corpus{10};
+    oqs::Signature signer{sig_name};
+    oqs::bytes public_key = signer.generate_keypair();
+    oqs::bytes file = corpus.builder().build(signer, public_key);
+    std::string path =
+        "/tmp/oqs-manifest-test-" + std::to_string(::getpid()) + ".bin";
+    {
+        std::ofstream out{path, std::ios::binary};
+        out.write(reinterpret_cast<const char*>(file.data()),
+                  static_cast<std::streamsize>(file.size()));
+    }
+
+    {
+        oqs::manifest::MappedFile mapped{path};
+        ASSERT_EQ(mapped.size(), file.size());
+        oqs::manifest::Manifest manifest{mapped.data(), mapped.size()};
+        oqs::Signature verifier{sig_name};
+        EXPECT_TRUE(manifest.verify(verifier, public_key, corpus.ids[3],
+                                    oqs::manifest::digest(corpus.contents[3])));
+        EXPECT_TRUE(manifest.verify_merkle_root(verifier, public_key));
+    }
+    std::remove(path.c_str());
+    EXPECT_THROW(oqs::manifest::MappedFile{path}, std::runtime_error);
+}
+#endif // _WIN32
@@ -0,0 +1,82 @@
+// Unit testing oqs::metrics
+
+#include <string>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+#include "metrics/metrics.hpp"
+#include "oqs_cpp.hpp"
+
+namespace {
+const oqs::metrics::OperationStats* find(
+    const std::vector<oqs::metrics::OperationStats>& stats,
+    const std::string& kind, const std::string& name,
+    oqs::metrics::Operation op) {
+    for (auto&& elem : stats)
+        if (elem.kind == kind && elem.algorithm == name && elem.operation == op)
+            return &elem;
+    return nullptr;
+}
+} // namespace
+
+TEST(oqs_metrics, LatencyBuckets) {
+    for (std::uint64_t ns : {2u, 3u, 1000u, 123456u, 1u << 30}) {
+        std::size_t idx = oqs::metrics::latency_bucket(ns);
+        EXPECT_LT(static_cast<double>(ns),
+                  oqs::metrics::latency_bucket_upper_ns(idx));
+        if (idx > 0)
+            EXPECT_GE(static_cast<double>(ns),
+                      oqs::metrics::latency_bucket_upper_ns(idx - 1));
+    }
+}
+
+TEST(oqs_metrics, SamplesFromExitedThreads) {
+    std::size_t id = oqs::metrics::internal::algorithm_id("kem", "test-kem");
+    EXPECT_EQ(id, oqs::metrics::internal::algorithm_id("kem", "test-kem"));
+    auto work = [id](std::size_t n) {
+        for (std::size_t i = 0; i < n; ++i) {
+            oqs::metrics::internal::Sample sample{
+                id, oqs::metrics::Operation::Encaps};
+            sample.done(i % 2 == 0);
+        }
+    };
+    std::thread t{work, 10};
+    t.join();
+    work(5);
+
+    auto stats = oqs::metrics::snapshot();
+    auto s = find(stats, "kem", "test-kem", oqs::metrics::Operation::Encaps);
+    ASSERT_NE(s, nullptr);
+    EXPECT_EQ(s->calls, 15u);
+    EXPECT_EQ(s->failures, 7u);
+    EXPECT_GT(s->percentile(99), 0);
+
+    std::string text = oqs::metrics::prometheus_text();
+    EXPECT_NE(text.find("liboqs_cpp_operations_total{algorithm=\"test-kem\","
+                        "kind=\"kem\",operation=\"encaps\"} 15"),
+              std::string::npos);
+    EXPECT_NE(text.find("liboqs_cpp_operation_duration_seconds_count{"
+                        "algorithm=\"test-kem\",kind=\"kem\",operation="
+                        "\"encaps\"} 15"),
+              std::string::npos);
+}
+
+#ifdef LIBOQS_CPP_METRICS
+TEST(oqs_metrics, Instrumentation) {
+    std::string sig_name = oqs::Sigs::get_enabled_sigs().front();
+    oqs::Signature signer{sig_name};
+    oqs::bytes public_key = signer.generate_keypair();
+    oqs::bytes message = "metrics"_bytes;
+    oqs::bytes signature = signer.sign(message);
+    EXPECT_TRUE(signer.verify(message, signature, public_key));
+    EXPECT_FALSE(signer.verify("other"_bytes, signature, public_key));
+
+    auto stats = oqs::metrics::snapshot();
+    auto verify =
+        find(stats, "sig", sig_name, oqs::metrics::Operation::Verify);
+    ASSERT_NE(verify, nullptr);
+    EXPECT_GE(verify->calls, 2u);
+    EXPECT_GE(verify->failures, 1u);
+}
+#endif
@@ -0,0 +1,97 @@
+// Unit testing oqs::mldsa
+
+#include <sstream>
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "mldsa/mldsa.hpp"
+#include "oqs_cpp.hpp"
+#include "sha3/sha3.hpp"
+
+namespace {
+const std::string sig_name = "ML-DSA-65";
+
+oqs::bytes pattern(std::size_t len) {
+    oqs::bytes result(len);
+    for (std::size_t i = 0; i < len; ++i)
+        result[i] = static_cast<oqs::byte>(i * 17 + 3);
+    return result;
+}
+} // namespace
+
+TEST(oqs_mldsa, ComputeMu) {
+    oqs::Signature sig{sig_name};
+    oqs::bytes public_key = sig.generate_keypair();
+    oqs::bytes context{'c', 't', 'x'};
+    oqs::bytes message = pattern(200000);
+
+    // FIPS 204: mu = SHAKE256(SHAKE256(pk, 64) | 0 | |ctx| | ctx | M, 64)
+    oqs::bytes input = oqs::sha3::shake256(public_key, oqs::mldsa::tr_length);
+    input.push_back(0);
+    input.push_back(static_cast<oqs::byte>(context.size()));
+    input.insert(input.end(), context.begin(), context.end());
+    input.insert(input.end(), message.begin(), message.end());
+    oqs::bytes expected = oqs::sha3::shake256(input, oqs::mldsa::mu_length);
+
+    EXPECT_EQ(oqs::mldsa::compute_mu(sig, public_key, context, message),
+              expected);
+    std::istringstream stream{std::string(message.begin(), message.end())};
+    EXPECT_EQ(oqs::mldsa::compute_mu(sig, public_key, context, stream),
+              expected);
+    oqs::mldsa::MuHasher hasher{sig, public_key, context};
+    hasher.update(message.data(), 1000).update(message.data() + 1000,
+                                               message.size() - 1000);
+    EXPECT_EQ(hasher.finalize(), expected);
+
+    EXPECT_NE(oqs::mldsa::compute_mu(sig, public_key, {}, message), expected);
+    EXPECT_THROW(oqs::mldsa::MuHasher(sig, {1, 2, 3}), std::invalid_argument);
+    EXPECT_THROW(oqs::mldsa::MuHasher(sig, public_key, oqs::bytes(256, 0)),
+                 std::invalid_argument);
+}
+
+TEST(oqs_mldsa, SplitSignAndVerify) {
+    oqs::Signature signer{sig_name};
+    oqs::bytes public_key = signer.generate_keypair();
+    oqs::bytes context{1, 2};
+    std::string message(100000, 'm');
+
+    // Data side: only the public key
+    oqs::Signature data_side{sig_name};
+    std::istringstream stream{message};
+    oqs::bytes mu =
+        oqs::mldsa::compute_mu(data_side, public_key, context, stream);
+    ASSERT_EQ(mu.size(), oqs::mldsa::mu_length);
+
+    // Key side: only mu
+    oqs::bytes signature = oqs::mldsa::sign_mu(signer, mu);
+
+    oqs::Signature verifier{sig_name};
+    EXPECT_TRUE(oqs::mldsa::verify_mu(verifier, mu, signature, public_key));
+    std::istringstream again{message};
+    EXPECT_TRUE(
+        oqs::mldsa::verify(verifier, public_key, context, again, signature));
+    std::istringstream modified{message + "!"};
+    EXPECT_FALSE(
+        oqs::mldsa::verify(verifier, public_key, context, modified, signature));
+    std::istringstream other_context{message};
+    EXPECT_FALSE(
+        oqs::mldsa::verify(verifier, public_key, {}, other_context, signature));
+    // Not a signature of mu as a plain message
+    EXPECT_FALSE(verifier.verify(mu, signature, public_key));
+
+    EXPECT_THROW(oqs::mldsa::sign_mu(signer, {1, 2, 3}), std::invalid_argument);
+}
+
+TEST(oqs_mldsa, RequiresMlDsa) {
+    for (auto&& name : oqs::Sigs::get_enabled_sigs()) {
+        oqs::Signature sig{name};
+        if (oqs::mldsa::is_ml_dsa(sig))
+            continue;
+        oqs::bytes public_key = sig.generate_keypair();
+        EXPECT_THROW(oqs::mldsa::MuHasher(sig, public_key),
+                     std::invalid_argument);
+        EXPECT_THROW(oqs::mldsa::sign_mu(sig, oqs::bytes(64, 0)),
+                     std::invalid_argument);
+    }
+}
@@ -0,0 +1,92 @@
+// Unit testing oqs::numa
+
+#include <atomic>
+#include <cstddef>
+#include <future>
+#include <stdexcept>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "numa/numa.hpp"
+#include "oqs_cpp.hpp"
+
+TEST(oqs_numa, ParseCpulist) {
+    EXPECT_EQ(oqs::numa::parse_cpulist("0-3,8,10-11\n"),
+              (std::vector<int>{0, 1, 2, 3, 8, 10, 11}));
+    EXPECT_EQ(oqs::numa::parse_cpulist("5,1,1"), (std::vector<int>{1, 5}));
+    EXPECT_TRUE(oqs::numa::parse_cpulist("").empty());
+}
+
+TEST(oqs_numa, Topology) {
+    oqs::numa::Topology topology{{{0, 1}, {}, {2, 3}, {4}}};
+    EXPECT_EQ(topology.num_nodes(), 3u); // the empty node is dropped
+    EXPECT_EQ(topology.cpus(1), (std::vector<int>{2, 3}));
+    EXPECT_EQ(topology.first_nodes(2).num_nodes(), 2u);
+    EXPECT_EQ(topology.first_nodes(0).num_nodes(), 1u);
+    EXPECT_THROW(oqs::numa::Topology{{{}}}, std::runtime_error);
+
+    EXPECT_EQ(oqs::numa::Topology::single_node(3).cpus(0),
+              (std::vector<int>{0, 1, 2}));
+    EXPECT_GE(oqs::numa::Topology::detect().num_nodes(), 1u);
+}
+
+TEST(oqs_numa, ShardedPool) {
+    // Pinning is best effort, the CPUs need not exist
+    oqs::numa::Topology topology{{{0, 1, 2}, {3}}};
+    std::atomic<int> sum{0};
+    {
+        oqs::numa::ShardedPool pool{topology, 2};
+        EXPECT_EQ(pool.size(), 3u); // at most 2 per node
+        EXPECT_EQ(pool.current_node(), oqs::numa::any_node);
+        for (int i = 1; i <= 100; ++i)
+            pool.post([&sum, i] { sum += i; });
+        for (int i = 0; i < 10; ++i)
+            pool.post(1, [&](std::size_t) {
+                // Jobs posted by a worker stay on its node
+                pool.post(oqs::numa::any_node, [&](std::size_t inner) {
+                    sum += inner == pool.current_node() ? 1 : 1000;
+                });
+            });
+        EXPECT_THROW(pool.post(2, [](std::size_t) {}), std::out_of_range);
+    } // drains the queues
+    EXPECT_EQ(sum, 5060);
+}
+
+TEST(oqs_numa, Replicas) {
+    oqs::numa::ShardedPool pool{oqs::numa::Topology{{{0}, {0}, {0}}}};
+    std::atomic<int> made{0};
+    oqs::numa::Replicas<std::size_t> nodes =
+        pool.replicate<std::size_t>([&] {
+            ++made;
+            return new std::size_t{pool.current_node()};
+        });
+    ASSERT_EQ(nodes.size(), 3u);
+    EXPECT_EQ(made, 3);
+    for (std::size_t node = 0; node < nodes.size(); ++node)
+        EXPECT_EQ(nodes[node], node); // made by a worker of that node
+
+    auto failing = []() -> int* { throw std::runtime_error("factory"); };
+    EXPECT_THROW(pool.replicate<int>(failing), std::runtime_error);
+}
+
+TEST(oqs_numa, ReplicatedSecretKey) {
+    oqs::Signature signer{"ML-DSA-44"};
+    oqs::bytes public_key = signer.generate_keypair();
+    oqs::bytes secret_key = signer.export_secret_key();
+
+    oqs::numa::ShardedPool pool{oqs::numa::Topology{{{0}, {0}}}};
+    auto signers = pool.replicate<oqs::Signature>(
+        [&] { return new oqs::Signature{"ML-DSA-44", secret_key}; });
+
+    // One job per node at a time, the replicas are not used concurrently
+    oqs::bytes message{'n', 'u', 'm', 'a'};
+    std::vector<std::promise<oqs::bytes>> signatures(signers.size());
+    for (std::size_t node = 0; node < signers.size(); ++node)
+        pool.post(node, [&, node](std::size_t on) {
+            signatures[node].set_value(signers[on].sign(message));
+        });
+    for (auto&& signature : signatures)
+        EXPECT_TRUE(
+            signer.verify(message, signature.get_future().get(), public_key));
+}
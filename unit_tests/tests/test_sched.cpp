@@ -0,0 +1,189 @@
+// Unit testing oqs::sched
+
+#include <chrono>
+#include <future>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "oqs_cpp.hpp"
+#include "sched/sched.hpp"
+
+namespace {
+// Blocks a worker until opened
+class Gate {
+    std::promise<void> open_{};
+    std::shared_future<void> opened_{open_.get_future().share()};
+
+  public:
+    void wait() const { opened_.wait(); }
+    void open() { open_.set_value(); }
+};
+
+const std::string alg = "test";
+
+oqs::sched::SchedulerOptions options(std::size_t num_threads,
+                                     std::size_t bulk_threads) {
+    oqs::sched::SchedulerOptions result;
+    result.num_threads = num_threads;
+    result.bulk_threads = bulk_threads;
+    return result;
+}
+} // namespace
+
+TEST(oqs_sched, CostModel) {
+    oqs::sched::CostModel costs{0.5, 0.5};
+    EXPECT_EQ(costs.estimate(alg, oqs::sched::Operation::Sign), 0.5);
+    costs.record(alg, oqs::sched::Operation::Sign, 2);
+    EXPECT_EQ(costs.estimate(alg, oqs::sched::Operation::Sign), 2);
+    costs.record(alg, oqs::sched::Operation::Sign, 4);
+    EXPECT_EQ(costs.estimate(alg, oqs::sched::Operation::Sign), 3);
+    EXPECT_EQ(costs.estimate(alg, oqs::sched::Operation::Verify), 0.5);
+
+    oqs::metrics::OperationStats stats{
+        "ML-DSA-44", "sig", oqs::sched::Operation::Verify, 4, 0, 2e-3, {}};
+    costs.load({stats});
+    EXPECT_DOUBLE_EQ(
+        costs.estimate("ML-DSA-44", oqs::sched::Operation::Verify), 5e-4);
+}
+
+TEST(oqs_sched, PriorityAndDeadlineOrder) {
+    oqs::sched::CostModel costs{1e-6};
+    oqs::sched::Scheduler scheduler{costs, options(1, 1)};
+    Gate gate;
+    std::mutex mutex;
+    std::vector<std::string> order;
+    auto log = [&](const std::string& name) {
+        return [&, name] {
+            std::lock_guard<std::mutex> lock{mutex};
+            order.push_back(name);
+        };
+    };
+
+    using oqs::sched::Priority;
+    using oqs::sched::Request;
+    auto later = oqs::sched::Clock::now() + std::chrono::hours(1);
+    auto blocked = scheduler.submit(
+        Request{alg, oqs::sched::Operation::Keypair, Priority::Normal},
+        [&] { gate.wait(); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    std::vector<std::future<void>> done;
+    done.push_back(scheduler.submit(
+        Request{alg, oqs::sched::Operation::Keypair, Priority::Bulk},
+        log("bulk")));
+    done.push_back(scheduler.submit(
+        Request{alg, oqs::sched::Operation::Sign, Priority::Normal},
+        log("normal")));
+    done.push_back(scheduler.submit(
+        Request{alg, oqs::sched::Operation::Verify, Priority::Interactive},
+        log("interactive, no deadline")));
+    done.push_back(scheduler.submit(
+        Request{alg, oqs::sched::Operation::Verify, Priority::Interactive,
+                later},
+        log("interactive, deadline")));
+    gate.open();
+    blocked.get();
+    for (auto&& elem : done)
+        elem.get();
+
+    EXPECT_EQ(order, (std::vector<std::string>{"interactive, deadline",
+                                               "interactive, no deadline",
+                                               "normal", "bulk"}));
+    oqs::sched::SchedulerStats stats = scheduler.stats();
+    EXPECT_EQ(stats.started[0], 2u);
+    EXPECT_EQ(stats.started[1], 2u);
+    EXPECT_EQ(stats.started[2], 1u);
+}
+
+TEST(oqs_sched, AdmissionAndShedding) {
+    oqs::sched::CostModel costs{1e-6};
+    costs.set(alg, oqs::sched::Operation::Sign, 1);
+    oqs::sched::Scheduler scheduler{costs, options(1, 1)};
+    using oqs::sched::Clock;
+    using oqs::sched::Priority;
+    using oqs::sched::Request;
+
+    // Estimated at 1 s, rejected right away for a 10 ms deadline
+    EXPECT_THROW(
+        scheduler.submit(Request{alg, oqs::sched::Operation::Sign,
+                                 Priority::Interactive,
+                                 Clock::now() + std::chrono::milliseconds(10)},
+                         [] {}),
+        oqs::sched::DeadlineExceeded);
+
+    // Admitted, but still queued when its deadline passes
+    Gate gate;
+    auto blocked = scheduler.submit(
+        Request{alg, oqs::sched::Operation::Verify, Priority::Normal},
+        [&] { gate.wait(); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    bool ran = false;
+    auto shed = scheduler.submit(
+        Request{alg, oqs::sched::Operation::Verify, Priority::Interactive,
+                Clock::now() + std::chrono::milliseconds(50)},
+        [&] { ran = true; });
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    gate.open();
+    blocked.get();
+    EXPECT_THROW(shed.get(), oqs::sched::DeadlineExceeded);
+    EXPECT_FALSE(ran);
+
+    oqs::sched::SchedulerStats stats = scheduler.stats();
+    EXPECT_EQ(stats.rejected[0], 1u);
+    EXPECT_EQ(stats.shed[0], 1u);
+    EXPECT_EQ(stats.started[1], 1u);
+}
+
+TEST(oqs_sched, BulkLeavesAWorkerFree) {
+    oqs::sched::CostModel costs;
+    oqs::sched::Scheduler scheduler{costs, options(2, 1)};
+    EXPECT_EQ(scheduler.size(), 2u);
+    Gate gate;
+    using oqs::sched::Priority;
+    using oqs::sched::Request;
+    std::vector<std::future<void>> bulk;
+    for (int i = 0; i < 2; ++i)
+        bulk.push_back(scheduler.submit(
+            Request{alg, oqs::sched::Operation::Keypair, Priority::Bulk},
+            [&] { gate.wait(); }));
+
+    oqs::Signature signer{"ML-DSA-44"};
+    oqs::bytes public_key = signer.generate_keypair();
+    oqs::bytes message{'a', 'b', 'c'};
+    oqs::bytes signature = signer.sign(message);
+    std::future<bool> valid =
+        oqs::sched::verify(scheduler, signer, message, signature, public_key);
+    EXPECT_EQ(valid.wait_for(std::chrono::seconds(10)),
+              std::future_status::ready);
+    EXPECT_TRUE(valid.get());
+    gate.open();
+    for (auto&& elem : bulk)
+        elem.get();
+    EXPECT_EQ(scheduler.stats().started[2], 2u);
+}
+
+TEST(oqs_sched, WrapperOperations) {
+    oqs::sched::CostModel costs;
+    oqs::sched::Scheduler scheduler{costs, options(2, 0)};
+    oqs::KeyEncapsulation kem{"ML-KEM-768"};
+    oqs::bytes public_key =
+        oqs::sched::generate_keypair(scheduler, kem).get();
+    auto encaps = oqs::sched::encap_secret(scheduler, kem, public_key).get();
+    EXPECT_EQ(oqs::sched::decap_secret(scheduler, kem, encaps.first).get(),
+              encaps.second);
+
+    oqs::Signature signer{"ML-DSA-44"};
+    oqs::bytes sig_public_key =
+        oqs::sched::generate_keypair(scheduler, signer).get();
+    oqs::bytes message{'x'};
+    oqs::bytes signature = oqs::sched::sign(scheduler, signer, message).get();
+    EXPECT_TRUE(oqs::sched::verify(scheduler, signer, message, signature,
+                                   sig_public_key)
+                    .get());
+
+    // Measured durations replace the default estimate
+    EXPECT_NE(costs.estimate("ML-DSA-44", oqs::sched::Operation::Sign), 1e-3);
+}
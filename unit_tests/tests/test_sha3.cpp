@@ -0,0 +1,36 @@
+// Unit testing oqs::sha3
+
+#include <gtest/gtest.h>
+
+#include "oqs_cpp.hpp"
+#include "sha3/sha3.hpp"
+
+TEST(oqs_sha3, KnownAnswer) {
+    // FIPS 202 example, SHA3-256("abc")
+    oqs::bytes expected{0x3a, 0x98, 0x5d, 0xa7, 0x4f, 0xe2, 0x25, 0xb2,
+                        0x04, 0x5c, 0x17, 0x2d, 0x6b, 0xd3, 0x90, 0xbd,
+                        0x85, 0x5f, 0x08, 0x6e, 0x3e, 0x9d, 0x52, 0x5b,
+                        0x46, 0xbf, 0xe2, 0x45, 0x11, 0x43, 0x15, 0x32};
+    EXPECT_EQ(oqs::sha3::sha3_256("abc"_bytes), expected);
+}
+
+TEST(oqs_sha3, Incremental) {
+    oqs::bytes message = "This is our favourite message to hash"_bytes;
+    oqs::sha3::SHA3_256 h;
+    h.absorb(message.data(), 10);
+    oqs::sha3::SHA3_256 copy = h;
+    h.absorb(message.data() + 10, message.size() - 10);
+    EXPECT_EQ(h.digest(), oqs::sha3::sha3_256(message));
+    // digest() leaves the running state untouched
+    EXPECT_EQ(h.digest(), oqs::sha3::sha3_256(message));
+    EXPECT_EQ(copy.digest(),
+              oqs::sha3::sha3_256(oqs::bytes(message.begin(),
+                                             message.begin() + 10)));
+
+    oqs::sha3::SHAKE256 xof;
+    xof.absorb(message).finalize();
+    oqs::bytes first = xof.squeeze(20);
+    oqs::bytes second = xof.squeeze(44);
+    first.insert(first.end(), second.begin(), second.end());
+    EXPECT_EQ(first, oqs::sha3::shake256(message, 64));
+}
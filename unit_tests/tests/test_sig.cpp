@@ -221,6 +221,18 @@ TEST(oqs_Signature, WrongPublicKey) {
         elem.join();
 }
 
+TEST(oqs_Signature, InPlace) {
+    oqs::bytes message = "This is our favourite message to sign"_bytes;
+    std::string sig_name = oqs::Sigs::get_enabled_sigs().front();
+    oqs::Signature signer{sig_name};
+    oqs::bytes signer_public_key;
+    signer.generate_keypair(signer_public_key);
+    oqs::bytes signature;
+    signer.sign(message, signature);
+    oqs::Signature verifier{sig_name};
+    EXPECT_TRUE(verifier.verify(message, signature, signer_public_key));
+}
+
 TEST(oqs_Signature, NotSupported) {
     EXPECT_THROW(oqs::Signature{"unsupported_sig"},
                  oqs::MechanismNotSupportedError);
@@ -0,0 +1,167 @@
+// Unit testing the concurrency contract of oqs::KeyEncapsulation and
+// oqs::Signature, see oqs_cpp.hpp; meant to also run under ThreadSanitizer
+
+#include <atomic>
+#include <cstddef>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "oqs_cpp.hpp"
+
+namespace {
+const std::string kem_name = "ML-KEM-768";
+const std::string sig_name = "ML-DSA-44";
+constexpr std::size_t num_threads = 8;
+constexpr std::size_t num_iterations = 16;
+
+// Runs f(thread) on num_threads threads released together, and returns the
+// number of failed checks reported by f
+template <typename F>
+std::size_t stress(F f) {
+    std::atomic<bool> go{false};
+    std::atomic<std::size_t> failures{0};
+    std::vector<std::thread> threads;
+    for (std::size_t t = 0; t < num_threads; ++t)
+        threads.emplace_back([&, t] {
+            while (!go)
+                std::this_thread::yield();
+            failures += f(t);
+        });
+    go = true;
+    for (auto&& thread : threads)
+        thread.join();
+    return failures;
+}
+} // namespace
+
+TEST(oqs_thread_safety, SharedSecretKey) {
+    oqs::SharedSecretKey empty;
+    EXPECT_TRUE(empty.empty());
+    EXPECT_EQ(empty.data(), nullptr);
+    EXPECT_EQ(empty.use_count(), 0);
+    EXPECT_TRUE(oqs::SharedSecretKey{oqs::bytes{}}.empty());
+
+    oqs::SharedSecretKey key{oqs::bytes{1, 2, 3}};
+    oqs::SharedSecretKey copy = key;
+    EXPECT_EQ(copy.data(), key.data());
+    EXPECT_EQ(key.use_count(), 2);
+    EXPECT_EQ(copy.to_bytes(), (oqs::bytes{1, 2, 3}));
+    oqs::SharedSecretKey moved = std::move(copy);
+    EXPECT_EQ(key.use_count(), 2);
+    EXPECT_EQ(moved.data(), key.data());
+
+    // Copies of the wrappers share the secret key
+    oqs::Signature signer{sig_name};
+    signer.generate_keypair();
+    oqs::Signature signer_copy = signer;
+    EXPECT_EQ(signer_copy.share_secret_key().data(),
+              signer.share_secret_key().data());
+    oqs::Signature from_shared{sig_name, signer.share_secret_key()};
+    EXPECT_EQ(from_shared.share_secret_key().data(),
+              signer.share_secret_key().data());
+    EXPECT_EQ(signer.share_secret_key().use_count(), 4);
+    EXPECT_EQ(from_shared.export_secret_key(), signer.export_secret_key());
+
+    // A new key pair does not affect the copies
+    oqs::bytes old_secret_key = signer.export_secret_key();
+    oqs::bytes public_key;
+    signer.generate_keypair(public_key);
+    EXPECT_NE(signer.export_secret_key(), old_secret_key);
+    EXPECT_EQ(signer_copy.export_secret_key(), old_secret_key);
+    // and reuses the secret key buffer once it is no longer shared
+    const oqs::byte* buffer = signer.share_secret_key().data();
+    signer.generate_keypair(public_key);
+    EXPECT_EQ(signer.share_secret_key().data(), buffer);
+
+    oqs::Signature moved_signer = std::move(signer_copy);
+    EXPECT_EQ(moved_signer.export_secret_key(), old_secret_key);
+    EXPECT_TRUE(signer_copy.export_secret_key().empty());
+}
+
+TEST(oqs_thread_safety, KemSharedInstance) {
+    oqs::KeyEncapsulation server{kem_name};
+    oqs::bytes public_key = server.generate_keypair();
+    const oqs::KeyEncapsulation& shared = server;
+
+    std::size_t failures = stress([&](std::size_t) {
+        std::size_t result = 0;
+        oqs::bytes ciphertext, shared_secret, shared_secret_server;
+        for (std::size_t i = 0; i < num_iterations; ++i) {
+            shared.encap_secret(public_key, ciphertext, shared_secret);
+            shared.decap_secret(ciphertext, shared_secret_server);
+            result += shared_secret != shared_secret_server;
+            result += shared.decap_secret(ciphertext) != shared_secret;
+        }
+        return result;
+    });
+    EXPECT_EQ(failures, 0u);
+}
+
+TEST(oqs_thread_safety, KemCopiesShareKey) {
+    oqs::KeyEncapsulation server{kem_name};
+    oqs::bytes public_key = server.generate_keypair();
+    oqs::SharedSecretKey secret_key = server.share_secret_key();
+
+    // Every thread makes and drops its own copies while the others decap
+    std::size_t failures = stress([&](std::size_t t) {
+        std::size_t result = 0;
+        for (std::size_t i = 0; i < num_iterations; ++i) {
+            oqs::KeyEncapsulation copy =
+                t % 2 == 0 ? server
+                           : oqs::KeyEncapsulation{kem_name, secret_key};
+            result += copy.share_secret_key().data() != secret_key.data();
+            auto encaps = copy.encap_secret(public_key);
+            result += copy.decap_secret(encaps.first) != encaps.second;
+        }
+        return result;
+    });
+    EXPECT_EQ(failures, 0u);
+    EXPECT_EQ(secret_key.use_count(), 2);
+}
+
+TEST(oqs_thread_safety, SigSharedInstance) {
+    oqs::Signature signer{sig_name};
+    oqs::bytes public_key = signer.generate_keypair();
+    const oqs::Signature& shared = signer;
+    oqs::Signature verifier{sig_name};
+
+    std::size_t failures = stress([&](std::size_t t) {
+        std::size_t result = 0;
+        oqs::bytes signature;
+        for (std::size_t i = 0; i < num_iterations; ++i) {
+            oqs::bytes message(32 + t, static_cast<oqs::byte>(i));
+            shared.sign(message, signature);
+            result += !verifier.verify(message, signature, public_key);
+            oqs::bytes context(t, 1);
+            if (shared.get_details().sig_with_ctx_support)
+                result += !verifier.verify_with_ctx_str(
+                    message, shared.sign_with_ctx_str(message, context),
+                    context, public_key);
+        }
+        return result;
+    });
+    EXPECT_EQ(failures, 0u);
+}
+
+TEST(oqs_thread_safety, SigCopiesShareKey) {
+    oqs::Signature signer{sig_name};
+    oqs::bytes public_key = signer.generate_keypair();
+    oqs::SharedSecretKey secret_key = signer.share_secret_key();
+
+    std::size_t failures = stress([&](std::size_t t) {
+        std::size_t result = 0;
+        oqs::Signature own{sig_name, secret_key};
+        for (std::size_t i = 0; i < num_iterations; ++i) {
+            oqs::Signature copy = t % 2 == 0 ? signer : own;
+            result += copy.share_secret_key().data() != secret_key.data();
+            oqs::bytes message(16, static_cast<oqs::byte>(t));
+            result += !copy.verify(message, copy.sign(message), public_key);
+        }
+        return result;
+    });
+    EXPECT_EQ(failures, 0u);
+    EXPECT_EQ(secret_key.use_count(), 2);
+}
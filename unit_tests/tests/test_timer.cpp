@@ -0,0 +1,76 @@
+// Unit testing oqs::Histogram, oqs::AccumulatingTimer and oqs::ScopedSample
+
+#include <chrono>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+#include "oqs_cpp.hpp"
+
+TEST(oqs_Histogram, Statistics) {
+    oqs::Histogram h;
+    EXPECT_EQ(h.count(), 0u);
+    EXPECT_EQ(h.percentile(50), 0);
+
+    for (int i = 1; i <= 1000; ++i)
+        h.record(i);
+    EXPECT_EQ(h.count(), 1000u);
+    EXPECT_EQ(h.min(), 1);
+    EXPECT_EQ(h.max(), 1000);
+    EXPECT_DOUBLE_EQ(h.mean(), 500.5);
+    EXPECT_NEAR(h.percentile(50), 500, 500 * 0.016);
+    EXPECT_NEAR(h.percentile(99), 990, 990 * 0.016);
+    EXPECT_EQ(h.percentile(0), 1);
+    EXPECT_EQ(h.percentile(100), 1000);
+
+    // Tiny and huge values are clamped to [min, max]
+    oqs::Histogram extremes;
+    extremes.record(1e-30);
+    extremes.record(1e30);
+    EXPECT_EQ(extremes.percentile(0), 1e-30);
+    EXPECT_EQ(extremes.percentile(100), 1e30);
+
+    h.merge(extremes);
+    EXPECT_EQ(h.count(), 1002u);
+    EXPECT_EQ(h.min(), 1e-30);
+    EXPECT_EQ(h.max(), 1e30);
+
+    h.reset();
+    EXPECT_EQ(h.count(), 0u);
+    EXPECT_EQ(h.mean(), 0);
+}
+
+TEST(oqs_AccumulatingTimer, ScopedSample) {
+    oqs::AccumulatingTimer<std::chrono::duration<double, std::milli>> timer;
+    for (int i = 0; i < 3; ++i) {
+        oqs::ScopedSample<decltype(timer)> sample{timer};
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+    timer.tic();
+    timer.toc();
+    EXPECT_EQ(timer.histogram().count(), 4u);
+    EXPECT_GE(timer.histogram().max(), 2);
+    EXPECT_LT(timer.histogram().min(), 2);
+}
+
+TEST(oqs_AccumulatingTimer, Clocks) {
+    oqs::Timer<oqs::clocks::cycle_clock::duration, oqs::clocks::cycle_clock>
+        cycles;
+    volatile double x = 0;
+    for (int i = 0; i < 100000; ++i)
+        x = x + 1;
+    cycles.toc();
+    EXPECT_GT(cycles.tics(), 0);
+
+#if defined(__unix__) || defined(__APPLE__)
+    // A sleeping thread consumes (almost) no CPU time
+    oqs::AccumulatingTimer<std::chrono::duration<double, std::milli>,
+                           oqs::clocks::thread_cpu_clock>
+        cpu;
+    {
+        oqs::ScopedSample<decltype(cpu)> sample{cpu};
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+    EXPECT_LT(cpu.histogram().max(), 10);
+#endif
+}
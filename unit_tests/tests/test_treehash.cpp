@@ -0,0 +1,157 @@
+// Unit testing oqs::treehash
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+#include "oqs_cpp.hpp"
+#include "sha3/sha3.hpp"
+#include "treehash/treehash.hpp"
+
+namespace {
+const std::string sig_name = "ML-DSA-44";
+
+oqs::bytes pattern(std::size_t len) {
+    oqs::bytes result(len);
+    for (std::size_t i = 0; i < len; ++i)
+        result[i] = static_cast<oqs::byte>(i * 13 + i / 256);
+    return result;
+}
+
+oqs::treehash::Options options(std::size_t leaf_size, std::size_t threads,
+                               bool use_x4) {
+    oqs::treehash::Options result;
+    result.leaf_size = leaf_size;
+    result.num_threads = threads;
+    result.use_x4 = use_x4;
+    return result;
+}
+
+// Straightforward, sequential implementation of the tree
+oqs::bytes reference_root(const oqs::bytes& data, std::size_t leaf_size) {
+    std::vector<oqs::bytes> level;
+    for (std::size_t begin = 0; begin < data.size() || level.empty();
+         begin += leaf_size) {
+        std::size_t end = std::min(data.size(), begin + leaf_size);
+        level.emplace_back(oqs::sha3::shake256(
+            oqs::bytes(data.begin() + static_cast<std::ptrdiff_t>(begin),
+                       data.begin() + static_cast<std::ptrdiff_t>(end)),
+            oqs::treehash::digest_length));
+    }
+    while (level.size() > 1) {
+        std::vector<oqs::bytes> next;
+        for (std::size_t i = 0; i + 1 < level.size(); i += 2) {
+            oqs::bytes node{1};
+            node.insert(node.end(), level[i].begin(), level[i].end());
+            node.insert(node.end(), level[i + 1].begin(), level[i + 1].end());
+            next.emplace_back(
+                oqs::sha3::shake256(node, oqs::treehash::digest_length));
+        }
+        if (level.size() % 2 != 0)
+            next.emplace_back(level.back());
+        level = next;
+    }
+    oqs::bytes top{2};
+    for (int shift = 56; shift >= 0; shift -= 8)
+        top.push_back(static_cast<oqs::byte>(
+            static_cast<std::uint64_t>(leaf_size) >> shift));
+    for (int shift = 56; shift >= 0; shift -= 8)
+        top.push_back(static_cast<oqs::byte>(
+            static_cast<std::uint64_t>(data.size()) >> shift));
+    top.insert(top.end(), level.front().begin(), level.front().end());
+    return oqs::sha3::shake256(top, oqs::treehash::digest_length);
+}
+} // namespace
+
+TEST(oqs_treehash, Shake256X4) {
+    oqs::bytes inputs[4] = {pattern(200), oqs::bytes(200, 1),
+                            oqs::bytes(200, 2), pattern(201)};
+    inputs[3].erase(inputs[3].begin());
+    oqs::bytes outputs[4];
+    const oqs::byte* in[4];
+    oqs::byte* out[4];
+    for (int i = 0; i < 4; ++i) {
+        outputs[i].resize(33);
+        in[i] = inputs[i].data();
+        out[i] = outputs[i].data();
+    }
+    oqs::sha3::shake256_x4(out, 33, in, 200);
+    for (int i = 0; i < 4; ++i)
+        EXPECT_EQ(outputs[i], oqs::sha3::shake256(inputs[i], 33));
+}
+
+TEST(oqs_treehash, MatchesReferenceTree) {
+    for (std::size_t length : {0, 1, 7, 8, 9, 63, 64, 65, 129, 1000}) {
+        oqs::bytes data = pattern(length);
+        oqs::bytes expected = reference_root(data, 8);
+        for (std::size_t threads : {1, 3})
+            for (bool use_x4 : {false, true})
+                EXPECT_EQ(oqs::treehash::root(data,
+                                              options(8, threads, use_x4)),
+                          expected)
+                    << length << " bytes, " << threads << " thread(s), x4 "
+                    << use_x4;
+    }
+    oqs::bytes data = pattern(100);
+    EXPECT_NE(oqs::treehash::root(data, options(8, 1, true)),
+              oqs::treehash::root(data, options(16, 1, true)));
+    EXPECT_THROW(oqs::treehash::root(data, options(0, 1, true)),
+                 std::invalid_argument);
+}
+
+#ifndef _WIN32
+TEST(oqs_treehash, File) {
+    oqs::bytes data = pattern(100000);
+    std::string path =
+        "/tmp/oqs-treehash-test-" + std::to_string(::getpid()) + ".bin";
+    {
+        std::ofstream out{path, std::ios::binary};
+        out.write(reinterpret_cast<const char*>(data.data()),
+                  static_cast<std::streamsize>(data.size()));
+    }
+    oqs::treehash::Options opts = options(4096, 3, true);
+    EXPECT_EQ(oqs::treehash::root_file(path, opts),
+              oqs::treehash::root(data, opts));
+    std::remove(path.c_str());
+    EXPECT_THROW(oqs::treehash::root_file(path, opts), std::runtime_error);
+}
+#endif // _WIN32
+
+TEST(oqs_treehash, SignAndVerify) {
+    oqs::Signature signer{sig_name};
+    if (!signer.get_details().sig_with_ctx_support)
+        GTEST_SKIP() << "Context strings not supported";
+    oqs::bytes public_key = signer.generate_keypair();
+    oqs::Signature verifier{sig_name};
+    oqs::bytes data = pattern(50000);
+    oqs::treehash::Options opts = options(1024, 2, true);
+
+    oqs::bytes signature =
+        oqs::treehash::sign(signer, data.data(), data.size(), opts);
+    EXPECT_TRUE(oqs::treehash::verify(verifier, data.data(), data.size(),
+                                      signature, public_key, opts));
+    // The root is not signed as a plain message
+    oqs::bytes root = oqs::treehash::root(data, opts);
+    EXPECT_FALSE(verifier.verify(root, signature, public_key));
+    EXPECT_TRUE(oqs::treehash::verify_root(verifier, root, signature,
+                                           public_key, opts));
+    // Nor under another leaf size
+    EXPECT_FALSE(oqs::treehash::verify_root(
+        verifier, root, signature, public_key, options(2048, 2, true)));
+
+    data[12345] ^= 1;
+    EXPECT_FALSE(oqs::treehash::verify(verifier, data.data(), data.size(),
+                                       signature, public_key, opts));
+    std::string context = "oqs-treehash 1 shake256 leaf 1024";
+    EXPECT_EQ(oqs::treehash::context(opts),
+              oqs::bytes(context.begin(), context.end()));
+}
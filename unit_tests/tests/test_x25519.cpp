@@ -0,0 +1,85 @@
+// Unit testing oqs::x25519
+
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "oqs_cpp.hpp"
+#include "x25519/x25519.hpp"
+
+namespace {
+oqs::bytes from_hex(const std::string& hex) {
+    oqs::bytes result;
+    for (std::size_t i = 0; i + 1 < hex.size(); i += 2)
+        result.push_back(
+            static_cast<oqs::byte>(std::stoul(hex.substr(i, 2), nullptr, 16)));
+    return result;
+}
+} // namespace
+
+// RFC 7748 section 5.2
+TEST(oqs_x25519, KnownAnswer) {
+    EXPECT_EQ(
+        oqs::x25519::x25519(
+            from_hex("a546e36bf0527c9d3b16154b82465edd62144c0ac1fc5a18506a2244"
+                     "ba449ac4"),
+            from_hex("e6db6867583030db3594c1a424b15f7c726624ec26b3353b10a903a6"
+                     "d0ab1c4c")),
+        from_hex("c3da55379de9c6908e94ea4df28d084f32eccf03491c71f754b4075577a2"
+                 "8552"));
+    // Sets the top bit of u, which is ignored
+    EXPECT_EQ(
+        oqs::x25519::x25519(
+            from_hex("4b66e9d4d1b4673c5ad22691957d6af5c11b6421e0ea01d42ca4169e"
+                     "7918ba0d"),
+            from_hex("e5210f12786811d3f4b7959d0538ae2c31dbe7106fc03c3efc4cd549"
+                     "c715a493")),
+        from_hex("95cbde9476e8907d7aade45cb4b873f88b595a68799fa152e6f8f7647aac"
+                 "7957"));
+}
+
+// RFC 7748 section 5.2, iterated
+TEST(oqs_x25519, Iterated) {
+    oqs::bytes k(oqs::x25519::key_length, 0), u(oqs::x25519::key_length, 0);
+    k[0] = u[0] = 9;
+    for (int i = 1; i <= 1000; ++i) {
+        oqs::bytes result = oqs::x25519::x25519(k, u);
+        u = k;
+        k = result;
+        if (i == 1)
+            EXPECT_EQ(k, from_hex("422c8e7a6227d7bca1350b3e2bb7279f7897b87bb6"
+                                  "854b783c60e80311ae3079"));
+    }
+    EXPECT_EQ(k, from_hex("684cf59ba83309552800ef566f2f4d3c1c3887c49360e3875f"
+                          "2eb94d99532c51"));
+}
+
+// RFC 7748 section 6.1
+TEST(oqs_x25519, DiffieHellman) {
+    oqs::bytes alice =
+        from_hex("77076d0a7318a57d3c16c17251b26645df4c2f87ebc0992ab177fba51db9"
+                 "2c2a");
+    oqs::bytes bob =
+        from_hex("5dab087e624a8a4b79e17f8b83800ee66f3bb1292618b6fd1c2f8b27ff88"
+                 "e0eb");
+    oqs::bytes alice_public = oqs::x25519::public_key(alice);
+    oqs::bytes bob_public = oqs::x25519::public_key(bob);
+    EXPECT_EQ(alice_public,
+              from_hex("8520f0098930a754748b7ddcb43ef75a0dbf3a0d26381af4eba4a9"
+                       "8eaa9b4e6a"));
+    EXPECT_EQ(bob_public,
+              from_hex("de9edb7d7b7dc1b4d35b61c2ece435373f8343c85b78674dadfc7e"
+                       "146f882b4f"));
+    oqs::bytes shared =
+        from_hex("4a5d9d5ba4ce2de1728e3bf480350f25e07e21c947d19e3376f09b3c1e16"
+                 "1742");
+    EXPECT_EQ(oqs::x25519::x25519(alice, bob_public), shared);
+    EXPECT_EQ(oqs::x25519::x25519(bob, alice_public), shared);
+
+    // In place
+    oqs::bytes out = alice;
+    oqs::x25519::scalarmult(out.data(), out.data(), bob_public.data());
+    EXPECT_EQ(out, shared);
+    EXPECT_THROW(oqs::x25519::x25519(alice, oqs::bytes(31)),
+                 std::runtime_error);
+}